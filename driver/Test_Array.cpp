@@ -7,6 +7,9 @@
 #include <vector>
 #include <sstream>
 #include <iterator>
+#include <numeric>
+#include <thread>
+#include <chrono>
 
 using std::cout;
 using std::endl;
@@ -250,8 +253,70 @@ void Test_SharedArray()
 	b = (x >= z);
 }
 
+void Test_SharedArray_freeze()
+{
+	cout << "*** test SharedArray::freeze() ***" << endl;
+
+	SharedArray<int> a{ 0, 1, 2, 3, 4 };
+	cout << a.use_count() << endl;
+
+	// 他に参照がなければそのまま引き渡される
+	const int* p = a.data();
+	SharedArray<const int> f = a.freeze();
+	cout << (f.data() == p) << ' ' << a.empty() << endl;
+	print(f);
+
+	// 参照が残っていればコピーされる
+	SharedArray<int> b{ 5, 6, 7 };
+	SharedArray<int> b2 = b;
+	SharedArray<const int> fb = b.freeze();
+	cout << (fb.data() != b2.data()) << ' ' << b2.use_count() << endl;
+	b2[0] = 50;
+	print(fb);
+
+	// 読み取り専用配列同士は共有
+	SharedArray<const int> fb2 = fb;
+	cout << fb.use_count() << ' ' << (fb == fb2) << endl;
+
+	SharedArray<const int> e = SharedArray<int>().freeze();
+	cout << e.empty() << endl;
+}
+
 } // anonymous namespace
 
+// 読み取り専用配列を複数スレッドで走査するベンチマーク
+void Bench_SharedArray_freeze()
+{
+	cout << "*** bench SharedArray::freeze() multi-reader scan ***" << endl;
+
+	const size_t N = 1 << 24;
+	SharedArray<int> a(N);
+	std::iota(a.begin(), a.end(), 0);
+	SharedArray<const int> table = a.freeze();
+
+	unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned n = 1; n <= max_threads; n *= 2) {
+		std::vector<long long> sums(n);
+		auto start = std::chrono::steady_clock::now();
+		std::vector<std::thread> threads;
+		for (unsigned t = 0; t < n; ++t) {
+			// スレッドごとに参照をコピーして渡す
+			threads.emplace_back([table, &sums, t]() {
+				for (int rep = 0; rep < 4; ++rep) {
+					sums[t] += std::accumulate(table.begin(), table.end(), 0LL);
+				}
+			});
+		}
+		for (auto& th : threads) th.join();
+		auto end = std::chrono::steady_clock::now();
+
+		double sec = std::chrono::duration<double>(end - start).count();
+		double gbps = 4.0 * n * N * sizeof(int) / sec / 1e9;
+		cout << n << " threads: " << sec * 1000 << " ms, "
+			<< gbps << " GB/s (sum " << sums[0] << ")" << endl;
+	}
+}
+
 void Test_Array()
 {
 	//Test_Array_int();
@@ -260,4 +325,5 @@ void Test_Array()
 	//Test_SharedArrayObject();
 
 	Test_SharedArray();
+	Test_SharedArray_freeze();
 }
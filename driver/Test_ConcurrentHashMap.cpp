@@ -0,0 +1,174 @@
+﻿#include <iostream>
+#include <string>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <tork/container/ConcurrentHashMap.h>
+#include <tork/memory/shared_ptr.h>
+
+using std::cout;
+using std::endl;
+using tork::ConcurrentHashMap;
+
+namespace {
+
+// std::unordered_map を1つの mutex で守ったもの（比較用）
+class MutexMap {
+	std::mutex mutex_;
+	std::unordered_map<unsigned, unsigned> map_;
+public:
+	bool find(unsigned key)
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		return map_.find(key) != map_.end();
+	}
+	void insert_or_assign(unsigned key, unsigned value)
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		map_[key] = value;
+	}
+	void erase(unsigned key)
+	{
+		std::lock_guard<std::mutex> guard(mutex_);
+		map_.erase(key);
+	}
+};
+
+// 検索 read_percent %、残りを挿入と削除に半分ずつ割り当てて
+// threads スレッドで回したときのスループット（百万操作／秒）
+template<class Map, class Find>
+double Throughput(Map& m, Find find, unsigned threads, unsigned read_percent, unsigned keys)
+{
+	const unsigned ops = 200000;
+	std::atomic<bool> start(false);
+	std::vector<std::thread> workers;
+	for (unsigned t = 0; t < threads; ++t) {
+		workers.push_back(std::thread([&, t]() {
+			std::minstd_rand rng(t + 1);
+			while (!start.load()) {
+				std::this_thread::yield();
+			}
+			for (unsigned i = 0; i < ops; ++i) {
+				unsigned r = rng();
+				unsigned key = (r >> 8) % keys;
+				unsigned kind = r % 100;
+				if (kind < read_percent) find(m, key);
+				else if (kind & 1) m.insert_or_assign(key, i);
+				else m.erase(key);
+			}
+		}));
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+	start = true;
+	for (auto& w : workers) {
+		w.join();
+	}
+	double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	return static_cast<double>(ops) * threads / sec / 1e6;
+}
+
+// stride 間隔のキーを n 個入れて全部探す時間
+double InsertFindStride(size_t n, unsigned long long stride, bool& ok)
+{
+	auto t = std::chrono::steady_clock::now();
+	ConcurrentHashMap<unsigned long long, size_t> m(64);
+	for (size_t i = 0; i < n; ++i) {
+		m.insert_or_assign(i * stride, i);
+	}
+	size_t hit = 0;
+	for (size_t i = 0; i < n; ++i) {
+		auto v = m.find(i * stride);
+		if (v.valid() && *v == i) ++hit;
+	}
+	ok = m.size() == n && hit == n && !m.contains(n * stride);
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+}
+
+}   // anonymous namespace
+
+void Test_ConcurrentHashMap()
+{
+	cout << "*** test ConcurrentHashMap ***" << endl;
+
+	// 値を shared_ptr にすれば、削除された後も取り出した側で使い続けられる
+	ConcurrentHashMap<std::string, tork::shared_ptr<std::string>> m(8);
+	m.insert_or_assign("a", tork::make_shared<std::string>("alpha"));
+	m.insert_or_assign("b", tork::make_shared<std::string>("beta"));
+	auto a = m.find("a");
+	m.erase("a");
+	cout << m.shard_count() << ' ' << m.size() << ' ' << a.valid() << ' ' << **a
+		<< ' ' << m.find("a").valid() << endl;
+
+	// 複数スレッドから同じキーを compute_if_absent しても生成は1回
+	ConcurrentHashMap<int, int> c;
+	std::atomic<int> created(0);
+	std::vector<std::thread> workers;
+	for (int t = 0; t < 8; ++t) {
+		workers.push_back(std::thread([&c, &created]() {
+			for (int i = 0; i < 1000; ++i) {
+				c.compute_if_absent(i, [&created](int key) {
+					++created;
+					return key * 10;
+				});
+			}
+		}));
+	}
+	for (auto& w : workers) {
+		w.join();
+	}
+	cout << created << ' ' << c.size() << ' ' << *c.find(999) << endl;
+
+	std::atomic<long> sum(0);
+	c.parallel_for_each([&sum](int key, int value) {
+		sum += value - key;
+	}, 4);
+	long seq = 0;
+	c.for_each([&seq](int key, int value) {
+		seq += value - key;
+	});
+	cout << sum << ' ' << seq << endl;
+
+	c.clear();
+	cout << c.empty() << endl;
+
+	// シャードの選択で上位ビットを使ったあとも、下位ビットがそろったキーが
+	// シャードの中で偏らない
+	bool ok1 = false, ok2 = false, ok3 = false;
+	double seq_ms = InsertFindStride(200000, 1, ok1);
+	double aligned_ms = InsertFindStride(200000, 4096, ok2);
+	double wide_ms = InsertFindStride(200000, 1ULL << 32, ok3);
+	cout << ok1 << ok2 << ok3 << ' ' << (aligned_ms < seq_ms * 10 + 10) << (wide_ms < seq_ms * 10 + 10) << endl;
+}
+
+void Bench_ConcurrentHashMap()
+{
+	cout << "*** bench ConcurrentHashMap (Mops/s) ***" << endl;
+
+	const unsigned keys = 1 << 16;
+	const unsigned reads[] = { 90, 10 };
+	for (unsigned read_percent : reads) {
+		cout << (read_percent >= 50 ? "read-heavy" : "write-heavy")
+			<< " (" << read_percent << "% find)" << endl;
+		for (unsigned threads = 1; threads <= 64; threads *= 2) {
+			ConcurrentHashMap<unsigned, unsigned> cm;
+			MutexMap mm;
+			for (unsigned k = 0; k < keys; k += 2) {
+				cm.insert_or_assign(k, k);
+				mm.insert_or_assign(k, k);
+			}
+			double c = Throughput(cm, [](ConcurrentHashMap<unsigned, unsigned>& m, unsigned key) {
+				return m.contains(key);
+			}, threads, read_percent, keys);
+			double u = Throughput(mm, [](MutexMap& m, unsigned key) {
+				return m.find(key);
+			}, threads, read_percent, keys);
+			cout << "  " << threads << " threads: ConcurrentHashMap " << c
+				<< ", mutex + unordered_map " << u << endl;
+		}
+	}
+}
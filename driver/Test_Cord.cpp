@@ -0,0 +1,263 @@
+﻿#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <tork/container/Cord.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define TORK_FILENO _fileno
+#else
+#include <unistd.h>
+#define TORK_FILENO fileno
+#endif
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double Millis(Clock::time_point begin)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+// 断片の列（長さ 1..64）
+std::vector<std::string> MakeFragments(size_t count)
+{
+	std::mt19937 rng(12345);
+	std::vector<std::string> v;
+	v.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		v.push_back(std::string(1 + rng() % 64, static_cast<char>('a' + i % 26)));
+	}
+	return v;
+}
+
+// ランダムな操作を std::string と同じように行って結果を比べる
+bool Fuzz(unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::vector<tork::Cord> cords(4);
+	std::vector<std::string> models(4);
+	for (int step = 0; step < 2000; ++step) {
+		size_t i = rng() % 4;
+		size_t j = rng() % 4;
+		switch (rng() % 6) {
+		case 0:
+		case 1: {
+			std::string s(rng() % 100, static_cast<char>('A' + step % 26));
+			if (rng() % 10 == 0) s.assign(rng() % 6000, 'z');
+			cords[i].append(s);
+			models[i] += s;
+			break;
+		}
+		case 2:
+			cords[i].append(cords[j]);
+			models[i] += models[j];
+			break;
+		case 3: {
+			size_t pos = models[j].empty() ? 0 : rng() % models[j].size();
+			size_t n = rng() % (models[j].size() + 1);
+			cords[i] = cords[j].substr(pos, n);
+			models[i] = models[j].substr(pos, n);
+			break;
+		}
+		case 4:
+			cords[i] = cords[j];
+			models[i] = models[j];
+			break;
+		case 5:
+			if (rng() % 4 == 0) cords[i].flatten();
+			if (models[i].size() > 200000) {
+				cords[i].clear();
+				models[i].clear();
+			}
+			break;
+		}
+		for (size_t k = 0; k < 4; ++k) {
+			if (cords[k].size() != models[k].size() || cords[k].str() != models[k]) return false;
+		}
+	}
+	return true;
+}
+
+}   // anonymous namespace
+
+void Test_Cord()
+{
+	cout << "*** test Cord ***" << endl;
+
+	// 短い断片は同じチャンクにまとまる
+	tork::Cord a;
+	a.append("hello");
+	a += ", ";
+	a += std::string("world");
+	cout << a << ' ' << a.size() << ' ' << a.chunk_count() << ' ' << a.is_flat() << endl;
+
+	// コピーを伸ばしても元は変わらない
+	tork::Cord b = a;
+	b += "!";
+	cout << a << " / " << b << ' ' << b.chunk_count() << endl;
+
+	// 共有した Flat の空きは、先に伸ばしたほうだけが使う
+	tork::Cord c = a;
+	c += "?";
+	cout << c << " / " << b << ' ' << c.chunk_count() << endl;
+
+	// コピーを取りながら追加しても、チャンクは増えすぎず、コピーは変わらない
+	tork::Cord log;
+	tork::Cord snapshot;
+	std::vector<tork::Cord> kept;
+	for (int i = 0; i < 100000; ++i) {
+		log += "0123456789";
+		snapshot = log;
+		if (i % 10000 == 0) kept.push_back(log);
+	}
+	std::string log_str = log.str();
+	bool kept_ok = true;
+	for (size_t i = 0; i < kept.size(); ++i) {
+		kept_ok = kept_ok && kept[i].size() == (i * 10000 + 1) * 10
+			&& kept[i] == tork::string_view(log_str).substr(0, kept[i].size());
+	}
+	cout << log.size() << ' ' << (log.chunk_count() < 1000) << ' ' << kept_ok << endl;
+
+	// 長いコードの連結はチャンクをつなぐだけ
+	tork::Cord big;
+	for (int i = 0; i < 1000; ++i) big += "0123456789";
+	size_t big_chunks = big.chunk_count();
+	tork::Cord joined = big + a + big;
+	cout << big.size() << ' ' << big_chunks << ' ' << joined.size() << ' '
+		<< (joined.chunk_count() <= 2 * big_chunks + 1) << endl;
+	size_t shared = 0;
+	auto it = big.chunks().begin();
+	for (tork::string_view s : joined.chunks()) {
+		if (it != big.chunks().end() && s.data() == it->data()) ++shared, ++it;
+	}
+	cout << (shared == big_chunks) << endl;
+
+	// 部分コードと比較
+	tork::Cord mid = joined.substr(9995, 25);
+	cout << mid << ' ' << (mid == "56789hello, world01234567") << ' ' << (mid.compare(joined) > 0)
+		<< (tork::Cord("abc") < tork::Cord("abd")) << (joined.substr(0, 10000) == big) << endl;
+	tork::Cord tail = joined.substr(5000);
+	cout << tail.size() << ' ' << (tail.str() == joined.str().substr(5000)) << endl;
+
+	// 自分自身を連結
+	tork::Cord self = big;
+	self += self;
+	self += self;
+	cout << self.size() << ' ' << (self.substr(30000) == big) << endl;
+
+	// 必要なときだけひとつにまとめる
+	tork::string_view flat = joined.flatten();
+	cout << joined.is_flat() << ' ' << joined.chunk_count() << ' ' << (flat == tork::string_view(joined.str()))
+		<< ' ' << big.chunk_count() << endl;
+
+	// ファイルディスクリプタに書き出す
+	std::FILE* fp = std::tmpfile();
+	if (fp) {
+		tail.write_to(TORK_FILENO(fp));
+		std::rewind(fp);
+		std::string back(tail.size() + 1, '\0');
+		size_t n = std::fread(&back[0], 1, back.size(), fp);
+		back.resize(n);
+		std::fclose(fp);
+		cout << n << ' ' << (back == tail.str()) << endl;
+	}
+	try {
+		joined.substr(joined.size() + 1);
+	}
+	catch (const std::out_of_range&) {
+		cout << "out_of_range" << endl;
+	}
+
+	// 入れ子が深くなっても並べ直される
+	tork::Cord deep;
+	std::string model;
+	for (int i = 0; i < 200; ++i) {
+		tork::Cord piece(std::string(300 + i, static_cast<char>('a' + i % 26)));
+		deep = piece + deep.substr(i % 7);
+		model = piece.str() + model.substr(i % 7);
+	}
+	cout << (deep.str() == model) << endl;
+
+	bool ok = true;
+	for (unsigned seed = 0; seed < 20; ++seed) ok = ok && Fuzz(seed);
+	cout << "fuzz " << ok << endl;
+}
+
+void Bench_Cord()
+{
+	cout << "*** bench Cord ***" << endl;
+
+	// 断片を 10^6 個追加
+	auto fragments = MakeFragments(1000000);
+	auto t = Clock::now();
+	std::string s;
+	for (const auto& f : fragments) s += f;
+	double string_ms = Millis(t);
+	t = Clock::now();
+	tork::Cord c;
+	for (const auto& f : fragments) c += f;
+	double cord_ms = Millis(t);
+	cout << "append 10^6 fragments: std::string " << string_ms << " ms, Cord " << cord_ms << " ms ("
+		<< (s.size() == c.size()) << ")" << endl;
+
+	// 断片から作った節を応答にまとめる
+	// std::string は節の中身を毎回コピーし、Cord はチャンクをつなぐ
+	const size_t sections = 1000;
+	const size_t per_section = fragments.size() / sections;
+	std::vector<std::string> string_sections;
+	std::vector<tork::Cord> cord_sections;
+	for (size_t i = 0; i < sections; ++i) {
+		std::string ss;
+		tork::Cord cs;
+		for (size_t k = 0; k < per_section; ++k) {
+			ss += fragments[i * per_section + k];
+			cs += fragments[i * per_section + k];
+		}
+		string_sections.push_back(ss);
+		cord_sections.push_back(cs);
+	}
+	t = Clock::now();
+	size_t total = 0;
+	for (int rep = 0; rep < 10; ++rep) {
+		std::string response;
+		for (const auto& sec : string_sections) response += sec;
+		total += response.size();
+	}
+	string_ms = Millis(t);
+	t = Clock::now();
+	size_t total2 = 0;
+	for (int rep = 0; rep < 10; ++rep) {
+		tork::Cord response;
+		for (const auto& sec : cord_sections) response += sec;
+		total2 += response.size();
+	}
+	cord_ms = Millis(t);
+	cout << "join " << sections << " sections x 10: std::string " << string_ms << " ms, Cord " << cord_ms
+		<< " ms (" << (total == total2) << ")" << endl;
+
+	// コピーを取りながら短い断片を追加
+	t = Clock::now();
+	{
+		tork::Cord log;
+		tork::Cord snapshot;
+		for (int i = 0; i < 200000; ++i) {
+			log += "0123456789";
+			snapshot = log;
+		}
+		cout << "append 2*10^5 x 10 bytes with a snapshot each time: " << Millis(t) << " ms, "
+			<< log.chunk_count() << " chunks" << endl;
+	}
+
+	// 連続した文字列が必要なときの flatten
+	t = Clock::now();
+	tork::string_view v = c.flatten();
+	cout << "flatten " << v.size() << " bytes: " << Millis(t) << " ms" << endl;
+}
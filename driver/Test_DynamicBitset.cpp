@@ -0,0 +1,142 @@
+﻿#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <tork/container/DynamicBitset.h>
+
+using std::cout;
+using std::endl;
+using tork::DynamicBitset;
+using tork::RankSelectIndex;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double Millis(Clock::time_point begin)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+}   // anonymous namespace
+
+void Test_DynamicBitset()
+{
+	cout << "*** test DynamicBitset ***" << endl;
+
+	DynamicBitset a("1010011");
+	DynamicBitset b("0110110");
+	cout << a.to_string() << ' ' << a.count() << ' ' << a.find_first() << ' ' << a.find_next(2) << endl;
+	cout << (a & b).to_string() << ' ' << (a | b).to_string() << ' ' << (a ^ b).to_string()
+		<< ' ' << DynamicBitset(a).and_not(b).to_string() << ' ' << (~a).to_string() << endl;
+
+	a.resize(70, true);
+	cout << a.count() << ' ' << a.test(69) << ' ' << a.find_next(6) << ' ' << a.all() << endl;
+	a.set();
+	cout << a.all() << ' ' << a.count() << endl;
+	a.push_back(false);
+	cout << a.size() << ' ' << a.all() << ' ' << a.find_next(69) << endl;
+
+	// 縮めると余ったワードも消える
+	DynamicBitset shrink(1000, true);
+	shrink.resize(10);
+	cout << shrink.num_words() << ' ' << shrink.count() << ' ' << (shrink == DynamicBitset(10, true)) << endl;
+
+	try {
+		a &= b;
+	}
+	catch (std::invalid_argument& e) {
+		cout << e.what() << endl;
+	}
+
+	// rank / select を vector<bool> と突き合わせる
+	std::mt19937 rng(1);
+	bool ok = true;
+	for (int round = 0; round < 20; ++round) {
+		size_t n = rng() % 5000;
+		DynamicBitset bits(n);
+		std::vector<bool> ref(n);
+		unsigned density = rng() % 100;
+		for (size_t i = 0; i < n; ++i) {
+			if (rng() % 100 < density) {
+				bits.set(i);
+				ref[i] = true;
+			}
+		}
+		RankSelectIndex idx(bits);
+		size_t ones = 0;
+		for (size_t i = 0; i <= n; ++i) {
+			if (idx.rank1(i) != ones) ok = false;
+			if (i < n && ref[i]) {
+				if (idx.select1(ones) != i) ok = false;
+				++ones;
+			}
+		}
+		if (idx.select1(ones) != DynamicBitset::npos || idx.count() != bits.count()) ok = false;
+
+		size_t found = 0;
+		for (size_t i = bits.find_first(); i != DynamicBitset::npos; i = bits.find_next(i)) {
+			if (!ref[i]) ok = false;
+			++found;
+		}
+		if (found != ones) ok = false;
+	}
+	cout << "rank/select " << (ok ? "ok" : "NG") << endl;
+}
+
+void Bench_DynamicBitset()
+{
+	cout << "*** bench DynamicBitset vs std::vector<bool> ***" << endl;
+
+	const size_t n = 1 << 26;
+	std::mt19937 rng(1);
+	DynamicBitset a(n), b(n);
+	std::vector<bool> va(n), vb(n);
+	for (size_t i = 0; i < n; ++i) {
+		unsigned r = rng();
+		if (r & 1) { a.set(i); va[i] = true; }
+		if (r & 2) { b.set(i); vb[i] = true; }
+	}
+
+	auto t = Clock::now();
+	size_t c1 = a.count();
+	double bitset_count = Millis(t);
+	t = Clock::now();
+	size_t c2 = 0;
+	for (size_t i = 0; i < n; ++i) c2 += va[i];
+	double vector_count = Millis(t);
+	cout << "count:     DynamicBitset " << bitset_count << " ms, vector<bool> " << vector_count
+		<< " ms (" << (c1 == c2) << ')' << endl;
+
+	t = Clock::now();
+	a &= b;
+	double bitset_and = Millis(t);
+	t = Clock::now();
+	for (size_t i = 0; i < n; ++i) va[i] = va[i] && vb[i];
+	double vector_and = Millis(t);
+	cout << "and:       DynamicBitset " << bitset_and << " ms, vector<bool> " << vector_and << " ms" << endl;
+
+	t = Clock::now();
+	size_t s1 = 0;
+	for (size_t i = a.find_first(); i != DynamicBitset::npos; i = a.find_next(i)) s1 += i;
+	double bitset_scan = Millis(t);
+	t = Clock::now();
+	size_t s2 = 0;
+	for (size_t i = 0; i < n; ++i) if (va[i]) s2 += i;
+	double vector_scan = Millis(t);
+	t = Clock::now();
+	size_t s3 = 0;
+	a.for_each_set([&s3](size_t i) { s3 += i; });
+	double bitset_each = Millis(t);
+	cout << "scan:      DynamicBitset find_next " << bitset_scan << " ms, for_each_set " << bitset_each
+		<< " ms, vector<bool> " << vector_scan << " ms (" << (s1 == s2 && s1 == s3) << ')' << endl;
+
+	t = Clock::now();
+	RankSelectIndex idx(a);
+	double build = Millis(t);
+	t = Clock::now();
+	size_t r = 0;
+	for (size_t i = 0; i < 10000000; ++i) r += idx.rank1(rng() % n);
+	double rank = Millis(t);
+	cout << "rank index: build " << build << " ms, 10^7 rank1 " << rank << " ms (" << (r != 0) << ')' << endl;
+}
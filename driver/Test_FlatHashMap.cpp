@@ -0,0 +1,169 @@
+﻿#include <iostream>
+#include <string>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <unordered_map>
+#include <tork/container/FlatHashMap.h>
+
+using std::cout;
+using std::endl;
+using tork::FlatHashMap;
+
+namespace {
+
+// 挿入、検索（ヒット／ミス）、削除の時間を計る
+template<class Map>
+void MeasureMap(const char* name, const std::vector<unsigned long long>& keys)
+{
+	using Clock = std::chrono::steady_clock;
+	auto ms = [](Clock::time_point a, Clock::time_point b) {
+		return std::chrono::duration<double, std::milli>(b - a).count();
+	};
+	size_t n = keys.size() / 2;     // 後半は検索ミス用
+
+	Map m;
+	auto t0 = Clock::now();
+	for (size_t i = 0; i < n; ++i) {
+		m[keys[i]] = i;
+	}
+	auto t1 = Clock::now();
+	size_t hit = 0;
+	for (size_t i = 0; i < n; ++i) {
+		hit += m.count(keys[i]);
+	}
+	auto t2 = Clock::now();
+	size_t miss = 0;
+	for (size_t i = n; i < keys.size(); ++i) {
+		miss += m.count(keys[i]);
+	}
+	auto t3 = Clock::now();
+	for (size_t i = 0; i < n; ++i) {
+		m.erase(keys[i]);
+	}
+	auto t4 = Clock::now();
+
+	cout << "  " << name << ": insert " << ms(t0, t1) << " ms, find hit " << ms(t1, t2)
+		<< " ms, find miss " << ms(t2, t3) << " ms, erase " << ms(t3, t4) << " ms"
+		<< " (" << hit << '/' << miss << '/' << m.size() << ')' << endl;
+}
+
+// stride 間隔のキーを n 個入れて全部探す時間
+double InsertFindStride(size_t n, unsigned long long stride, bool& ok)
+{
+	auto t = std::chrono::steady_clock::now();
+	FlatHashMap<unsigned long long, size_t> m;
+	for (size_t i = 0; i < n; ++i) {
+		m[i * stride] = i;
+	}
+	size_t hit = 0;
+	for (size_t i = 0; i < n; ++i) {
+		auto it = m.find(i * stride);
+		if (it != m.end() && it->second == i) ++hit;
+	}
+	ok = m.size() == n && hit == n && m.count(n * stride) == 0;
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+}
+
+}   // anonymous namespace
+
+void Test_FlatHashMap()
+{
+	cout << "*** test FlatHashMap ***" << endl;
+
+	FlatHashMap<std::string, int> m = { { "one", 1 }, { "two", 2 }, { "three", 3 } };
+	m["four"] = 4;
+	m.insert(std::make_pair(std::string("one"), 100));     // 既にあるので挿入されない
+	m.insert_or_assign("two", 20);
+	cout << m.size() << ' ' << m["one"] << ' ' << m.at("two") << ' ' << m.count("five") << endl;
+
+	try {
+		m.at("five");
+	}
+	catch (std::out_of_range& e) {
+		cout << e.what() << endl;
+	}
+
+	// 削除と再挿入を繰り返しても削除済みスロットが溜まり続けない
+	FlatHashMap<int, int> a;
+	for (int i = 0; i < 1000; ++i) {
+		a[i] = i * 2;
+	}
+	size_t cap = a.capacity();
+	for (int round = 0; round < 100; ++round) {
+		for (int i = 0; i < 500; ++i) {
+			a.erase(i + round * 500);
+		}
+		for (int i = 0; i < 500; ++i) {
+			a[i + (round + 2) * 500] = i;
+		}
+	}
+	cout << a.size() << ' ' << (a.capacity() == cap) << ' ' << a.load_factor() << endl;
+
+	long long sum = 0;
+	for (auto it = a.begin(); it != a.end(); ) {
+		if (it->first % 2) {
+			it = a.erase(it);
+		}
+		else {
+			sum += it->first;
+			++it;
+		}
+	}
+	cout << a.size() << ' ' << sum << endl;
+
+	// 負荷率の変更と予約
+	FlatHashMap<int, int> b;
+	b.max_load_factor(0.5f);
+	b.reserve(100);
+	cap = b.capacity();
+	for (int i = 0; i < 100; ++i) {
+		b.try_emplace(i, i);
+	}
+	cout << (b.capacity() == cap) << ' ' << b.max_load_factor() << endl;
+	b.clear();
+	b.rehash(0);
+	cout << b.size() << ' ' << b.capacity() << endl;
+
+	// 下位ビットがそろったキー（アラインされたポインタなど）も偏らない
+	// 偏ると 1 間隔のキーより何百倍も遅くなる
+	bool ok1 = false, ok2 = false, ok3 = false;
+	double seq = InsertFindStride(200000, 1, ok1);
+	double aligned = InsertFindStride(200000, 4096, ok2);
+	InsertFindStride(200000, 1ULL << 32, ok3);
+	std::vector<int> objects(1000);
+	FlatHashMap<const int*, int> ptrs;
+	for (auto& obj : objects) {
+		ptrs[&obj] = static_cast<int>(&obj - &objects[0]);
+	}
+	bool ptr_ok = ptrs.size() == objects.size() && ptrs[&objects[500]] == 500;
+	cout << ok1 << ok2 << ok3 << ptr_ok << ' ' << (aligned < seq * 10 + 10) << endl;
+}
+
+void Bench_FlatHashMap()
+{
+	cout << "*** bench FlatHashMap vs std::unordered_map ***" << endl;
+
+	// 32ビット環境ではアドレス空間が足りないので 10^7 まで
+	const size_t max_n = sizeof(void*) >= 8 ? 100000000 : 10000000;
+
+	for (size_t n = 1000; n <= max_n; n *= 10) {
+		std::mt19937_64 rng(static_cast<unsigned long long>(n));
+		std::vector<unsigned long long> keys(n * 2);
+		for (auto& k : keys) {
+			k = rng();
+		}
+
+		cout << "n = " << n << endl;
+		MeasureMap<FlatHashMap<unsigned long long, size_t>>("FlatHashMap       ", keys);
+		MeasureMap<std::unordered_map<unsigned long long, size_t>>("std::unordered_map", keys);
+	}
+
+	// 下位ビットがそろったキー
+	const unsigned long long strides[] = { 1, 256, 4096 };
+	for (auto stride : strides) {
+		bool ok = false;
+		double ms = InsertFindStride(200000, stride, ok);
+		cout << "stride " << stride << ": insert + find 200000 keys " << ms << " ms (" << ok << ')' << endl;
+	}
+}
@@ -0,0 +1,112 @@
+﻿#include <iostream>
+#include <string>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <tork/container/FlatMap.h>
+
+using std::cout;
+using std::endl;
+using tork::FlatMap;
+using tork::FlatSet;
+
+namespace {
+
+// 全キーを引いたときの1回あたりの時間（ナノ秒）
+template<class Map>
+double MeasureLookup(const Map& m, const std::vector<unsigned>& queries)
+{
+	auto begin = std::chrono::steady_clock::now();
+	unsigned long long sum = 0;
+	for (unsigned q : queries) {
+		auto it = m.find(q);
+		if (it != m.end()) sum += it->second;
+	}
+	double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+	if (sum == 1) cout << "";   // 最適化で消されないように
+	return ns / queries.size();
+}
+
+}   // anonymous namespace
+
+void Test_FlatMap()
+{
+	cout << "*** test FlatMap, FlatSet ***" << endl;
+
+	// ソートされていない入力から。重複は最初のものが残る
+	std::vector<std::pair<int, std::string>> src = {
+		{ 5, "five" }, { 1, "one" }, { 3, "three" }, { 1, "uno" }, { 4, "four" },
+	};
+	FlatMap<int, std::string> m(src.begin(), src.end());
+	for (const auto& kv : m) {
+		cout << kv.first << ':' << kv.second << ' ';
+	}
+	cout << endl;
+
+	m[2] = "two";
+	m.insert_or_assign(5, "FIVE");
+	cout << m.size() << ' ' << m.at(2) << ' ' << m.at(5) << ' ' << m.count(6)
+		<< ' ' << m.lower_bound(0)->first << ' ' << (m.lower_bound(6) == m.end()) << endl;
+
+	// まとめて挿入（既にあるキーは元の値を残す）
+	std::vector<std::pair<int, std::string>> more = { { 9, "nine" }, { 0, "zero" }, { 3, "drei" }, { 7, "seven" } };
+	m.insert_range(more.begin(), more.end());
+	for (const auto& kv : m) {
+		cout << kv.first << ':' << kv.second << ' ';
+	}
+	cout << endl;
+
+	m.erase(3);
+	m.erase(m.begin(), m.begin() + 2);
+	cout << m.size() << ' ' << m.begin()->first << endl;
+
+	try {
+		m.at(100);
+	}
+	catch (std::out_of_range& e) {
+		cout << e.what() << endl;
+	}
+
+	FlatSet<int> s = { 8, 3, 3, 1, 8, 5 };
+	s.insert(4);
+	s.insert_range({ 2, 9, 1 });
+	for (int x : s) {
+		cout << x << ' ';
+	}
+	cout << s.contains(6) << s.contains(9) << endl;
+
+	int sorted[] = { 1, 2, 3 };
+	FlatSet<int> t(tork::sorted_unique, sorted, sorted + 3);
+	FlatSet<int, std::greater<int>> r(sorted, sorted + 3);
+	cout << (t == FlatSet<int>({ 3, 2, 1 })) << ' ' << *r.begin() << endl;
+}
+
+void Bench_FlatMap()
+{
+	cout << "*** bench FlatMap lookup vs std::map, std::unordered_map (ns/lookup) ***" << endl;
+
+	const size_t queries_count = 1000000;
+	const size_t sizes[] = { 8, 64, 512, 4096, 32768, 262144, 1000000 };
+	for (size_t n : sizes) {
+		std::mt19937 rng(static_cast<unsigned>(n));
+		std::vector<std::pair<unsigned, unsigned>> src(n);
+		for (auto& kv : src) {
+			kv.first = rng();
+			kv.second = kv.first & 0xFF;
+		}
+		std::vector<unsigned> queries(queries_count);
+		for (auto& q : queries) {
+			q = src[rng() % n].first;
+		}
+
+		FlatMap<unsigned, unsigned> fm(src.begin(), src.end());
+		std::map<unsigned, unsigned> sm(src.begin(), src.end());
+		std::unordered_map<unsigned, unsigned> um(src.begin(), src.end());
+
+		cout << "n = " << n << ": FlatMap " << MeasureLookup(fm, queries)
+			<< ", std::map " << MeasureLookup(sm, queries)
+			<< ", std::unordered_map " << MeasureLookup(um, queries) << endl;
+	}
+}
@@ -0,0 +1,112 @@
+﻿#include <iostream>
+#include <string>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <thread>
+#include <tork/container/LruCache.h>
+
+using std::cout;
+using std::endl;
+using tork::LruCache;
+using tork::CachePolicy;
+
+namespace {
+
+void ShowStats(const char* name, const tork::CacheStats& st)
+{
+	cout << name << ": hit " << st.hits << ", miss " << st.misses
+		<< ", evict " << st.evictions << endl;
+}
+
+// threads スレッドで get し、ミスしたら put する
+// 百万操作／秒とヒット率を表示する
+void MeasureCache(const char* name, CachePolicy policy, unsigned threads)
+{
+	const unsigned ops = 1000000;
+	const unsigned keys = 200000;
+	LruCache<unsigned, unsigned> cache(keys / 2, 0, policy);
+
+	auto begin = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for (unsigned t = 0; t < threads; ++t) {
+		workers.push_back(std::thread([&cache, t]() {
+			std::mt19937 rng(t + 1);
+			// 一部のキーに偏ったアクセス
+			std::exponential_distribution<double> dist(1.0 / (keys / 8));
+			for (unsigned i = 0; i < ops; ++i) {
+				unsigned key = static_cast<unsigned>(dist(rng)) % keys;
+				if (!cache.get(key)) {
+					cache.put(key, tork::make_shared<unsigned>(key));
+				}
+			}
+		}));
+	}
+	for (auto& w : workers) {
+		w.join();
+	}
+	double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	tork::CacheStats st = cache.stats();
+	cout << "  " << name << ' ' << threads << " threads: "
+		<< static_cast<double>(ops) * threads / sec / 1e6 << " Mops/s, hit "
+		<< st.hits * 100.0 / (st.hits + st.misses) << " %" << endl;
+}
+
+}   // anonymous namespace
+
+void Test_LruCache()
+{
+	cout << "*** test LruCache ***" << endl;
+
+	// 1シャード、重みは文字列の長さ
+	LruCache<int, std::string> c(10, 1, CachePolicy::Lru,
+		[](int, const std::string& s) { return s.size(); });
+	c.put(1, tork::make_shared<std::string>("aaa"));
+	c.put(2, tork::make_shared<std::string>("bbb"));
+	c.put(3, tork::make_shared<std::string>("ccc"));
+	auto one = c.get(1);                // 1 が最新になる
+	c.put(4, tork::make_shared<std::string>("dd"));    // 2 が追い出される
+	cout << c.size() << ' ' << c.weight() << ' ' << !c.get(2) << ' ' << *one << endl;
+
+	// 追い出されても取り出した値は使える
+	c.put(5, tork::make_shared<std::string>("eeeeeeeeee"));
+	cout << c.size() << ' ' << *one << endl;
+
+	// 容量を超える値は入らない
+	c.put(6, tork::make_shared<std::string>("ffffffffffff"));
+	cout << c.size() << ' ' << !c.get(6) << endl;
+	ShowStats("LRU", c.stats());
+
+	// CLOCK：参照ビットの立った要素は1回見逃される
+	LruCache<int, int> k(3, 1, CachePolicy::Clock);
+	k.put(1, tork::make_shared<int>(1));
+	k.put(2, tork::make_shared<int>(2));
+	k.put(3, tork::make_shared<int>(3));
+	k.get(1);
+	k.put(4, tork::make_shared<int>(4));    // 1 は見逃され、2 が追い出される
+	cout << !!k.get(1) << !!k.get(2) << !!k.get(3) << !!k.get(4) << endl;
+	ShowStats("CLOCK", k.stats());
+	k.reset_stats();
+	k.erase(1);
+	k.clear();
+	cout << k.size() << ' ' << k.stats().hits << endl;
+
+	// シャード数を省略しても、小さい容量がシャードに細切れにならない
+	LruCache<int, std::string> small(10, 0, CachePolicy::Lru,
+		[](int, const std::string& s) { return s.size(); });
+	small.put(1, tork::make_shared<std::string>("ggggggggg"));
+	LruCache<int, int> large(100000);
+	size_t per_shard = 100000 / large.shard_count();
+	cout << small.shard_count() << ' ' << !!small.get(1) << ' '
+		<< (per_shard >= LruCache<int, int>::MinShardCapacity) << endl;
+}
+
+void Bench_LruCache()
+{
+	cout << "*** bench LruCache LRU vs CLOCK ***" << endl;
+	for (unsigned threads = 1; threads <= 16; threads *= 2) {
+		MeasureCache("LRU  ", CachePolicy::Lru, threads);
+		MeasureCache("CLOCK", CachePolicy::Clock, threads);
+	}
+}
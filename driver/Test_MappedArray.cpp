@@ -0,0 +1,68 @@
+﻿#include <iostream>
+#include <cstdio>
+#include <numeric>
+#include <tork/container/MappedArray.h>
+
+using std::cout;
+using std::endl;
+using tork::MappedArray;
+using tork::MapMode;
+using tork::MapAdvice;
+
+namespace {
+
+struct Entry {
+	int key;
+	double value;
+};
+
+}   // anonymous namespace
+
+void Test_MappedArray()
+{
+	cout << "*** test MappedArray ***" << endl;
+
+	const char* path = "mapped_array_test.bin";
+
+	// 作成して書き込む
+	{
+		MappedArray<Entry> a;
+		a.create(path, 10);
+		for (size_t i = 0; i < a.size(); ++i) {
+			a[i].key = static_cast<int>(i);
+			a[i].value = i * 1.5;
+		}
+		a.resize(20);
+		a.back().key = 999;
+		a.flush();
+		cout << a.size() << endl;
+	}
+
+	// 読み取り専用で開く
+	{
+		MappedArray<Entry> a(path);
+		a.advise(MapAdvice::Sequential);
+		for (const auto& e : a) {
+			cout << e.key << ':' << e.value << ' ';
+		}
+		cout << endl;
+	}
+
+	// コピーオンライトで開くと、書き込みはファイルに反映されない
+	{
+		MappedArray<Entry> a(path, MapMode::CopyOnWrite);
+		a[0].key = -1;
+		MappedArray<Entry> b(path);
+		cout << a[0].key << ' ' << b[0].key << endl;
+	}
+
+	// 開けないファイル
+	try {
+		MappedArray<int> a("no_such_file.bin");
+	}
+	catch (const tork::MappedFileError& e) {
+		cout << e.what() << endl;
+	}
+
+	std::remove(path);
+}
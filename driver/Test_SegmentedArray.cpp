@@ -0,0 +1,103 @@
+﻿#include <iostream>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <tork/container/SegmentedArray.h>
+#include <tork/container/Array.h>
+
+using std::cout;
+using std::endl;
+using tork::SegmentedArray;
+
+namespace {
+
+// push_back の所要時間を2の冪のバケットで数える
+template<class C>
+void MeasurePushBack(const char* name, C& c, size_t n)
+{
+	using Clock = std::chrono::steady_clock;
+	size_t buckets[64] = {};
+	long long worst = 0;
+
+	auto begin = Clock::now();
+	for (size_t i = 0; i < n; ++i) {
+		auto start = Clock::now();
+		c.push_back(static_cast<int>(i));
+		long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				Clock::now() - start).count();
+		if (ns > worst) worst = ns;
+		int b = 0;
+		while ((1LL << b) < ns && b < 63) ++b;
+		++buckets[b];
+	}
+	double total = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+	// 99.9 パーセンタイル、99.999 パーセンタイルを含むバケットの上限
+	auto percentile = [&](double p) {
+		size_t target = static_cast<size_t>(n * p);
+		size_t acc = 0;
+		for (int b = 0; b < 64; ++b) {
+			acc += buckets[b];
+			if (acc >= target) return 1LL << b;
+		}
+		return worst;
+	};
+	cout << name << ": total " << total << " ms, p99.9 <= " << percentile(0.999)
+		<< " ns, p99.999 <= " << percentile(0.99999) << " ns, max " << worst << " ns" << endl;
+}
+
+}   // anonymous namespace
+
+void Test_SegmentedArray()
+{
+	cout << "*** test SegmentedArray ***" << endl;
+
+	SegmentedArray<std::string, 2> a;
+	for (int i = 0; i < 10; ++i) {
+		a.push_back(std::to_string(i));
+	}
+
+	// 伸長しても要素のアドレスは変わらない
+	std::string* p = &a[3];
+	for (int i = 0; i < 100; ++i) {
+		a.emplace_back("x");
+	}
+	cout << (p == &a[3]) << ' ' << *p << endl;
+	cout << a.size() << ' ' << a.chunk_count() << ' ' << a.capacity() << endl;
+
+	a.resize(6);
+	a.shrink_to_fit();
+	for (const auto& s : a) {
+		cout << s << ' ';
+	}
+	cout << endl;
+	cout << a.capacity() << endl;
+
+	// チャンクごとの並列処理
+	SegmentedArray<int, 8> b(10000, 1);
+	std::atomic<long> sum(0);
+	b.parallel_for_each_chunk([&sum](tork::span<int> chunk, size_t) {
+		long s = 0;
+		for (int v : chunk) s += v;
+		sum += s;
+	});
+	cout << sum << endl;
+}
+
+// push_back のテールレイテンシを Array と比べる
+void Bench_SegmentedArray()
+{
+	cout << "*** bench SegmentedArray push_back latency ***" << endl;
+
+	// 32bit では Array の再確保が収まらないので要素数を減らす
+	const size_t n = sizeof(void*) >= 8 ? 100000000 : 10000000;
+
+	{
+		tork::Array<int> a;
+		MeasurePushBack("Array         ", a, n);
+	}
+	{
+		SegmentedArray<int> s;
+		MeasurePushBack("SegmentedArray", s, n);
+	}
+}
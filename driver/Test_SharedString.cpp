@@ -0,0 +1,133 @@
+﻿#include <iostream>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <tork/container/SharedString.h>
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double Millis(Clock::time_point begin)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+// パイプラインの段を通すように、コピーを次々に渡す
+template<class String>
+size_t PassThrough(const std::vector<String>& input, int hops)
+{
+	size_t total = 0;
+	for (const auto& s : input) {
+		String cur = s;
+		for (int h = 0; h < hops; ++h) {
+			String next = cur;
+			cur = next;
+		}
+		total += cur.size();
+	}
+	return total;
+}
+
+}   // anonymous namespace
+
+void Test_SharedString()
+{
+	cout << "*** test SharedString ***" << endl;
+
+	tork::SharedString empty;
+	tork::SharedString small("hello");
+	tork::SharedString exact(std::string(23, 'a'));
+	tork::SharedString large("the quick brown fox jumps over the lazy dog");
+	cout << sizeof(tork::SharedString) << ' ' << empty.empty() << ' ' << small << ' ' << small.size() << ' '
+		<< small.is_shared() << ' ' << exact.is_shared() << ' ' << large.is_shared() << ' ' << large.use_count() << endl;
+
+	// コピーはバッファを共有する
+	tork::SharedString copy = large;
+	cout << (copy.data() == large.data()) << ' ' << large.use_count() << endl;
+	{
+		tork::SharedString tail = large.substr(4);
+		cout << tail << ' ' << (tail.data() == large.data() + 4) << ' ' << large.use_count() << endl;
+		tork::SharedString word = large.substr(4, 5);
+		cout << word << ' ' << word.is_shared() << ' ' << large.use_count() << endl;
+		copy = tail.substr(6);
+		cout << copy << ' ' << large.use_count() << endl;
+	}
+	cout << large.use_count() << endl;
+
+	// ムーブと入れ替え
+	tork::SharedString moved = std::move(copy);
+	cout << moved << " [" << copy << "] " << large.use_count() << endl;
+	swap(moved, small);
+	cout << moved << ' ' << small << endl;
+
+	// 比較とハッシュ
+	cout << (small == large.substr(10)) << (tork::SharedString("abc") < tork::SharedString("abd"))
+		<< (moved == "hello") << (moved == std::string("hello")) << (moved != tork::string_view("help")) << endl;
+	std::unordered_set<tork::SharedString> set;
+	set.insert(large);
+	set.insert(large.substr(0));
+	set.insert(tork::SharedString("hello"));
+	cout << set.size() << ' ' << set.count(tork::SharedString("hello")) << endl;
+	try {
+		large.substr(100);
+	}
+	catch (const std::out_of_range&) {
+		cout << "out_of_range" << endl;
+	}
+
+	// 複数スレッドでコピーと破棄をしても参照カウントが合う
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([&] {
+			for (int i = 0; i < 100000; ++i) {
+				tork::SharedString c = large;
+				tork::SharedString s = c.substr(i % 10);
+			}
+		});
+	}
+	for (auto& th : threads) th.join();
+	cout << large.use_count() << endl;
+}
+
+void Bench_SharedString()
+{
+	cout << "*** bench SharedString ***" << endl;
+
+	const int hops = 8;
+	const size_t lengths[] = { 10, 40, 200 };
+	for (size_t len : lengths) {
+		std::vector<std::string> strings;
+		std::vector<tork::SharedString> shared;
+		for (int i = 0; i < 1000000; ++i) {
+			std::string s(len, static_cast<char>('a' + i % 26));
+			strings.push_back(s);
+			shared.push_back(tork::SharedString(s));
+		}
+		auto t = Clock::now();
+		size_t a = PassThrough(strings, hops);
+		double string_ms = Millis(t);
+		t = Clock::now();
+		size_t b = PassThrough(shared, hops);
+		double shared_ms = Millis(t);
+
+		// 部分文字列
+		t = Clock::now();
+		size_t c = 0;
+		for (const auto& s : strings) c += s.substr(len / 4).size();
+		double string_substr_ms = Millis(t);
+		t = Clock::now();
+		size_t d = 0;
+		for (const auto& s : shared) d += s.substr(len / 4).size();
+		double shared_substr_ms = Millis(t);
+
+		cout << "length " << len << ", " << hops << " hops: std::string " << string_ms << " ms, SharedString "
+			<< shared_ms << " ms / substr: std::string " << string_substr_ms << " ms, SharedString "
+			<< shared_substr_ms << " ms (" << (a == b) << (c == d) << ")" << endl;
+	}
+}
@@ -0,0 +1,100 @@
+﻿#include <iostream>
+#include <string>
+#include <chrono>
+#include <tork/container/SoAArray.h>
+#include <tork/container/Array.h>
+
+using std::cout;
+using std::endl;
+using tork::SoAArray;
+
+namespace {
+
+// 配列構造体側のレコード
+struct Record {
+	float x;
+	float y;
+	float z;
+	int id;
+};
+
+}   // anonymous namespace
+
+void Test_SoAArray()
+{
+	cout << "*** test SoAArray ***" << endl;
+
+	SoAArray<int, double, std::string> a;
+	for (int i = 0; i < 10; ++i) {
+		a.push_back(i, i * 0.5, std::to_string(i));
+	}
+	a.emplace_back(100, 1.5, "hundred");
+	cout << a.size() << ' ' << a.capacity() << endl;
+
+	// 行はフィールドへの参照のタプル
+	for (auto row : a) {
+		std::get<1>(row) *= 2;
+		cout << std::get<0>(row) << ':' << std::get<1>(row) << ':'
+			<< std::get<2>(row) << ' ';
+	}
+	cout << endl;
+
+	// 列ごとのアクセス
+	tork::span<const int> ids = a.column<0>();
+	int sum = 0;
+	for (int id : ids) sum += id;
+	cout << "sum of ids: " << sum << endl;
+	cout << "aligned: " << (reinterpret_cast<uintptr_t>(a.data<1>()) % a.alignment == 0) << endl;
+
+	SoAArray<int, double, std::string> b = a;
+	b.resize(3);
+	b.resize(5, std::make_tuple(-1, -1.0, std::string("new")));
+	for (size_t i = 0; i < b.size(); ++i) {
+		cout << b.get<2>(i) << ' ';
+	}
+	cout << endl;
+}
+
+// 1フィールドの合計を配列構造体と構造体配列で比べる
+void Bench_SoAArray()
+{
+	cout << "*** bench SoAArray field sum (AoS vs SoA) ***" << endl;
+
+	// 32bit ではアドレス空間に収まらないので行数を減らす
+	const size_t rows = sizeof(void*) >= 8 ? 100000000 : 10000000;
+	using Clock = std::chrono::steady_clock;
+
+	{
+		tork::Array<Record> aos;
+		aos.reserve(rows);
+		for (size_t i = 0; i < rows; ++i) {
+			Record r = { float(i & 0xff), 1.0f, 2.0f, int(i) };
+			aos.push_back(r);
+		}
+
+		auto start = Clock::now();
+		double sum = 0;
+		for (size_t i = 0; i < aos.size(); ++i) {
+			sum += aos[i].x;
+		}
+		double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		cout << "AoS: " << ms << " ms (sum " << sum << ")" << endl;
+	}
+
+	{
+		SoAArray<float, float, float, int> soa;
+		soa.reserve(rows);
+		for (size_t i = 0; i < rows; ++i) {
+			soa.push_back(float(i & 0xff), 1.0f, 2.0f, int(i));
+		}
+
+		auto start = Clock::now();
+		double sum = 0;
+		tork::span<const float> xs = soa.column<0>();
+		for (size_t i = 0; i < xs.size(); ++i) {
+			sum += xs[i];
+		}
+		double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		cout << "SoA: " << ms << " ms (sum " << sum << ")" << endl;
+	}
+}
@@ -0,0 +1,252 @@
+﻿#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <tork/container/StringPool.h>
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double Millis(Clock::time_point begin)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+// 確保したバイト数を数えるアロケータ
+size_t allocated_bytes = 0;
+
+template<class T>
+struct CountingAllocator {
+	typedef T value_type;
+	CountingAllocator() { }
+	template<class U> CountingAllocator(const CountingAllocator<U>&) { }
+	T* allocate(size_t n)
+	{
+		allocated_bytes += n * sizeof(T);
+		return static_cast<T*>(::operator new(n * sizeof(T)));
+	}
+	void deallocate(T* p, size_t n)
+	{
+		allocated_bytes -= n * sizeof(T);
+		::operator delete(p);
+	}
+};
+template<class T, class U>
+bool operator ==(const CountingAllocator<T>&, const CountingAllocator<U>&) { return true; }
+template<class T, class U>
+bool operator !=(const CountingAllocator<T>&, const CountingAllocator<U>&) { return false; }
+
+// この大きさの new[] を一度だけ失敗させる（0 なら失敗させない）
+std::atomic<size_t> fail_array_size(0);
+
+}   // anonymous namespace
+
+void* operator new[](size_t n)
+{
+	size_t expected = n;
+	if (n != 0 && fail_array_size.compare_exchange_strong(expected, 0)) throw std::bad_alloc();
+	void* p = std::malloc(n ? n : 1);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+void operator delete[](void* p) throw()
+{
+	std::free(p);
+}
+
+namespace {
+
+// 識別子のような文字列
+std::vector<std::string> MakeWords(size_t n, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::unordered_set<std::string> seen;
+	std::vector<std::string> words;
+	while (words.size() < n) {
+		std::string w = "key_";
+		size_t len = 4 + rng() % 20;
+		for (size_t i = 0; i < len; ++i) w += static_cast<char>('a' + rng() % 26);
+		if (seen.insert(w).second) words.push_back(w);
+	}
+	return words;
+}
+
+}   // anonymous namespace
+
+void Test_StringPool()
+{
+	cout << "*** test StringPool ***" << endl;
+
+	tork::StringPool pool(4);
+	tork::StringPool::id_type a = pool.intern("apple");
+	tork::StringPool::id_type b = pool.intern(std::string("banana"));
+	tork::StringPool::id_type a2 = pool.intern(tork::string_view("apple pie", 5));
+	tork::StringPool::id_type e = pool.intern("");
+	cout << a << ' ' << b << ' ' << a2 << ' ' << e << ' ' << pool.size() << ' '
+		<< pool.view(b) << ' ' << pool.view(e).empty() << ' ' << pool.view(a).data()[5] + 0 << endl;
+	cout << pool.find("banana") << ' ' << (pool.find("cherry") == tork::StringPool::npos) << endl;
+	try {
+		pool.at(100);
+	}
+	catch (const std::out_of_range&) {
+		cout << "out_of_range" << endl;
+	}
+
+	// 大量に登録しても ID は連番、ビューは動かない
+	std::vector<std::string> words = MakeWords(20000, 1);
+	words.push_back(std::string(100000, 'x'));      // ブロックより大きい文字列
+	std::vector<tork::StringPool::id_type> ids;
+	const char* first_data = pool.view(a).data();
+	for (const auto& w : words) ids.push_back(pool.intern(w));
+	bool ok = pool.view(a).data() == first_data && pool.size() == words.size() + 3;
+	for (size_t i = 0; i < words.size(); ++i) {
+		ok = ok && ids[i] == i + 3 && pool.view(ids[i]) == words[i] && pool.find(words[i]) == ids[i];
+	}
+	cout << ok << endl;
+
+	// ID を入れるセグメントを確保できなくても、後の登録は止まらない
+	// シャードを 1 つにして、2 番目のセグメント（2048 個）を確保するときだけ失敗させる
+	tork::StringPool failing(1);
+	std::vector<std::string> spare = MakeWords(1025, 6);
+	for (size_t i = 0; i < 1024; ++i) failing.intern(spare[i]);
+	fail_array_size = 2048 * sizeof(const char*);
+	try {
+		failing.intern(spare[1024]);
+	}
+	catch (const std::bad_alloc&) {
+		cout << "bad_alloc ";
+	}
+	fail_array_size = 0;
+	tork::StringPool::id_type retried = tork::StringPool::npos;
+	std::thread other([&] { retried = failing.intern(spare[1024]); });
+	other.join();
+	cout << failing.size() << ' ' << retried << ' ' << (failing.view(retried) == spare[1024]) << endl;
+
+	// 複数スレッドから同じ文字列を登録しても、ID は 1 つ
+	tork::StringPool shared;
+	std::vector<std::string> common = MakeWords(5000, 2);
+	std::vector<std::vector<tork::StringPool::id_type>> results(4);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([&, t] {
+			std::mt19937 rng(t);
+			std::vector<size_t> order(common.size());
+			for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+			std::shuffle(order.begin(), order.end(), rng);
+			results[t].resize(common.size());
+			for (size_t i : order) results[t][i] = shared.intern(common[i]);
+		});
+	}
+	for (auto& th : threads) th.join();
+	bool same = shared.size() == common.size();
+	for (size_t i = 0; i < common.size(); ++i) {
+		for (int t = 1; t < 4; ++t) same = same && results[t][i] == results[0][i];
+		same = same && results[0][i] < common.size() && shared.view(results[0][i]) == common[i];
+	}
+	cout << same << endl;
+
+	// 登録している途中でも、size() より小さい ID は読める
+	tork::StringPool growing;
+	std::vector<std::string> more = MakeWords(20000, 5);
+	std::atomic<int> writers(2);
+	std::atomic<bool> readable(true);
+	std::vector<std::thread> workers;
+	for (int t = 0; t < 2; ++t) {
+		workers.emplace_back([&, t] {
+			for (size_t i = t; i < more.size(); i += 2) growing.intern(more[i]);
+			--writers;
+		});
+	}
+	for (int t = 0; t < 2; ++t) {
+		workers.emplace_back([&] {
+			while (writers > 0) {
+				size_t n = growing.size();
+				for (size_t id = n > 64 ? n - 64 : 0; id < n; ++id) {
+					if (growing.at(static_cast<tork::StringPool::id_type>(id)).empty()) readable = false;
+				}
+			}
+		});
+	}
+	for (auto& th : workers) th.join();
+	cout << readable << ' ' << (growing.size() == more.size()) << endl;
+}
+
+void Bench_StringPool()
+{
+	cout << "*** bench StringPool ***" << endl;
+
+	const size_t distinct = 5000;
+	const size_t lookups = 20000000;
+	std::vector<std::string> words = MakeWords(distinct, 3);
+	std::mt19937 rng(4);
+	std::vector<std::string> queries;
+	for (size_t i = 0; i < 1 << 16; ++i) queries.push_back(words[rng() % distinct]);
+	const size_t mask = (1 << 16) - 1;
+
+	// メモリ
+	tork::StringPool pool;
+	for (const auto& w : words) pool.intern(w);
+	allocated_bytes = 0;
+	typedef std::unordered_set<std::string, std::hash<std::string>, std::equal_to<std::string>,
+		CountingAllocator<std::string>> Set;
+	Set set;
+	size_t string_heap = 0;
+	for (const auto& w : words) {
+		auto it = set.insert(w).first;
+		if (it->capacity() > 15) string_heap += it->capacity() + 1;   // SSO に入らない文字列
+	}
+	cout << distinct << " strings: StringPool " << pool.memory_usage() << " bytes, unordered_set "
+		<< allocated_bytes + string_heap << " bytes (estimated)" << endl;
+
+	// 検索
+	size_t sum = 0;
+	auto t = Clock::now();
+	for (size_t i = 0; i < lookups; ++i) {
+		sum += pool.find(queries[i & mask]);
+	}
+	double pool_ms = Millis(t);
+	t = Clock::now();
+	for (size_t i = 0; i < lookups; ++i) {
+		sum += set.find(queries[i & mask])->size();
+	}
+	double set_ms = Millis(t);
+	t = Clock::now();
+	for (size_t i = 0; i < lookups; ++i) {
+		sum += pool.intern(queries[i & mask]);
+	}
+	double intern_ms = Millis(t);
+
+	// 複数スレッドからの検索
+	unsigned threads = std::thread::hardware_concurrency();
+	if (threads == 0) threads = 1;
+	std::atomic<size_t> total(0);
+	t = Clock::now();
+	{
+		std::vector<std::thread> ths;
+		for (unsigned k = 0; k < threads; ++k) {
+			ths.emplace_back([&, k] {
+				size_t local = 0;
+				for (size_t i = k; i < lookups; i += threads) local += pool.find(queries[i & mask]);
+				total += local;
+			});
+		}
+		for (auto& th : ths) th.join();
+	}
+	double mt_ms = Millis(t);
+
+	cout << lookups << " lookups: StringPool::find " << pool_ms << " ms, unordered_set::find " << set_ms
+		<< " ms, StringPool::intern (existing) " << intern_ms << " ms, find on " << threads << " threads "
+		<< mt_ms << " ms (" << sum + total << ")" << endl;
+}
@@ -0,0 +1,259 @@
+﻿#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <tork/thread/ThreadPool.h>
+
+using std::cout;
+using std::endl;
+using tork::ThreadPool;
+using tork::TaskGroup;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double Millis(Clock::time_point begin)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+// fork / join で fib
+long long Fib(ThreadPool& pool, int n)
+{
+	if (n < 20) {
+		return (n < 2) ? n : Fib(pool, n - 1) + Fib(pool, n - 2);
+	}
+	long long a, b;
+	TaskGroup group(pool);
+	group.run([&]() { a = Fib(pool, n - 1); });
+	b = Fib(pool, n - 2);
+	group.wait();
+	return a + b;
+}
+
+long long SerialFib(int n)
+{
+	return (n < 2) ? n : SerialFib(n - 1) + SerialFib(n - 2);
+}
+
+// N クイーンの解の数（cols, diag1, diag2 は使用中のビット）
+long long SerialQueens(int n, int row, unsigned cols, unsigned diag1, unsigned diag2)
+{
+	if (row == n) return 1;
+	long long count = 0;
+	unsigned free = ~(cols | diag1 | diag2) & ((1u << n) - 1);
+	while (free) {
+		unsigned bit = free & (0u - free);
+		free ^= bit;
+		count += SerialQueens(n, row + 1, cols | bit, (diag1 | bit) << 1, (diag2 | bit) >> 1);
+	}
+	return count;
+}
+
+long long Queens(ThreadPool& pool, int n, int row, unsigned cols, unsigned diag1, unsigned diag2)
+{
+	if (n - row <= 8) return SerialQueens(n, row, cols, diag1, diag2);
+	std::atomic<long long> count(0);
+	TaskGroup group(pool);
+	unsigned free = ~(cols | diag1 | diag2) & ((1u << n) - 1);
+	while (free) {
+		unsigned bit = free & (0u - free);
+		free ^= bit;
+		group.run([&, bit]() {
+			count += Queens(pool, n, row + 1, cols | bit, (diag1 | bit) << 1, (diag2 | bit) >> 1);
+		});
+	}
+	group.wait();
+	return count;
+}
+
+}   // anonymous namespace
+
+void Test_ThreadPool()
+{
+	cout << "*** test ThreadPool ***" << endl;
+
+	// Chase-Lev 両端キュー（持ち主は後入れ先出し、盗む側は先入れ先出し）
+	{
+		tork::impl::WorkStealingDeque<int> q(2);
+		int v[5] = { 0, 1, 2, 3, 4 };
+		for (auto& x : v) q.push(&x);
+		cout << q.size() << ' ' << *q.pop() << ' ' << *q.steal() << ' ' << *q.steal() << ' ' << *q.pop() << ' '
+			<< *q.pop() << ' ' << (q.pop() == nullptr) << ' ' << (q.steal() == nullptr) << endl;
+	}
+
+	// 持ち主が積んで取り出す間に、他のスレッドが盗む
+	{
+		const int n = 200000;
+		std::vector<int> items(n);
+		std::vector<std::atomic<int>> seen(n);
+		for (auto& s : seen) s = 0;
+		tork::impl::WorkStealingDeque<int> q;
+		std::atomic<bool> done(false);
+		std::vector<std::thread> thieves;
+		for (int t = 0; t < 3; ++t) {
+			thieves.emplace_back([&]() {
+				while (!done) {
+					int* p = q.steal();
+					if (p) ++seen[p - &items[0]];
+				}
+			});
+		}
+		for (int i = 0; i < n; ++i) {
+			q.push(&items[i]);
+			if (i % 3 == 0) {
+				int* p = q.pop();
+				if (p) ++seen[p - &items[0]];
+			}
+		}
+		while (int* p = q.pop()) ++seen[p - &items[0]];
+		done = true;
+		for (auto& t : thieves) t.join();
+		bool ok = true;
+		for (auto& s : seen) ok = ok && (s == 1);
+		cout << "deque: " << ok << endl;
+	}
+
+	ThreadPool pool(4);
+	cout << pool.thread_count() << ' ' << pool.current_index() << endl;
+
+	// submit
+	auto f1 = pool.submit([]() { return std::string("future"); });
+	auto f2 = pool.submit([]() { throw std::runtime_error("thrown in submit"); });
+	std::atomic<int> counter(0);
+	auto f3 = pool.submit([&]() { ++counter; });
+	cout << f1.get() << ' ' << f1.valid() << endl;
+	try {
+		f2.get();
+	}
+	catch (std::runtime_error& e) {
+		cout << e.what() << endl;
+	}
+	f3.wait();
+	cout << f3.is_ready() << ' ' << counter << endl;
+
+	// タスクの中から submit して待つ
+	auto f4 = pool.submit([&pool]() {
+		auto inner = pool.submit([]() { return 21; });
+		return inner.get() * 2;
+	});
+	cout << "nested submit: " << f4.get() << endl;
+
+	// fork / join
+	cout << "fib: " << (Fib(pool, 27) == SerialFib(27)) << endl;
+	cout << "queens: " << (Queens(pool, 11, 0, 0, 0, 0) == 2680) << endl;
+
+	// タスクグループの例外
+	{
+		TaskGroup group(pool);
+		for (int i = 0; i < 100; ++i) {
+			group.run([i]() {
+				if (i == 42) throw std::logic_error("thrown in TaskGroup");
+			});
+		}
+		try {
+			group.wait();
+		}
+		catch (std::logic_error& e) {
+			cout << e.what() << endl;
+		}
+	}
+
+	// parallel_for（入れ子を含む）
+	{
+		const int n = 1000;
+		std::vector<std::atomic<int>> hits(n * n);
+		for (auto& h : hits) h = 0;
+		pool.parallel_for(0, n, [&](int i) {
+			pool.parallel_for(0, n, [&](int j) { ++hits[i * n + j]; }, 16);
+		});
+		bool ok = true;
+		for (auto& h : hits) ok = ok && (h == 1);
+		cout << "parallel_for: " << ok << endl;
+	}
+
+	// 外部の複数スレッドから同時に投入する
+	{
+		std::atomic<int> total(0);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; ++t) {
+			threads.emplace_back([&]() {
+				TaskGroup group(pool);
+				for (int i = 0; i < 10000; ++i) {
+					group.run([&]() { ++total; });
+				}
+				group.wait();
+			});
+		}
+		for (auto& t : threads) t.join();
+		cout << "external: " << total << endl;
+	}
+
+	cout << endl;
+}
+
+void Bench_ThreadPool()
+{
+	cout << "*** bench ThreadPool ***" << endl;
+
+	unsigned hw = std::thread::hardware_concurrency();
+	if (hw == 0) hw = 1;
+
+	auto t = Clock::now();
+	long long fib_serial = SerialFib(34);
+	double fib_serial_ms = Millis(t);
+	t = Clock::now();
+	long long queens_serial = SerialQueens(13, 0, 0, 0, 0);
+	double queens_serial_ms = Millis(t);
+	cout << "serial: fib(34) " << fib_serial_ms << " ms, nqueens(13) " << queens_serial_ms << " ms" << endl;
+
+	for (unsigned threads = 1; ; threads *= 2) {
+		if (threads > hw) threads = hw;
+		ThreadPool pool(threads, true);
+
+		t = Clock::now();
+		long long fib = Fib(pool, 34);
+		double fib_ms = Millis(t);
+		t = Clock::now();
+		long long queens = Queens(pool, 13, 0, 0, 0, 0);
+		double queens_ms = Millis(t);
+		cout << threads << " threads: fib(34) " << fib_ms << " ms, nqueens(13) " << queens_ms << " ms ("
+			<< (fib == fib_serial) << (queens == queens_serial) << ')' << endl;
+
+		if (threads == hw) break;
+	}
+
+	// 過剰なスレッド数と、複数の外部スレッドからの投入
+	const int tasks = 1000000;
+	for (unsigned factor = 1; factor <= 4; factor *= 2) {
+		ThreadPool pool(hw * factor);
+		std::atomic<long long> sum(0);
+
+		t = Clock::now();
+		std::vector<std::thread> producers;
+		for (unsigned p = 0; p < hw; ++p) {
+			producers.emplace_back([&]() {
+				TaskGroup group(pool);
+				for (int i = 0; i < tasks / static_cast<int>(hw); ++i) {
+					group.run([&sum, i]() { sum.fetch_add(i, std::memory_order_relaxed); });
+				}
+				group.wait();
+			});
+		}
+		for (auto& p : producers) p.join();
+		double inject_ms = Millis(t);
+
+		t = Clock::now();
+		pool.parallel_for(0, tasks, [&sum](int i) { sum.fetch_add(i, std::memory_order_relaxed); });
+		double for_ms = Millis(t);
+
+		cout << hw * factor << " workers: " << tasks << " injected tasks " << inject_ms
+			<< " ms, parallel_for " << for_ms << " ms (" << sum << ')' << endl;
+	}
+
+	cout << endl;
+}
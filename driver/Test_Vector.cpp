@@ -0,0 +1,92 @@
+﻿#include <iostream>
+#include <chrono>
+#include <tork/container/Vector.h>
+
+using std::cout;
+using std::endl;
+using tork::Vector;
+namespace VectorCheck = tork::VectorCheck;
+
+namespace {
+
+// 添え字アクセスで合計する
+template<class V>
+long long SumByIndex(const V& v)
+{
+	long long sum = 0;
+	for (size_t i = 0; i < v.size(); ++i) {
+		sum += v[i];
+	}
+	return sum;
+}
+
+// 1回チェックしたスパンで合計する
+template<class V>
+long long SumByRange(const V& v)
+{
+	tork::span<const int> s = v.checked_range(0, v.size());
+	long long sum = 0;
+	for (size_t i = 0; i < s.size(); ++i) {
+		sum += s[i];
+	}
+	return sum;
+}
+
+template<class F>
+void Measure(const char* name, F f)
+{
+	auto start = std::chrono::steady_clock::now();
+	long long sum = 0;
+	for (int rep = 0; rep < 2000; ++rep) {
+		sum += f();
+	}
+	double ms = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+	cout << name << ": " << ms << " ms (sum " << sum << ")" << endl;
+}
+
+}   // anonymous namespace
+
+void Test_Vector()
+{
+	cout << "*** test Vector ***" << endl;
+
+	Vector<int> v(5, 1);
+	try {
+		v[5] = 0;
+	}
+	catch (const tork::OutOfRangeError& e) {
+		cout << "out of range: " << e.index << endl;
+	}
+
+	Vector<int, std::allocator<int>, VectorCheck::PerRange> r(10, 2);
+	tork::span<int> s = r.checked_range(2, 5);
+	for (auto& x : s) x = 7;
+	for (size_t i = 0; i < r.size(); ++i) {
+		cout << r[i] << ' ';
+	}
+	cout << endl;
+
+	try {
+		r.checked_range(8, 5);
+	}
+	catch (const tork::OutOfRangeError& e) {
+		cout << "out of range: " << e.index << endl;
+	}
+}
+
+// チェック方法ごとのループ速度
+void Bench_Vector_check()
+{
+	cout << "*** bench Vector range check ***" << endl;
+
+	// メモリ帯域ではなくループ自体の速さを見るため、キャッシュに収まる大きさにする
+	const size_t n = 1 << 16;
+	Vector<int> always(n, 1);
+	Vector<int, std::allocator<int>, VectorCheck::DebugOnly> debug(n, 1);
+	Vector<int, std::allocator<int>, VectorCheck::PerRange> range(n, 1);
+
+	Measure("Always    operator[]     ", [&]() { return SumByIndex(always); });
+	Measure("DebugOnly operator[]     ", [&]() { return SumByIndex(debug); });
+	Measure("PerRange  checked_range()", [&]() { return SumByRange(range); });
+}
@@ -0,0 +1,216 @@
+﻿#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <tork/charconv.h>
+#include <tork/text.h>
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double Millis(Clock::time_point begin)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+template<class T>
+std::string ToChars(T v)
+{
+	char buf[32];
+	tork::to_chars_result r = tork::to_chars(buf, buf + sizeof(buf), v);
+	return std::string(buf, r.ptr);
+}
+
+template<class T>
+const char* ParseResult(const char* s, T& v)
+{
+	tork::from_chars_result r = tork::from_chars(s, s + std::strlen(s), v);
+	if (r.ec == std::errc::invalid_argument) return "invalid";
+	if (r.ec == std::errc::result_out_of_range) return "range";
+	return r.ptr;
+}
+
+}   // anonymous namespace
+
+void Test_charconv()
+{
+	cout << "*** test charconv ***" << endl;
+
+	cout << ToChars(0) << ' ' << ToChars(-1) << ' ' << ToChars(std::numeric_limits<int>::min()) << ' '
+		<< ToChars(std::numeric_limits<long long>::min()) << ' ' << ToChars(std::numeric_limits<unsigned long long>::max())
+		<< ' ' << ToChars(static_cast<short>(-300)) << endl;
+
+	cout << ToChars(0.0) << ' ' << ToChars(-0.0) << ' ' << ToChars(0.1) << ' ' << ToChars(1.0 / 3) << ' '
+		<< ToChars(100.0) << ' ' << ToChars(1e20) << ' ' << ToChars(1e-7) << ' ' << ToChars(123.456) << ' '
+		<< ToChars(5e-324) << ' ' << ToChars(std::numeric_limits<double>::max()) << ' '
+		<< ToChars(std::numeric_limits<double>::infinity()) << ' ' << ToChars(0.1f) << ' ' << ToChars(16777216.0f) << endl;
+
+	// 足りないバッファ
+	char small[3];
+	cout << (tork::to_chars(small, small + 3, 12345).ec == std::errc::value_too_large) << ' '
+		<< (tork::to_chars(small, small + 3, 0.125).ec == std::errc::value_too_large) << endl;
+
+	int i = 7;
+	cout << ParseResult("123abc", i) << ' ' << i << ' ' << ParseResult("-2147483648", i) << ' ' << i << ' '
+		<< ParseResult("2147483648", i) << ' ' << i << ' ' << ParseResult("+1", i) << ' ' << ParseResult("", i) << endl;
+	unsigned u;
+	unsigned long long ull;
+	cout << ParseResult("-1", u) << ' ' << ParseResult("18446744073709551615", ull) << ' ' << ull << ' '
+		<< ParseResult("18446744073709551616", ull) << endl;
+
+	double d = 0;
+	cout << ParseResult("1.5e3x", d) << ' ' << d << ' ' << ParseResult("-.25", d) << ' ' << d << ' '
+		<< ParseResult("1e", d) << ' ' << d << ' ' << ParseResult("1e400", d) << ' ' << ParseResult("INF", d) << ' ' << d << ' '
+		<< ParseResult(".", d) << ' ' << ParseResult("0.1000000000000000055511151231257827", d) << ' ' << (d == 0.1) << endl;
+
+	// 乱数で往復を確かめる
+	std::mt19937_64 rng(1);
+	bool ok = true;
+	for (int n = 0; n < 1000000; ++n) {
+		uint64_t bits = rng();
+		double v;
+		std::memcpy(&v, &bits, sizeof(v));
+		if (std::isnan(v)) continue;
+		std::string s = ToChars(v);
+		double back;
+		tork::from_chars_result r = tork::from_chars(s.data(), s.data() + s.size(), back);
+		if (r.ec != std::errc() || r.ptr != s.data() + s.size() || back != v) {
+			cout << "round trip failed: " << s << endl;
+			ok = false;
+			break;
+		}
+
+		long long ll = static_cast<long long>(rng());
+		std::string t = ToChars(ll);
+		long long llback = 0;
+		tork::from_chars(t.data(), t.data() + t.size(), llback);
+		if (llback != ll || t != std::to_string(ll)) {
+			cout << "round trip failed: " << t << endl;
+			ok = false;
+			break;
+		}
+	}
+	cout << "round trip: " << ok << endl;
+
+	// text.h の to_string / from_string
+	cout << tork::to_string(42) << ' ' << tork::to_string(2.5) << ' ' << tork::to_string(true) << ' '
+		<< tork::to_string('c') << ' ' << tork::to_string(std::string("str")) << endl;
+	cout << tork::from_string<int>("  -17 ") << ' ' << tork::from_string<double>("+0.5") << ' '
+		<< tork::from_string<bool>("1") << ' ' << tork::from_string<char>("x") << endl;
+	const char* bad[] = { "abc", "", "99999999999", "-3" };
+	for (auto s : bad) {
+		try {
+			if (std::strcmp(s, "-3") == 0) {
+				tork::from_string<unsigned>(s);
+			}
+			else {
+				tork::from_string<int>(s);
+			}
+			cout << "no exception: " << s << endl;
+		}
+		catch (tork::bad_from_string& e) {
+			cout << e.what() << ' ';
+		}
+	}
+	cout << endl;
+
+	cout << endl;
+}
+
+void Bench_charconv()
+{
+	cout << "*** bench charconv ***" << endl;
+
+	const int n = 100000000;
+	const int stream_n = 1000000;
+	std::mt19937 rng(1);
+	std::vector<int> ints(1 << 16);
+	std::vector<double> doubles(1 << 16);
+	for (auto& x : ints) x = static_cast<int>(rng()) >> (rng() % 31);
+	for (auto& x : doubles) x = std::uniform_real_distribution<double>(-1e6, 1e6)(rng);
+	const size_t mask = (1 << 16) - 1;
+
+	// 書き出し
+	char buf[32];
+	size_t total = 0;
+	auto t = Clock::now();
+	for (int i = 0; i < n; ++i) {
+		total += tork::to_chars(buf, buf + sizeof(buf), ints[i & mask]).ptr - buf;
+	}
+	double int_to_ms = Millis(t);
+	t = Clock::now();
+	for (int i = 0; i < n; ++i) {
+		total += tork::to_chars(buf, buf + sizeof(buf), doubles[i & mask]).ptr - buf;
+	}
+	double double_to_ms = Millis(t);
+	t = Clock::now();
+	for (int i = 0; i < stream_n; ++i) {
+		std::ostringstream os;
+		os << doubles[i & mask];
+		total += os.str().size();
+	}
+	double stream_to_ms = Millis(t) * (n / stream_n);
+	cout << n << " to_chars: int " << int_to_ms << " ms, double " << double_to_ms
+		<< " ms, ostringstream double (estimated) " << stream_to_ms << " ms" << endl;
+
+	// 読み込み
+	std::vector<std::string> int_text, double_text;
+	for (size_t i = 0; i <= mask; ++i) {
+		int_text.push_back(tork::to_string(ints[i]));
+		double_text.push_back(tork::to_string(doubles[i]));
+	}
+	long long sum = 0;
+	double dsum = 0;
+	t = Clock::now();
+	for (int i = 0; i < n; ++i) {
+		const std::string& s = int_text[i & mask];
+		int v;
+		tork::from_chars(s.data(), s.data() + s.size(), v);
+		sum += v;
+	}
+	double int_from_ms = Millis(t);
+	t = Clock::now();
+	for (int i = 0; i < n; ++i) {
+		const std::string& s = double_text[i & mask];
+		double v;
+		tork::from_chars(s.data(), s.data() + s.size(), v);
+		dsum += v;
+	}
+	double double_from_ms = Millis(t);
+	t = Clock::now();
+	for (int i = 0; i < stream_n; ++i) {
+		std::istringstream is(double_text[i & mask]);
+		double v;
+		is >> v;
+		dsum += v;
+	}
+	double stream_from_ms = Millis(t) * (n / stream_n);
+	cout << n << " from_chars: int " << int_from_ms << " ms, double " << double_from_ms
+		<< " ms, istringstream double (estimated) " << stream_from_ms << " ms" << endl;
+
+	// to_string / from_string（std::string を作る分を含む）
+	t = Clock::now();
+	for (int i = 0; i < n / 10; ++i) {
+		total += tork::to_string(doubles[i & mask]).size();
+	}
+	double to_string_ms = Millis(t);
+	t = Clock::now();
+	for (int i = 0; i < n / 10; ++i) {
+		dsum += tork::from_string<double>(double_text[i & mask]);
+	}
+	double from_string_ms = Millis(t);
+	cout << n / 10 << " to_string(double) " << to_string_ms << " ms, from_string<double> " << from_string_ms
+		<< " ms (" << total << ' ' << sum << ' ' << dsum << ')' << endl;
+
+	cout << endl;
+}
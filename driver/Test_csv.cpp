@@ -0,0 +1,161 @@
+﻿#include <iostream>
+#include <chrono>
+#include <random>
+#include <sstream>
+#include <string>
+#include <tork/text/csv.h>
+#include <tork/container/Array.h>
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double Millis(Clock::time_point begin)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+const char* KindName(tork::text::ParseErrorKind kind)
+{
+	switch (kind) {
+	case tork::text::ParseErrorKind::InvalidValue: return "invalid";
+	case tork::text::ParseErrorKind::OutOfRange: return "range";
+	case tork::text::ParseErrorKind::MissingField: return "missing";
+	case tork::text::ParseErrorKind::ExtraField: return "extra";
+	}
+	return "?";
+}
+
+void PrintErrors(const tork::text::ParseResult& r)
+{
+	cout << "rows " << r.rows << " values " << r.values << " errors " << r.error_count << ':';
+	for (const auto& e : r.errors) {
+		cout << " (" << e.row << ',' << e.column << ',' << e.offset << ',' << KindName(e.kind) << ')';
+	}
+	cout << endl;
+}
+
+template<class T>
+void PrintArray(const tork::Array<T>& a)
+{
+	for (size_t i = 0; i < a.size(); ++i) cout << (i ? " " : "") << a[i];
+	cout << endl;
+}
+
+// ベンチマーク用の CSV（整数, 小数, 整数）
+std::string MakeCsv(size_t rows)
+{
+	std::mt19937 rng(1);
+	std::string text;
+	char buf[32];
+	for (size_t i = 0; i < rows; ++i) {
+		text += tork::to_string(i);
+		text += ',';
+		text.append(buf, tork::to_chars(buf, buf + sizeof(buf), std::uniform_real_distribution<double>(-1e4, 1e4)(rng)).ptr);
+		text += ',';
+		text += tork::to_string(static_cast<int>(rng() % 100000));
+		text += '\n';
+	}
+	return text;
+}
+
+}   // anonymous namespace
+
+void Test_csv()
+{
+	cout << "*** test csv ***" << endl;
+
+	// 区切られた数値
+	tork::Array<int> ints;
+	PrintErrors(tork::text::parse_numbers("1,2, 3\n4,x,6\r\n\n7,99999999999,", ',', ints));
+	PrintArray(ints);
+
+	tork::Array<double> doubles;
+	PrintErrors(tork::text::parse_numbers("  1.5   -2e3\t\n0.25  ", ' ', doubles));
+	PrintArray(doubles);
+
+	// 列ごとの読み込み
+	std::string csv =
+		"id,price,name,flag\r\n"
+		"1,2.5,apple,1\r\n"
+		"2,\"3.75\",\"banana, ripe\",0\r\n"
+		"3,oops,cherry\r\n"
+		"\r\n"
+		"4,1e2,\"say \"\"hi\"\"\",1,extra\r\n";
+	tork::Array<long long> ids;
+	tork::Array<float> prices;
+	tork::Array<tork::string_view> names;
+	tork::Array<bool> flags;
+	tork::text::CsvOptions opt;
+	opt.header = true;
+	tork::text::ParseResult r = tork::text::parse_csv(csv, opt, ids, prices, names, flags);
+	PrintErrors(r);
+	PrintArray(ids);
+	PrintArray(prices);
+	PrintArray(names);
+	PrintArray(flags);
+
+	// 誤りの記録数の上限
+	tork::Array<int> many;
+	tork::text::CsvOptions limited;
+	limited.max_errors = 2;
+	r = tork::text::parse_csv("a\nb\nc\nd\n", limited, many);
+	cout << r.error_count << ' ' << r.errors.size() << ' ' << many.size() << endl;
+
+	// 16 バイトを超える行（区切り文字の SIMD 探索）
+	tork::Array<unsigned> wide;
+	PrintErrors(tork::text::parse_numbers("100000000,200000000,300000000,400000000\n5", ',', wide));
+	PrintArray(wide);
+}
+
+void Bench_csv()
+{
+	cout << "*** bench csv ***" << endl;
+
+	const size_t rows = 1000000;
+	std::string text = MakeCsv(rows);
+	double mb = static_cast<double>(text.size()) / (1024 * 1024);
+
+	// parse_csv
+	auto t = Clock::now();
+	tork::Array<long long> a;
+	tork::Array<double> b;
+	tork::Array<int> c;
+	tork::text::ParseResult r = tork::text::parse_csv(text, tork::text::CsvOptions(), a, b, c);
+	double csv_ms = Millis(t);
+
+	// parse_numbers（列を区別しない）
+	t = Clock::now();
+	tork::Array<double> all;
+	tork::text::parse_numbers(text, ',', all);
+	double numbers_ms = Millis(t);
+
+	// iostream（getline と >>）
+	t = Clock::now();
+	tork::Array<long long> sa;
+	tork::Array<double> sb;
+	tork::Array<int> sc;
+	{
+		std::istringstream is(text);
+		std::string line;
+		while (std::getline(is, line)) {
+			std::istringstream ls(line);
+			long long x;
+			double y;
+			int z;
+			char comma;
+			ls >> x >> comma >> y >> comma >> z;
+			sa.push_back(x);
+			sb.push_back(y);
+			sc.push_back(z);
+		}
+	}
+	double stream_ms = Millis(t);
+
+	cout << mb << " MB, " << rows << " rows: parse_csv " << mb / csv_ms * 1000 << " MB/s, parse_numbers "
+		<< mb / numbers_ms * 1000 << " MB/s, iostream " << mb / stream_ms * 1000 << " MB/s ("
+		<< r.values << ' ' << all.size() << ' ' << (b[rows / 2] == sb[rows / 2]) << ")" << endl;
+}
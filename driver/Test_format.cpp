@@ -0,0 +1,150 @@
+﻿#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <tork/format.h>
+#include <tork/text.h>
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double Millis(Clock::time_point begin)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+struct Point {
+	int x, y;
+};
+
+std::ostream& operator <<(std::ostream& os, const Point& p)
+{
+	return os << '(' << p.x << ',' << p.y << ')';
+}
+
+template<class... Args>
+std::string FormatError(const char* fmt, const Args&... args)
+{
+	tork::StackBuffer<64> buf;
+	try {
+		tork::format_to(buf, fmt, args...);
+	}
+	catch (const std::invalid_argument& e) {
+		return e.what();
+	}
+	return "no error";
+}
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define SNPRINTF sprintf_s
+#else
+#define SNPRINTF snprintf
+#endif
+
+}   // anonymous namespace
+
+void Test_format()
+{
+	cout << "*** test format ***" << endl;
+
+	tork::StackBuffer<128> buf;
+	tork::format_to(buf, "id={} value={} ok={} c={} name={}", 42, 3.25, true, 'x', "foo");
+	cout << buf.view() << endl;
+
+	buf.clear();
+	std::string s = "bar";
+	tork::string_view sv("baz");
+	char text[8] = "qux";
+	char* ptr = text;
+	tork::format_to(buf, "{{{}}} {} {} {} {} {}", s, sv, ptr, -7LL, 0.1f, Point{ 1, 2 });
+	cout << buf.view() << endl;
+
+	buf.clear();
+	tork::append_to(buf, "n=", 10u, ',', false, ',', -0.5);
+	cout << buf.view() << ' ' << buf.size() << endl;
+
+	// 固定容量は切り捨て
+	tork::StackBuffer<8> small;
+	tork::append_to(small, "abc", 12345, 678);
+	cout << small.view() << ' ' << small.truncated() << endl;
+	small.clear();
+	cout << small.empty() << ' ' << small.truncated() << endl;
+
+	// 伸長するバッファ
+	tork::MemoryBuffer<16> mem;
+	for (int i = 0; i < 100; ++i) {
+		tork::append_to(mem, i, ' ');
+	}
+	cout << mem.size() << ' ' << (mem.capacity() >= mem.size()) << ' ' << mem.truncated() << ' '
+		<< mem.view().substr(0, 20) << endl;
+
+	// std::string への追記
+	std::string line = "x=";
+	tork::append_to(line, 1.5, " y=", 2, " p=", Point{ 3, 4 });
+	cout << line << endl;
+
+	// 書式の誤り
+	cout << FormatError("{} {}", 1) << endl;
+	cout << FormatError("{}", 1, 2) << endl;
+	cout << FormatError("{x}", 1) << endl;
+	cout << FormatError("}", 1) << endl;
+}
+
+void Bench_format()
+{
+	cout << "*** bench format ***" << endl;
+
+	const int n = 5000000;
+	std::vector<std::string> names;
+	names.push_back("alpha");
+	names.push_back("beta");
+	names.push_back("gamma");
+	size_t total = 0;
+
+	// to_string の連結（1 行ごとに確保）
+	auto t = Clock::now();
+	for (int i = 0; i < n; ++i) {
+		std::string line = "id=" + tork::to_string(i) + " value=" + tork::to_string(i * 0.25)
+			+ " name=" + names[i % 3] + "\n";
+		total += line.size();
+	}
+	double concat_ms = Millis(t);
+
+	// snprintf
+	char cbuf[128];
+	t = Clock::now();
+	for (int i = 0; i < n; ++i) {
+		int len = SNPRINTF(cbuf, sizeof(cbuf), "id=%d value=%.17g name=%s\n", i, i * 0.25, names[i % 3].c_str());
+		total += len;
+	}
+	double snprintf_ms = Millis(t);
+
+	// format_to（スタックのバッファ）
+	t = Clock::now();
+	for (int i = 0; i < n; ++i) {
+		tork::StackBuffer<128> buf;
+		tork::format_to(buf, "id={} value={} name={}\n", i, i * 0.25, names[i % 3]);
+		total += buf.size();
+	}
+	double format_ms = Millis(t);
+
+	// append_to（使い回す std::string）
+	std::string line;
+	t = Clock::now();
+	for (int i = 0; i < n; ++i) {
+		line.clear();
+		tork::append_to(line, "id=", i, " value=", i * 0.25, " name=", names[i % 3], '\n');
+		total += line.size();
+	}
+	double append_ms = Millis(t);
+
+	cout << n << " lines: to_string concat " << concat_ms << " ms, snprintf " << snprintf_ms
+		<< " ms, format_to " << format_ms << " ms, append_to(string) " << append_ms << " ms ("
+		<< total << ")" << endl;
+}
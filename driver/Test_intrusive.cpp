@@ -0,0 +1,219 @@
+﻿#include <iostream>
+#include <string>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <tork/container/IntrusiveList.h>
+#include <tork/container/IntrusiveHashSet.h>
+#include <tork/memory/unique_ptr.h>
+#include <tork/memory/shared_ptr.h>
+
+using std::cout;
+using std::endl;
+using tork::IntrusiveList;
+using tork::IntrusiveListHook;
+using tork::IntrusiveHashSet;
+using tork::IntrusiveHashHook;
+
+namespace {
+
+// 2つのリストと1つのハッシュセットに同時に入る要素
+struct Item {
+	int id;
+	std::string name;
+	IntrusiveListHook all;
+	IntrusiveListHook active;
+	IntrusiveHashHook by_id;
+
+	Item(int i, const std::string& n) :id(i), name(n) { }
+};
+
+struct ItemId {
+	int operator ()(const Item& x) const { return x.id; }
+};
+
+typedef IntrusiveList<Item, &Item::all> AllList;
+typedef IntrusiveList<Item, &Item::active> ActiveList;
+typedef IntrusiveHashSet<Item, &Item::by_id, int, ItemId> IdIndex;
+
+// LRU キャッシュの std::list + std::unordered_map 版
+class StdLru {
+	typedef std::list<std::pair<unsigned, unsigned>> List;
+	List list_;
+	std::unordered_map<unsigned, List::iterator> map_;
+	size_t capacity_;
+public:
+	explicit StdLru(size_t capacity) :capacity_(capacity) { map_.reserve(capacity); }
+
+	// 見つかれば先頭へ移して true、なければ末尾を追い出して追加し false
+	bool access(unsigned key)
+	{
+		auto it = map_.find(key);
+		if (it != map_.end()) {
+			list_.splice(list_.begin(), list_, it->second);
+			return true;
+		}
+		if (list_.size() >= capacity_) {
+			map_.erase(list_.back().first);
+			list_.pop_back();
+		}
+		list_.push_front(std::make_pair(key, key));
+		map_[key] = list_.begin();
+		return false;
+	}
+};
+
+// LRU キャッシュの侵入型版
+// ノードは最初にまとめて確保し、追い出したものを使い回す
+class IntrusiveLru {
+	struct Node {
+		unsigned key;
+		unsigned value;
+		IntrusiveListHook lru;
+		IntrusiveHashHook index;
+	};
+	struct NodeKey {
+		unsigned operator ()(const Node& n) const { return n.key; }
+	};
+
+	std::vector<Node> pool_;
+	IntrusiveList<Node, &Node::lru> list_;
+	IntrusiveHashSet<Node, &Node::index, unsigned, NodeKey> map_;
+	size_t used_ = 0;
+public:
+	explicit IntrusiveLru(size_t capacity) :pool_(capacity), map_(capacity) { }
+	~IntrusiveLru()
+	{
+		map_.clear();
+		list_.clear();
+	}
+
+	bool access(unsigned key)
+	{
+		if (Node* p = map_.find(key)) {
+			list_.move_to_front(*p);
+			return true;
+		}
+		Node* n;
+		if (used_ < pool_.size()) {
+			n = &pool_[used_++];
+		}
+		else {
+			n = &list_.back();
+			list_.pop_back();
+			map_.erase(*n);
+		}
+		n->key = key;
+		n->value = key;
+		list_.push_front(*n);
+		map_.insert(*n);
+		return false;
+	}
+};
+
+template<class Lru>
+void MeasureLru(const char* name, const std::vector<unsigned>& keys, size_t capacity)
+{
+	Lru lru(capacity);
+	auto begin = std::chrono::steady_clock::now();
+	size_t hits = 0;
+	for (unsigned k : keys) {
+		hits += lru.access(k);
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+	cout << "  " << name << ": " << ms << " ms, " << ms * 1e6 / keys.size()
+		<< " ns/op, hit " << hits * 100.0 / keys.size() << " %" << endl;
+}
+
+}   // anonymous namespace
+
+void Test_intrusive()
+{
+	cout << "*** test IntrusiveList, IntrusiveHashSet ***" << endl;
+
+	// 所有は unique_ptr、索引は侵入型コンテナ
+	std::vector<tork::unique_ptr<Item>> owner;
+	AllList all;
+	ActiveList active;
+	IdIndex index;
+	for (int i = 0; i < 10; ++i) {
+		owner.push_back(tork::unique_ptr<Item>(new Item(i, "item" + std::to_string(i))));
+		Item& x = *owner.back();
+		all.push_back(x);
+		index.insert(x);
+		if (i % 3 == 0) active.push_front(x);
+	}
+	cout << all.size() << ' ' << active.size() << ' ' << index.size() << endl;
+
+	for (const Item& x : active) {
+		cout << x.id << ' ';
+	}
+	cout << endl;
+
+	// 重複キーは入らない
+	Item dup(3, "dup");
+	cout << index.insert(dup).second << ' ' << index.find(3)->name << endl;
+
+	// O(1) で外す
+	Item* p = index.find(6);
+	all.erase(*p);
+	active.erase(*p);
+	index.erase(*p);
+	cout << all.size() << ' ' << active.size() << ' ' << index.contains(6)
+		<< ' ' << p->all.is_linked() << endl;
+
+	active.move_to_back(*index.find(9));
+	for (auto it = active.rbegin(); it != active.rend(); ++it) {
+		cout << it->id << ' ';
+	}
+	cout << endl;
+
+	// 破棄する前に全部外す
+	active.clear();
+	index.clear();
+	all.clear();
+
+	// 所有権をリストに預けて、外すときに delete する
+	AllList owned;
+	for (int i = 0; i < 3; ++i) {
+		tork::unique_ptr<Item> u(new Item(i, "owned"));
+		owned.push_back(*u.release());
+	}
+	int disposed = 0;
+	owned.clear_and_dispose([&disposed](Item* x) {
+		delete x;
+		++disposed;
+	});
+	cout << disposed << ' ' << owned.empty() << endl;
+
+	// shared_ptr で生かしておいて、複数のリストで共有する
+	tork::shared_ptr<Item> s = tork::make_shared<Item>(100, "shared");
+	AllList l1;
+	ActiveList l2;
+	l1.push_back(*s);
+	l2.push_back(*s);
+	cout << l1.front().name << ' ' << (&l1.front() == &l2.front()) << endl;
+	l1.clear();
+	l2.clear();
+}
+
+void Bench_intrusive_lru()
+{
+	cout << "*** bench LRU: std::list + unordered_map vs intrusive ***" << endl;
+
+	const size_t n = 10000000;
+	for (size_t capacity = 1000; capacity <= 1000000; capacity *= 10) {
+		// 容量の2倍の範囲から偏りのあるキーを引く
+		std::mt19937 rng(static_cast<unsigned>(capacity));
+		std::exponential_distribution<double> dist(1.0 / capacity);
+		std::vector<unsigned> keys(n);
+		for (auto& k : keys) {
+			k = static_cast<unsigned>(dist(rng)) % static_cast<unsigned>(capacity * 4);
+		}
+		cout << "capacity = " << capacity << endl;
+		MeasureLru<StdLru>("std::list + unordered_map", keys, capacity);
+		MeasureLru<IntrusiveLru>("IntrusiveList + HashSet  ", keys, capacity);
+	}
+}
@@ -0,0 +1,164 @@
+﻿#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include <tork/parallel.h>
+#include <tork/container/Array.h>
+#include <tork/thread/ThreadPool.h>
+
+using std::cout;
+using std::endl;
+using tork::Array;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double Millis(Clock::time_point begin)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+}   // anonymous namespace
+
+void Test_parallel()
+{
+	cout << "*** test parallel ***" << endl;
+
+	const size_t n = 100003;
+	Array<long long> a(n);
+	tork::parallel::each_with_index(a.begin(), a.end(), [](long long& x, size_t i) {
+		x = static_cast<long long>(i);
+	}, 1000);
+	bool ok = true;
+	for (size_t i = 0; i < n; ++i) ok = ok && (a[i] == static_cast<long long>(i));
+	cout << "each_with_index: " << ok << endl;
+
+	tork::parallel::for_each(a.begin(), a.end(), [](long long& x) { x *= 2; });
+	Array<long long> b(n);
+	tork::parallel::transform(a.begin(), a.end(), b.begin(), [](long long x) { return x + 1; });
+	ok = true;
+	for (size_t i = 0; i < n; ++i) ok = ok && (b[i] == 2 * static_cast<long long>(i) + 1);
+	cout << "for_each/transform: " << ok << endl;
+
+	long long sum = tork::parallel::reduce(b.begin(), b.end(), 0LL);
+	cout << "reduce: " << (sum == std::accumulate(b.begin(), b.end(), 0LL)) << endl;
+
+	// スレッド数を変えても浮動小数点の合計は変わらない
+	std::mt19937 rng(1);
+	std::vector<double> d(n);
+	for (auto& x : d) x = std::uniform_real_distribution<double>(-1.0, 1.0)(rng);
+	tork::parallel::set_thread_count(1);
+	double s1 = tork::parallel::reduce(d.begin(), d.end(), 0.0);
+	tork::parallel::set_thread_count(0);
+	double s2 = tork::parallel::reduce(d.begin(), d.end(), 0.0);
+	cout << "deterministic reduce: " << (s1 == s2) << endl;
+
+	std::vector<long long> scan(n);
+	tork::parallel::inclusive_scan(b.begin(), b.end(), scan.begin(), std::plus<long long>(), 777);
+	std::vector<long long> ref(n);
+	std::partial_sum(b.begin(), b.end(), ref.begin());
+	cout << "inclusive_scan: " << (scan == ref) << endl;
+	tork::parallel::inclusive_scan(b.begin(), b.end(), b.begin());
+	cout << "inclusive_scan in place: " << std::equal(b.begin(), b.end(), ref.begin()) << endl;
+
+	std::vector<unsigned> v(n);
+	for (auto& x : v) x = rng();
+	std::vector<unsigned> sorted = v;
+	std::sort(sorted.begin(), sorted.end());
+	for (size_t grain : { size_t(0), size_t(1), size_t(100), size_t(40000) }) {
+		std::vector<unsigned> w = v;
+		tork::parallel::sort(w.begin(), w.end(), std::less<unsigned>(), grain);
+		cout << "sort grain " << grain << ": " << (w == sorted) << endl;
+	}
+
+	// 空の範囲
+	std::vector<int> empty;
+	tork::parallel::sort(empty.begin(), empty.end());
+	cout << "empty: " << tork::parallel::reduce(empty.begin(), empty.end(), 5) << endl;
+
+	// 入れ子の呼び出しは呼び出したスレッドで処理される
+	std::vector<int> outer(64, 0);
+	tork::parallel::each_with_index(outer.begin(), outer.end(), [](int& x, size_t i) {
+		std::vector<int> inner(100, static_cast<int>(i));
+		x = tork::parallel::reduce(inner.begin(), inner.end(), 0);
+	}, 1);
+	cout << "nested: " << (outer[63] == 6300) << endl;
+
+	// 例外は呼び出し元に届く
+	try {
+		tork::parallel::for_each(v.begin(), v.end(), [](unsigned x) {
+			if (x % 1000 == 0) throw std::runtime_error("thrown in parallel::for_each");
+		}, 10);
+	}
+	catch (std::runtime_error& e) {
+		cout << e.what() << endl;
+	}
+
+	// 既存の ThreadPool を渡せば、そのワーカーで処理する
+	auto shared = std::make_shared<tork::ThreadPool>(3);
+	tork::parallel::set_pool(shared);
+	std::atomic<unsigned> on_workers(0);
+	tork::parallel::for_each(v.begin(), v.end(), [&](unsigned) {
+		if (shared->current_index() >= 0) on_workers.fetch_add(1, std::memory_order_relaxed);
+	}, 1000);
+	long long shared_sum = shared->submit([&b]() {
+		return tork::parallel::reduce(b.begin(), b.end(), 0LL);
+	}).get();
+	cout << "shared pool: " << tork::parallel::thread_count() << ' ' << (tork::parallel::pool() == shared)
+		<< ' ' << (on_workers > 0) << ' ' << (shared_sum == std::accumulate(b.begin(), b.end(), 0LL)) << endl;
+	tork::parallel::set_pool(nullptr);
+	cout << "built-in pool: " << (tork::parallel::pool() != shared) << endl;
+
+	cout << endl;
+}
+
+void Bench_parallel()
+{
+	cout << "*** bench parallel ***" << endl;
+
+	const size_t n = 1 << 24;
+	Array<double> src(n);
+	std::mt19937 rng(1);
+	for (auto& x : src) x = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+
+	tork::parallel::set_thread_count(0);
+	unsigned max_threads = tork::parallel::thread_count();
+	Array<double> dst(n);
+	for (unsigned threads = 1; ; threads *= 2) {
+		if (threads > max_threads) threads = max_threads;
+		tork::parallel::set_thread_count(threads);
+
+		auto t = Clock::now();
+		tork::parallel::transform(src.begin(), src.end(), dst.begin(), [](double x) {
+			return std::sqrt(x) * std::log(x + 1.0);
+		});
+		double transform_ms = Millis(t);
+
+		t = Clock::now();
+		double sum = tork::parallel::reduce(src.begin(), src.end(), 0.0);
+		double reduce_ms = Millis(t);
+
+		t = Clock::now();
+		tork::parallel::inclusive_scan(src.begin(), src.end(), dst.begin());
+		double scan_ms = Millis(t);
+
+		dst = src;
+		t = Clock::now();
+		tork::parallel::sort(dst.begin(), dst.end());
+		double sort_ms = Millis(t);
+
+		cout << threads << " threads: transform " << transform_ms << " ms, reduce " << reduce_ms
+			<< " ms, scan " << scan_ms << " ms, sort " << sort_ms << " ms (" << sum << ')' << endl;
+
+		if (threads == max_threads) break;
+	}
+	tork::parallel::set_thread_count(0);
+
+	cout << endl;
+}
@@ -0,0 +1,255 @@
+﻿#include <iostream>
+#include <string>
+#include <chrono>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <stdexcept>
+#include <tork/thread/SpscRing.h>
+#include <tork/thread/MpmcQueue.h>
+
+using std::cout;
+using std::endl;
+using tork::SpscRing;
+using tork::MpmcQueue;
+
+namespace {
+
+// mutex と条件変数で守った有界キュー（比較用）
+template<class T>
+class MutexQueue {
+	std::mutex mutex_;
+	std::condition_variable not_empty_;
+	std::condition_variable not_full_;
+	std::deque<T> queue_;
+	size_t capacity_;
+public:
+	explicit MutexQueue(size_t capacity) :capacity_(capacity) { }
+
+	bool try_push(const T& value)
+	{
+		{
+			std::lock_guard<std::mutex> guard(mutex_);
+			if (queue_.size() >= capacity_) return false;
+			queue_.push_back(value);
+		}
+		not_empty_.notify_one();
+		return true;
+	}
+	bool try_pop(T& out)
+	{
+		{
+			std::lock_guard<std::mutex> guard(mutex_);
+			if (queue_.empty()) return false;
+			out = queue_.front();
+			queue_.pop_front();
+		}
+		not_full_.notify_one();
+		return true;
+	}
+	void push(const T& value)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			not_full_.wait(lock, [this] { return queue_.size() < capacity_; });
+			queue_.push_back(value);
+		}
+		not_empty_.notify_one();
+	}
+	void pop(T& out)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			not_empty_.wait(lock, [this] { return !queue_.empty(); });
+			out = queue_.front();
+			queue_.pop_front();
+		}
+		not_full_.notify_one();
+	}
+};
+
+typedef std::chrono::steady_clock Clock;
+
+double Seconds(Clock::time_point begin)
+{
+	return std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+// producers 個のスレッドが per_thread 個ずつ try_push し、consumers 個のスレッドが try_pop する
+// 百万要素／秒を返す
+template<class Queue>
+double Throughput(Queue& q, unsigned producers, unsigned consumers, unsigned per_thread)
+{
+	const unsigned long long total = static_cast<unsigned long long>(per_thread) * producers;
+	std::atomic<unsigned long long> popped(0);
+	std::atomic<unsigned long long> sum(0);
+	std::vector<std::thread> threads;
+
+	auto begin = Clock::now();
+	for (unsigned p = 0; p < producers; ++p) {
+		threads.push_back(std::thread([&q, per_thread]() {
+			for (unsigned i = 1; i <= per_thread; ++i) {
+				while (!q.try_push(i)) {
+					std::this_thread::yield();
+				}
+			}
+		}));
+	}
+	for (unsigned c = 0; c < consumers; ++c) {
+		threads.push_back(std::thread([&q, &popped, &sum, total]() {
+			unsigned long long local = 0;
+			unsigned v;
+			while (popped.load(std::memory_order_relaxed) < total) {
+				if (q.try_pop(v)) {
+					local += v;
+					popped.fetch_add(1, std::memory_order_relaxed);
+				}
+				else {
+					std::this_thread::yield();
+				}
+			}
+			sum += local;
+		}));
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	double sec = Seconds(begin);
+
+	// 取りこぼしや重複がないか
+	unsigned long long expect = static_cast<unsigned long long>(per_thread) * (per_thread + 1) / 2 * producers;
+	if (sum != expect) cout << "  !! sum mismatch" << endl;
+	return total / sec / 1e6;
+}
+
+// 2つのキューで値を往復させたときの1往復の平均時間（マイクロ秒）
+// 受け取り側は眠って待つ
+template<class Queue>
+double PingPong(unsigned rounds)
+{
+	Queue ping(64), pong(64);
+	std::thread echo([&ping, &pong, rounds]() {
+		unsigned v;
+		for (unsigned i = 0; i < rounds; ++i) {
+			ping.pop(v);
+			pong.push(v);
+		}
+	});
+	auto begin = Clock::now();
+	unsigned v;
+	for (unsigned i = 0; i < rounds; ++i) {
+		ping.push(i);
+		pong.pop(v);
+	}
+	double sec = Seconds(begin);
+	echo.join();
+	return sec / rounds * 1e6;
+}
+
+// 負の値では構築できない要素
+struct Picky {
+	int value;
+	explicit Picky(int v) :value(v)
+	{
+		if (v < 0) throw std::invalid_argument("Picky");
+	}
+};
+
+}   // anonymous namespace
+
+void Test_queue()
+{
+	cout << "*** test SpscRing, MpmcQueue ***" << endl;
+
+	SpscRing<std::string> r(5);
+	cout << r.capacity() << ' ';
+	for (int i = 0; i < 10; ++i) {
+		if (!r.try_push(std::to_string(i))) {
+			cout << "full at " << i << ' ';
+			break;
+		}
+	}
+	std::string s;
+	r.try_pop(s);
+	cout << s << ' ' << r.size() << endl;
+
+	std::string batch[4] = { "a", "b", "c", "d" };
+	cout << r.push_batch(batch, 4) << ' ';
+	std::string out[16];
+	size_t n = r.pop_batch(out, 16);
+	for (size_t i = 0; i < n; ++i) {
+		cout << out[i];
+	}
+	cout << ' ' << r.empty() << endl;
+
+	// 要素が残ったまま破棄しても解放される
+	MpmcQueue<std::string> q(4);
+	q.try_push("x");
+	q.try_emplace(3, 'y');
+	cout << q.capacity() << ' ' << q.size() << endl;
+
+	// 要素の構築が例外を投げても、キューは止まらない
+	MpmcQueue<Picky> p(2);
+	try {
+		p.try_emplace(-1);
+	}
+	catch (const std::invalid_argument&) {
+		cout << "invalid_argument ";
+	}
+	Picky got(0);
+	bool pushed = p.try_emplace(1) && p.try_emplace(2);
+	bool popped = p.try_pop(got) && got.value == 1 && p.try_pop(got) && got.value == 2;
+	cout << pushed << popped << p.empty() << endl;
+
+	// 複数スレッドで全要素が1回ずつ取り出される
+	MpmcQueue<unsigned> m(256);
+	Throughput(m, 4, 4, 10000);
+
+	// 眠って待つ
+	SpscRing<unsigned, tork::allocator<unsigned>, true> b(2);
+	std::thread consumer([&b]() {
+		unsigned long long total = 0;
+		unsigned v;
+		for (int i = 0; i < 1000; ++i) {
+			b.pop(v);
+			total += v;
+		}
+		cout << total << endl;
+	});
+	for (unsigned i = 0; i < 1000; ++i) {
+		b.push(i);
+	}
+	consumer.join();
+}
+
+void Bench_queue()
+{
+	cout << "*** bench SpscRing, MpmcQueue vs mutex + condition_variable ***" << endl;
+
+	const unsigned n = 10000000;
+	{
+		SpscRing<unsigned> r(1024);
+		MpmcQueue<unsigned> m(1024);
+		MutexQueue<unsigned> x(1024);
+		cout << "1 producer, 1 consumer (M items/s)" << endl;
+		cout << "  SpscRing   " << Throughput(r, 1, 1, n) << endl;
+		cout << "  MpmcQueue  " << Throughput(m, 1, 1, n) << endl;
+		cout << "  MutexQueue " << Throughput(x, 1, 1, n) << endl;
+	}
+	for (unsigned t = 2; t <= 8; t *= 2) {
+		MpmcQueue<unsigned> m(1024);
+		MutexQueue<unsigned> x(1024);
+		cout << t << " producers, " << t << " consumers (M items/s)" << endl;
+		cout << "  MpmcQueue  " << Throughput(m, t, t, n / t) << endl;
+		cout << "  MutexQueue " << Throughput(x, t, t, n / t) << endl;
+	}
+
+	const unsigned rounds = 100000;
+	cout << "ping-pong round trip with blocking wait (us)" << endl;
+	cout << "  SpscRing   " << PingPong<SpscRing<unsigned, tork::allocator<unsigned>, true>>(rounds) << endl;
+	cout << "  MpmcQueue  " << PingPong<MpmcQueue<unsigned, tork::allocator<unsigned>, true>>(rounds) << endl;
+	cout << "  MutexQueue " << PingPong<MutexQueue<unsigned>>(rounds) << endl;
+}
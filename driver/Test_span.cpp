@@ -0,0 +1,75 @@
+﻿#include <iostream>
+#include <vector>
+#include <tork/span.h>
+#include <tork/container/Array.h>
+#include <tork/container/SharedArray.h>
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+template<class C>
+void print(const C& a)
+{
+	cout << "{ ";
+	for (auto v : a) {
+		cout << v << ' ';
+	}
+	cout << "}" << endl;
+}
+
+void Test_span_basic()
+{
+	cout << "*** test span ***" << endl;
+
+	int raw[] = { 0, 1, 2, 3, 4, 5 };
+	tork::span<int> s(raw);
+	print(s);
+	print(s.subspan(2, 3));
+	print(s.first(2));
+	print(s.last(2));
+
+	tork::Array<int> a{ 10, 20, 30 };
+	tork::span<const int> cs = a;
+	print(cs);
+
+	std::vector<int> v{ 7, 8, 9 };
+	auto vs = tork::make_span(v);
+	vs[0] = 70;
+	print(v);
+}
+
+void Test_SharedSlice()
+{
+	cout << "*** test SharedSlice ***" << endl;
+
+	tork::SharedArray<int> a{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+	tork::SharedSlice<int> s = a.slice(2, 6);
+
+	// 元の配列がなくなってもスライスは有効
+	a = tork::SharedArray<int>();
+	print(s);
+	cout << s.use_count() << endl;
+
+	auto sub = s.subslice(1, 3);
+	print(sub);
+
+	// 明示的にコピーする場合
+	tork::Array<int> owned = sub.to_array();
+	print(owned);
+
+	// 読み取り専用配列のスライス
+	tork::SharedArray<const int> f = tork::SharedArray<int>{ 1, 2, 3, 4 }.freeze();
+	tork::SharedSlice<const int> fs = f.slice(1, 2);
+	tork::span<const int> sp = fs;
+	print(sp);
+}
+
+}   // anonymous namespace
+
+void Test_span()
+{
+	Test_span_basic();
+	Test_SharedSlice();
+}
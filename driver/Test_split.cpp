@@ -0,0 +1,175 @@
+﻿#include <iostream>
+#include <chrono>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <tork/text/split.h>
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double Millis(Clock::time_point begin)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+// 分割結果を [a|b|c] の形で
+std::string Join(const tork::text::SplitRange& range)
+{
+	std::string r = "[";
+	bool first = true;
+	for (tork::string_view s : range) {
+		if (!first) r += '|';
+		r.append(s.data(), s.size());
+		first = false;
+	}
+	return r + "]";
+}
+
+// ログ風の行を作る
+std::string MakeLog(size_t lines, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::string text;
+	for (size_t i = 0; i < lines; ++i) {
+		int fields = 8 + rng() % 8;
+		for (int f = 0; f < fields; ++f) {
+			if (f) text += ',';
+			int len = rng() % 16;
+			for (int k = 0; k < len; ++k) text += static_cast<char>('a' + rng() % 26);
+		}
+		text += '\n';
+	}
+	return text;
+}
+
+}   // anonymous namespace
+
+void Test_split()
+{
+	cout << "*** test split ***" << endl;
+
+	using tork::text::split;
+	using tork::text::tokenize;
+
+	cout << Join(split("a,b,c", ',')) << ' ' << Join(split("a,,b,", ',')) << ' '
+		<< Join(split("", ',')) << ' ' << Join(split("abc", ',')) << endl;
+
+	// データを指さない string_view() も空文字列として "" を 1 つ返す
+	size_t fields = 0;
+	for (auto f : split(tork::string_view(), ',')) fields += 1 + f.size();
+	cout << fields << ' ' << Join(tokenize(tork::string_view(), ",")) << '|' << endl;
+	cout << Join(tokenize("  hello \t world\n", " \t\n")) << ' ' << Join(tokenize(" ,; ", " ,;")) << ' '
+		<< Join(tokenize("k=v;x=y", "=;")) << endl;
+
+	// 16 バイトを超える文字列（SIMD の経路と端数）
+	std::string longer = "0123456789abcdefghij,klmnopqrstuvwxyz0123456789ABCDEFGHIJ;tail";
+	cout << Join(split(longer, ',')) << endl;
+	cout << Join(split(longer, tork::text::CharSet(",;"))) << endl;
+
+	// find_any_of（少ない文字集合と多い文字集合）
+	std::string hay = "the quick brown fox jumps over the lazy dog";
+	cout << tork::text::find_any_of(hay, "xyz") << ' ' << tork::text::find_any_of(hay, "q")
+		<< ' ' << tork::text::find_any_of(hay, "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ!?") << ' '
+		<< tork::text::find_any_of(hay, "zyxwvutsrq", 5) << ' ' << tork::text::find_any_of(hay, "", 0) << endl;
+
+	// 表を引く場合と同じ結果になるか
+	std::mt19937 rng(5);
+	int mismatch = 0;
+	for (int i = 0; i < 10000; ++i) {
+		std::string s(rng() % 100, 'a');
+		for (auto& c : s) c = static_cast<char>(rng() % 8 == 0 ? rng() : 'a' + rng() % 26);
+		std::string chars(1 + rng() % 10, ' ');
+		for (auto& c : chars) c = static_cast<char>(rng() % 4 == 0 ? rng() : 'a' + rng() % 26);
+		size_t pos = rng() % (s.size() + 1);
+		if (tork::text::find_any_of(s, chars, pos) != s.find_first_of(chars, pos)) ++mismatch;
+	}
+	cout << "mismatch " << mismatch << endl;
+
+	// trim, starts_with
+	cout << '[' << tork::text::trim("  a b \r\n") << "] [" << tork::text::trim_left("\tx ") << "] ["
+		<< tork::text::trim_right("\tx ") << "] [" << tork::text::trim("   ") << "] "
+		<< tork::text::starts_with("prefix", "pre") << tork::text::ends_with("prefix", "fix")
+		<< tork::text::starts_with("pre", "prefix") << endl;
+}
+
+void Bench_split()
+{
+	cout << "*** bench split ***" << endl;
+
+	std::string text = MakeLog(1 << 18, 1);
+	size_t fields = 0, bytes = 0;
+
+	// tork::text::split
+	auto t = Clock::now();
+	for (tork::string_view line : tork::text::split(text, '\n')) {
+		for (tork::string_view field : tork::text::split(line, ',')) {
+			++fields;
+			bytes += field.size();
+		}
+	}
+	double split_ms = Millis(t);
+
+	// std::string::find のループ
+	t = Clock::now();
+	size_t begin = 0;
+	while (begin < text.size()) {
+		size_t eol = text.find('\n', begin);
+		if (eol == std::string::npos) eol = text.size();
+		size_t p = begin;
+		for (;;) {
+			size_t comma = text.find(',', p);
+			if (comma == std::string::npos || comma > eol) comma = eol;
+			++fields;
+			bytes += comma - p;
+			if (comma == eol) break;
+			p = comma + 1;
+		}
+		begin = eol + 1;
+	}
+	double find_ms = Millis(t);
+
+	// istringstream と getline
+	t = Clock::now();
+	{
+		std::istringstream is(text);
+		std::string line, field;
+		while (std::getline(is, line)) {
+			std::istringstream ls(line);
+			while (std::getline(ls, field, ',')) {
+				++fields;
+				bytes += field.size();
+			}
+		}
+	}
+	double stream_ms = Millis(t);
+
+	// 空白区切りの語
+	std::string words = text;
+	for (auto& c : words) if (c == ',') c = ' ';
+	t = Clock::now();
+	for (tork::string_view w : tork::text::tokenize(words, " \n")) {
+		++fields;
+		bytes += w.size();
+	}
+	double tokenize_ms = Millis(t);
+	t = Clock::now();
+	{
+		std::istringstream is(words);
+		std::string w;
+		while (is >> w) {
+			++fields;
+			bytes += w.size();
+		}
+	}
+	double stream_words_ms = Millis(t);
+
+	cout << text.size() / (1024 * 1024) << " MB: split " << split_ms << " ms, string::find " << find_ms
+		<< " ms, istringstream getline " << stream_ms << " ms / tokenize " << tokenize_ms
+		<< " ms, istringstream >> " << stream_words_ms << " ms (" << fields << ", " << bytes << ")" << endl;
+}
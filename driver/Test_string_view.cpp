@@ -0,0 +1,41 @@
+﻿#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <tork/string_view.h>
+
+using std::cout;
+using std::endl;
+using tork::string_view;
+
+void Test_string_view()
+{
+	cout << "*** test string_view ***" << endl;
+
+	std::string str = "hello, string view";
+	string_view s(str);
+	string_view lit = "hello";
+	cout << s << ' ' << s.size() << ' ' << s.substr(7, 6) << ' ' << s.substr(14) << endl;
+	cout << s.find(',') << ' ' << s.find("view") << ' ' << s.find("none") << ' ' << s.rfind('i') << ' '
+		<< s.rfind("i") << ' ' << s.find_first_of("aeiou") << ' ' << s.find_last_not_of("wiev") << endl;
+	cout << s.starts_with(lit) << ' ' << s.ends_with("view") << ' ' << s.starts_with('x') << ' '
+		<< (s.substr(0, 5) == lit) << ' ' << (lit == "hello") << ' ' << (std::string("hello") == lit) << ' '
+		<< (lit < s) << ' ' << (lit != s) << endl;
+
+	string_view t = s;
+	t.remove_prefix(7);
+	t.remove_suffix(5);
+	cout << '[' << t << "] " << t.front() << t.back() << ' ' << std::string(t) << ' ' << t.to_string().size() << endl;
+
+	try {
+		s.substr(100);
+	}
+	catch (std::out_of_range& e) {
+		cout << e.what() << endl;
+	}
+
+	std::unordered_set<string_view> set;
+	set.insert(string_view(str).substr(0, 5));
+	cout << set.count("hello") << ' ' << set.count("hell") << endl;
+
+	cout << endl;
+}
@@ -1,5 +1,6 @@
 ﻿#include <iostream>
 #include <string>
+#include <limits>
 #include <tork/text.h>
 using std::cout;
 using std::endl;
@@ -18,5 +19,36 @@ void Test_text()
     str = tork::lexical_cast<std::string>(5678);
     cout << n << endl;
     cout << str << endl;
+
+    // lexical_cast の変換方法ごと
+    cout << tork::lexical_cast<long>(123) << ' '
+        << tork::lexical_cast<double>(std::string(" 2.5 ")) << ' '
+        << tork::lexical_cast<unsigned>(tork::string_view("42,43").substr(3)) << ' '
+        << tork::lexical_cast<int>(3.0) << ' '
+        << tork::lexical_cast<bool>("1") << ' '
+        << tork::lexical_cast<std::string>(0.1) << ' '
+        << tork::lexical_cast<std::string>(tork::string_view("a b")) << ' '
+        << tork::lexical_cast<char>("x") << endl;
+
+    const char* bad[] = { "300 to char", "1.5 to int", "-1 to unsigned", "1e300 to float", "12x to int", "2 to bool" };
+    for (int i = 0; i < 6; ++i) {
+        try {
+            switch (i) {
+            case 0: tork::lexical_cast<signed char>(300); break;
+            case 1: tork::lexical_cast<int>(1.5); break;
+            case 2: tork::lexical_cast<unsigned>(-1); break;
+            case 3: tork::lexical_cast<float>(1e300); break;
+            case 4: tork::lexical_cast<int>("12x"); break;
+            case 5: tork::lexical_cast<bool>(2); break;
+            }
+            cout << "no exception: " << bad[i] << endl;
+        }
+        catch (tork::bad_lexical_cast&) {
+            cout << bad[i] << ": bad_lexical_cast" << endl;
+        }
+    }
+    cout << tork::lexical_cast<int>(true) << ' '
+        << tork::lexical_cast<unsigned short>(65535.0) << ' '
+        << tork::lexical_cast<long long>(std::numeric_limits<unsigned>::max()) << endl;
 }
 
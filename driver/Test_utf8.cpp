@@ -0,0 +1,166 @@
+﻿#include <iostream>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <tork/utf8.h>
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+typedef tork::utf8::impl::SimdLevel SimdLevel;
+
+double Millis(Clock::time_point begin)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+const SimdLevel Levels[] = { SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2 };
+const char* LevelNames[] = { "scalar", "sse2", "avx2" };
+
+// 比較用の素朴な実装（コードポイントに戻して範囲を調べる）
+size_t ReferenceFindInvalid(const std::string& s)
+{
+	size_t i = 0;
+	while (i < s.size()) {
+		uint32_t c = static_cast<unsigned char>(s[i]);
+		size_t n = c < 0x80 ? 1 : (c >> 5) == 6 ? 2 : (c >> 4) == 14 ? 3 : (c >> 3) == 30 ? 4 : 0;
+		if (n == 0 || i + n > s.size()) return i;
+		uint32_t cp = n == 1 ? c : c & (0x7F >> n);
+		for (size_t k = 1; k < n; ++k) {
+			uint32_t d = static_cast<unsigned char>(s[i + k]);
+			if ((d >> 6) != 2) return i;
+			cp = (cp << 6) | (d & 0x3F);
+		}
+		static const uint32_t min_cp[] = { 0, 0, 0x80, 0x800, 0x10000 };
+		if (cp < min_cp[n] || cp > 0x10FFFF || (cp >= 0xD800 && cp < 0xE000)) return i;
+		i += n;
+	}
+	return s.size();
+}
+
+void AppendUtf8(std::string& s, uint32_t cp)
+{
+	if (cp < 0x80) {
+		s += static_cast<char>(cp);
+	}
+	else if (cp < 0x800) {
+		s += static_cast<char>(0xC0 | (cp >> 6));
+		s += static_cast<char>(0x80 | (cp & 0x3F));
+	}
+	else if (cp < 0x10000) {
+		s += static_cast<char>(0xE0 | (cp >> 12));
+		s += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+		s += static_cast<char>(0x80 | (cp & 0x3F));
+	}
+	else {
+		s += static_cast<char>(0xF0 | (cp >> 18));
+		s += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+		s += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+		s += static_cast<char>(0x80 | (cp & 0x3F));
+	}
+}
+
+// 正しい UTF-8 の乱数文字列（ascii_percent の割合で ASCII）
+std::string MakeText(std::mt19937& rng, size_t chars, int ascii_percent)
+{
+	std::string s;
+	for (size_t i = 0; i < chars; ++i) {
+		int r = static_cast<int>(rng() % 100);
+		uint32_t cp;
+		if (r < ascii_percent) cp = rng() % 0x80;
+		else if (r % 3 == 0) cp = 0x80 + rng() % 0x780;
+		else if (r % 3 == 1) {
+			do cp = 0x800 + rng() % 0xF800; while (cp >= 0xD800 && cp < 0xE000);
+		}
+		else cp = 0x10000 + rng() % 0x100000;
+		AppendUtf8(s, cp);
+	}
+	return s;
+}
+
+}   // anonymous namespace
+
+void Test_utf8()
+{
+	cout << "*** test utf8 ***" << endl;
+
+	std::string ok = "abc \xC3\xA9\xE3\x81\x82\xF0\x9F\x98\x80";
+	cout << tork::utf8::validate(ok) << ' ' << tork::utf8::count_code_points(ok) << ' '
+		<< tork::utf8::find_invalid(ok) << endl;
+
+	const char* bad[] = { "\x80", "ab\xC0\xAF", "abc\xE3\x81", "\xED\xA0\x80", "x\xF4\x90\x80\x80", "\xF8\x88\x80\x80\x80" };
+	for (const char* b : bad) {
+		std::string s = b;
+		cout << tork::utf8::validate(s) << ':' << tork::utf8::find_invalid(s) << ' ';
+	}
+	cout << endl;
+
+	// ブロックの境目をまたぐシーケンス
+	std::string longer(31, 'a');
+	longer += "\xE3\x81\x82";
+	longer += std::string(40, 'b');
+	std::string cut = longer.substr(0, 33);
+	cout << tork::utf8::validate(longer) << ' ' << tork::utf8::find_invalid(cut) << endl;
+
+	// 乱数で壊した文字列を、命令セットごとに素朴な実装と比べる
+	std::mt19937 rng(7);
+	int mismatch[3] = {};
+	for (int iter = 0; iter < 20000; ++iter) {
+		std::string s = MakeText(rng, rng() % 200, static_cast<int>(rng() % 101));
+		int edits = static_cast<int>(rng() % 3);
+		for (int e = 0; e < edits && !s.empty(); ++e) {
+			size_t pos = rng() % s.size();
+			switch (rng() % 3) {
+			case 0: s[pos] = static_cast<char>(rng()); break;
+			case 1: s.erase(pos, 1); break;
+			default: s.insert(pos, 1, static_cast<char>(0x80 | rng() % 0x80)); break;
+			}
+		}
+		size_t expected = ReferenceFindInvalid(s);
+		size_t count = 0;
+		for (char c : s) count += (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+		for (int l = 0; l < 3; ++l) {
+			if (tork::utf8::impl::FindInvalid(s.data(), s.size(), Levels[l]) != expected
+				|| tork::utf8::impl::CountCodePoints(s.data(), s.size(), Levels[l]) != count) {
+				++mismatch[l];
+			}
+		}
+	}
+	cout << "mismatch " << mismatch[0] << ' ' << mismatch[1] << ' ' << mismatch[2] << endl;
+}
+
+void Bench_utf8()
+{
+	cout << "*** bench utf8 ***" << endl;
+	cout << "detected " << LevelNames[static_cast<int>(tork::utf8::impl::DetectSimdLevel())] << endl;
+
+	std::mt19937 rng(1);
+	const char* names[] = { "ASCII", "ASCII-heavy", "CJK-heavy" };
+	const int percents[] = { 100, 95, 10 };
+	for (int t = 0; t < 3; ++t) {
+		std::string text = MakeText(rng, 1 << 20, percents[t]);
+		const int rounds = 200;
+		double gb = static_cast<double>(text.size()) * rounds / (1 << 30);
+		size_t total = 0;
+		cout << names[t] << " (GB/s)";
+		for (int l = 0; l < 3; ++l) {
+			auto start = Clock::now();
+			for (int i = 0; i < rounds; ++i) {
+				total += tork::utf8::impl::FindInvalid(text.data(), text.size(), Levels[l]);
+			}
+			double validate_ms = Millis(start);
+			start = Clock::now();
+			for (int i = 0; i < rounds; ++i) {
+				total += tork::utf8::impl::CountCodePoints(text.data(), text.size(), Levels[l]);
+			}
+			double count_ms = Millis(start);
+			cout << ' ' << LevelNames[l] << " validate " << gb / validate_ms * 1000
+				<< " count " << gb / count_ms * 1000 << ',';
+		}
+		cout << " (" << total << ")" << endl;
+	}
+}
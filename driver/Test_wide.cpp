@@ -0,0 +1,262 @@
+﻿#include <iostream>
+#include <chrono>
+#include <codecvt>
+#include <cstdint>
+#include <locale>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <tork/text.h>
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double Millis(Clock::time_point begin)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+// 比較用の標準の変換器
+typedef std::conditional<sizeof(wchar_t) == 2,
+	std::codecvt_utf8_utf16<wchar_t>, std::codecvt_utf8<wchar_t>>::type StdCodecvt;
+typedef std::wstring_convert<StdCodecvt> StdConverter;
+
+// システムのロケールの変換器（tork::ToWide / FromWide の比較用）
+// wstring_convert はファセットを delete するので、デストラクタを公開する
+struct LocaleCodecvt : std::codecvt_byname<wchar_t, char, std::mbstate_t> {
+	LocaleCodecvt() :std::codecvt_byname<wchar_t, char, std::mbstate_t>("") { }
+	~LocaleCodecvt() { }
+};
+typedef std::wstring_convert<LocaleCodecvt> LocaleConverter;
+
+// 16 進で表示
+template<class String>
+std::string Hex(const String& s)
+{
+	static const char digits[] = "0123456789ABCDEF";
+	std::string r;
+	for (size_t i = 0; i < s.size(); ++i) {
+		uint32_t c = static_cast<uint32_t>(s[i]) & (sizeof(s[i]) == 1 ? 0xFF : sizeof(s[i]) == 2 ? 0xFFFF : 0xFFFFFFFF);
+		if (i) r += ' ';
+		std::string h;
+		do {
+			h.insert(h.begin(), digits[c & 15]);
+			c >>= 4;
+		} while (c);
+		r += h;
+	}
+	return r;
+}
+
+// 変換結果か、例外なら "range_error"
+template<class F>
+std::string ResultOf(F f)
+{
+	try {
+		return Hex(f());
+	}
+	catch (const std::range_error&) {
+		return "range_error";
+	}
+}
+
+std::string ThrowResult(const std::string& s)
+{
+	try {
+		tork::Utf8ToWide(s);
+	}
+	catch (const std::range_error&) {
+		return "range_error";
+	}
+	return "no exception";
+}
+
+// 乱数で文字列を作る（ascii_percent の割合で ASCII、残りは漢字など）
+std::string MakeText(size_t bytes, int ascii_percent, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::wstring w;
+	size_t n = 0;
+	while (n < bytes) {
+		uint32_t cp;
+		int r = static_cast<int>(rng() % 100);
+		if (r < ascii_percent) {
+			cp = 0x20 + rng() % 0x5F;
+			n += 1;
+		}
+		else if (r < ascii_percent + (100 - ascii_percent) * 9 / 10) {
+			cp = 0x4E00 + rng() % 0x5000;
+			n += 3;
+		}
+		else {
+			cp = 0x1F300 + rng() % 0x200;
+			n += 4;
+		}
+		if (sizeof(wchar_t) == 2 && cp >= 0x10000) {
+			w += static_cast<wchar_t>(0xD800 + ((cp - 0x10000) >> 10));
+			w += static_cast<wchar_t>(0xDC00 + ((cp - 0x10000) & 0x3FF));
+		}
+		else {
+			w += static_cast<wchar_t>(cp);
+		}
+	}
+	return StdConverter().to_bytes(w);
+}
+
+void BenchCorpus(const char* name, const std::string& text)
+{
+	const int rounds = 200;
+	double mb = static_cast<double>(text.size()) * rounds / (1024 * 1024);
+	std::wstring w = tork::Utf8ToWide(text);
+	size_t total = 0;
+
+	auto t = Clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		total += tork::Utf8ToWide(text).size();
+	}
+	double to_ms = Millis(t);
+	t = Clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		total += tork::WideToUtf8(w).size();
+	}
+	double from_ms = Millis(t);
+
+	// 呼び出し側のバッファ（確保なし）
+	std::wstring wbuf(w.size(), L'\0');
+	t = Clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		total += tork::Utf8ToWide(text.data(), text.data() + text.size(), &wbuf[0]) - &wbuf[0];
+	}
+	double to_buf_ms = Millis(t);
+
+	StdConverter conv;
+	t = Clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		total += conv.from_bytes(text).size();
+	}
+	double std_to_ms = Millis(t);
+	t = Clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		total += conv.to_bytes(w).size();
+	}
+	double std_from_ms = Millis(t);
+
+	cout << name << " (MB/s of UTF-8): Utf8ToWide " << mb / to_ms * 1000 << ", Utf8ToWide(buffer) " << mb / to_buf_ms * 1000
+		<< ", WideToUtf8 " << mb / from_ms * 1000 << ", wstring_convert from_bytes " << mb / std_to_ms * 1000
+		<< ", to_bytes " << mb / std_from_ms * 1000 << " (" << total << ")" << endl;
+}
+
+}   // anonymous namespace
+
+void Test_wide()
+{
+	cout << "*** test wide ***" << endl;
+
+	// 1～4 バイトの文字
+	std::string s = "A\xC3\xA9\xE3\x81\x82\xF0\x9F\x98\x80";     // A é あ 😀
+	std::wstring w = tork::Utf8ToWide(s);
+	cout << Hex(w) << ' ' << tork::Utf8ToWideLength(s.data(), s.data() + s.size()) << ' '
+		<< (tork::WideToUtf8(w) == s) << ' ' << tork::WideToUtf8Length(w.data(), w.data() + w.size()) << endl;
+	cout << (tork::Utf8ToWide(s.c_str()) == w) << ' ' << (tork::WideToUtf8(w.c_str()) == s) << ' '
+		<< tork::Utf8ToWide("").empty() << ' ' << tork::WideToUtf8(L"").empty() << endl;
+
+	// ASCII の高速経路（16 文字単位とその端数）
+	std::string ascii = "The quick brown fox jumps over the lazy dog 0123456789";
+	cout << (tork::WideToUtf8(tork::Utf8ToWide(ascii)) == ascii) << ' ' << tork::Utf8ToWide(ascii).size() << endl;
+
+	// 不正なシーケンスの置き換え（最大部分ごとに 1 文字）
+	const char* bad[] = {
+		"a\x80z",               // 単独の継続バイト
+		"a\xC0\xAFz",           // 冗長な表現
+		"a\xE3\x81z",           // 途中で切れた 3 バイト文字
+		"a\xED\xA0\x80z",       // サロゲート
+		"a\xF4\x90\x80\x80z",   // U+10FFFF 超
+		"a\xF0\x9F\x98",        // 末尾で切れた 4 バイト文字
+	};
+	for (const char* b : bad) {
+		std::wstring r = tork::Utf8ToWide(b, tork::InvalidSequence::Replace);
+		cout << Hex(r) << " / " << ThrowResult(b) << endl;
+	}
+
+	// 不正なワイド文字
+	std::wstring lone;
+	lone += L'x';
+	lone += static_cast<wchar_t>(0xDC00);
+	lone += L'y';
+	cout << Hex(tork::WideToUtf8(lone, tork::InvalidSequence::Replace)) << ' '
+		<< tork::WideToUtf8Length(lone.data(), lone.data() + lone.size()) << endl;
+	try {
+		tork::WideToUtf8(lone);
+		cout << "no exception" << endl;
+	}
+	catch (const std::range_error&) {
+		cout << "range_error" << endl;
+	}
+
+	// 標準の変換器と比べる
+	int mismatch = 0;
+	for (unsigned seed = 0; seed < 200; ++seed) {
+		std::string text = MakeText(seed * 7 % 300, static_cast<int>(seed % 101), seed);
+		std::wstring expected = StdConverter().from_bytes(text);
+		if (tork::Utf8ToWide(text) != expected || tork::WideToUtf8(expected) != text) ++mismatch;
+	}
+	cout << "mismatch " << mismatch << endl;
+
+	// 乱数のバイト列でも長さと一致し、往復で置換文字以外は保たれる
+	std::mt19937 rng(3);
+	int length_mismatch = 0;
+	for (int i = 0; i < 10000; ++i) {
+		std::string text(rng() % 40, '\0');
+		for (auto& c : text) c = static_cast<char>(rng() % 4 == 0 ? rng() : rng() % 0x80);
+		std::wstring r = tork::Utf8ToWide(text, tork::InvalidSequence::Replace);
+		if (r.size() != tork::Utf8ToWideLength(text.data(), text.data() + text.size())) ++length_mismatch;
+		std::string back = tork::WideToUtf8(r);
+		if (back.size() != tork::WideToUtf8Length(r.data(), r.data() + r.size())) ++length_mismatch;
+	}
+	cout << "length mismatch " << length_mismatch << endl;
+
+	// ToWide / FromWide はシステムのロケールで変換する（wstring_convert と同じ結果）
+	const std::string samples[] = { ascii, "", s, "abc\x82\xA0xyz" };
+	int locale_mismatch = 0;
+	for (const auto& sample : samples) {
+		std::string expected = ResultOf([&] { return LocaleConverter(new LocaleCodecvt).from_bytes(sample); });
+		if (ResultOf([&] { return tork::ToWide(sample); }) != expected) ++locale_mismatch;
+		if (ResultOf([&] { return tork::ToWide(sample.c_str()); }) != expected) ++locale_mismatch;
+		if (expected != "range_error") {
+			std::wstring wide = tork::ToWide(sample);
+			if (tork::FromWide(wide) != sample || tork::FromWide(wide.c_str()) != sample) ++locale_mismatch;
+		}
+	}
+	cout << (tork::ToWide(ascii) == std::wstring(ascii.begin(), ascii.end())) << ' '
+		<< "locale mismatch " << locale_mismatch << endl;
+}
+
+void Bench_wide()
+{
+	cout << "*** bench wide ***" << endl;
+
+	BenchCorpus("ASCII-heavy", MakeText(1 << 20, 97, 1));
+	BenchCorpus("CJK-heavy", MakeText(1 << 20, 5, 2));
+
+	// システムのロケールの変換（短い ASCII 文字列を何度も変換する）
+	const std::string key = "configuration/window/width";
+	const int rounds = 100000;
+	size_t total = 0;
+	auto t = Clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		total += tork::ToWide(key).size();
+	}
+	double to_ms = Millis(t);
+	t = Clock::now();
+	for (int i = 0; i < rounds; ++i) {
+		total += LocaleConverter(new LocaleCodecvt).from_bytes(key).size();
+	}
+	double std_ms = Millis(t);
+	cout << "ToWide (locale) " << rounds << " short strings: " << to_ms << " ms, wstring_convert per call "
+		<< std_ms << " ms (" << total << ")" << endl;
+}
@@ -25,6 +25,53 @@ void Test_enable_shared_from_this(); // enabld_shared_from_this テスト
 void Test_pointer_traits();  // std::pointer_traits<shared_ptr<T>> など
 
 void Test_Array();
+void Test_Vector();          // Vector テスト
+void Test_span();            // span, SharedSlice テスト
+void Test_SoAArray();        // SoAArray テスト
+void Test_SegmentedArray();  // SegmentedArray テスト
+void Test_MappedArray();     // MappedArray テスト
+void Test_FlatHashMap();     // FlatHashMap テスト
+void Test_ConcurrentHashMap(); // ConcurrentHashMap テスト
+void Test_queue();           // SpscRing, MpmcQueue テスト
+void Test_intrusive();       // IntrusiveList, IntrusiveHashSet テスト
+void Test_LruCache();        // LruCache テスト
+void Test_FlatMap();         // FlatMap, FlatSet テスト
+void Test_DynamicBitset();   // DynamicBitset, RankSelectIndex テスト
+void Test_parallel();        // 並列アルゴリズム テスト
+void Test_ThreadPool();      // ThreadPool, TaskGroup テスト
+void Test_charconv();        // to_chars, from_chars テスト
+void Test_string_view();     // string_view テスト
+void Test_format();          // format_to, append_to テスト
+void Test_wide();            // ToWide, Utf8ToWide テスト
+void Test_utf8();            // utf8::validate, count_code_points テスト
+void Test_split();           // text::split, tokenize, find_any_of テスト
+void Test_csv();             // text::parse_numbers, parse_csv テスト
+void Test_StringPool();      // StringPool テスト
+void Test_SharedString();    // SharedString テスト
+void Test_Cord();            // Cord テスト
+
+void Bench_SharedArray_freeze(); // SharedArray::freeze() 複数スレッド読み取り
+void Bench_SoAArray();       // SoAArray 列の合計 AoS/SoA 比較
+void Bench_SegmentedArray(); // SegmentedArray push_back レイテンシ
+void Bench_Vector_check();   // Vector 範囲チェック方法の比較
+void Bench_FlatHashMap();    // FlatHashMap と std::unordered_map の比較
+void Bench_ConcurrentHashMap(); // ConcurrentHashMap スレッド数ごとのスループット
+void Bench_queue();          // SpscRing, MpmcQueue と mutex キューの比較
+void Bench_intrusive_lru();  // LRU の std::list + unordered_map と侵入型の比較
+void Bench_LruCache();       // LruCache の LRU と CLOCK の比較
+void Bench_FlatMap();        // FlatMap と std::map, std::unordered_map の検索時間
+void Bench_DynamicBitset();  // DynamicBitset と std::vector<bool> の比較
+void Bench_parallel();       // 並列アルゴリズムのスレッド数ごとの速度
+void Bench_ThreadPool();     // fib, nqueens と過剰スレッド時のスループット
+void Bench_charconv();       // to_chars, from_chars とストリームの比較
+void Bench_format();         // format_to と to_string 連結、snprintf の比較
+void Bench_wide();           // Utf8ToWide, WideToUtf8 と wstring_convert の比較
+void Bench_utf8();           // utf8::validate, count_code_points の命令セットごとの速度
+void Bench_split();          // text::split, tokenize と string::find, istringstream の比較
+void Bench_csv();            // text::parse_csv, parse_numbers と iostream の比較
+void Bench_StringPool();     // StringPool と std::unordered_set のメモリと検索の比較
+void Bench_SharedString();   // SharedString と std::string のコピー、substr の比較
+void Bench_Cord();           // Cord と std::string の追加、連結の比較
 
 
 // エントリポイント
@@ -47,6 +94,53 @@ int main()
     Test_enable_shared_from_this();
 
     Test_text();
+    Test_Vector();
+    Test_span();
+    Test_SoAArray();
+    Test_SegmentedArray();
+    Test_MappedArray();
+    Test_FlatHashMap();
+    Test_ConcurrentHashMap();
+    Test_queue();
+    Test_intrusive();
+    Test_LruCache();
+    Test_FlatMap();
+    Test_DynamicBitset();
+    Test_parallel();
+    Test_ThreadPool();
+    Test_charconv();
+    Test_string_view();
+    Test_format();
+    Test_wide();
+    Test_utf8();
+    Test_split();
+    Test_csv();
+    Test_StringPool();
+    Test_SharedString();
+    Test_Cord();
+
+    Bench_SharedArray_freeze();
+    Bench_SoAArray();
+    Bench_SegmentedArray();
+    Bench_Vector_check();
+    Bench_FlatHashMap();
+    Bench_ConcurrentHashMap();
+    Bench_queue();
+    Bench_intrusive_lru();
+    Bench_LruCache();
+    Bench_FlatMap();
+    Bench_DynamicBitset();
+    Bench_parallel();
+    Bench_ThreadPool();
+    Bench_charconv();
+    Bench_format();
+    Bench_wide();
+    Bench_utf8();
+    Bench_split();
+    Bench_csv();
+    Bench_StringPool();
+    Bench_SharedString();
+    Bench_Cord();
     */
     stopper();
     return 0;
@@ -4,13 +4,22 @@
 #include "tork/define.h"
 #include "tork/debug.h"
 #include "tork/optional.h"
+#include "tork/span.h"
+#include "tork/string_view.h"
+#include "tork/charconv.h"
 #include "tork/text.h"
+#include "tork/format.h"
+#include "tork/utf8.h"
+#include "tork/text/split.h"
+#include "tork/text/csv.h"
 #include "tork/algorithm.h"
 #include "tork/function.h"
+#include "tork/parallel.h"
 
 #include "tork/container.h"
 #include "tork/app.h"
 #include "tork/memory.h"
+#include "tork/thread.h"
 
 namespace tork {
 
@@ -0,0 +1,68 @@
+﻿//******************************************************************************
+//
+// ビット操作と SSE2 の有無（ライブラリの実装で使う）
+//
+// SSE2 が使えるときは TORK_HAS_SSE2 を定義し、<emmintrin.h> を読み込む
+//
+//******************************************************************************
+
+#ifndef TORK_BITS_H_INCLUDED
+#define TORK_BITS_H_INCLUDED
+
+#include <cassert>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TORK_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace tork {
+
+    namespace impl {
+
+// 最下位の立っているビットの位置（x != 0）
+inline unsigned CountTrailingZeros(unsigned x)
+{
+    assert(x != 0);
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward(&idx, x);
+    return static_cast<unsigned>(idx);
+#elif defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctz(x));
+#else
+    unsigned n = 0;
+    while ((x & 1) == 0) {
+        x >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+// 64 ビット版（x != 0）
+inline unsigned CountTrailingZeros64(uint64_t x)
+{
+    assert(x != 0);
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctzll(x));
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long idx;
+    _BitScanForward64(&idx, x);
+    return static_cast<unsigned>(idx);
+#else
+    unsigned lo = static_cast<unsigned>(x);
+    return lo ? CountTrailingZeros(lo) : CountTrailingZeros(static_cast<unsigned>(x >> 32)) + 32;
+#endif
+}
+
+    }   // namespace tork::impl
+
+}   // namespace tork
+
+#endif  // TORK_BITS_H_INCLUDED
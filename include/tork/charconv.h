@@ -0,0 +1,167 @@
+﻿//******************************************************************************
+//
+// 数値と文字列の相互変換（ストリームを使わない）
+//
+// std::to_chars / std::from_chars と同じ形のインターフェイス
+// ロケールに依存せず、ヒープ確保もしない
+// 浮動小数点数は、読み戻すと元の値に戻る最短の桁数で書き出す
+//
+//******************************************************************************
+
+#ifndef TORK_CHARCONV_H_INCLUDED
+#define TORK_CHARCONV_H_INCLUDED
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <system_error>
+#include <type_traits>
+
+namespace tork {
+
+// to_chars() の結果
+struct to_chars_result {
+    char* ptr;          // 書き込んだ末尾（失敗したら last）
+    std::errc ec;       // 成功なら std::errc()
+};
+
+// from_chars() の結果
+struct from_chars_result {
+    const char* ptr;    // 読み終えた位置（数値がなければ first）
+    std::errc ec;       // 成功なら std::errc()
+};
+
+    namespace impl {
+
+// 文字型（数値として扱わない整数型）
+template<class T> struct IsCharType : std::false_type { };
+template<> struct IsCharType<char> : std::true_type { };
+template<> struct IsCharType<signed char> : std::true_type { };
+template<> struct IsCharType<unsigned char> : std::true_type { };
+template<> struct IsCharType<wchar_t> : std::true_type { };
+#if !defined(_MSC_VER) || _MSC_VER >= 1900
+// VS2013 までは char16_t / char32_t が unsigned short / unsigned int の別名
+template<> struct IsCharType<char16_t> : std::true_type { };
+template<> struct IsCharType<char32_t> : std::true_type { };
+#endif
+
+// to_chars() / from_chars() で扱う整数型
+template<class T>
+struct IsCharconvInteger : std::integral_constant<bool,
+    std::is_integral<T>::value && !std::is_same<T, bool>::value && !IsCharType<T>::value> { };
+
+// to_chars() / from_chars() で扱う浮動小数点型
+template<class T>
+struct IsCharconvFloat : std::integral_constant<bool,
+    std::is_same<T, float>::value || std::is_same<T, double>::value> { };
+
+// 変換に必要な最大文字数（符号を含む）
+const size_t MaxIntegerChars = 20;
+const size_t MaxFloatChars = 24;
+
+// 10 進の桁数
+unsigned CountDigits32(uint32_t v);
+unsigned CountDigits64(uint64_t v);
+
+// end の直前から後ろ向きに 10 進で書く
+void WriteDigits32(char* end, uint32_t v);
+void WriteDigits64(char* end, uint64_t v);
+
+// 10 進の数字列を読む（max を超えたら out_of_range）
+from_chars_result ParseDecimal(const char* first, const char* last, uint64_t max, uint64_t& value);
+
+// 浮動小数点数
+to_chars_result FormatDouble(char* first, char* last, double value);
+to_chars_result FormatFloat(char* first, char* last, float value);
+from_chars_result ParseDouble(const char* first, const char* last, double& value);
+from_chars_result ParseFloat(const char* first, const char* last, float& value);
+
+// 負数かどうか（符号なし型で警告を出さない）
+template<class T>
+inline bool IsNegative(T v, std::true_type) { return v < 0; }
+template<class T>
+inline bool IsNegative(T, std::false_type) { return false; }
+
+    }   // namespace tork::impl
+
+// 整数を 10 進で書く
+template<class T>
+typename std::enable_if<impl::IsCharconvInteger<T>::value, to_chars_result>::type
+to_chars(char* first, char* last, T value)
+{
+    typedef typename std::make_unsigned<T>::type U;
+    U u = static_cast<U>(value);
+    bool negative = impl::IsNegative(value, std::is_signed<T>());
+    if (negative) u = static_cast<U>(0 - u);
+
+    unsigned digits = (sizeof(U) <= 4) ? impl::CountDigits32(static_cast<uint32_t>(u))
+                                       : impl::CountDigits64(u);
+    size_t n = digits + (negative ? 1 : 0);
+    if (static_cast<size_t>(last - first) < n) {
+        to_chars_result r = { last, std::errc::value_too_large };
+        return r;
+    }
+    if (negative) *first = '-';
+    if (sizeof(U) <= 4) {
+        impl::WriteDigits32(first + n, static_cast<uint32_t>(u));
+    }
+    else {
+        impl::WriteDigits64(first + n, u);
+    }
+    to_chars_result r = { first + n, std::errc() };
+    return r;
+}
+
+// 浮動小数点数を最短の桁数で書く
+// 固定小数点と指数表記のうち短いほうを使う（inf, -inf, nan も書く）
+inline to_chars_result to_chars(char* first, char* last, double value)
+{
+    return impl::FormatDouble(first, last, value);
+}
+inline to_chars_result to_chars(char* first, char* last, float value)
+{
+    return impl::FormatFloat(first, last, value);
+}
+
+// 10 進の整数を読む
+// 符号付きなら先頭の '-' を受け付ける（'+' や空白は受け付けない）
+template<class T>
+typename std::enable_if<impl::IsCharconvInteger<T>::value, from_chars_result>::type
+from_chars(const char* first, const char* last, T& value)
+{
+    typedef typename std::make_unsigned<T>::type U;
+    const char* p = first;
+    bool negative = false;
+    if (std::is_signed<T>::value && p != last && *p == '-') {
+        negative = true;
+        ++p;
+    }
+    uint64_t max = static_cast<uint64_t>(std::numeric_limits<T>::max());
+    if (negative) ++max;
+
+    uint64_t v;
+    from_chars_result r = impl::ParseDecimal(p, last, max, v);
+    if (r.ec == std::errc::invalid_argument) {
+        r.ptr = first;
+    }
+    else if (r.ec == std::errc()) {
+        value = negative ? static_cast<T>(0 - static_cast<U>(v)) : static_cast<T>(v);
+    }
+    return r;
+}
+
+// 浮動小数点数を読む
+// [-] 数字列 [. 数字列] [e [+-] 数字列]、inf、infinity、nan を受け付ける
+// 結果は最も近い値に丸める。表せない大きさなら out_of_range
+inline from_chars_result from_chars(const char* first, const char* last, double& value)
+{
+    return impl::ParseDouble(first, last, value);
+}
+inline from_chars_result from_chars(const char* first, const char* last, float& value)
+{
+    return impl::ParseFloat(first, last, value);
+}
+
+}   // namespace tork
+
+#endif  // TORK_CHARCONV_H_INCLUDED
@@ -4,5 +4,18 @@
 #include "container/Vector.h"
 #include "container/Array.h"
 #include "container/SharedArray.h"
+#include "container/SoAArray.h"
+#include "container/SegmentedArray.h"
+#include "container/MappedArray.h"
+#include "container/FlatHashMap.h"
+#include "container/ConcurrentHashMap.h"
+#include "container/IntrusiveList.h"
+#include "container/IntrusiveHashSet.h"
+#include "container/LruCache.h"
+#include "container/FlatMap.h"
+#include "container/DynamicBitset.h"
+#include "container/StringPool.h"
+#include "container/SharedString.h"
+#include "container/Cord.h"
 
 #endif  // TORK_CONTAINER_H_INCLUDED
@@ -279,7 +279,9 @@ private:
     void ResizeImpl(size_type sz, Arg&& value)
     {
         if (sz < size()) {
-            for (size_type i = 0; i < size() - sz; ++i) {
+            // pop_back() で size() が減るので、削除する数は先に求めておく
+            size_type n = size() - sz;
+            for (size_type i = 0; i < n; ++i) {
                 pop_back();
             }
         }
@@ -0,0 +1,244 @@
+﻿//******************************************************************************
+//
+// 複数スレッドから使えるハッシュマップ
+//
+// キーのハッシュ値で N 個のシャードに振り分け、シャードごとに読み書きスピンロックで守る
+// 値はコピーで返すので、tork::shared_ptr を値にすればロックの外でも生存が保証される
+//
+//******************************************************************************
+
+#ifndef TORK_CONTAINER_CONCURRENT_HASH_MAP_H_INCLUDED
+#define TORK_CONTAINER_CONCURRENT_HASH_MAP_H_INCLUDED
+
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <memory>
+#include "FlatHashMap.h"
+#include "../optional.h"
+#include "../thread/SpinLock.h"
+
+namespace tork {
+
+//==============================================================================
+// 並行ハッシュマップクラス
+//==============================================================================
+template<class K, class V,
+    class Hash = std::hash<K>,
+    class KeyEqual = std::equal_to<K>,
+    class Allocator = tork::allocator<std::pair<const K, V>>>
+class ConcurrentHashMap {
+public:
+    typedef K key_type;
+    typedef V mapped_type;
+    typedef std::pair<const K, V> value_type;
+    typedef size_t size_type;
+    typedef Hash hasher;
+    typedef KeyEqual key_equal;
+
+    typedef FlatHashMap<K, V, Hash, KeyEqual, Allocator> MapType;
+
+private:
+    // シャード
+    // 隣のシャードとキャッシュラインを共有しないように後ろを埋める
+    struct Shard {
+        mutable RWSpinLock lock;
+        MapType map;
+        char padding[64];
+    };
+
+    std::unique_ptr<Shard[]> shards_;
+    size_type shard_count_ = 0;     // 2 の冪
+    unsigned shard_shift_ = 0;
+    Hash hash_;
+
+public:
+
+    // シャード数を指定して構築
+    // 0 ならハードウェアスレッド数の 4 倍を 2 の冪に切り上げた数
+    explicit ConcurrentHashMap(size_type shard_count = 0)
+    {
+        if (shard_count == 0) {
+            shard_count = std::thread::hardware_concurrency() * 4;
+        }
+        if (shard_count > 4096) shard_count = 4096;
+
+        unsigned bits = 0;
+        while ((size_type(1) << bits) < shard_count) {
+            ++bits;
+        }
+        shard_count_ = size_type(1) << bits;
+        // 上位7ビットは各シャードの FlatHashMap が制御バイトに使うので、その下を使う
+        shard_shift_ = static_cast<unsigned>(sizeof(size_t) * 8 - 7 - bits);
+        shards_.reset(new Shard[shard_count_]);
+    }
+
+    ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+    ConcurrentHashMap& operator =(const ConcurrentHashMap&) = delete;
+
+    // 検索
+    // 見つかれば値のコピーを返す
+    optional<V> find(const K& key) const
+    {
+        const Shard& s = shard_of(key);
+        SharedLockGuard<RWSpinLock> guard(s.lock);
+        auto it = s.map.find(key);
+        if (it == s.map.end()) return optional<V>();
+        return optional<V>(it->second);
+    }
+
+    // キーがあるかどうか
+    bool contains(const K& key) const
+    {
+        const Shard& s = shard_of(key);
+        SharedLockGuard<RWSpinLock> guard(s.lock);
+        return s.map.contains(key);
+    }
+
+    // 挿入または代入
+    // 新しく挿入した場合は true
+    template<class M>
+    bool insert_or_assign(const K& key, M&& value)
+    {
+        Shard& s = shard_of(key);
+        std::lock_guard<RWSpinLock> guard(s.lock);
+        return s.map.insert_or_assign(key, std::forward<M>(value)).second;
+    }
+
+    // 削除
+    // 削除した場合は true
+    bool erase(const K& key)
+    {
+        Shard& s = shard_of(key);
+        std::lock_guard<RWSpinLock> guard(s.lock);
+        return s.map.erase(key) != 0;
+    }
+
+    // キーがなければ f(key) の結果を挿入し、どちらの場合もキーの値を返す
+    // f はシャードの書き込みロック中に呼ばれるので、同じマップを操作しないこと
+    template<class Function>
+    V compute_if_absent(const K& key, Function f)
+    {
+        Shard& s = shard_of(key);
+        {
+            SharedLockGuard<RWSpinLock> guard(s.lock);
+            auto it = s.map.find(key);
+            if (it != s.map.end()) return it->second;
+        }
+        std::lock_guard<RWSpinLock> guard(s.lock);
+        // 読み込みロックを外している間に他のスレッドが挿入したかもしれない
+        auto it = s.map.find(key);
+        if (it != s.map.end()) return it->second;
+        return s.map.try_emplace(key, f(key)).first->second;
+    }
+
+    // 全要素に f(key, value) を適用する
+    // シャードごとに読み込みロックを取るので、全体の一貫したスナップショットではない
+    template<class Function>
+    void for_each(Function f) const
+    {
+        for (size_type i = 0; i < shard_count_; ++i) {
+            for_each_in_shard(i, f);
+        }
+    }
+
+    // シャードを threads 個のスレッドに分けて f(key, value) を適用する
+    // threads が 0 ならハードウェアスレッド数
+    template<class Function>
+    void parallel_for_each(Function f, unsigned threads = 0) const
+    {
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        if (threads == 0) threads = 1;
+        if (threads > shard_count_) threads = static_cast<unsigned>(shard_count_);
+        if (threads <= 1) {
+            for_each(f);
+            return;
+        }
+
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        size_type per = shard_count_ / threads;
+        size_type rest = shard_count_ % threads;
+        size_type first = 0;
+        for (unsigned t = 0; t < threads; ++t) {
+            size_type last = first + per + (t < rest ? 1 : 0);
+            auto task = [this, &f, first, last]() {
+                for (size_type i = first; i < last; ++i) {
+                    for_each_in_shard(i, f);
+                }
+            };
+            // 最後の区間は呼び出したスレッドで処理する
+            if (t + 1 == threads) task();
+            else workers.push_back(std::thread(task));
+            first = last;
+        }
+        for (auto& w : workers) {
+            w.join();
+        }
+    }
+
+    // 全要素の削除
+    void clear()
+    {
+        for (size_type i = 0; i < shard_count_; ++i) {
+            std::lock_guard<RWSpinLock> guard(shards_[i].lock);
+            shards_[i].map.clear();
+        }
+    }
+
+    // n 要素を再ハッシュなしで入れられるようにする（均等に散らばる前提）
+    void reserve(size_type n)
+    {
+        size_type per = (n + shard_count_ - 1) / shard_count_;
+        for (size_type i = 0; i < shard_count_; ++i) {
+            std::lock_guard<RWSpinLock> guard(shards_[i].lock);
+            shards_[i].map.reserve(per);
+        }
+    }
+
+    // 要素数
+    // 他のスレッドが更新中なら概算
+    size_type size() const
+    {
+        size_type n = 0;
+        for (size_type i = 0; i < shard_count_; ++i) {
+            SharedLockGuard<RWSpinLock> guard(shards_[i].lock);
+            n += shards_[i].map.size();
+        }
+        return n;
+    }
+
+    // 空かどうか
+    bool empty() const { return size() == 0; }
+
+    // シャード数
+    size_type shard_count() const { return shard_count_; }
+
+private:
+
+    // キーの属するシャード
+    // シャード内の FlatHashMap は畳み込んだ下位ビットでグループを選ぶので、
+    // ここで上位ビットを使っても、シャードの中でキーが偏ることはない
+    size_type shard_index(const K& key) const
+    {
+        return (impl::HashMix(hash_(key)) >> shard_shift_) & (shard_count_ - 1);
+    }
+    Shard& shard_of(const K& key) { return shards_[shard_index(key)]; }
+    const Shard& shard_of(const K& key) const { return shards_[shard_index(key)]; }
+
+    // 1つのシャードの全要素に f を適用する
+    template<class Function>
+    void for_each_in_shard(size_type i, Function& f) const
+    {
+        const Shard& s = shards_[i];
+        SharedLockGuard<RWSpinLock> guard(s.lock);
+        for (auto it = s.map.begin(); it != s.map.end(); ++it) {
+            f(it->first, it->second);
+        }
+    }
+
+};  // class ConcurrentHashMap
+
+}   // namespace tork
+
+#endif  // TORK_CONTAINER_CONCURRENT_HASH_MAP_H_INCLUDED
@@ -0,0 +1,405 @@
+﻿//******************************************************************************
+//
+// コード（大きな文字列を組み立てるためのロープ）
+//
+// 文字は参照カウント付きのチャンクに置き、文字列はチャンクの範囲を並べて表す
+// 連結はチャンクをつなぐだけで、コピーしたコードとはチャンクを共有する
+// 連続した文字列が必要になったときだけ flatten() でひとつにまとめる
+//
+//******************************************************************************
+
+#ifndef TORK_CONTAINER_CORD_H_INCLUDED
+#define TORK_CONTAINER_CORD_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "../string_view.h"
+
+namespace tork {
+
+    namespace impl {
+
+// コードの節
+// Flat は文字を持ち、List は他の節の範囲を並べる
+struct CordNode {
+    std::atomic<int> ref_counter;   // 参照カウンタ
+    bool is_flat;                   // Flat かどうか
+    unsigned char depth;            // List の入れ子の深さ（Flat は 0）
+
+    CordNode(bool flat, unsigned char d) :ref_counter(1), is_flat(flat), depth(d) { }
+
+    // 参照を増やす
+    void add_ref()
+    {
+        ref_counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 参照を減らし、最後なら破棄する
+    void release()
+    {
+        if (ref_counter.fetch_sub(1, std::memory_order_acq_rel) == 1) destroy(this);
+    }
+
+    // 他から参照されていないかどうか（書き換えてよいかどうか）
+    bool is_unique() const
+    {
+        return ref_counter.load(std::memory_order_acquire) == 1;
+    }
+
+    // 破棄
+    static void destroy(CordNode* node);
+};
+
+// 節の範囲
+struct CordPiece {
+    CordNode* node;
+    size_t offset;
+    size_t length;
+};
+
+// 文字を持つ節
+// data の [0, used) は書き込み済みで、以後は変わらない
+struct CordFlat : CordNode {
+    std::atomic<size_t> used;   // 書き込み済みのバイト数
+    size_t capacity;            // data の大きさ
+    char data[1];               // 実際は capacity バイト
+
+    // 作成（参照カウントは 1）
+    static CordFlat* create(size_t capacity);
+
+    // end で終わる範囲を伸ばすために、end から最大 n バイトの空きを確保する
+    // end が used でなければ（別の範囲が先に伸ばしていれば）確保せずに 0 を返す
+    // Flat を共有していても、同じ空きを 2 つの範囲に渡すことはない
+    size_t claim(size_t end, size_t n)
+    {
+        size_t k = capacity - end < n ? capacity - end : n;
+        if (k == 0) return 0;
+        return used.compare_exchange_strong(end, end + k, std::memory_order_relaxed) ? k : 0;
+    }
+
+private:
+    CordFlat(size_t cap) :CordNode(true, 0), used(0), capacity(cap) { }
+};
+
+// 範囲を並べる節
+struct CordList : CordNode {
+    std::vector<CordPiece> pieces;
+    size_t length = 0;  // pieces の長さの合計
+
+    explicit CordList(unsigned char d = 1) :CordNode(false, d) { }
+    ~CordList();
+};
+
+    }   // namespace tork::impl
+
+//==============================================================================
+// コード
+// 値として扱えて、コピーは O(1)。別スレッドのコードとチャンクを共有してもよいが、
+// ひとつのコードを複数のスレッドから同時に変更してはいけない
+//==============================================================================
+class Cord {
+public:
+    typedef size_t size_type;
+
+    static const size_type npos = size_type(-1);
+
+    // 新しく作るチャンクの大きさ（これより長い断片はそのままの大きさで作る）
+    static const size_type MinFlatSize = 64;
+    static const size_type MaxFlatSize = 4080;
+
+    // これ以下の長さのコードを連結するときはチャンクをつながずにコピーする
+    static const size_type CopyThreshold = 256;
+
+    // 節の入れ子の最大の深さ（超えたら並べ直す）
+    static const int MaxDepth = 16;
+
+    class chunk_iterator;
+    class chunk_range;
+
+private:
+    typedef impl::CordNode Node;
+    typedef impl::CordFlat Flat;
+    typedef impl::CordList List;
+    typedef impl::CordPiece Piece;
+
+    List* root_ = nullptr;  // 空なら nullptr
+
+public:
+
+    // 空のコード
+    Cord() { }
+
+    // 文字列をコピーして作る
+    // string_view との間で曖昧にならないように、文字列からの変換は explicit にする
+    explicit Cord(const char* s)
+    {
+        append(string_view(s));
+    }
+    explicit Cord(const std::string& s)
+    {
+        append(string_view(s));
+    }
+    explicit Cord(string_view s)
+    {
+        append(s);
+    }
+
+    // コピーコンストラクタ（チャンクは共有する）
+    Cord(const Cord& other) :root_(other.root_)
+    {
+        if (root_) root_->add_ref();
+    }
+
+    // ムーブコンストラクタ
+    Cord(Cord&& other) :root_(other.root_)
+    {
+        other.root_ = nullptr;
+    }
+
+    // デストラクタ
+    ~Cord()
+    {
+        if (root_) root_->release();
+    }
+
+    // コピー代入
+    Cord& operator =(const Cord& other)
+    {
+        Cord(other).swap(*this);
+        return *this;
+    }
+
+    // ムーブ代入
+    Cord& operator =(Cord&& other)
+    {
+        Cord(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    // 入れ替え
+    void swap(Cord& other)
+    {
+        List* t = root_;
+        root_ = other.root_;
+        other.root_ = t;
+    }
+
+    // 文字数
+    size_type size() const { return root_ ? root_->length : 0; }
+    size_type length() const { return size(); }
+
+    // 空かどうか
+    bool empty() const { return size() == 0; }
+
+    // 空にする
+    void clear()
+    {
+        if (root_) root_->release();
+        root_ = nullptr;
+    }
+
+    // 末尾に追加
+    // 最後のチャンクがその書き込み済みの末尾で終わっていれば、共有していてもその空きにコピーする
+    void append(const char* s, size_type n);
+    void append(string_view s) { append(s.data(), s.size()); }
+
+    // 末尾にコードを追加（短くなければチャンクをつなぐだけ）
+    void append(const Cord& other);
+
+    Cord& operator +=(string_view s) { append(s); return *this; }
+    Cord& operator +=(const char* s) { append(string_view(s)); return *this; }
+    Cord& operator +=(const std::string& s) { append(string_view(s)); return *this; }
+    Cord& operator +=(const Cord& other) { append(other); return *this; }
+
+    // 部分コード（チャンクは共有する）
+    Cord substr(size_type pos, size_type n = npos) const;
+
+    // チャンクの列
+    chunk_range chunks() const;
+
+    // チャンクの数
+    size_type chunk_count() const;
+
+    // チャンクごとに f(string_view) を呼ぶ
+    template<class F>
+    void for_each_chunk(F f) const;
+
+    // 連続した文字列かどうか（チャンクがひとつ以下）
+    bool is_flat() const
+    {
+        return !root_ || (root_->pieces.size() == 1 && root_->pieces[0].node->is_flat);
+    }
+
+    // ひとつのチャンクにまとめて、その範囲を返す
+    // 返した範囲は次にコードを変更するまで有効
+    string_view flatten();
+
+    // out に全体をコピーし、コピーした末尾を返す（NUL 終端はしない）
+    char* copy_to(char* out) const;
+
+    // std::string にコピー
+    std::string str() const;
+
+    // ファイルディスクリプタに書き出す（POSIX では writev でまとめて書く）
+    // 書けなければ std::system_error
+    void write_to(int fd) const;
+
+    // 比較
+    int compare(const Cord& other) const;
+    int compare(string_view s) const;
+
+private:
+
+    // 変更してよい根を返す（共有していれば作り直す）
+    List* mutable_root();
+
+    // 入れ子をなくして並べ直す
+    void rebuild();
+
+};  // class Cord
+
+//==============================================================================
+// チャンクのイテレータ
+// 前から順に、空でない string_view を返す
+//==============================================================================
+class Cord::chunk_iterator {
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef string_view value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const string_view* pointer;
+    typedef const string_view& reference;
+
+private:
+    // 走査中の List と、その中の位置
+    struct Frame {
+        const impl::CordList* list;
+        size_t index;   // 次の範囲
+        size_t skip;    // 読み飛ばす残りの文字数
+        size_t remain;  // 返す残りの文字数
+    };
+
+    Frame stack_[MaxDepth];
+    int top_ = -1;      // -1 なら終端
+    string_view current_;
+
+public:
+
+    // 終端
+    chunk_iterator() { }
+
+    // 先頭
+    explicit chunk_iterator(const impl::CordList* root)
+    {
+        if (root == nullptr || root->length == 0) return;
+        Frame f = { root, 0, 0, root->length };
+        stack_[0] = f;
+        top_ = 0;
+        advance();
+    }
+
+    reference operator *() const { return current_; }
+    pointer operator ->() const { return &current_; }
+
+    chunk_iterator& operator ++()
+    {
+        advance();
+        return *this;
+    }
+    chunk_iterator operator ++(int)
+    {
+        chunk_iterator t(*this);
+        advance();
+        return t;
+    }
+
+    bool operator ==(const chunk_iterator& other) const
+    {
+        if (top_ != other.top_) return false;
+        if (top_ < 0) return true;
+        return stack_[top_].list == other.stack_[top_].list
+            && stack_[top_].index == other.stack_[top_].index
+            && current_.data() == other.current_.data();
+    }
+    bool operator !=(const chunk_iterator& other) const { return !(*this == other); }
+
+private:
+
+    // 次のチャンクへ
+    void advance();
+
+};  // class Cord::chunk_iterator
+
+//==============================================================================
+// チャンクの列（範囲 for 用）
+//==============================================================================
+class Cord::chunk_range {
+    const impl::CordList* root_;
+public:
+    explicit chunk_range(const impl::CordList* root) :root_(root) { }
+
+    chunk_iterator begin() const { return chunk_iterator(root_); }
+    chunk_iterator end() const { return chunk_iterator(); }
+};
+
+// チャンクの列
+inline Cord::chunk_range Cord::chunks() const
+{
+    return chunk_range(root_);
+}
+
+// チャンクごとに f(string_view) を呼ぶ
+template<class F>
+void Cord::for_each_chunk(F f) const
+{
+    for (chunk_iterator it(root_), e; it != e; ++it) f(*it);
+}
+
+// 連結
+inline Cord operator +(Cord x, const Cord& y)
+{
+    x.append(y);
+    return x;
+}
+inline Cord operator +(Cord x, string_view y)
+{
+    x.append(y);
+    return x;
+}
+
+// 比較
+inline bool operator ==(const Cord& x, const Cord& y) { return x.size() == y.size() && x.compare(y) == 0; }
+inline bool operator !=(const Cord& x, const Cord& y) { return !(x == y); }
+inline bool operator <(const Cord& x, const Cord& y) { return x.compare(y) < 0; }
+inline bool operator >(const Cord& x, const Cord& y) { return y < x; }
+inline bool operator <=(const Cord& x, const Cord& y) { return !(y < x); }
+inline bool operator >=(const Cord& x, const Cord& y) { return !(x < y); }
+
+inline bool operator ==(const Cord& x, string_view y) { return x.size() == y.size() && x.compare(y) == 0; }
+inline bool operator ==(string_view x, const Cord& y) { return y == x; }
+inline bool operator !=(const Cord& x, string_view y) { return !(x == y); }
+inline bool operator !=(string_view x, const Cord& y) { return !(y == x); }
+inline bool operator ==(const Cord& x, const char* y) { return x == string_view(y); }
+inline bool operator !=(const Cord& x, const char* y) { return !(x == y); }
+
+// ストリーム出力
+inline std::ostream& operator <<(std::ostream& os, const Cord& c)
+{
+    for (string_view s : c.chunks()) os.write(s.data(), static_cast<std::streamsize>(s.size()));
+    return os;
+}
+
+// 入れ替え
+inline void swap(Cord& x, Cord& y)
+{
+    x.swap(y);
+}
+
+}   // namespace tork
+
+#endif  // TORK_CONTAINER_CORD_H_INCLUDED
@@ -0,0 +1,271 @@
+﻿//******************************************************************************
+//
+// 可変長ビット集合
+//
+// 64 ビットワードの tork::Array にビットを詰めて持つ
+// 数え上げは popcount、探索はワード単位の末尾ゼロ数え、
+// 集合演算は SSE2 で 128 ビットずつ処理する
+// RankSelectIndex を作れば rank（i 未満の 1 の数）が O(1) で求まる
+//
+//******************************************************************************
+
+#ifndef TORK_CONTAINER_DYNAMIC_BITSET_H_INCLUDED
+#define TORK_CONTAINER_DYNAMIC_BITSET_H_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <stdexcept>
+#include <utility>
+#include <cassert>
+#include "Array.h"
+#include "../bits.h"
+
+namespace tork {
+
+    namespace impl {
+
+// 立っているビットの数
+inline unsigned PopCount64(uint64_t x)
+{
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_popcountll(x));
+#else
+    // POPCNT 命令がない CPU でも動くように、ビット演算で数える
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<unsigned>((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+    }   // namespace tork::impl
+
+//==============================================================================
+// 可変長ビット集合クラス
+//==============================================================================
+class DynamicBitset {
+public:
+    typedef size_t size_type;
+    typedef uint64_t word_type;
+
+    // 見つからなかったときの位置
+    static const size_type npos = static_cast<size_type>(-1);
+
+    // ワードあたりのビット数
+    static const size_type bits_per_word = 64;
+
+private:
+    Array<word_type> words_;
+    size_type size_ = 0;
+
+public:
+
+    // デフォルトコンストラクタ
+    DynamicBitset() { }
+
+    // ビット数と初期値
+    explicit DynamicBitset(size_type n, bool value = false);
+
+    // '0' と '1' の文字列（先頭がビット 0）
+    explicit DynamicBitset(const std::string& s);
+
+    // ビット数の変更（増えた分は value）
+    void resize(size_type n, bool value = false);
+
+    // 全ビットの削除
+    void clear();
+
+    // 末尾にビットを追加
+    void push_back(bool value);
+
+    // ビットを立てる
+    DynamicBitset& set(size_type i, bool value = true)
+    {
+        check(i);
+        word_type m = mask_of(i);
+        if (value) words_[i / bits_per_word] |= m;
+        else words_[i / bits_per_word] &= ~m;
+        return *this;
+    }
+
+    // ビットを落とす
+    DynamicBitset& reset(size_type i) { return set(i, false); }
+
+    // ビットを反転する
+    DynamicBitset& flip(size_type i)
+    {
+        check(i);
+        words_[i / bits_per_word] ^= mask_of(i);
+        return *this;
+    }
+
+    // 全ビットを立てる、落とす、反転する
+    DynamicBitset& set();
+    DynamicBitset& reset();
+    DynamicBitset& flip();
+
+    // ビットを調べる（範囲チェック付き）
+    bool test(size_type i) const
+    {
+        check(i);
+        return (*this)[i];
+    }
+
+    // ビットを調べる
+    bool operator [](size_type i) const
+    {
+        assert(i < size_);
+        return (words_[i / bits_per_word] & mask_of(i)) != 0;
+    }
+
+    // 立っているビットの数
+    size_type count() const;
+
+    // どれか立っているか、全部立っているか、1つも立っていないか
+    bool any() const;
+    bool all() const;
+    bool none() const { return !any(); }
+
+    // 最初に立っているビットの位置（なければ npos）
+    size_type find_first() const;
+
+    // i より後で最初に立っているビットの位置（なければ npos）
+    size_type find_next(size_type i) const;
+
+    // 立っているビットの位置ごとに f(i) を呼ぶ
+    template<class Function>
+    void for_each_set(Function f) const
+    {
+        for (size_type w = 0; w < words_.size(); ++w) {
+            word_type x = words_[w];
+            while (x) {
+                f(w * bits_per_word + impl::CountTrailingZeros64(x));
+                x &= x - 1;
+            }
+        }
+    }
+
+    // 集合演算（ビット数が同じであること）
+    DynamicBitset& operator &=(const DynamicBitset& other);
+    DynamicBitset& operator |=(const DynamicBitset& other);
+    DynamicBitset& operator ^=(const DynamicBitset& other);
+
+    // other で立っているビットを落とす（*this &= ~other）
+    DynamicBitset& and_not(const DynamicBitset& other);
+
+    // 全ビットを反転したもの
+    DynamicBitset operator ~() const
+    {
+        DynamicBitset r(*this);
+        return r.flip();
+    }
+
+    // other の立っているビットが全部立っているか
+    bool is_superset_of(const DynamicBitset& other) const;
+
+    // 等しいかどうか
+    bool operator ==(const DynamicBitset& other) const;
+    bool operator !=(const DynamicBitset& other) const { return !(*this == other); }
+
+    // '0' と '1' の文字列（先頭がビット 0）
+    std::string to_string() const;
+
+    // ビット数
+    size_type size() const { return size_; }
+
+    // 空かどうか
+    bool empty() const { return size_ == 0; }
+
+    // ワード数
+    size_type num_words() const { return words_.size(); }
+
+    // ワード列（最後のワードの size() 以降のビットは 0）
+    const word_type* data() const { return words_.data(); }
+
+    // スワップ
+    void swap(DynamicBitset& other)
+    {
+        words_.swap(other.words_);
+        std::swap(size_, other.size_);
+    }
+
+private:
+
+    static word_type mask_of(size_type i) { return word_type(1) << (i % bits_per_word); }
+
+    void check(size_type i) const
+    {
+        if (i >= size_) throw std::out_of_range("out of range at tork::DynamicBitset");
+    }
+
+    void check_size(const DynamicBitset& other) const
+    {
+        if (size_ != other.size_) throw std::invalid_argument("size mismatch at tork::DynamicBitset");
+    }
+
+    // 最後のワードの余分なビットを落とす
+    void trim();
+
+};  // class DynamicBitset
+
+// 集合演算
+inline DynamicBitset operator &(const DynamicBitset& x, const DynamicBitset& y)
+{
+    DynamicBitset r(x);
+    return r &= y;
+}
+inline DynamicBitset operator |(const DynamicBitset& x, const DynamicBitset& y)
+{
+    DynamicBitset r(x);
+    return r |= y;
+}
+inline DynamicBitset operator ^(const DynamicBitset& x, const DynamicBitset& y)
+{
+    DynamicBitset r(x);
+    return r ^= y;
+}
+
+//==============================================================================
+// rank / select 索引
+// 512 ビットごとの累積数と、その中の各ワードまでの相対数（9 ビット × 7）を持つ
+// 追加の領域はビット集合の 25%
+// 元のビット集合を変更したら作り直すこと
+//==============================================================================
+class RankSelectIndex {
+public:
+    typedef size_t size_type;
+
+private:
+    const DynamicBitset* p_bits_ = nullptr;
+    Array<uint64_t> counts_;    // ブロックごとに [累積数, 相対数] の 2 ワード
+    size_type ones_ = 0;
+
+public:
+
+    // デフォルトコンストラクタ
+    RankSelectIndex() { }
+
+    // ビット集合から作る
+    explicit RankSelectIndex(const DynamicBitset& bits);
+
+    // 作り直す
+    void build(const DynamicBitset& bits);
+
+    // [0, i) の中の 1 の数（O(1)）
+    size_type rank1(size_type i) const;
+
+    // [0, i) の中の 0 の数（O(1)）
+    size_type rank0(size_type i) const { return i - rank1(i); }
+
+    // k 番目（0 から数える）の 1 の位置（なければ npos）
+    // ブロックを二分探索するので O(log n)
+    size_type select1(size_type k) const;
+
+    // 1 の総数
+    size_type count() const { return ones_; }
+
+};  // class RankSelectIndex
+
+}   // namespace tork
+
+#endif  // TORK_CONTAINER_DYNAMIC_BITSET_H_INCLUDED
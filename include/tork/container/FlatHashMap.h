@@ -0,0 +1,691 @@
+﻿//******************************************************************************
+//
+// オープンアドレス法のハッシュマップ
+//
+// 要素は1つの配列に直接格納し、ノードを確保しない
+// スロットごとに1バイトの制御バイト（空き／削除済み／ハッシュ値の上位7ビット）を持ち、
+// 16スロットのグループ単位で SIMD 比較して探索する
+//
+//******************************************************************************
+
+#ifndef TORK_CONTAINER_FLAT_HASH_MAP_H_INCLUDED
+#define TORK_CONTAINER_FLAT_HASH_MAP_H_INCLUDED
+
+#include <memory>
+#include <iterator>
+#include <utility>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <initializer_list>
+#include <cstring>
+#include <cassert>
+#include "../bits.h"
+#include "../memory/allocator.h"
+
+namespace tork {
+
+    namespace impl {
+
+// 制御バイトの値
+// 0～127 は使用中（ハッシュ値の上位7ビット）、負の値は空き
+const signed char HashCtrlEmpty = -128;     // 未使用
+const signed char HashCtrlDeleted = -2;     // 削除済み（探索は続ける）
+
+// 一度に調べるスロット数
+const size_t HashGroupSize = 16;
+
+// グループ内で制御バイトが b に一致するスロットのビットマスク
+inline unsigned HashMatchByte(const signed char* group, signed char b)
+{
+#ifdef TORK_HAS_SSE2
+    __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8(b))));
+#else
+    unsigned mask = 0;
+    for (size_t i = 0; i < HashGroupSize; ++i) {
+        if (group[i] == b) mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+// グループ内の未使用スロット
+inline unsigned HashMatchEmpty(const signed char* group)
+{
+    return HashMatchByte(group, HashCtrlEmpty);
+}
+
+// グループ内の未使用または削除済みスロット（符号ビットが立っているもの）
+inline unsigned HashMatchFree(const signed char* group)
+{
+#ifdef TORK_HAS_SSE2
+    __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return static_cast<unsigned>(_mm_movemask_epi8(g));
+#else
+    unsigned mask = 0;
+    for (size_t i = 0; i < HashGroupSize; ++i) {
+        if (group[i] < 0) mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+// ハッシュ値を混ぜる
+// 定数を掛けただけでは下位ビットがキーの下位ビットでしか決まらず、std::hash が
+// 恒等関数だと、アラインされたポインタのような下位ビットがそろったキーが
+// 少数のグループに集まってしまう。掛けたあとに上半分を下半分に畳み込んで、
+// グループの選択に使う下位ビットにもキー全体を反映させる
+// 制御バイト（H2）とシャードの選択には、畳み込みの影響を受けない最上位側を使う
+inline size_t HashMix(size_t h)
+{
+    if (sizeof(size_t) >= 8) {
+        h *= static_cast<size_t>(0x9E3779B97F4A7C15ULL);
+        return h ^ (h >> (sizeof(size_t) * 4));
+    }
+    // 32ビットでは上半分が短く、H2 とシャードの選択に近いので、もう一度混ぜる
+    h *= static_cast<size_t>(0x9E3779B9U);
+    h ^= h >> 16;
+    h *= static_cast<size_t>(0x85EBCA6BU);
+    return h ^ (h >> 13);
+}
+
+// FlatHashMap のイテレータ
+template<class Map, class Value>
+class FlatHashIterator {
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef typename std::remove_const<Value>::type value_type;
+    typedef ptrdiff_t difference_type;
+    typedef Value& reference;
+    typedef Value* pointer;
+
+private:
+    Map* p_map_ = nullptr;
+    size_t index_ = 0;
+
+public:
+    FlatHashIterator() { }
+    FlatHashIterator(Map* p, size_t i) :p_map_(p), index_(i) { }
+
+    // 非constからconstへの変換
+    template<class M, class V>
+    FlatHashIterator(const FlatHashIterator<M, V>& x)
+        :p_map_(x.map()), index_(x.index())
+    {
+
+    }
+
+    Map* map() const { return p_map_; }
+    size_t index() const { return index_; }
+
+    reference operator *() const { return p_map_->slot(index_); }
+    pointer operator ->() const { return &p_map_->slot(index_); }
+
+    FlatHashIterator& operator ++()
+    {
+        index_ = p_map_->next_full(index_ + 1);
+        return *this;
+    }
+    FlatHashIterator operator ++(int)
+    {
+        FlatHashIterator tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    bool operator ==(const FlatHashIterator& x) const { return index_ == x.index_; }
+    bool operator !=(const FlatHashIterator& x) const { return index_ != x.index_; }
+
+};  // class FlatHashIterator
+
+    }   // namespace tork::impl
+
+//==============================================================================
+// フラットハッシュマップクラス
+//==============================================================================
+template<class K, class V,
+    class Hash = std::hash<K>,
+    class KeyEqual = std::equal_to<K>,
+    class Allocator = tork::allocator<std::pair<const K, V>>>
+class FlatHashMap {
+public:
+    typedef FlatHashMap<K, V, Hash, KeyEqual, Allocator> ThisType;
+
+    typedef K key_type;
+    typedef V mapped_type;
+    typedef std::pair<const K, V> value_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef Hash hasher;
+    typedef KeyEqual key_equal;
+    typedef Allocator allocator_type;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+
+    typedef impl::FlatHashIterator<ThisType, value_type> iterator;
+    typedef impl::FlatHashIterator<const ThisType, const value_type> const_iterator;
+
+private:
+    typedef std::allocator_traits<Allocator> BaseTraits;
+    typedef typename BaseTraits::template rebind_alloc<value_type> SlotAlloc;
+    typedef std::allocator_traits<SlotAlloc> SlotTraits;
+    typedef typename BaseTraits::template rebind_alloc<signed char> CtrlAlloc;
+    typedef std::allocator_traits<CtrlAlloc> CtrlTraits;
+
+    template<class, class> friend class impl::FlatHashIterator;
+
+    SlotAlloc alloc_;
+    Hash hash_;
+    KeyEqual eq_;
+
+    signed char* ctrl_ = nullptr;   // 制御バイト
+    value_type* slots_ = nullptr;   // スロット
+    size_type capacity_ = 0;        // スロット数（グループサイズの 2 の冪倍）
+    size_type size_ = 0;            // 要素数
+    size_type growth_left_ = 0;     // 再ハッシュせずに埋められる未使用スロット数
+    float max_load_factor_ = 0.875f;
+
+public:
+
+    // デフォルトコンストラクタ
+    FlatHashMap() { }
+
+    // バケット数（＋ハッシュ関数、比較関数、アロケータ）
+    explicit FlatHashMap(size_type n, const Hash& hash = Hash(),
+            const KeyEqual& eq = KeyEqual(), const Allocator& a = Allocator())
+        :alloc_(a), hash_(hash), eq_(eq)
+    {
+        reserve(n);
+    }
+
+    // イテレータ
+    template<class InputIter,
+        class = typename std::enable_if<
+            !std::is_integral<InputIter>::value, void>::type>
+    FlatHashMap(InputIter first, InputIter last)
+    {
+        insert(first, last);
+    }
+
+    // 初期化子リスト
+    FlatHashMap(std::initializer_list<value_type> il)
+    {
+        reserve(il.size());
+        insert(il.begin(), il.end());
+    }
+
+    // コピーコンストラクタ
+    FlatHashMap(const FlatHashMap& other)
+        :alloc_(SlotTraits::select_on_container_copy_construction(other.alloc_)),
+        hash_(other.hash_), eq_(other.eq_),
+        max_load_factor_(other.max_load_factor_)
+    {
+        reserve(other.size());
+        insert(other.begin(), other.end());
+    }
+
+    // ムーブコンストラクタ
+    FlatHashMap(FlatHashMap&& other)
+        :alloc_(other.alloc_), hash_(other.hash_), eq_(other.eq_)
+    {
+        swap(other);
+    }
+
+    // デストラクタ
+    ~FlatHashMap()
+    {
+        clear();
+        deallocate(ctrl_, slots_, capacity_);
+    }
+
+    // コピー代入演算子
+    FlatHashMap& operator =(const FlatHashMap& other)
+    {
+        if (this == &other) return *this;
+        FlatHashMap(other).swap(*this);
+        return *this;
+    }
+
+    // ムーブ代入演算子
+    FlatHashMap& operator =(FlatHashMap&& other)
+    {
+        if (this == &other) return *this;
+        FlatHashMap(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    // スワップ
+    void swap(FlatHashMap& other)
+    {
+        std::swap(alloc_, other.alloc_);
+        std::swap(hash_, other.hash_);
+        std::swap(eq_, other.eq_);
+        std::swap(ctrl_, other.ctrl_);
+        std::swap(slots_, other.slots_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(size_, other.size_);
+        std::swap(growth_left_, other.growth_left_);
+        std::swap(max_load_factor_, other.max_load_factor_);
+    }
+
+    // キーがなければ構築して挿入
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(const K& key, Args&&... args)
+    {
+        return EmplaceImpl(key, std::forward<Args>(args)...);
+    }
+
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args)
+    {
+        return EmplaceImpl(std::move(key), std::forward<Args>(args)...);
+    }
+
+    // キーと値から構築して挿入
+    template<class Key, class... Args>
+    std::pair<iterator, bool> emplace(Key&& key, Args&&... args)
+    {
+        return EmplaceImpl(std::forward<Key>(key), std::forward<Args>(args)...);
+    }
+
+    // 挿入
+    std::pair<iterator, bool> insert(const value_type& value)
+    {
+        return EmplaceImpl(value.first, value.second);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& value)
+    {
+        return EmplaceImpl(value.first, std::move(value.second));
+    }
+
+    // 範囲の挿入
+    template<class InputIter>
+    void insert(InputIter first, InputIter last)
+    {
+        for (auto it = first; it != last; ++it) {
+            insert(*it);
+        }
+    }
+
+    // 挿入または代入
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(const K& key, M&& obj)
+    {
+        std::pair<iterator, bool> r = EmplaceImpl(key, std::forward<M>(obj));
+        if (!r.second) r.first->second = std::forward<M>(obj);
+        return r;
+    }
+
+    // 添え字アクセス（なければ値をデフォルト構築）
+    V& operator [](const K& key)
+    {
+        return EmplaceImpl(key).first->second;
+    }
+
+    V& operator [](K&& key)
+    {
+        return EmplaceImpl(std::move(key)).first->second;
+    }
+
+    // 範囲チェック付きアクセス
+    V& at(const K& key)
+    {
+        size_type i = find_index(key);
+        if (i == capacity_) throw std::out_of_range("key not found at tork::FlatHashMap");
+        return slots_[i].second;
+    }
+    const V& at(const K& key) const
+    {
+        size_type i = find_index(key);
+        if (i == capacity_) throw std::out_of_range("key not found at tork::FlatHashMap");
+        return slots_[i].second;
+    }
+
+    // 検索
+    iterator find(const K& key)
+    {
+        return iterator(this, find_index(key));
+    }
+    const_iterator find(const K& key) const
+    {
+        return const_iterator(this, find_index(key));
+    }
+
+    // キーの数（0 か 1）
+    size_type count(const K& key) const
+    {
+        return find_index(key) != capacity_ ? 1 : 0;
+    }
+
+    // キーがあるかどうか
+    bool contains(const K& key) const
+    {
+        return find_index(key) != capacity_;
+    }
+
+    // キーを指定して削除
+    size_type erase(const K& key)
+    {
+        size_type i = find_index(key);
+        if (i == capacity_) return 0;
+        erase_at(i);
+        return 1;
+    }
+
+    // イテレータの指す要素を削除
+    // 次の要素を指すイテレータを返す
+    iterator erase(const_iterator pos)
+    {
+        size_type i = pos.index();
+        erase_at(i);
+        return iterator(this, next_full(i + 1));
+    }
+
+    // 全要素の削除（容量は残す）
+    void clear()
+    {
+        if (capacity_ == 0) return;
+        for (size_type i = 0; i < capacity_; ++i) {
+            if (ctrl_[i] >= 0) {
+                SlotTraits::destroy(alloc_, &slots_[i]);
+            }
+        }
+        std::memset(ctrl_, impl::HashCtrlEmpty, capacity_);
+        size_ = 0;
+        reset_growth_left();
+    }
+
+    // n 要素を再ハッシュなしで入れられるようにする
+    void reserve(size_type n)
+    {
+        // 削除済みスロットを除いても足りている
+        if (n <= size_ + growth_left_) return;
+
+        size_type cap = capacity_for(n);
+        resize(cap > capacity_ ? cap : capacity_);
+    }
+
+    // 少なくとも n 要素を入れられる容量で作り直す
+    // 削除済みスロットもここで片付く
+    // n が要素数より少なければ要素数に合わせる
+    void rehash(size_type n)
+    {
+        if (n < size_) n = size_;
+        if (n == 0 && size_ == 0) {
+            // 空にする
+            deallocate(ctrl_, slots_, capacity_);
+            ctrl_ = nullptr;
+            slots_ = nullptr;
+            capacity_ = 0;
+            growth_left_ = 0;
+            return;
+        }
+        resize(capacity_for(n));
+    }
+
+    // 最大負荷率
+    float max_load_factor() const { return max_load_factor_; }
+
+    // 最大負荷率の設定
+    // グループの中に必ず空きが残るように 15/16 までに制限する
+    void max_load_factor(float f)
+    {
+        if (f < 0.25f) f = 0.25f;
+        if (f > 0.9375f) f = 0.9375f;
+        max_load_factor_ = f;
+        if (size_ > max_elements(capacity_)) {
+            rehash(size_);
+        }
+        else {
+            reset_growth_left();
+        }
+    }
+
+    // 負荷率
+    float load_factor() const
+    {
+        return capacity_ ? static_cast<float>(size_) / capacity_ : 0.0f;
+    }
+
+    // 要素数
+    size_type size() const { return size_; }
+
+    // 空かどうか
+    bool empty() const { return size_ == 0; }
+
+    // スロット数
+    size_type capacity() const { return capacity_; }
+    size_type bucket_count() const { return capacity_; }
+
+    // ハッシュ関数、比較関数、アロケータ
+    hasher hash_function() const { return hash_; }
+    key_equal key_eq() const { return eq_; }
+    allocator_type get_allocator() const { return allocator_type(alloc_); }
+
+    // イテレータ
+    iterator begin() { return iterator(this, next_full(0)); }
+    const_iterator begin() const { return const_iterator(this, next_full(0)); }
+    iterator end() { return iterator(this, capacity_); }
+    const_iterator end() const { return const_iterator(this, capacity_); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+private:
+
+    value_type& slot(size_type i) { return slots_[i]; }
+    const value_type& slot(size_type i) const { return slots_[i]; }
+
+    // i 以降で最初に使用中のスロット（なければ capacity_）
+    size_type next_full(size_type i) const
+    {
+        while (i < capacity_ && ctrl_[i] < 0) {
+            ++i;
+        }
+        return i;
+    }
+
+    // 容量 cap で入れられる要素数
+    size_type max_elements(size_type cap) const
+    {
+        return static_cast<size_type>(cap * static_cast<double>(max_load_factor_));
+    }
+
+    // n 要素を入れるのに必要なスロット数（グループサイズの 2 の冪倍）
+    size_type capacity_for(size_type n) const
+    {
+        size_type cap = impl::HashGroupSize;
+        while (max_elements(cap) < n) {
+            cap *= 2;
+        }
+        return cap;
+    }
+
+    // 削除済みスロットがない状態での残り
+    void reset_growth_left()
+    {
+        size_type m = max_elements(capacity_);
+        growth_left_ = m > size_ ? m - size_ : 0;
+    }
+
+    // ハッシュ値の下位（グループの選択）と上位7ビット（制御バイト）
+    // HashMix で畳み込んであるので、下位ビットもキー全体で決まる
+    static size_type H1(size_t h) { return h; }
+    static signed char H2(size_t h)
+    {
+        return static_cast<signed char>(h >> (sizeof(size_t) * 8 - 7));
+    }
+
+    size_t hash_of(const K& key) const
+    {
+        return impl::HashMix(hash_(key));
+    }
+
+    // キーの位置（なければ capacity_）
+    size_type find_index(const K& key) const
+    {
+        if (size_ == 0) return capacity_;
+
+        size_t h = hash_of(key);
+        signed char h2 = H2(h);
+        size_type groups = capacity_ / impl::HashGroupSize;
+        size_type g = H1(h) & (groups - 1);
+
+        // 三角数の間隔でグループを巡回する（グループ数が 2 の冪なら全部回る）
+        for (size_type step = 1; step <= groups; ++step) {
+            const signed char* ctrl = ctrl_ + g * impl::HashGroupSize;
+            unsigned m = impl::HashMatchByte(ctrl, h2);
+            while (m) {
+                size_type i = g * impl::HashGroupSize + impl::CountTrailingZeros(m);
+                if (eq_(slots_[i].first, key)) return i;
+                m &= m - 1;
+            }
+            // 未使用スロットがあるグループより先には入っていない
+            if (impl::HashMatchEmpty(ctrl)) break;
+            g = (g + step) & (groups - 1);
+        }
+        return capacity_;
+    }
+
+    // ハッシュ値 h を入れるスロット（未使用か削除済み）を探す
+    static size_type find_free(const signed char* ctrl_base, size_type cap, size_t h)
+    {
+        size_type groups = cap / impl::HashGroupSize;
+        size_type g = H1(h) & (groups - 1);
+        for (size_type step = 1; ; ++step) {
+            unsigned m = impl::HashMatchFree(ctrl_base + g * impl::HashGroupSize);
+            if (m) {
+                return g * impl::HashGroupSize + impl::CountTrailingZeros(m);
+            }
+            assert(step <= groups);
+            g = (g + step) & (groups - 1);
+        }
+    }
+
+    // 挿入本体
+    template<class Key, class... Args>
+    std::pair<iterator, bool> EmplaceImpl(Key&& key, Args&&... args)
+    {
+        size_type found = find_index(key);
+        if (found != capacity_) {
+            return std::make_pair(iterator(this, found), false);
+        }
+
+        size_t h = hash_of(key);
+        if (capacity_ == 0) {
+            resize(capacity_for(1));
+        }
+        size_type i = find_free(ctrl_, capacity_, h);
+
+        // 未使用スロットを使う場合は残りが必要
+        if (growth_left_ == 0 && ctrl_[i] == impl::HashCtrlEmpty) {
+            grow();
+            i = find_free(ctrl_, capacity_, h);
+        }
+
+        SlotTraits::construct(alloc_, &slots_[i],
+                std::piecewise_construct,
+                std::forward_as_tuple(std::forward<Key>(key)),
+                std::forward_as_tuple(std::forward<Args>(args)...));
+
+        if (ctrl_[i] == impl::HashCtrlEmpty) --growth_left_;
+        ctrl_[i] = H2(h);
+        ++size_;
+
+        return std::make_pair(iterator(this, i), true);
+    }
+
+    // 満杯になったときの拡張
+    // 削除済みスロットが多ければ同じ容量で作り直すだけにする
+    void grow()
+    {
+        if (size_ <= max_elements(capacity_) / 2) {
+            resize(capacity_);
+        }
+        else {
+            resize(capacity_ * 2);
+        }
+    }
+
+    // スロットの削除
+    void erase_at(size_type i)
+    {
+        assert(i < capacity_ && ctrl_[i] >= 0);
+        SlotTraits::destroy(alloc_, &slots_[i]);
+        --size_;
+
+        // 同じグループに未使用スロットがあれば、このグループで探索は止まるので
+        // 削除済みの印を残さずに未使用に戻せる
+        const signed char* group = ctrl_ + (i & ~(impl::HashGroupSize - 1));
+        if (impl::HashMatchEmpty(group)) {
+            ctrl_[i] = impl::HashCtrlEmpty;
+            ++growth_left_;
+        }
+        else {
+            ctrl_[i] = impl::HashCtrlDeleted;
+        }
+    }
+
+    // 容量を変えて全要素を入れ直す
+    void resize(size_type new_cap)
+    {
+        signed char* new_ctrl = nullptr;
+        value_type* new_slots = nullptr;
+        allocate(new_cap, new_ctrl, new_slots);
+
+        for (size_type i = 0; i < capacity_; ++i) {
+            if (ctrl_[i] < 0) continue;
+
+            size_t h = hash_of(slots_[i].first);
+            size_type j = find_free(new_ctrl, new_cap, h);
+            // キーは const だが、移動元はすぐに破棄するのでムーブしてしまう
+            SlotTraits::construct(alloc_, &new_slots[j],
+                    std::move(const_cast<K&>(slots_[i].first)),
+                    std::move(slots_[i].second));
+            new_ctrl[j] = H2(h);
+            SlotTraits::destroy(alloc_, &slots_[i]);
+        }
+
+        deallocate(ctrl_, slots_, capacity_);
+        ctrl_ = new_ctrl;
+        slots_ = new_slots;
+        capacity_ = new_cap;
+        reset_growth_left();
+    }
+
+    // 領域確保
+    void allocate(size_type cap, signed char*& ctrl, value_type*& slots)
+    {
+        CtrlAlloc ca(alloc_);
+        ctrl = CtrlTraits::allocate(ca, cap);
+        if (ctrl == nullptr) throw std::bad_alloc();
+        slots = SlotTraits::allocate(alloc_, cap);
+        if (slots == nullptr) {
+            CtrlTraits::deallocate(ca, ctrl, cap);
+            throw std::bad_alloc();
+        }
+        std::memset(ctrl, impl::HashCtrlEmpty, cap);
+    }
+
+    // 領域解放
+    void deallocate(signed char* ctrl, value_type* slots, size_type cap)
+    {
+        if (cap == 0) return;
+        CtrlAlloc ca(alloc_);
+        CtrlTraits::deallocate(ca, ctrl, cap);
+        SlotTraits::deallocate(alloc_, slots, cap);
+    }
+
+};  // class FlatHashMap
+
+// スワップ
+template<class K, class V, class H, class E, class A>
+void swap(FlatHashMap<K, V, H, E, A>& x, FlatHashMap<K, V, H, E, A>& y)
+{
+    x.swap(y);
+}
+
+}   // namespace tork
+
+#endif  // TORK_CONTAINER_FLAT_HASH_MAP_H_INCLUDED
@@ -0,0 +1,470 @@
+﻿//******************************************************************************
+//
+// ソート済み配列による連想コンテナ
+//
+// 要素を tork::Array にキー順で並べて持つ。探索は分岐のない二分探索
+// 挿入と削除は要素をずらすので O(n)。読み込みが中心の小さな表に向く
+// まとめて入れる場合は、コンストラクタか insert_range() を使えばソートとマージで済む
+//
+//******************************************************************************
+
+#ifndef TORK_CONTAINER_FLAT_MAP_H_INCLUDED
+#define TORK_CONTAINER_FLAT_MAP_H_INCLUDED
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <tuple>
+#include <stdexcept>
+#include <cassert>
+#include <initializer_list>
+#include "Array.h"
+
+namespace tork {
+
+// 入力がキー順に並んでいて重複もないことを示すタグ
+struct sorted_unique_t { };
+const sorted_unique_t sorted_unique = sorted_unique_t();
+
+    namespace impl {
+
+// FlatSet 用のキー取り出し
+struct FlatIdentity {
+    template<class T>
+    const T& operator ()(const T& x) const { return x; }
+};
+
+// FlatMap 用のキー取り出し
+struct FlatFirst {
+    template<class T>
+    const typename T::first_type& operator ()(const T& x) const { return x.first; }
+};
+
+//==============================================================================
+// FlatMap と FlatSet の共通部分
+//==============================================================================
+template<class Value, class Key, class KeyOf, class Compare, class Allocator>
+class FlatTree {
+public:
+    typedef Key key_type;
+    typedef Value value_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef Compare key_compare;
+    typedef Allocator allocator_type;
+    typedef Value& reference;
+    typedef const Value& const_reference;
+    typedef Array<Value, Allocator> container_type;
+
+    typedef typename container_type::iterator iterator;
+    typedef typename container_type::const_iterator const_iterator;
+    typedef typename container_type::reverse_iterator reverse_iterator;
+    typedef typename container_type::const_reverse_iterator const_reverse_iterator;
+
+protected:
+    container_type data_;
+    Compare comp_;
+    KeyOf key_of_;
+
+public:
+
+    // デフォルトコンストラクタ
+    FlatTree() { }
+
+    // 比較関数を指定
+    explicit FlatTree(const Compare& comp) :comp_(comp) { }
+
+    // ソートされていない範囲から構築
+    template<class InputIter>
+    FlatTree(InputIter first, InputIter last, const Compare& comp = Compare())
+        :data_(first, last), comp_(comp)
+    {
+        sort_unique(data_.begin());
+    }
+
+    // キー順で重複のない範囲から構築（ソートしない）
+    template<class InputIter>
+    FlatTree(sorted_unique_t, InputIter first, InputIter last, const Compare& comp = Compare())
+        :data_(first, last), comp_(comp)
+    {
+        assert(is_sorted_unique());
+    }
+
+    // 挿入
+    // 同じキーがあれば挿入せず、その要素と false を返す
+    std::pair<iterator, bool> insert(const value_type& value)
+    {
+        iterator it = lower_bound(key_of_(value));
+        if (it != end() && !comp_(key_of_(value), key_of_(*it))) {
+            return std::make_pair(it, false);
+        }
+        return std::make_pair(insert_at(it, value), true);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& value)
+    {
+        iterator it = lower_bound(key_of_(value));
+        if (it != end() && !comp_(key_of_(value), key_of_(*it))) {
+            return std::make_pair(it, false);
+        }
+        return std::make_pair(insert_at(it, std::move(value)), true);
+    }
+
+    // 範囲をまとめて挿入する
+    // 末尾に追加してソートし、元の要素とマージするので O(n + m log m)
+    // 既にあるキーは元の要素を残す
+    template<class InputIter>
+    void insert_range(InputIter first, InputIter last)
+    {
+        size_type old_size = data_.size();
+        for (; first != last; ++first) {
+            data_.push_back(*first);
+        }
+        if (data_.size() == old_size) return;
+
+        iterator mid = data_.begin() + old_size;
+        std::stable_sort(mid, data_.end(), value_compare(comp_));
+        // マージは安定なので、同じキーなら元の要素が前に来る
+        std::inplace_merge(data_.begin(), mid, data_.end(), value_compare(comp_));
+        unique_from(data_.begin());
+    }
+
+    void insert_range(std::initializer_list<value_type> il)
+    {
+        insert_range(il.begin(), il.end());
+    }
+
+    // キーを指定して削除
+    size_type erase(const key_type& key)
+    {
+        iterator it = find(key);
+        if (it == end()) return 0;
+        erase(it);
+        return 1;
+    }
+
+    // イテレータの指す要素を削除
+    // 次の要素を指すイテレータを返す
+    iterator erase(const_iterator pos)
+    {
+        iterator it = data_.begin() + (pos - data_.begin());
+        std::move(it + 1, data_.end(), it);
+        data_.pop_back();
+        return it;
+    }
+
+    // 範囲を削除
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        iterator f = data_.begin() + (first - data_.begin());
+        iterator l = data_.begin() + (last - data_.begin());
+        iterator new_end = std::move(l, data_.end(), f);
+        truncate(new_end);
+        return f;
+    }
+
+    // キー以上の最初の要素
+    // 分岐しない二分探索（比較結果は条件付き移動になる）
+    iterator lower_bound(const key_type& key)
+    {
+        return data_.begin() + lower_bound_index(key);
+    }
+    const_iterator lower_bound(const key_type& key) const
+    {
+        return data_.begin() + lower_bound_index(key);
+    }
+
+    // キーより大きい最初の要素
+    iterator upper_bound(const key_type& key)
+    {
+        iterator it = lower_bound(key);
+        return (it != end() && !comp_(key, key_of_(*it))) ? it + 1 : it;
+    }
+    const_iterator upper_bound(const key_type& key) const
+    {
+        const_iterator it = lower_bound(key);
+        return (it != end() && !comp_(key, key_of_(*it))) ? it + 1 : it;
+    }
+
+    // 検索
+    iterator find(const key_type& key)
+    {
+        iterator it = lower_bound(key);
+        return (it != end() && !comp_(key, key_of_(*it))) ? it : end();
+    }
+    const_iterator find(const key_type& key) const
+    {
+        const_iterator it = lower_bound(key);
+        return (it != end() && !comp_(key, key_of_(*it))) ? it : end();
+    }
+
+    // キーの数（0 か 1）
+    size_type count(const key_type& key) const { return find(key) != end() ? 1 : 0; }
+
+    // キーがあるかどうか
+    bool contains(const key_type& key) const { return find(key) != end(); }
+
+    // 全要素の削除
+    void clear() { data_.clear(); }
+
+    // 領域の予約
+    void reserve(size_type n) { data_.reserve(n); }
+
+    // 余分な領域の解放
+    void shrink_to_fit() { data_.shrink_to_fit(); }
+
+    // 要素数
+    size_type size() const { return data_.size(); }
+
+    // 空かどうか
+    bool empty() const { return data_.empty(); }
+
+    // 容量
+    size_type capacity() const { return data_.capacity(); }
+
+    // 添え字アクセス（キー順で i 番目）
+    const_reference nth(size_type i) const { return data_.at(i); }
+
+    // 内部の配列
+    const container_type& container() const { return data_; }
+
+    // 比較関数
+    key_compare key_comp() const { return comp_; }
+
+    // イテレータ
+    iterator begin() { return data_.begin(); }
+    const_iterator begin() const { return data_.begin(); }
+    iterator end() { return data_.end(); }
+    const_iterator end() const { return data_.end(); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+    reverse_iterator rbegin() { return data_.rbegin(); }
+    const_reverse_iterator rbegin() const { return data_.rbegin(); }
+    reverse_iterator rend() { return data_.rend(); }
+    const_reverse_iterator rend() const { return data_.rend(); }
+
+protected:
+
+    // 要素同士をキーで比較する
+    class value_compare {
+        Compare comp_;
+        KeyOf key_of_;
+    public:
+        explicit value_compare(const Compare& comp) :comp_(comp) { }
+        bool operator ()(const value_type& x, const value_type& y) const
+        {
+            return comp_(key_of_(x), key_of_(y));
+        }
+    };
+
+    size_type lower_bound_index(const key_type& key) const
+    {
+        const value_type* base = data_.data();
+        size_type n = data_.size();
+        if (n == 0) return 0;
+        while (n > 1) {
+            size_type half = n / 2;
+            base = comp_(key_of_(base[half]), key) ? base + half : base;
+            n -= half;
+        }
+        return (base - data_.data()) + (comp_(key_of_(*base), key) ? 1 : 0);
+    }
+
+    // pos に挿入（後ろをずらす）
+    template<class V>
+    iterator insert_at(iterator pos, V&& value)
+    {
+        size_type i = pos - data_.begin();
+        data_.push_back(std::forward<V>(value));
+        std::rotate(data_.begin() + i, data_.end() - 1, data_.end());
+        return data_.begin() + i;
+    }
+
+    // first 以降をソートして重複を除く
+    void sort_unique(iterator first)
+    {
+        std::stable_sort(first, data_.end(), value_compare(comp_));
+        unique_from(first);
+    }
+
+    // 隣り合う同じキーを除く（最初のものを残す）
+    void unique_from(iterator first)
+    {
+        const Compare& comp = comp_;
+        const KeyOf& key_of = key_of_;
+        iterator new_end = std::unique(first, data_.end(),
+            [&comp, &key_of](const value_type& x, const value_type& y) {
+                return !comp(key_of(x), key_of(y));
+            });
+        truncate(new_end);
+    }
+
+    // new_end 以降を削除
+    void truncate(iterator new_end)
+    {
+        while (data_.end() != new_end) {
+            data_.pop_back();
+        }
+    }
+
+    bool is_sorted_unique() const
+    {
+        for (size_type i = 1; i < data_.size(); ++i) {
+            if (!comp_(key_of_(data_[i - 1]), key_of_(data_[i]))) return false;
+        }
+        return true;
+    }
+
+};  // class FlatTree
+
+    }   // namespace tork::impl
+
+//==============================================================================
+// フラットマップクラス
+// 要素は std::pair<K, V>。イテレータ経由でキーを書き換えないこと
+//==============================================================================
+template<class K, class V,
+    class Compare = std::less<K>,
+    class Allocator = tork::allocator<std::pair<K, V>>>
+class FlatMap : public impl::FlatTree<std::pair<K, V>, K, impl::FlatFirst, Compare, Allocator> {
+    typedef impl::FlatTree<std::pair<K, V>, K, impl::FlatFirst, Compare, Allocator> Base;
+
+public:
+    typedef V mapped_type;
+    typedef typename Base::iterator iterator;
+    typedef typename Base::const_iterator const_iterator;
+    typedef typename Base::value_type value_type;
+
+    // デフォルトコンストラクタ
+    FlatMap() { }
+
+    // 比較関数を指定
+    explicit FlatMap(const Compare& comp) :Base(comp) { }
+
+    // ソートされていない範囲から構築（重複キーは最初のものを残す）
+    template<class InputIter>
+    FlatMap(InputIter first, InputIter last, const Compare& comp = Compare())
+        :Base(first, last, comp)
+    {
+
+    }
+
+    // キー順で重複のない範囲から構築
+    template<class InputIter>
+    FlatMap(sorted_unique_t t, InputIter first, InputIter last, const Compare& comp = Compare())
+        :Base(t, first, last, comp)
+    {
+
+    }
+
+    // 初期化子リスト
+    FlatMap(std::initializer_list<value_type> il, const Compare& comp = Compare())
+        :Base(il.begin(), il.end(), comp)
+    {
+
+    }
+
+    // キーがなければ値を構築して挿入
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(const K& key, Args&&... args)
+    {
+        iterator it = this->lower_bound(key);
+        if (it != this->end() && !this->comp_(key, it->first)) {
+            return std::make_pair(it, false);
+        }
+        return std::make_pair(this->insert_at(it,
+            value_type(std::piecewise_construct,
+                std::forward_as_tuple(key),
+                std::forward_as_tuple(std::forward<Args>(args)...))), true);
+    }
+
+    // 挿入または代入
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(const K& key, M&& obj)
+    {
+        std::pair<iterator, bool> r = try_emplace(key, std::forward<M>(obj));
+        if (!r.second) r.first->second = std::forward<M>(obj);
+        return r;
+    }
+
+    // 添え字アクセス（なければ値をデフォルト構築）
+    V& operator [](const K& key)
+    {
+        return try_emplace(key).first->second;
+    }
+
+    // 範囲チェック付きアクセス
+    V& at(const K& key)
+    {
+        iterator it = this->find(key);
+        if (it == this->end()) throw std::out_of_range("key not found at tork::FlatMap");
+        return it->second;
+    }
+    const V& at(const K& key) const
+    {
+        const_iterator it = this->find(key);
+        if (it == this->end()) throw std::out_of_range("key not found at tork::FlatMap");
+        return it->second;
+    }
+
+};  // class FlatMap
+
+//==============================================================================
+// フラットセットクラス
+//==============================================================================
+template<class K,
+    class Compare = std::less<K>,
+    class Allocator = tork::allocator<K>>
+class FlatSet : public impl::FlatTree<K, K, impl::FlatIdentity, Compare, Allocator> {
+    typedef impl::FlatTree<K, K, impl::FlatIdentity, Compare, Allocator> Base;
+
+public:
+    typedef typename Base::value_type value_type;
+
+    // デフォルトコンストラクタ
+    FlatSet() { }
+
+    // 比較関数を指定
+    explicit FlatSet(const Compare& comp) :Base(comp) { }
+
+    // ソートされていない範囲から構築（重複は除く）
+    template<class InputIter>
+    FlatSet(InputIter first, InputIter last, const Compare& comp = Compare())
+        :Base(first, last, comp)
+    {
+
+    }
+
+    // キー順で重複のない範囲から構築
+    template<class InputIter>
+    FlatSet(sorted_unique_t t, InputIter first, InputIter last, const Compare& comp = Compare())
+        :Base(t, first, last, comp)
+    {
+
+    }
+
+    // 初期化子リスト
+    FlatSet(std::initializer_list<value_type> il, const Compare& comp = Compare())
+        :Base(il.begin(), il.end(), comp)
+    {
+
+    }
+
+};  // class FlatSet
+
+// 比較
+template<class V, class K, class KO, class C, class A>
+bool operator ==(const impl::FlatTree<V, K, KO, C, A>& x, const impl::FlatTree<V, K, KO, C, A>& y)
+{
+    return x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin());
+}
+
+template<class V, class K, class KO, class C, class A>
+bool operator !=(const impl::FlatTree<V, K, KO, C, A>& x, const impl::FlatTree<V, K, KO, C, A>& y)
+{
+    return !(x == y);
+}
+
+}   // namespace tork
+
+#endif  // TORK_CONTAINER_FLAT_MAP_H_INCLUDED
@@ -0,0 +1,321 @@
+﻿//******************************************************************************
+//
+// 侵入型ハッシュセット
+//
+// 要素のメンバに置いたフックでバケットのチェインをつなぐので、
+// 要素ごとのノード確保は起きない（確保するのはバケット配列だけ）
+// フックは前の要素の next を指すポインタを持つので、要素を外すのは O(1)
+// 要素は所有しない。寿命の扱いは IntrusiveList と同じ
+//
+//******************************************************************************
+
+#ifndef TORK_CONTAINER_INTRUSIVE_HASH_SET_H_INCLUDED
+#define TORK_CONTAINER_INTRUSIVE_HASH_SET_H_INCLUDED
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <functional>
+#include <cassert>
+#include "Array.h"
+#include "IntrusiveList.h"
+
+namespace tork {
+
+//==============================================================================
+// ハッシュセットフック
+//==============================================================================
+class IntrusiveHashHook {
+    template<class T, IntrusiveHashHook T::*, class, class, class, class>
+    friend class IntrusiveHashSet;
+
+    IntrusiveHashHook* next_ = nullptr;
+    IntrusiveHashHook** pprev_ = nullptr;   // 前の要素（またはバケット）の next_
+    size_t hash_ = 0;                       // 再ハッシュ用に覚えておく
+#if TORK_INTRUSIVE_SAFE_MODE
+    const void* owner_ = nullptr;           // 所属するセット
+#endif
+
+public:
+    IntrusiveHashHook() { }
+
+    // コピーしてもリンクは引き継がない
+    IntrusiveHashHook(const IntrusiveHashHook&) { }
+    IntrusiveHashHook& operator =(const IntrusiveHashHook&) { return *this; }
+
+    ~IntrusiveHashHook()
+    {
+#if TORK_INTRUSIVE_SAFE_MODE
+        assert(!is_linked() && "destroying an object still linked into tork::IntrusiveHashSet");
+#endif
+    }
+
+    // セットに入っているかどうか
+    bool is_linked() const { return pprev_ != nullptr; }
+
+};  // class IntrusiveHashHook
+
+//==============================================================================
+// 侵入型ハッシュセットクラス
+// KeyOf は要素からキーを取り出す関数オブジェクト（const T& -> const Key&）
+//
+//  struct Item {
+//      int id;
+//      tork::IntrusiveHashHook by_id;
+//  };
+//  struct ItemId { int operator ()(const Item& x) const { return x.id; } };
+//  tork::IntrusiveHashSet<Item, &Item::by_id, int, ItemId> index;
+//==============================================================================
+template<class T, IntrusiveHashHook T::*Hook, class Key, class KeyOf,
+    class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>>
+class IntrusiveHashSet {
+public:
+    typedef T value_type;
+    typedef Key key_type;
+    typedef size_t size_type;
+
+private:
+    Array<IntrusiveHashHook*> buckets_;
+    size_type size_ = 0;
+    KeyOf key_of_;
+    Hash hash_;
+    KeyEqual eq_;
+
+public:
+
+    // イテレータ（バケット順）
+    template<class V>
+    class Iterator {
+        friend class IntrusiveHashSet;
+        template<class> friend class Iterator;
+        const IntrusiveHashSet* p_set_ = nullptr;
+        size_type bucket_ = 0;
+        IntrusiveHashHook* p_ = nullptr;
+
+        Iterator(const IntrusiveHashSet* s, size_type b, IntrusiveHashHook* p)
+            :p_set_(s), bucket_(b), p_(p)
+        {
+            skip_empty();
+        }
+
+        void skip_empty()
+        {
+            while (p_ == nullptr && ++bucket_ < p_set_->buckets_.size()) {
+                p_ = p_set_->buckets_[bucket_];
+            }
+        }
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef ptrdiff_t difference_type;
+        typedef V* pointer;
+        typedef V& reference;
+
+        Iterator() { }
+
+        // 非constからconstへの変換
+        operator Iterator<const T>() const { return Iterator<const T>(p_set_, bucket_, p_); }
+
+        reference operator *() const { return *impl::OwnerOf(p_, Hook); }
+        pointer operator ->() const { return impl::OwnerOf(p_, Hook); }
+
+        Iterator& operator ++()
+        {
+            p_ = p_->next_;
+            skip_empty();
+            return *this;
+        }
+        Iterator operator ++(int) { Iterator t = *this; ++*this; return t; }
+
+        bool operator ==(const Iterator& x) const { return p_ == x.p_; }
+        bool operator !=(const Iterator& x) const { return p_ != x.p_; }
+    };
+
+    typedef Iterator<T> iterator;
+    typedef Iterator<const T> const_iterator;
+
+    // バケット数を指定して構築
+    explicit IntrusiveHashSet(size_type bucket_count = 16, const KeyOf& key_of = KeyOf(),
+            const Hash& hash = Hash(), const KeyEqual& eq = KeyEqual())
+        :key_of_(key_of), hash_(hash), eq_(eq)
+    {
+        buckets_.assign(round_up(bucket_count), nullptr);
+    }
+
+    // 要素を所有しないので、コピーはできない
+    IntrusiveHashSet(const IntrusiveHashSet&) = delete;
+    IntrusiveHashSet& operator =(const IntrusiveHashSet&) = delete;
+
+    // デストラクタ
+    // 残っている要素はセットから外すだけで、破棄はしない
+    ~IntrusiveHashSet()
+    {
+        clear();
+    }
+
+    // 挿入
+    // 同じキーの要素があれば挿入せず、その要素と false を返す
+    std::pair<T*, bool> insert(T& value)
+    {
+        const Key& key = key_of_(value);
+        size_t h = hash_(key);
+        T* found = find_with_hash(key, h);
+        if (found) return std::make_pair(found, false);
+
+        if (size_ >= buckets_.size()) {
+            rehash(buckets_.size() * 2);
+        }
+
+        IntrusiveHashHook* hook = &(value.*Hook);
+#if TORK_INTRUSIVE_SAFE_MODE
+        assert(!hook->is_linked() && "object is already linked into a tork::IntrusiveHashSet");
+        hook->owner_ = this;
+#endif
+        hook->hash_ = h;
+        link(hook, bucket_of(h));
+        ++size_;
+        return std::make_pair(&value, true);
+    }
+
+    // 検索
+    // なければ nullptr
+    T* find(const Key& key) const
+    {
+        return find_with_hash(key, hash_(key));
+    }
+
+    // キーがあるかどうか
+    bool contains(const Key& key) const { return find(key) != nullptr; }
+
+    // 要素を外す（O(1)）
+    void erase(T& value)
+    {
+        IntrusiveHashHook* hook = &(value.*Hook);
+#if TORK_INTRUSIVE_SAFE_MODE
+        assert(hook->owner_ == this && "object is not linked into this tork::IntrusiveHashSet");
+        hook->owner_ = nullptr;
+#endif
+        unlink(hook);
+        --size_;
+    }
+
+    // キーを指定して外す
+    size_type erase(const Key& key)
+    {
+        T* p = find(key);
+        if (p == nullptr) return 0;
+        erase(*p);
+        return 1;
+    }
+
+    // 全要素を外す（破棄はしない）
+    void clear()
+    {
+        clear_and_dispose([](T*) { });
+    }
+
+    // 全要素を外しながら disposer(T*) を呼ぶ
+    template<class Disposer>
+    void clear_and_dispose(Disposer disposer)
+    {
+        for (size_type b = 0; b < buckets_.size(); ++b) {
+            while (IntrusiveHashHook* hook = buckets_[b]) {
+                T* p = impl::OwnerOf(hook, Hook);
+                erase(*p);
+                disposer(p);
+            }
+        }
+    }
+
+    // バケット数を変えてつなぎ直す（2 の冪に切り上げる）
+    void rehash(size_type n)
+    {
+        if (n < size_) n = size_;
+        n = round_up(n);
+        if (n == buckets_.size()) return;
+
+        Array<IntrusiveHashHook*> old(n, nullptr);
+        old.swap(buckets_);
+        for (size_type b = 0; b < old.size(); ++b) {
+            IntrusiveHashHook* hook = old[b];
+            while (hook) {
+                IntrusiveHashHook* next = hook->next_;
+                link(hook, bucket_of(hook->hash_));
+                hook = next;
+            }
+        }
+    }
+
+    // 要素数
+    size_type size() const { return size_; }
+
+    // 空かどうか
+    bool empty() const { return size_ == 0; }
+
+    // バケット数
+    size_type bucket_count() const { return buckets_.size(); }
+
+    // イテレータ
+    iterator begin() { return iterator(this, 0, buckets_[0]); }
+    const_iterator begin() const { return const_iterator(this, 0, buckets_[0]); }
+    iterator end() { return iterator(this, buckets_.size(), nullptr); }
+    const_iterator end() const { return const_iterator(this, buckets_.size(), nullptr); }
+
+private:
+
+    static size_type round_up(size_type n)
+    {
+        size_type b = 1;
+        while (b < n) {
+            b *= 2;
+        }
+        return b;
+    }
+
+    size_type bucket_of(size_t h) const
+    {
+        return mix(h) & (buckets_.size() - 1);
+    }
+
+    // 恒等関数の std::hash でも下位ビットが散らばるようにする
+    static size_t mix(size_t h)
+    {
+        return h ^ (h >> 16) ^ (h >> 7);
+    }
+
+    // バケットの先頭につなぐ
+    void link(IntrusiveHashHook* hook, size_type b)
+    {
+        IntrusiveHashHook*& head = buckets_[b];
+        hook->next_ = head;
+        if (head) head->pprev_ = &hook->next_;
+        hook->pprev_ = &head;
+        head = hook;
+    }
+
+    // チェインから外す
+    static void unlink(IntrusiveHashHook* hook)
+    {
+        *hook->pprev_ = hook->next_;
+        if (hook->next_) hook->next_->pprev_ = hook->pprev_;
+        hook->next_ = nullptr;
+        hook->pprev_ = nullptr;
+    }
+
+    T* find_with_hash(const Key& key, size_t h) const
+    {
+        for (IntrusiveHashHook* hook = buckets_[bucket_of(h)]; hook; hook = hook->next_) {
+            if (hook->hash_ == h) {
+                T* p = impl::OwnerOf(hook, Hook);
+                if (eq_(key_of_(*p), key)) return p;
+            }
+        }
+        return nullptr;
+    }
+
+};  // class IntrusiveHashSet
+
+}   // namespace tork
+
+#endif  // TORK_CONTAINER_INTRUSIVE_HASH_SET_H_INCLUDED
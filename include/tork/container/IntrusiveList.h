@@ -0,0 +1,349 @@
+﻿//******************************************************************************
+//
+// 侵入型双方向リスト
+//
+// 要素のメンバに置いたフック（前後のポインタ）をつなぐだけなので、
+// 追加してもノードの確保は起きない
+// リストは要素を所有しない。要素の寿命は shared_ptr や unique_ptr などで別に管理し、
+// 破棄する前にリストから外すこと（clear_and_dispose() で外しながら解放もできる）
+//
+// TORK_INTRUSIVE_SAFE_MODE が 1 なら（_DEBUG では既定で 1）、
+// 二重登録、別のリストからの削除、リンクしたままの破棄を assert で検出する
+//
+//******************************************************************************
+
+#ifndef TORK_CONTAINER_INTRUSIVE_LIST_H_INCLUDED
+#define TORK_CONTAINER_INTRUSIVE_LIST_H_INCLUDED
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <cassert>
+
+#ifndef TORK_INTRUSIVE_SAFE_MODE
+#ifdef _DEBUG
+#define TORK_INTRUSIVE_SAFE_MODE 1
+#else
+#define TORK_INTRUSIVE_SAFE_MODE 0
+#endif
+#endif
+
+namespace tork {
+
+    namespace impl {
+
+// メンバへのポインタから、メンバのオフセットを求める
+template<class T, class Member>
+inline ptrdiff_t MemberOffset(Member T::*member)
+{
+    // ヌルポインタを使わないように、適当なアドレスを基準にする
+    const T* base = reinterpret_cast<const T*>(static_cast<size_t>(0x1000));
+    return reinterpret_cast<const char*>(&(base->*member))
+        - reinterpret_cast<const char*>(base);
+}
+
+// メンバのアドレスから、それを含むオブジェクトのアドレスを求める
+template<class T, class Member>
+inline T* OwnerOf(Member* p, Member T::*member)
+{
+    return reinterpret_cast<T*>(reinterpret_cast<char*>(p) - MemberOffset(member));
+}
+
+    }   // namespace tork::impl
+
+//==============================================================================
+// リストフック
+// リストに入れる型のメンバに置く。複数のリストに入れる場合はその数だけ置く
+//==============================================================================
+class IntrusiveListHook {
+    template<class T, IntrusiveListHook T::*> friend class IntrusiveList;
+    template<class T, IntrusiveListHook T::*, class V> friend class IntrusiveListIterator;
+
+    IntrusiveListHook* prev_ = nullptr;
+    IntrusiveListHook* next_ = nullptr;
+#if TORK_INTRUSIVE_SAFE_MODE
+    const void* owner_ = nullptr;   // 所属するリスト
+#endif
+
+public:
+    IntrusiveListHook() { }
+
+    // コピーしてもリンクは引き継がない
+    IntrusiveListHook(const IntrusiveListHook&) { }
+    IntrusiveListHook& operator =(const IntrusiveListHook&) { return *this; }
+
+    ~IntrusiveListHook()
+    {
+#if TORK_INTRUSIVE_SAFE_MODE
+        assert(!is_linked() && "destroying an object still linked into tork::IntrusiveList");
+#endif
+    }
+
+    // リストに入っているかどうか
+    bool is_linked() const { return next_ != nullptr; }
+
+};  // class IntrusiveListHook
+
+//==============================================================================
+// 侵入型リストのイテレータ
+//==============================================================================
+template<class T, IntrusiveListHook T::*Hook, class V>
+class IntrusiveListIterator {
+public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef ptrdiff_t difference_type;
+    typedef V* pointer;
+    typedef V& reference;
+
+private:
+    IntrusiveListHook* p_ = nullptr;
+
+public:
+    IntrusiveListIterator() { }
+    explicit IntrusiveListIterator(IntrusiveListHook* p) :p_(p) { }
+
+    // 非constからconstへの変換
+    operator IntrusiveListIterator<T, Hook, const T>() const
+    {
+        return IntrusiveListIterator<T, Hook, const T>(p_);
+    }
+
+    IntrusiveListHook* hook() const { return p_; }
+
+    reference operator *() const { return *impl::OwnerOf(p_, Hook); }
+    pointer operator ->() const { return impl::OwnerOf(p_, Hook); }
+
+    IntrusiveListIterator& operator ++() { p_ = p_->next_; return *this; }
+    IntrusiveListIterator& operator --() { p_ = p_->prev_; return *this; }
+    IntrusiveListIterator operator ++(int) { IntrusiveListIterator t = *this; ++*this; return t; }
+    IntrusiveListIterator operator --(int) { IntrusiveListIterator t = *this; --*this; return t; }
+
+    bool operator ==(const IntrusiveListIterator& x) const { return p_ == x.p_; }
+    bool operator !=(const IntrusiveListIterator& x) const { return p_ != x.p_; }
+
+};  // class IntrusiveListIterator
+
+//==============================================================================
+// 侵入型リストクラス
+// Hook はリストに使うフックのメンバポインタ
+//
+//  struct Item {
+//      int value;
+//      tork::IntrusiveListHook lru;
+//  };
+//  tork::IntrusiveList<Item, &Item::lru> list;
+//==============================================================================
+template<class T, IntrusiveListHook T::*Hook>
+class IntrusiveList {
+public:
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef IntrusiveListIterator<T, Hook, T> iterator;
+    typedef IntrusiveListIterator<T, Hook, const T> const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+private:
+    IntrusiveListHook root_;    // 番兵（先頭の前、末尾の次）
+    size_type size_ = 0;
+
+public:
+
+    // コンストラクタ
+    IntrusiveList()
+    {
+        root_.prev_ = root_.next_ = &root_;
+    }
+
+    // 要素を所有しないので、コピーはできない
+    IntrusiveList(const IntrusiveList&) = delete;
+    IntrusiveList& operator =(const IntrusiveList&) = delete;
+
+    // ムーブコンストラクタ
+    IntrusiveList(IntrusiveList&& other)
+    {
+        root_.prev_ = root_.next_ = &root_;
+        swap(other);
+    }
+
+    // ムーブ代入演算子
+    IntrusiveList& operator =(IntrusiveList&& other)
+    {
+        if (this == &other) return *this;
+        clear();
+        swap(other);
+        return *this;
+    }
+
+    // デストラクタ
+    // 残っている要素はリストから外すだけで、破棄はしない
+    ~IntrusiveList()
+    {
+        clear();
+        root_.prev_ = root_.next_ = nullptr;
+    }
+
+    // スワップ
+    void swap(IntrusiveList& other)
+    {
+        IntrusiveListHook tmp;
+        relink_root(tmp, root_);
+        relink_root(root_, other.root_);
+        relink_root(other.root_, tmp);
+        tmp.prev_ = tmp.next_ = nullptr;
+        std::swap(size_, other.size_);
+#if TORK_INTRUSIVE_SAFE_MODE
+        for (auto it = begin(); it != end(); ++it) {
+            it.hook()->owner_ = this;
+        }
+        for (auto it = other.begin(); it != other.end(); ++it) {
+            it.hook()->owner_ = &other;
+        }
+#endif
+    }
+
+    // pos の前に挿入
+    iterator insert(const_iterator pos, T& value)
+    {
+        IntrusiveListHook* h = &(value.*Hook);
+#if TORK_INTRUSIVE_SAFE_MODE
+        assert(!h->is_linked() && "object is already linked into a tork::IntrusiveList");
+        h->owner_ = this;
+#endif
+        IntrusiveListHook* next = pos.hook();
+        h->next_ = next;
+        h->prev_ = next->prev_;
+        next->prev_->next_ = h;
+        next->prev_ = h;
+        ++size_;
+        return iterator(h);
+    }
+
+    // 先頭に追加
+    void push_front(T& value) { insert(begin(), value); }
+
+    // 末尾に追加
+    void push_back(T& value) { insert(end(), value); }
+
+    // 先頭を外す
+    void pop_front() { assert(!empty()); erase(begin()); }
+
+    // 末尾を外す
+    void pop_back() { assert(!empty()); erase(--end()); }
+
+    // 要素を外す（O(1)）
+    // 次の要素を指すイテレータを返す
+    iterator erase(const_iterator pos)
+    {
+        IntrusiveListHook* h = pos.hook();
+        assert(h != &root_);
+#if TORK_INTRUSIVE_SAFE_MODE
+        assert(h->owner_ == this && "object is not linked into this tork::IntrusiveList");
+        h->owner_ = nullptr;
+#endif
+        IntrusiveListHook* next = h->next_;
+        h->prev_->next_ = next;
+        next->prev_ = h->prev_;
+        h->prev_ = h->next_ = nullptr;
+        --size_;
+        return iterator(next);
+    }
+
+    // 要素を外す（O(1)）
+    void erase(T& value) { erase(iterator_to(value)); }
+
+    // 要素を先頭へ移す（O(1)）
+    void move_to_front(T& value)
+    {
+        erase(value);
+        push_front(value);
+    }
+
+    // 要素を末尾へ移す（O(1)）
+    void move_to_back(T& value)
+    {
+        erase(value);
+        push_back(value);
+    }
+
+    // 全要素を外す（破棄はしない）
+    void clear()
+    {
+        clear_and_dispose([](T*) { });
+    }
+
+    // 全要素を外しながら disposer(T*) を呼ぶ
+    // unique_ptr から release() して入れた要素を delete する場合などに使う
+    template<class Disposer>
+    void clear_and_dispose(Disposer disposer)
+    {
+        while (!empty()) {
+            T* p = &front();
+            pop_front();
+            disposer(p);
+        }
+    }
+
+    // 要素を指すイテレータ
+    iterator iterator_to(T& value)
+    {
+        return iterator(&(value.*Hook));
+    }
+    const_iterator iterator_to(const T& value) const
+    {
+        return const_iterator(const_cast<IntrusiveListHook*>(&(value.*Hook)));
+    }
+
+    // 先頭要素
+    reference front() { assert(!empty()); return *begin(); }
+    const_reference front() const { assert(!empty()); return *begin(); }
+
+    // 末尾要素
+    reference back() { assert(!empty()); return *--end(); }
+    const_reference back() const { assert(!empty()); return *--end(); }
+
+    // 要素数
+    size_type size() const { return size_; }
+
+    // 空かどうか
+    bool empty() const { return size_ == 0; }
+
+    // イテレータ
+    iterator begin() { return iterator(root_.next_); }
+    const_iterator begin() const { return const_iterator(root_.next_); }
+    iterator end() { return iterator(&root_); }
+    const_iterator end() const { return const_iterator(const_cast<IntrusiveListHook*>(&root_)); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    // 逆イテレータ
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+private:
+
+    // from の要素を to の番兵につなぎ替える
+    static void relink_root(IntrusiveListHook& to, IntrusiveListHook& from)
+    {
+        if (from.next_ == &from) {
+            to.prev_ = to.next_ = &to;
+        }
+        else {
+            to.next_ = from.next_;
+            to.prev_ = from.prev_;
+            to.next_->prev_ = &to;
+            to.prev_->next_ = &to;
+        }
+        from.prev_ = from.next_ = &from;
+    }
+
+};  // class IntrusiveList
+
+}   // namespace tork
+
+#endif  // TORK_CONTAINER_INTRUSIVE_LIST_H_INCLUDED
@@ -0,0 +1,319 @@
+﻿//******************************************************************************
+//
+// シャード分割した LRU / CLOCK キャッシュ
+//
+// 値は tork::shared_ptr で持つので、取り出した値は追い出された後も使える
+// 容量は重み（既定では1要素1）の合計で決め、重み関数でバイト数などを返せばバイト単位になる
+//
+// LRU    : ヒットのたびに要素をリストの末尾へ移す（書き込みロックが要る）
+// CLOCK  : ヒットでは参照ビットを立てるだけなので読み込みロックで済む
+//          追い出すときに参照ビットの立っている要素は1回だけ見逃す（セカンドチャンス）
+//
+//******************************************************************************
+
+#ifndef TORK_CONTAINER_LRU_CACHE_H_INCLUDED
+#define TORK_CONTAINER_LRU_CACHE_H_INCLUDED
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <functional>
+#include "FlatHashMap.h"
+#include "IntrusiveList.h"
+#include "../memory/shared_ptr.h"
+#include "../thread/SpinLock.h"
+
+namespace tork {
+
+// 追い出し方
+enum class CachePolicy {
+    Lru,        // 最も長く使われていないもの
+    Clock,      // 参照ビットによる近似 LRU
+};
+
+// キャッシュの統計
+struct CacheStats {
+    unsigned long long hits = 0;        // ヒット数
+    unsigned long long misses = 0;      // ミス数
+    unsigned long long evictions = 0;   // 容量超過で追い出した数
+};
+
+//==============================================================================
+// キャッシュクラス
+//==============================================================================
+template<class K, class V,
+    class Hash = std::hash<K>,
+    class KeyEqual = std::equal_to<K>>
+class LruCache {
+public:
+    typedef K key_type;
+    typedef V mapped_type;
+    typedef shared_ptr<V> value_ptr;
+    typedef size_t size_type;
+
+    // 重み関数
+    typedef std::function<size_type(const K&, const V&)> Weigher;
+
+    // シャードあたりの容量の下限
+    // 容量が小さいときはシャード数を減らして、1つのシャードに入る重みを確保する
+    static const size_type MinShardCapacity = 32;
+
+private:
+    // 要素
+    struct Entry {
+        K key;
+        value_ptr value;
+        size_type weight;
+        std::atomic<bool> referenced;   // CLOCK の参照ビット
+        IntrusiveListHook order;        // 先頭が最も古い
+
+        Entry(const K& k, const value_ptr& v, size_type w)
+            :key(k), value(v), weight(w), referenced(false)
+        {
+
+        }
+    };
+
+    typedef IntrusiveList<Entry, &Entry::order> OrderList;
+
+    // シャード
+    struct Shard {
+        mutable RWSpinLock lock;
+        FlatHashMap<K, Entry*, Hash, KeyEqual> map;
+        OrderList order;
+        size_type weight = 0;
+        size_type capacity = 0;
+        std::atomic<unsigned long long> hits;
+        std::atomic<unsigned long long> misses;
+        std::atomic<unsigned long long> evictions;
+        char padding[64];
+
+        Shard() :hits(0), misses(0), evictions(0) { }
+    };
+
+    std::unique_ptr<Shard[]> shards_;
+    size_type shard_count_ = 0;
+    unsigned shard_shift_ = 0;
+    size_type capacity_;
+    CachePolicy policy_;
+    Weigher weigher_;
+    Hash hash_;
+
+public:
+
+    // 容量（重みの合計）、シャード数、追い出し方、重み関数を指定して構築
+    // シャード数が 0 ならハードウェアスレッド数の 4 倍を 2 の冪に切り上げた数
+    // どちらの場合も、シャードの容量が MinShardCapacity を下回らないように減らす
+    // 重み関数を省略すると1要素の重みは 1
+    explicit LruCache(size_type capacity, size_type shard_count = 0,
+            CachePolicy policy = CachePolicy::Lru, Weigher weigher = Weigher())
+        :capacity_(capacity), policy_(policy), weigher_(weigher)
+    {
+        if (shard_count == 0) {
+            shard_count = std::thread::hardware_concurrency() * 4;
+        }
+        if (shard_count > 4096) shard_count = 4096;
+
+        unsigned bits = 0;
+        while ((size_type(1) << bits) < shard_count) {
+            ++bits;
+        }
+        // 重みの大きい要素が入らなくなるので、シャードの容量を小さくしすぎない
+        while (bits > 0 && (capacity >> bits) < MinShardCapacity) {
+            --bits;
+        }
+        shard_count_ = size_type(1) << bits;
+        shard_shift_ = static_cast<unsigned>(sizeof(size_t) * 8 - 7 - bits);
+        shards_.reset(new Shard[shard_count_]);
+
+        // 端数は先頭のシャードから1ずつ配る
+        for (size_type i = 0; i < shard_count_; ++i) {
+            shards_[i].capacity = capacity / shard_count_ + (i < capacity % shard_count_ ? 1 : 0);
+        }
+    }
+
+    LruCache(const LruCache&) = delete;
+    LruCache& operator =(const LruCache&) = delete;
+
+    // デストラクタ
+    ~LruCache()
+    {
+        clear();
+    }
+
+    // 取得
+    // なければ空の shared_ptr
+    value_ptr get(const K& key)
+    {
+        Shard& s = shard_of(key);
+        if (policy_ == CachePolicy::Clock) {
+            SharedLockGuard<RWSpinLock> guard(s.lock);
+            auto it = s.map.find(key);
+            if (it == s.map.end()) return miss(s);
+            // 既に立っていれば書き込まない（キャッシュラインを汚さない）
+            Entry* e = it->second;
+            if (!e->referenced.load(std::memory_order_relaxed)) {
+                e->referenced.store(true, std::memory_order_relaxed);
+            }
+            s.hits.fetch_add(1, std::memory_order_relaxed);
+            return e->value;
+        }
+        else {
+            std::lock_guard<RWSpinLock> guard(s.lock);
+            auto it = s.map.find(key);
+            if (it == s.map.end()) return miss(s);
+            Entry* e = it->second;
+            s.order.move_to_back(*e);
+            s.hits.fetch_add(1, std::memory_order_relaxed);
+            return e->value;
+        }
+    }
+
+    // 追加（既にあれば置き換える）
+    // 重みがシャードの容量を超える値は入れない（既存の値は消える）
+    void put(const K& key, const value_ptr& value)
+    {
+        size_type w = weigh(key, value);
+        Shard& s = shard_of(key);
+        std::lock_guard<RWSpinLock> guard(s.lock);
+
+        auto it = s.map.find(key);
+        if (it != s.map.end()) {
+            remove(s, it->second);
+        }
+        if (w > s.capacity) return;
+
+        // 表に入れ終わるまでは unique_ptr で持つ（表の拡張が例外を投げても漏れない）
+        std::unique_ptr<Entry> e(new Entry(key, value, w));
+        s.map.try_emplace(key, e.get());
+        s.order.push_back(*e.release());
+        s.weight += w;
+        evict(s);
+    }
+
+    // 削除
+    bool erase(const K& key)
+    {
+        Shard& s = shard_of(key);
+        std::lock_guard<RWSpinLock> guard(s.lock);
+        auto it = s.map.find(key);
+        if (it == s.map.end()) return false;
+        remove(s, it->second);
+        return true;
+    }
+
+    // 全要素の削除
+    void clear()
+    {
+        for (size_type i = 0; i < shard_count_; ++i) {
+            Shard& s = shards_[i];
+            std::lock_guard<RWSpinLock> guard(s.lock);
+            s.map.clear();
+            s.order.clear_and_dispose([](Entry* e) { delete e; });
+            s.weight = 0;
+        }
+    }
+
+    // 統計
+    CacheStats stats() const
+    {
+        CacheStats st;
+        for (size_type i = 0; i < shard_count_; ++i) {
+            st.hits += shards_[i].hits.load(std::memory_order_relaxed);
+            st.misses += shards_[i].misses.load(std::memory_order_relaxed);
+            st.evictions += shards_[i].evictions.load(std::memory_order_relaxed);
+        }
+        return st;
+    }
+
+    // 統計のリセット
+    void reset_stats()
+    {
+        for (size_type i = 0; i < shard_count_; ++i) {
+            shards_[i].hits = 0;
+            shards_[i].misses = 0;
+            shards_[i].evictions = 0;
+        }
+    }
+
+    // 要素数
+    size_type size() const
+    {
+        size_type n = 0;
+        for (size_type i = 0; i < shard_count_; ++i) {
+            SharedLockGuard<RWSpinLock> guard(shards_[i].lock);
+            n += shards_[i].map.size();
+        }
+        return n;
+    }
+
+    // 重みの合計
+    size_type weight() const
+    {
+        size_type n = 0;
+        for (size_type i = 0; i < shard_count_; ++i) {
+            SharedLockGuard<RWSpinLock> guard(shards_[i].lock);
+            n += shards_[i].weight;
+        }
+        return n;
+    }
+
+    // 容量
+    size_type capacity() const { return capacity_; }
+
+    // シャード数
+    size_type shard_count() const { return shard_count_; }
+
+    // 追い出し方
+    CachePolicy policy() const { return policy_; }
+
+private:
+
+    Shard& shard_of(const K& key)
+    {
+        return shards_[(impl::HashMix(hash_(key)) >> shard_shift_) & (shard_count_ - 1)];
+    }
+
+    size_type weigh(const K& key, const value_ptr& value) const
+    {
+        if (!weigher_ || !value) return 1;
+        return weigher_(key, *value);
+    }
+
+    value_ptr miss(Shard& s)
+    {
+        s.misses.fetch_add(1, std::memory_order_relaxed);
+        return value_ptr();
+    }
+
+    // 要素を外して破棄する（書き込みロック中に呼ぶ）
+    void remove(Shard& s, Entry* e)
+    {
+        s.map.erase(e->key);
+        s.order.erase(*e);
+        s.weight -= e->weight;
+        delete e;
+    }
+
+    // 容量に収まるまで古いものから追い出す（書き込みロック中に呼ぶ）
+    void evict(Shard& s)
+    {
+        while (s.weight > s.capacity && !s.order.empty()) {
+            Entry* e = &s.order.front();
+            if (policy_ == CachePolicy::Clock
+                    && e->referenced.exchange(false, std::memory_order_relaxed)) {
+                // 最近使われたので、末尾へ回してもう1周待つ
+                s.order.move_to_back(*e);
+                continue;
+            }
+            remove(s, e);
+            s.evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+};  // class LruCache
+
+}   // namespace tork
+
+#endif  // TORK_CONTAINER_LRU_CACHE_H_INCLUDED
@@ -0,0 +1,209 @@
+﻿//******************************************************************************
+//
+// ファイルにマップされた配列
+//
+// 要素をファイルにそのまま置いて、起動時に読み込みや解析をせずに使う
+// 要素型はバイト列として読み書きできる型（trivially copyable）に限る
+//
+//******************************************************************************
+
+#ifndef TORK_CONTAINER_MAPPED_ARRAY_H_INCLUDED
+#define TORK_CONTAINER_MAPPED_ARRAY_H_INCLUDED
+
+#include <string>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <cassert>
+#include "MappedFile.h"
+
+namespace tork {
+
+//==============================================================================
+// ファイルマップ配列クラス
+// 要素数はファイルサイズ / sizeof(T) で決まる
+//==============================================================================
+template<class T>
+class MappedArray {
+    static_assert(std::is_trivially_copyable<T>::value,
+            "tork::MappedArray needs a trivially copyable element type");
+
+public:
+    typedef MappedArray<T> ThisType;
+
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef T value_type;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+
+    typedef T* iterator;
+    typedef const T* const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+private:
+    MappedFile file_;
+
+public:
+
+    // デフォルトコンストラクタ
+    MappedArray() { }
+
+    // 既存のファイルを開く
+    explicit MappedArray(const std::string& path, MapMode mode = MapMode::ReadOnly)
+    {
+        open(path, mode);
+    }
+
+    // ムーブコンストラクタ
+    MappedArray(MappedArray&& other)
+        :file_(std::move(other.file_))
+    {
+
+    }
+
+    // ムーブ代入演算子
+    MappedArray& operator =(MappedArray&& other)
+    {
+        file_ = std::move(other.file_);
+        return *this;
+    }
+
+    // コピー禁止
+    MappedArray(const MappedArray&) = delete;
+    MappedArray& operator =(const MappedArray&) = delete;
+
+    // 既存のファイルを開く
+    // ファイルサイズが要素サイズの倍数でなければ、余りの部分は無視する
+    void open(const std::string& path, MapMode mode = MapMode::ReadOnly)
+    {
+        file_.open(path, mode);
+    }
+
+    // 要素数 n のファイルを作成して開く（要素は 0 で埋められる）
+    void create(const std::string& path, size_type n)
+    {
+        file_.create(path, n * sizeof(T));
+    }
+
+    // 閉じる
+    void close()
+    {
+        file_.close();
+    }
+
+    // 要素数を変更する（ファイルサイズを変えてマップし直す）
+    // 増えた要素は 0 で埋められる
+    // MapMode::ReadWrite で開いている場合のみ
+    // データのアドレスが変わるので、イテレータやポインタは無効になる
+    void resize(size_type n)
+    {
+        file_.resize(n * sizeof(T));
+    }
+
+    // 変更をファイルに書き出す
+    void flush()
+    {
+        file_.flush();
+    }
+
+    // アクセスパターンのヒント
+    void advise(MapAdvice advice)
+    {
+        file_.advise(advice);
+    }
+
+    // 範囲を指定してヒントを与える
+    void advise(MapAdvice advice, size_type first, size_type n)
+    {
+        file_.advise(advice, first * sizeof(T), n * sizeof(T));
+    }
+
+    // 開いているかどうか
+    bool is_open() const { return file_.is_open(); }
+
+    // モード
+    MapMode mode() const { return file_.mode(); }
+
+    // スワップ
+    void swap(MappedArray& other)
+    {
+        file_.swap(other.file_);
+    }
+
+    // 要素への添え字アクセス
+    // ReadOnly で開いている場合に書き込むとアクセス違反になる
+    reference at(size_type i)
+    {
+        if (i >= size()) throw std::out_of_range("out of range at tork::MappedArray");
+        return data()[i];
+    }
+    const_reference at(size_type i) const
+    {
+        if (i >= size()) throw std::out_of_range("out of range at tork::MappedArray");
+        return data()[i];
+    }
+
+    // operator []
+    reference operator [](size_type i)
+    {
+        assert(i < size());
+        return data()[i];
+    }
+    const_reference operator [](size_type i) const
+    {
+        assert(i < size());
+        return data()[i];
+    }
+
+    // 要素数
+    size_type size() const { return file_.size() / sizeof(T); }
+
+    // 空かどうか
+    bool empty() const { return size() == 0; }
+
+    // データの先頭を指すポインタ
+    T* data() { return static_cast<T*>(file_.data()); }
+    const T* data() const { return static_cast<const T*>(file_.data()); }
+
+    // 先頭要素の参照
+    reference front() { return *data(); }
+    const_reference front() const { return *data(); }
+
+    // 末尾要素の参照
+    reference back() { return data()[size() - 1]; }
+    const_reference back() const { return data()[size() - 1]; }
+
+    // 最初の要素を指すイテレータ
+    iterator begin() { return data(); }
+    const_iterator begin() const { return data(); }
+
+    // 最後の要素の次を指すイテレータ
+    iterator end() { return data() + size(); }
+    const_iterator end() const { return data() + size(); }
+
+    // 逆イテレータ
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    // constイテレータ
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+};  // class MappedArray
+
+// スワップ
+template<class T>
+void swap(MappedArray<T>& x, MappedArray<T>& y)
+{
+    x.swap(y);
+}
+
+}   // namespace tork
+
+#endif  // TORK_CONTAINER_MAPPED_ARRAY_H_INCLUDED
@@ -0,0 +1,123 @@
+﻿//******************************************************************************
+//
+// メモリマップトファイル
+//
+//******************************************************************************
+
+#ifndef TORK_CONTAINER_MAPPED_FILE_H_INCLUDED
+#define TORK_CONTAINER_MAPPED_FILE_H_INCLUDED
+
+#include <string>
+#include <stdexcept>
+
+namespace tork {
+
+// マップのモード
+enum class MapMode {
+    ReadOnly,       // 読み取り専用
+    ReadWrite,      // 読み書き（書き込みはファイルに反映される）
+    CopyOnWrite,    // 書き込めるがファイルには反映されない（プライベートマップ）
+};
+
+// アクセスパターンのヒント
+enum class MapAdvice {
+    Normal,         // 特になし
+    Sequential,     // 先頭から順に読む
+    Random,         // ランダムに読む
+    WillNeed,       // すぐに読むので先読みしてほしい
+};
+
+// マップ失敗例外
+class MappedFileError : public std::runtime_error {
+    int code_;
+public:
+    MappedFileError(const std::string& what, int code);
+
+    // OS のエラーコード（errno / GetLastError()）
+    int code() const { return code_; }
+};
+
+//==============================================================================
+// メモリマップトファイル
+// ファイル全体をアドレス空間にマップする
+// サイズ 0 のファイルは開けるが、data() は nullptr になる
+//==============================================================================
+class MappedFile {
+public:
+
+    // コンストラクタ
+    MappedFile();
+
+    // ムーブコンストラクタ
+    MappedFile(MappedFile&& other);
+
+    // デストラクタ
+    // ReadWrite の場合でも flush() はしない（OS に任せる）
+    ~MappedFile();
+
+    // ムーブ代入演算子
+    MappedFile& operator =(MappedFile&& other);
+
+    // コピー禁止
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator =(const MappedFile&) = delete;
+
+    // 既存のファイルを開く
+    void open(const std::string& path, MapMode mode = MapMode::ReadOnly);
+
+    // ファイルを作成して開く（既にあれば切り詰める）
+    // 内容は 0 で埋められる
+    void create(const std::string& path, size_t bytes);
+
+    // 閉じる
+    void close();
+
+    // ファイルサイズを変更してマップし直す
+    // 伸ばした部分は 0 で埋められる
+    // data() の値は変わることがある
+    void resize(size_t bytes);
+
+    // 変更をファイルに書き出す
+    void flush();
+
+    // アクセスパターンのヒントを与える
+    // 対応していない環境では何もしない
+    void advise(MapAdvice advice);
+    void advise(MapAdvice advice, size_t offset, size_t bytes);
+
+    // マップされた領域
+    void* data() const { return p_data_; }
+
+    // バイト数
+    size_t size() const { return size_; }
+
+    // 開いているかどうか
+    bool is_open() const { return is_open_; }
+
+    // モード
+    MapMode mode() const { return mode_; }
+
+    // スワップ
+    void swap(MappedFile& other);
+
+private:
+    void* p_data_ = nullptr;
+    size_t size_ = 0;
+    MapMode mode_ = MapMode::ReadOnly;
+    bool is_open_ = false;
+
+    // OS のハンドル
+    // Windows: ファイルとファイルマッピングオブジェクトの HANDLE
+    // POSIX:   file_ にファイルディスクリプタ
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+
+    void open_file(const std::string& path, MapMode mode, bool create);
+    void map(size_t bytes);
+    void unmap();
+
+};  // class MappedFile
+
+}   // namespace tork
+
+#endif  // TORK_CONTAINER_MAPPED_FILE_H_INCLUDED
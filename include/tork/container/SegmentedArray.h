@@ -0,0 +1,471 @@
+﻿//******************************************************************************
+//
+// 分割配列
+//
+// 固定サイズのチャンクを継ぎ足して伸びる配列
+// 伸長時に既存の要素を移動しないので、要素のアドレスが変わらず、
+// 大きな配列でも再確保による遅延やメモリ使用量の一時的な倍増が起きない
+//
+//******************************************************************************
+
+#ifndef TORK_CONTAINER_SEGMENTED_ARRAY_H_INCLUDED
+#define TORK_CONTAINER_SEGMENTED_ARRAY_H_INCLUDED
+
+#include <memory>
+#include <iterator>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include <initializer_list>
+#include <thread>
+#include <vector>
+#include <cassert>
+#include "../memory/allocator.h"
+#include "../span.h"
+#include "Array.h"
+
+namespace tork {
+
+    namespace impl {
+
+// SegmentedArray のイテレータ
+template<class Owner, class T>
+class SegmentedIterator {
+public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef typename std::remove_const<T>::type value_type;
+    typedef ptrdiff_t difference_type;
+    typedef T& reference;
+    typedef T* pointer;
+
+private:
+    Owner* p_owner_ = nullptr;
+    size_t index_ = 0;
+
+public:
+    SegmentedIterator() { }
+    SegmentedIterator(Owner* p, size_t i) :p_owner_(p), index_(i) { }
+
+    // 非constからconstへの変換
+    template<class O, class U>
+    SegmentedIterator(const SegmentedIterator<O, U>& x)
+        :p_owner_(x.owner()), index_(x.index())
+    {
+
+    }
+
+    Owner* owner() const { return p_owner_; }
+    size_t index() const { return index_; }
+
+    reference operator *() const { return (*p_owner_)[index_]; }
+    pointer operator ->() const { return &(*p_owner_)[index_]; }
+    reference operator [](difference_type n) const { return (*p_owner_)[index_ + n]; }
+
+    SegmentedIterator& operator ++() { ++index_; return *this; }
+    SegmentedIterator& operator --() { --index_; return *this; }
+    SegmentedIterator operator ++(int) { SegmentedIterator tmp = *this; ++index_; return tmp; }
+    SegmentedIterator operator --(int) { SegmentedIterator tmp = *this; --index_; return tmp; }
+
+    SegmentedIterator& operator +=(difference_type n) { index_ += n; return *this; }
+    SegmentedIterator& operator -=(difference_type n) { index_ -= n; return *this; }
+    SegmentedIterator operator +(difference_type n) const { return SegmentedIterator(p_owner_, index_ + n); }
+    SegmentedIterator operator -(difference_type n) const { return SegmentedIterator(p_owner_, index_ - n); }
+
+    difference_type operator -(const SegmentedIterator& x) const
+    {
+        return static_cast<difference_type>(index_) - static_cast<difference_type>(x.index_);
+    }
+
+    bool operator ==(const SegmentedIterator& x) const { return index_ == x.index_; }
+    bool operator !=(const SegmentedIterator& x) const { return index_ != x.index_; }
+    bool operator <(const SegmentedIterator& x) const { return index_ < x.index_; }
+    bool operator >(const SegmentedIterator& x) const { return index_ > x.index_; }
+    bool operator <=(const SegmentedIterator& x) const { return index_ <= x.index_; }
+    bool operator >=(const SegmentedIterator& x) const { return index_ >= x.index_; }
+
+};  // class SegmentedIterator
+
+    }   // namespace tork::impl
+
+//==============================================================================
+// 分割配列クラス
+// ChunkShift: チャンクの要素数を 2 の何乗にするか
+//==============================================================================
+template<class T, size_t ChunkShift = 12, class Allocator = tork::allocator<T>>
+class SegmentedArray {
+public:
+    typedef SegmentedArray<T, ChunkShift, Allocator> ThisType;
+
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef T value_type;
+    typedef T& reference;
+    typedef const T& const_reference;
+
+    typedef Allocator allocator_type;
+    typedef std::allocator_traits<allocator_type> AllocTraits;
+
+    typedef impl::SegmentedIterator<ThisType, T> iterator;
+    typedef impl::SegmentedIterator<const ThisType, const T> const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    // チャンクあたりの要素数
+    static const size_type chunk_size = size_type(1) << ChunkShift;
+
+private:
+    static const size_type chunk_mask = chunk_size - 1;
+
+    allocator_type alloc_;
+    Array<T*> chunks_;          // チャンクテーブル
+    size_type size_ = 0;
+
+public:
+
+    // デフォルトコンストラクタ
+    SegmentedArray() { }
+
+    // アロケータ指定
+    explicit SegmentedArray(const Allocator& a) :alloc_(a) { }
+
+    // サイズ（＋アロケータ）
+    explicit SegmentedArray(size_type n, const Allocator& a = Allocator())
+        :alloc_(a)
+    {
+        resize(n);
+    }
+
+    // サイズと値（＋アロケータ）
+    SegmentedArray(size_type n, const T& value, const Allocator& a = Allocator())
+        :alloc_(a)
+    {
+        resize(n, value);
+    }
+
+    // イテレータ（＋アロケータ）
+    template<class InputIter,
+        class = typename std::enable_if<
+            !std::is_integral<InputIter>::value, void>::type>
+    SegmentedArray(InputIter first, InputIter last, const Allocator& a = Allocator())
+        :alloc_(a)
+    {
+        for (auto it = first; it != last; ++it) {
+            emplace_back(*it);
+        }
+    }
+
+    // 初期化子リスト
+    SegmentedArray(std::initializer_list<T> il, const Allocator& a = Allocator())
+        :SegmentedArray(il.begin(), il.end(), a)
+    {
+
+    }
+
+    // コピーコンストラクタ
+    SegmentedArray(const SegmentedArray& other)
+        :alloc_(AllocTraits::select_on_container_copy_construction(other.alloc_))
+    {
+        reserve(other.size());
+        for (size_type i = 0; i < other.size(); ++i) {
+            emplace_back(other[i]);
+        }
+    }
+
+    // ムーブコンストラクタ
+    SegmentedArray(SegmentedArray&& other)
+        :alloc_(other.alloc_)
+    {
+        swap(other);
+    }
+
+    // デストラクタ
+    ~SegmentedArray()
+    {
+        clear();
+        release_chunks(0);
+    }
+
+    // コピー代入演算子
+    SegmentedArray& operator =(const SegmentedArray& other)
+    {
+        if (this == &other) return *this;
+        SegmentedArray(other).swap(*this);
+        return *this;
+    }
+
+    // ムーブ代入演算子
+    SegmentedArray& operator =(SegmentedArray&& other)
+    {
+        if (this == &other) return *this;
+        SegmentedArray(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    // 初期化子リスト代入
+    SegmentedArray& operator =(std::initializer_list<T> il)
+    {
+        SegmentedArray(il, alloc_).swap(*this);
+        return *this;
+    }
+
+    // 末尾に追加
+    void push_back(const T& value)
+    {
+        emplace_back(value);
+    }
+
+    // 末尾に追加（ムーブ構築）
+    void push_back(T&& value)
+    {
+        emplace_back(std::move(value));
+    }
+
+    // 末尾に構築
+    template<class... Args>
+    void emplace_back(Args&&... args)
+    {
+        // チャンクが埋まっていたら次のチャンクを足す
+        if (size_ == capacity()) {
+            add_chunk();
+        }
+        AllocTraits::construct(alloc_, address(size_), std::forward<Args>(args)...);
+        ++size_;
+    }
+
+    // 末尾から削除
+    void pop_back()
+    {
+        assert(!empty());
+        --size_;
+        AllocTraits::destroy(alloc_, address(size_));
+    }
+
+    // サイズ変更
+    void resize(size_type n)
+    {
+        ResizeImpl(n, T());
+    }
+
+    void resize(size_type n, const T& value)
+    {
+        ResizeImpl(n, value);
+    }
+
+    // 要素のクリア
+    // チャンクは解放せずに残す
+    void clear()
+    {
+        while (size_ > 0) {
+            pop_back();
+        }
+    }
+
+    // 容量の予約（チャンク単位で確保）
+    void reserve(size_type n)
+    {
+        chunks_.reserve((n + chunk_mask) >> ChunkShift);
+        while (capacity() < n) {
+            add_chunk();
+        }
+    }
+
+    // 使っていないチャンクを解放する
+    void shrink_to_fit()
+    {
+        release_chunks((size_ + chunk_mask) >> ChunkShift);
+    }
+
+    // スワップ
+    void swap(SegmentedArray& other)
+    {
+        std::swap(alloc_, other.alloc_);
+        chunks_.swap(other.chunks_);
+        std::swap(size_, other.size_);
+    }
+
+    // 要素への添え字アクセス
+    reference operator [](size_type i)
+    {
+        return chunks_[i >> ChunkShift][i & chunk_mask];
+    }
+    const_reference operator [](size_type i) const
+    {
+        return chunks_[i >> ChunkShift][i & chunk_mask];
+    }
+
+    // 範囲チェック付きアクセス
+    reference at(size_type i)
+    {
+        if (i >= size_) throw std::out_of_range("out of range at tork::SegmentedArray");
+        return (*this)[i];
+    }
+    const_reference at(size_type i) const
+    {
+        if (i >= size_) throw std::out_of_range("out of range at tork::SegmentedArray");
+        return (*this)[i];
+    }
+
+    // 先頭要素の参照
+    reference front() { return (*this)[0]; }
+    const_reference front() const { return (*this)[0]; }
+
+    // 末尾要素の参照
+    reference back() { return (*this)[size_ - 1]; }
+    const_reference back() const { return (*this)[size_ - 1]; }
+
+    // 要素数
+    size_type size() const { return size_; }
+
+    // 空かどうか
+    bool empty() const { return size_ == 0; }
+
+    // 容量
+    size_type capacity() const { return chunks_.size() << ChunkShift; }
+
+    // アロケータ
+    allocator_type get_allocator() const { return alloc_; }
+
+    // 使用中のチャンク数
+    size_type chunk_count() const { return (size_ + chunk_mask) >> ChunkShift; }
+
+    // i 番目のチャンクのうち、要素が入っている部分
+    span<T> chunk(size_type i)
+    {
+        return span<T>(chunks_[i], chunk_length(i));
+    }
+    span<const T> chunk(size_type i) const
+    {
+        return span<const T>(chunks_[i], chunk_length(i));
+    }
+
+    // チャンクごとに関数を呼ぶ
+    // f(span<T> chunk, size_type first_index)
+    template<class Function>
+    Function for_each_chunk(Function f)
+    {
+        for (size_type i = 0; i < chunk_count(); ++i) {
+            f(chunk(i), i << ChunkShift);
+        }
+        return f;
+    }
+
+    // チャンクごとに複数スレッドで関数を呼ぶ
+    // チャンクを threads 個の連続した区間に分けて、各スレッドに割り当てる
+    // threads が 0 の場合はハードウェアスレッド数
+    template<class Function>
+    void parallel_for_each_chunk(Function f, unsigned threads = 0)
+    {
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        size_type n = chunk_count();
+        if (threads == 0) threads = 1;
+        if (threads > n) threads = static_cast<unsigned>(n);
+        if (threads <= 1) {
+            for_each_chunk(f);
+            return;
+        }
+
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        size_type per = n / threads;
+        size_type rest = n % threads;
+        size_type first = 0;
+        for (unsigned t = 0; t < threads; ++t) {
+            size_type last = first + per + (t < rest ? 1 : 0);
+            auto task = [this, &f, first, last]() {
+                for (size_type i = first; i < last; ++i) {
+                    f(chunk(i), i << ChunkShift);
+                }
+            };
+            // 最後の区間は呼び出したスレッドで処理する
+            if (t + 1 == threads) task();
+            else workers.push_back(std::thread(task));
+            first = last;
+        }
+        for (auto& w : workers) {
+            w.join();
+        }
+    }
+
+    // イテレータ
+    iterator begin() { return iterator(this, 0); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    iterator end() { return iterator(this, size_); }
+    const_iterator end() const { return const_iterator(this, size_); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    // 逆イテレータ
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+private:
+
+    // 要素のアドレス
+    T* address(size_type i)
+    {
+        return &chunks_[i >> ChunkShift][i & chunk_mask];
+    }
+
+    // i 番目のチャンクに入っている要素数
+    size_type chunk_length(size_type i) const
+    {
+        size_type first = i << ChunkShift;
+        return (size_ - first < chunk_size) ? size_ - first : chunk_size;
+    }
+
+    // チャンクを1つ追加
+    void add_chunk()
+    {
+        T* p = AllocTraits::allocate(alloc_, chunk_size);
+        if (p == nullptr) throw std::bad_alloc();
+        try {
+            chunks_.push_back(p);
+        }
+        catch (...) {
+            AllocTraits::deallocate(alloc_, p, chunk_size);
+            throw;
+        }
+        if (chunks_.empty() || chunks_.back() != p) {
+            // チャンクテーブルの拡張に失敗した
+            AllocTraits::deallocate(alloc_, p, chunk_size);
+            throw std::bad_alloc();
+        }
+    }
+
+    // n 個目以降のチャンクを解放
+    void release_chunks(size_type n)
+    {
+        while (chunks_.size() > n) {
+            AllocTraits::deallocate(alloc_, chunks_.back(), chunk_size);
+            chunks_.pop_back();
+        }
+    }
+
+    template<class Arg>
+    void ResizeImpl(size_type n, const Arg& value)
+    {
+        while (n < size_) {
+            pop_back();
+        }
+        if (n > size_) {
+            reserve(n);
+            while (size_ < n) {
+                emplace_back(value);
+            }
+        }
+    }
+
+};  // class SegmentedArray
+
+// スワップ
+template<class T, size_t S, class A>
+void swap(SegmentedArray<T, S, A>& x, SegmentedArray<T, S, A>& y)
+{
+    x.swap(y);
+}
+
+}   // namespace tork
+
+#endif  // TORK_CONTAINER_SEGMENTED_ARRAY_H_INCLUDED
@@ -14,6 +14,8 @@
 #include <initializer_list>
 #include <type_traits>
 #include <cassert>
+#include <atomic>
+#include "Array.h"
 
 namespace tork {
 
@@ -28,7 +30,7 @@ struct SharedArrayObject {
     T* p_data = nullptr;
     size_type capacity = 0;
     size_type size = 0;
-    int ref_counter = 0;
+    std::atomic<int> ref_counter;   // 参照カウンタ（スレッド間で共有できるようにアトミック）
     allocator_type alloc;
 
     // コンストラクタ
@@ -377,29 +379,382 @@ struct SharedArrayObject {
     }
 
     // 参照カウンタ増
+    // 既に参照を持っているスレッドからしか呼ばれないので順序付けは不要
     void inc_ref()
     {
-        ++ref_counter;
+        ref_counter.fetch_add(1, std::memory_order_relaxed);
     }
 
     // 参照カウンタ減
+    // 最後の参照を手放したスレッドが、他スレッドでの書き込みを見てから破棄する
     void dec_ref()
     {
-        assert(ref_counter > 0);
+        int old = ref_counter.fetch_sub(1, std::memory_order_acq_rel);
+        assert(old > 0);
 
-        --ref_counter;
-        if (ref_counter == 0) {
+        if (old == 1) {
             destroy(this);
         }
     }
 
+    // 参照カウンタ取得
+    int use_count() const
+    {
+        return ref_counter.load(std::memory_order_acquire);
+    }
+
 };  // struct SharedArrayObject
 
     }   // namespace tork::impl
 
-template<class T, class Allocator = std::allocator<T>>
+// 前方宣言
+// const T の場合も要素型のアロケータを使う
+template<class T,
+    class Allocator = std::allocator<typename std::remove_const<T>::type>>
+class SharedArray;
+
+//==============================================================================
+// 共有配列のスライス
+// SharedArray::slice() で作られる
+// 配列オブジェクトの参照を持つので、元の SharedArray がなくなっても有効
+// 要素はコピーせず、配列オブジェクトの中をオフセットで指す
+//==============================================================================
+template<class T,
+    class Allocator = std::allocator<typename std::remove_const<T>::type>>
+class SharedSlice {
+
+    template<class, class> friend class SharedArray;
+
+public:
+    typedef SharedSlice<T, Allocator> ThisType;
+    typedef typename std::remove_const<T>::type value_type;
+    typedef impl::SharedArrayObject<value_type, Allocator> ObjType;
+
+    typedef typename ObjType::size_type size_type;
+    typedef ptrdiff_t difference_type;
+    typedef T& reference;
+    typedef const T& const_reference;
+
+    typedef T* iterator;
+    typedef const T* const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+private:
+
+    ObjType* p_obj_ = nullptr;
+    size_type offset_ = 0;
+    size_type size_ = 0;
+
+    // 配列オブジェクトの範囲を参照する
+    SharedSlice(ObjType* p, size_type off, size_type n)
+        :p_obj_(p), offset_(off), size_(n)
+    {
+        if (p_obj_) p_obj_->inc_ref();
+    }
+
+public:
+
+    // デフォルトコンストラクタ
+    SharedSlice() { }
+
+    // コピーコンストラクタ
+    SharedSlice(const SharedSlice& x)
+        :p_obj_(x.p_obj_), offset_(x.offset_), size_(x.size_)
+    {
+        if (p_obj_) p_obj_->inc_ref();
+    }
+
+    // ムーブコンストラクタ
+    SharedSlice(SharedSlice&& x)
+        :p_obj_(x.p_obj_), offset_(x.offset_), size_(x.size_)
+    {
+        x.p_obj_ = nullptr;
+        x.offset_ = 0;
+        x.size_ = 0;
+    }
+
+    // デストラクタ
+    ~SharedSlice()
+    {
+        if (p_obj_) p_obj_->dec_ref();
+    }
+
+    // コピー代入演算子
+    SharedSlice& operator =(const SharedSlice& x)
+    {
+        SharedSlice(x).swap(*this);
+        return *this;
+    }
+
+    // ムーブ代入演算子
+    SharedSlice& operator =(SharedSlice&& x)
+    {
+        SharedSlice(std::move(x)).swap(*this);
+        return *this;
+    }
+
+    // スワップ
+    void swap(SharedSlice& x)
+    {
+        std::swap(p_obj_, x.p_obj_);
+        std::swap(offset_, x.offset_);
+        std::swap(size_, x.size_);
+    }
+
+    // 部分スライス
+    // n を省略した場合は末尾まで
+    SharedSlice subslice(size_type off, size_type n = size_type(-1)) const
+    {
+        if (off > size_)
+            throw std::out_of_range("out of range at tork::SharedSlice");
+        if (n > size_ - off) n = size_ - off;
+        return SharedSlice(p_obj_, offset_ + off, n);
+    }
+
+    // 要素をコピーして所有する配列を作る
+    Array<value_type> to_array() const
+    {
+        return Array<value_type>(begin(), end());
+    }
+
+    // 要素への添え字アクセス
+    reference at(size_type i) const
+    {
+        if (i >= size_)
+            throw std::out_of_range("out of range at tork::SharedSlice");
+        return data()[i];
+    }
+
+    // operator []
+    reference operator [](size_type i) const
+    {
+        assert(i < size_);
+        return data()[i];
+    }
+
+    // 要素数
+    size_type size() const { return size_; }
+
+    // 空かどうか
+    bool empty() const { return size_ == 0; }
+
+    // 配列オブジェクトを参照している数
+    long use_count() const { return p_obj_ ? p_obj_->use_count() : 0; }
+
+    // データの先頭を指すポインタ
+    // 配列オブジェクトが再確保されても追従するように、毎回オフセットから求める
+    T* data() const { return p_obj_ ? p_obj_->p_data + offset_ : nullptr; }
+
+    // 先頭要素への参照
+    reference front() const { return *data(); }
+
+    // 末尾要素への参照
+    reference back() const { return data()[size_ - 1]; }
+
+    // begin
+    iterator begin() const { return data(); }
+
+    // end
+    iterator end() const { return data() + size_; }
+
+    // rbegin
+    reverse_iterator rbegin() const { return reverse_iterator(end()); }
+
+    // rend
+    reverse_iterator rend() const { return reverse_iterator(begin()); }
+
+    // constイテレータ
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+};  // class SharedSlice
+
+//==============================================================================
+// 読み取り専用共有配列
+// SharedArray::freeze() で作られる
+// 要素を書き換える手段がないので、コピーを別スレッドに渡して同期なしで読める
+//==============================================================================
+template<class T, class Allocator>
+class SharedArray<const T, Allocator> {
+
+    template<class, class> friend class SharedArray;
+
+public:
+    typedef SharedArray<const T, Allocator> ThisType;
+    typedef impl::SharedArrayObject<T, Allocator> ObjType;
+
+    typedef typename ObjType::size_type size_type;
+    typedef ptrdiff_t difference_type;
+    typedef const T value_type;
+    typedef const T& reference;
+    typedef const T& const_reference;
+
+    typedef Allocator allocator_type;
+
+    typedef const T* iterator;
+    typedef const T* const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+private:
+
+    ObjType* p_obj_ = nullptr;
+
+    // 配列オブジェクトの参照を引き取る
+    explicit SharedArray(ObjType* p) :p_obj_(p) { }
+
+public:
+
+    // デフォルトコンストラクタ
+    SharedArray() {}
+
+    // イテレータ（＋アロケータ）
+    template<class InputIter,
+        class = typename std::enable_if<
+            !std::is_integral<InputIter>::value, void>::type>
+    SharedArray(InputIter first, InputIter last,
+            const Allocator& a = Allocator())
+        :p_obj_(ObjType::construct(a, first, last))
+    {
+
+    }
+
+    // 初期化子リスト
+    SharedArray(std::initializer_list<T> il,
+            const Allocator& a = Allocator())
+        :SharedArray(il.begin(), il.end(), a)
+    {
+
+    }
+
+    // コピーコンストラクタ
+    SharedArray(const SharedArray& x)
+        :p_obj_(x.p_obj_)
+    {
+        if (p_obj_) p_obj_->inc_ref();
+    }
+
+    // ムーブコンストラクタ
+    SharedArray(SharedArray&& x)
+        :p_obj_(x.p_obj_)
+    {
+        x.p_obj_ = nullptr;
+    }
+
+    // デストラクタ
+    ~SharedArray()
+    {
+        if (p_obj_) p_obj_->dec_ref();
+    }
+
+    // コピー代入演算子
+    SharedArray& operator =(const SharedArray& x)
+    {
+        if (this->p_obj_ == x.p_obj_) return *this;
+
+        if (p_obj_) p_obj_->dec_ref();
+
+        p_obj_ = x.p_obj_;
+        if (p_obj_) p_obj_->inc_ref();
+
+        return *this;
+    }
+
+    // ムーブ代入演算子
+    SharedArray& operator =(SharedArray&& x)
+    {
+        if (this->p_obj_ == x.p_obj_) return *this;
+
+        if (p_obj_) p_obj_->dec_ref();
+
+        p_obj_ = x.p_obj_;
+        x.p_obj_ = nullptr;
+
+        return *this;
+    }
+
+    // スワップ
+    void swap(SharedArray& x)
+    {
+        std::swap(p_obj_, x.p_obj_);
+    }
+
+    // 要素をコピーせずに範囲を参照するスライスを作る
+    SharedSlice<const T, Allocator> slice(size_type off, size_type n) const
+    {
+        if (off > size() || n > size() - off)
+            throw std::out_of_range("out of range at tork::SharedArray");
+        return SharedSlice<const T, Allocator>(p_obj_, off, n);
+    }
+
+    // 要素への添え字アクセス
+    const_reference at(size_type i) const
+    {
+        if (p_obj_ == nullptr || i >= size())
+            throw std::out_of_range("out of range at tork::SharedArray");
+        return p_obj_->p_data[i];
+    }
+
+    // operator []
+    const_reference operator [](size_type i) const
+    {
+        return p_obj_->p_data[i];
+    }
+
+    // 要素数
+    size_type size() const { return p_obj_ ? p_obj_->size : 0; }
+
+    // 空かどうか
+    bool empty() const { return size() == 0; }
+
+    // 参照しているSharedArrayの数
+    long use_count() const { return p_obj_ ? p_obj_->use_count() : 0; }
+
+    // アロケータ
+    allocator_type get_allocator() const {
+        return p_obj_ ? p_obj_->alloc : allocator_type();
+    }
+
+    // データの先頭を指すポインタ
+    const T* data() const { return p_obj_ ? p_obj_->p_data : nullptr; }
+
+    // 先頭要素への参照
+    const_reference front() const { return *data(); }
+
+    // 末尾要素への参照
+    const_reference back() const { return data()[size() - 1]; }
+
+    // begin
+    const_iterator begin() const { return p_obj_ ? data() : nullptr; }
+
+    // end
+    const_iterator end() const { return p_obj_ ? data() + size() : nullptr; }
+
+    // rbegin
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+
+    // rend
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    // constイテレータ
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    // const逆イテレータ
+    const_reverse_iterator crbegin() const { return rbegin(); }
+    const_reverse_iterator crend() const { return rend(); }
+
+};  // class SharedArray<const T, Allocator>
+
+//==============================================================================
+// 共有配列クラス
+//==============================================================================
+template<class T, class Allocator>
 class SharedArray {
 
+    template<class, class> friend class SharedArray;
+
 public:
     typedef SharedArray<T, Allocator> ThisType;
     typedef impl::SharedArrayObject<T, Allocator> ObjType;
@@ -673,6 +1028,36 @@ public:
         std::swap(p_obj_, x.p_obj_);
     }
 
+    // 読み取り専用の共有配列に変換する
+    // 他に参照しているSharedArrayがなければ配列オブジェクトをそのまま引き渡し、
+    // あれば書き換えられないように要素をコピーする
+    // 呼び出し後、このオブジェクトは空になる
+    SharedArray<const T, Allocator> freeze()
+    {
+        typedef SharedArray<const T, Allocator> Frozen;
+
+        if (p_obj_ == nullptr) return Frozen();
+
+        ObjType* p = p_obj_;
+        if (p->use_count() != 1) {
+            p = empty() ? nullptr :
+                ObjType::construct(p->alloc, p->p_data, p->p_data + p->size);
+            p_obj_->dec_ref();
+        }
+        p_obj_ = nullptr;
+
+        return Frozen(p);
+    }
+
+    // 要素をコピーせずに範囲を参照するスライスを作る
+    // 配列を縮めるとスライスの範囲が無効になるので注意
+    SharedSlice<T, Allocator> slice(size_type off, size_type n) const
+    {
+        if (off > size() || n > size() - off)
+            throw std::out_of_range("out of range at tork::SharedArray");
+        return SharedSlice<T, Allocator>(p_obj_, off, n);
+    }
+
     // 要素への添え字アクセス
     reference at(size_type i)
     {
@@ -703,6 +1088,9 @@ public:
     // 空かどうか
     bool empty() const { return size() == 0; }
 
+    // 参照しているSharedArrayの数
+    long use_count() const { return p_obj_ ? p_obj_->use_count() : 0; }
+
     // 容量
     size_type capacity() const { return p_obj_ ? p_obj_->capacity : 0; }
 
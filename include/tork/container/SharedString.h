@@ -0,0 +1,294 @@
+﻿//******************************************************************************
+//
+// 共有文字列クラス（変更できない文字列）
+//
+// InlineCapacity 文字までは自身の中に持ち、それより長ければ参照カウント付きの
+// バッファを共有する。コピーは参照カウントを増やすだけで、substr() は同じバッファを指す
+//
+//******************************************************************************
+
+#ifndef TORK_CONTAINER_SHARED_STRING_H_INCLUDED
+#define TORK_CONTAINER_SHARED_STRING_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include "../string_view.h"
+
+namespace tork {
+
+    namespace impl {
+
+// 共有文字列のバッファ
+struct SharedStringBuffer {
+    std::atomic<int> ref_counter;   // 参照カウンタ
+    char data[1];                   // 実際は文字数 + 1 バイト（末尾は NUL）
+
+    // 作成（参照カウントは 1）
+    static SharedStringBuffer* create(const char* s, size_t n);
+
+    // 参照を増やす
+    void add_ref()
+    {
+        ref_counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 参照を減らし、最後なら破棄する
+    void release()
+    {
+        if (ref_counter.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            ::operator delete(this);
+        }
+    }
+};
+
+    }   // namespace tork::impl
+
+//==============================================================================
+// 共有文字列クラス
+//==============================================================================
+class SharedString {
+public:
+    typedef char value_type;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef const char* const_iterator;
+    typedef const char* iterator;
+
+    static const size_type npos = size_type(-1);
+
+    // 自身の中に持てる文字数
+    static const size_type InlineCapacity = 23;
+
+private:
+    typedef impl::SharedStringBuffer Buffer;
+
+    // 最後のバイトが HeapTag ならバッファを共有し、そうでなければ中に持つ文字数
+    static const unsigned char HeapTag = 0xFF;
+
+    // tag は inline_ の最後のバイトと同じ位置に置く
+    // 詰め物の領域にすると、他のメンバーへの書き込みで値が保たれるとは限らないので、メンバーにする
+    struct Heap {
+        Buffer* buffer;
+        const char* data;   // buffer の中の位置（substr で先頭以外を指す）
+        uint32_t size;
+        char padding[InlineCapacity - 2 * sizeof(void*) - sizeof(uint32_t)];
+        unsigned char tag;  // HeapTag
+    };
+
+    union {
+        Heap heap_;
+        char inline_[InlineCapacity + 1];
+    };
+
+    static_assert(offsetof(Heap, tag) == InlineCapacity,
+        "tork::SharedString::Heap::tag must overlay the last byte of inline_");
+
+public:
+
+    // 空文字列
+    SharedString()
+    {
+        set_inline(nullptr, 0);
+    }
+
+    // 文字列をコピーして作る
+    SharedString(const char* s, size_type n)
+    {
+        init(s, n);
+    }
+    SharedString(const char* s)
+    {
+        init(s, std::strlen(s));
+    }
+    SharedString(const std::string& s)
+    {
+        init(s.data(), s.size());
+    }
+    explicit SharedString(string_view s)
+    {
+        init(s.data(), s.size());
+    }
+
+    // コピーコンストラクタ（バッファは共有する）
+    SharedString(const SharedString& other)
+    {
+        std::memcpy(inline_, other.inline_, sizeof(inline_));
+        if (is_heap()) heap_.buffer->add_ref();
+    }
+
+    // ムーブコンストラクタ
+    SharedString(SharedString&& other)
+    {
+        std::memcpy(inline_, other.inline_, sizeof(inline_));
+        other.set_inline(nullptr, 0);
+    }
+
+    // デストラクタ
+    ~SharedString()
+    {
+        if (is_heap()) heap_.buffer->release();
+    }
+
+    // コピー代入
+    SharedString& operator =(const SharedString& other)
+    {
+        SharedString(other).swap(*this);
+        return *this;
+    }
+
+    // ムーブ代入
+    SharedString& operator =(SharedString&& other)
+    {
+        SharedString(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    // 入れ替え
+    void swap(SharedString& other)
+    {
+        char t[sizeof(inline_)];
+        std::memcpy(t, inline_, sizeof(inline_));
+        std::memcpy(inline_, other.inline_, sizeof(inline_));
+        std::memcpy(other.inline_, t, sizeof(inline_));
+    }
+
+    // 先頭を指すポインタ（NUL 終端とは限らない）
+    const char* data() const { return is_heap() ? heap_.data : inline_; }
+
+    // 文字数
+    size_type size() const { return is_heap() ? heap_.size : tag(); }
+    size_type length() const { return size(); }
+
+    // 空かどうか
+    bool empty() const { return size() == 0; }
+
+    // 文字
+    char operator [](size_type i) const { return data()[i]; }
+
+    // 範囲チェック付きの文字
+    char at(size_type i) const
+    {
+        if (i >= size()) throw std::out_of_range("out of range at tork::SharedString");
+        return data()[i];
+    }
+
+    // イテレータ
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + size(); }
+
+    // 部分文字列
+    // 中に持てない長さなら、コピーせずに同じバッファを指す
+    SharedString substr(size_type pos, size_type n = npos) const
+    {
+        size_type sz = size();
+        if (pos > sz) throw std::out_of_range("out of range at tork::SharedString");
+        if (n > sz - pos) n = sz - pos;
+        if (n <= InlineCapacity) return SharedString(data() + pos, n);
+        SharedString r(*this);
+        r.heap_.data += pos;
+        r.heap_.size = static_cast<uint32_t>(n);
+        return r;
+    }
+
+    // バッファを共有しているかどうか
+    bool is_shared() const { return is_heap(); }
+
+    // バッファを共有している数（中に持っていれば 0）
+    long use_count() const
+    {
+        return is_heap() ? heap_.buffer->ref_counter.load(std::memory_order_acquire) : 0;
+    }
+
+    // ビュー
+    string_view view() const { return string_view(data(), size()); }
+    operator string_view() const { return view(); }
+
+    // std::string にコピー
+    std::string str() const { return std::string(data(), size()); }
+
+    // 比較
+    int compare(string_view s) const { return view().compare(s); }
+
+private:
+
+    unsigned char tag() const { return static_cast<unsigned char>(inline_[InlineCapacity]); }
+    bool is_heap() const { return tag() == HeapTag; }
+
+    // 中に持つ
+    void set_inline(const char* s, size_type n)
+    {
+        std::memset(inline_, 0, sizeof(inline_));
+        if (n) std::memcpy(inline_, s, n);
+        inline_[InlineCapacity] = static_cast<char>(n);
+    }
+
+    // 長さによって中に持つかバッファを作る
+    void init(const char* s, size_type n)
+    {
+        if (n <= InlineCapacity) {
+            set_inline(s, n);
+            return;
+        }
+        if (n > 0xFFFFFFFF) throw std::length_error("too long string at tork::SharedString");
+        std::memset(inline_, 0, sizeof(inline_));
+        heap_.buffer = Buffer::create(s, n);
+        heap_.data = heap_.buffer->data;
+        heap_.size = static_cast<uint32_t>(n);
+        heap_.tag = HeapTag;
+    }
+
+};  // class SharedString
+
+static_assert(sizeof(SharedString) == 24, "tork::SharedString must be 24 bytes");
+
+// 比較
+inline bool operator ==(const SharedString& x, const SharedString& y) { return x.view() == y.view(); }
+inline bool operator !=(const SharedString& x, const SharedString& y) { return !(x == y); }
+inline bool operator <(const SharedString& x, const SharedString& y) { return x.view() < y.view(); }
+inline bool operator >(const SharedString& x, const SharedString& y) { return y < x; }
+inline bool operator <=(const SharedString& x, const SharedString& y) { return !(y < x); }
+inline bool operator >=(const SharedString& x, const SharedString& y) { return !(x < y); }
+
+inline bool operator ==(const SharedString& x, string_view y) { return x.view() == y; }
+inline bool operator ==(string_view x, const SharedString& y) { return x == y.view(); }
+inline bool operator !=(const SharedString& x, string_view y) { return !(x == y); }
+inline bool operator !=(string_view x, const SharedString& y) { return !(x == y); }
+inline bool operator ==(const SharedString& x, const char* y) { return x.view() == string_view(y); }
+inline bool operator !=(const SharedString& x, const char* y) { return !(x == y); }
+inline bool operator ==(const SharedString& x, const std::string& y) { return x.view() == string_view(y); }
+inline bool operator !=(const SharedString& x, const std::string& y) { return !(x == y); }
+
+// ストリーム出力
+inline std::ostream& operator <<(std::ostream& os, const SharedString& s)
+{
+    return os << s.view();
+}
+
+// 入れ替え
+inline void swap(SharedString& x, SharedString& y)
+{
+    x.swap(y);
+}
+
+}   // namespace tork
+
+namespace std {
+
+// ハッシュ（string_view と同じ値）
+template<>
+struct hash<tork::SharedString> {
+    size_t operator ()(const tork::SharedString& s) const
+    {
+        return hash<tork::string_view>()(s.view());
+    }
+};
+
+}   // namespace std
+
+#endif  // TORK_CONTAINER_SHARED_STRING_H_INCLUDED
@@ -0,0 +1,547 @@
+﻿//******************************************************************************
+//
+// 列指向配列（Structure of Arrays）
+//
+// SoAArray<float, float, int> のように各フィールドの型を並べると、
+// フィールドごとに別々の連続領域（列）に格納する
+// 一部のフィールドだけを走査するループでキャッシュラインを無駄にしない
+//
+//******************************************************************************
+
+#ifndef TORK_CONTAINER_SOA_ARRAY_H_INCLUDED
+#define TORK_CONTAINER_SOA_ARRAY_H_INCLUDED
+
+#include <new>
+#include <tuple>
+#include <iterator>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include <initializer_list>
+#include <cstdint>
+#include <cassert>
+#include "../memory/allocator.h"
+#include "../span.h"
+
+namespace tork {
+
+    namespace impl {
+
+// コンパイル時の添え字列
+template<size_t... I>
+struct IndexSeq { };
+
+template<size_t N, size_t... I>
+struct MakeIndexSeq : MakeIndexSeq<N - 1, N - 1, I...> { };
+
+template<size_t... I>
+struct MakeIndexSeq<0, I...> {
+    typedef IndexSeq<I...> type;
+};
+
+// パック展開した式を順番に評価するためのもの
+inline void Swallow(std::initializer_list<int>) { }
+
+// SoAArray のイテレータ
+// 要素は列に分かれているので、参照は各フィールドへの参照のタプル（プロキシ）になる
+template<class Owner, class Reference>
+class SoAIterator {
+public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef typename Owner::value_type value_type;
+    typedef ptrdiff_t difference_type;
+    typedef Reference reference;
+    typedef void pointer;
+
+private:
+    Owner* p_owner_ = nullptr;
+    size_t index_ = 0;
+
+public:
+    SoAIterator() { }
+    SoAIterator(Owner* p, size_t i) :p_owner_(p), index_(i) { }
+
+    // 非constからconstへの変換
+    template<class O, class R>
+    SoAIterator(const SoAIterator<O, R>& x)
+        :p_owner_(x.owner()), index_(x.index())
+    {
+
+    }
+
+    Owner* owner() const { return p_owner_; }
+    size_t index() const { return index_; }
+
+    reference operator *() const { return (*p_owner_)[index_]; }
+    reference operator [](difference_type n) const { return (*p_owner_)[index_ + n]; }
+
+    SoAIterator& operator ++() { ++index_; return *this; }
+    SoAIterator& operator --() { --index_; return *this; }
+    SoAIterator operator ++(int) { SoAIterator tmp = *this; ++index_; return tmp; }
+    SoAIterator operator --(int) { SoAIterator tmp = *this; --index_; return tmp; }
+
+    SoAIterator& operator +=(difference_type n) { index_ += n; return *this; }
+    SoAIterator& operator -=(difference_type n) { index_ -= n; return *this; }
+    SoAIterator operator +(difference_type n) const { return SoAIterator(p_owner_, index_ + n); }
+    SoAIterator operator -(difference_type n) const { return SoAIterator(p_owner_, index_ - n); }
+
+    difference_type operator -(const SoAIterator& x) const
+    {
+        return static_cast<difference_type>(index_) - static_cast<difference_type>(x.index_);
+    }
+
+    bool operator ==(const SoAIterator& x) const { return index_ == x.index_; }
+    bool operator !=(const SoAIterator& x) const { return index_ != x.index_; }
+    bool operator <(const SoAIterator& x) const { return index_ < x.index_; }
+    bool operator >(const SoAIterator& x) const { return index_ > x.index_; }
+    bool operator <=(const SoAIterator& x) const { return index_ <= x.index_; }
+    bool operator >=(const SoAIterator& x) const { return index_ >= x.index_; }
+
+};  // class SoAIterator
+
+    }   // namespace tork::impl
+
+//==============================================================================
+// 列指向配列クラス
+//==============================================================================
+template<class... Fields>
+class SoAArray {
+    static_assert(sizeof...(Fields) > 0, "tork::SoAArray needs at least one field");
+
+public:
+    typedef SoAArray<Fields...> ThisType;
+
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef std::tuple<Fields...> value_type;
+    typedef std::tuple<Fields&...> reference;
+    typedef std::tuple<const Fields&...> const_reference;
+
+    typedef impl::SoAIterator<ThisType, reference> iterator;
+    typedef impl::SoAIterator<const ThisType, const_reference> const_iterator;
+
+    // フィールドの型
+    template<size_t I>
+    struct field {
+        typedef typename std::tuple_element<I, value_type>::type type;
+    };
+
+    // フィールド数
+    static const size_t field_count = sizeof...(Fields);
+
+    // 各列の先頭アドレスのアラインメント（キャッシュライン、SIMDレジスタ幅を想定）
+    static const size_t alignment = 64;
+
+private:
+    typedef typename impl::MakeIndexSeq<sizeof...(Fields)>::type Indices;
+
+    std::tuple<Fields*...> columns_;        // 各列の先頭（アライン済み）
+    void* raw_[sizeof...(Fields)];          // 各列の確保した領域
+    size_type size_ = 0;
+    size_type capacity_ = 0;
+
+public:
+
+    // デフォルトコンストラクタ
+    SoAArray()
+    {
+        InitColumns(Indices());
+    }
+
+    // サイズ
+    explicit SoAArray(size_type n)
+    {
+        InitColumns(Indices());
+        resize(n);
+    }
+
+    // サイズと値
+    SoAArray(size_type n, const value_type& value)
+    {
+        InitColumns(Indices());
+        resize(n, value);
+    }
+
+    // 初期化子リスト
+    SoAArray(std::initializer_list<value_type> il)
+    {
+        InitColumns(Indices());
+        reserve(il.size());
+        for (auto it = il.begin(); it != il.end(); ++it) {
+            push_back(*it);
+        }
+    }
+
+    // コピーコンストラクタ
+    SoAArray(const SoAArray& other)
+    {
+        InitColumns(Indices());
+        reserve(other.size());
+        for (size_type i = 0; i < other.size(); ++i) {
+            const_reference row = other[i];
+            ConstructRow<0>(i, row);
+            ++size_;
+        }
+    }
+
+    // ムーブコンストラクタ
+    SoAArray(SoAArray&& other)
+    {
+        InitColumns(Indices());
+        swap(other);
+    }
+
+    // デストラクタ
+    ~SoAArray()
+    {
+        clear();
+        ReleaseColumns(Indices());
+    }
+
+    // コピー代入演算子
+    SoAArray& operator =(const SoAArray& other)
+    {
+        if (this == &other) return *this;
+        SoAArray(other).swap(*this);
+        return *this;
+    }
+
+    // ムーブ代入演算子
+    SoAArray& operator =(SoAArray&& other)
+    {
+        if (this == &other) return *this;
+        SoAArray(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    // 末尾に追加（フィールドごとに指定）
+    void push_back(const Fields&... values)
+    {
+        std::tuple<const Fields&...> row(values...);
+        expand_capacity();
+        ConstructRow<0>(size_, row);
+        ++size_;
+    }
+
+    // 末尾に追加（タプル）
+    void push_back(const value_type& row)
+    {
+        expand_capacity();
+        ConstructRow<0>(size_, row);
+        ++size_;
+    }
+
+    // 末尾に追加（タプルをムーブ）
+    void push_back(value_type&& row)
+    {
+        expand_capacity();
+        ConstructRow<0>(size_, row);
+        ++size_;
+    }
+
+    // 末尾に構築（各フィールドのコンストラクタ引数を1つずつ）
+    template<class... Args>
+    void emplace_back(Args&&... args)
+    {
+        static_assert(sizeof...(Args) == sizeof...(Fields),
+                "tork::SoAArray::emplace_back needs one argument per field");
+        std::tuple<Args&&...> row(std::forward<Args>(args)...);
+        expand_capacity();
+        ConstructRow<0>(size_, row);
+        ++size_;
+    }
+
+    // 末尾から削除
+    void pop_back()
+    {
+        assert(!empty());
+        --size_;
+        DestroyRow(size_, Indices());
+    }
+
+    // サイズ変更
+    void resize(size_type n)
+    {
+        ResizeImpl(n, value_type());
+    }
+
+    void resize(size_type n, const value_type& value)
+    {
+        ResizeImpl(n, value);
+    }
+
+    // 要素のクリア
+    void clear()
+    {
+        while (size_ > 0) {
+            pop_back();
+        }
+    }
+
+    // 容量の予約
+    void reserve(size_type n)
+    {
+        if (n <= capacity_) return;
+        Reallocate(n, Indices());
+    }
+
+    // 容量をサイズにフィットさせる
+    void shrink_to_fit()
+    {
+        SoAArray(*this).swap(*this);
+    }
+
+    // スワップ
+    void swap(SoAArray& other)
+    {
+        std::swap(columns_, other.columns_);
+        for (size_t i = 0; i < field_count; ++i) {
+            std::swap(raw_[i], other.raw_[i]);
+        }
+        std::swap(size_, other.size_);
+        std::swap(capacity_, other.capacity_);
+    }
+
+    // 行への添え字アクセス（各フィールドへの参照のタプル）
+    reference operator [](size_type i)
+    {
+        return MakeRef(i, Indices());
+    }
+    const_reference operator [](size_type i) const
+    {
+        return MakeConstRef(i, Indices());
+    }
+
+    // 範囲チェック付きアクセス
+    reference at(size_type i)
+    {
+        if (i >= size_) throw std::out_of_range("out of range at tork::SoAArray");
+        return (*this)[i];
+    }
+    const_reference at(size_type i) const
+    {
+        if (i >= size_) throw std::out_of_range("out of range at tork::SoAArray");
+        return (*this)[i];
+    }
+
+    // 1フィールドへのアクセス
+    template<size_t I>
+    typename field<I>::type& get(size_type i)
+    {
+        assert(i < size_);
+        return std::get<I>(columns_)[i];
+    }
+    template<size_t I>
+    const typename field<I>::type& get(size_type i) const
+    {
+        assert(i < size_);
+        return std::get<I>(columns_)[i];
+    }
+
+    // 列の先頭を指すポインタ（alignment バイト境界に揃っている）
+    template<size_t I>
+    typename field<I>::type* data()
+    {
+        return std::get<I>(columns_);
+    }
+    template<size_t I>
+    const typename field<I>::type* data() const
+    {
+        return std::get<I>(columns_);
+    }
+
+    // 列全体のスパン
+    template<size_t I>
+    span<typename field<I>::type> column()
+    {
+        return span<typename field<I>::type>(std::get<I>(columns_), size_);
+    }
+    template<size_t I>
+    span<const typename field<I>::type> column() const
+    {
+        return span<const typename field<I>::type>(std::get<I>(columns_), size_);
+    }
+
+    // 先頭行の参照
+    reference front() { return (*this)[0]; }
+    const_reference front() const { return (*this)[0]; }
+
+    // 末尾行の参照
+    reference back() { return (*this)[size_ - 1]; }
+    const_reference back() const { return (*this)[size_ - 1]; }
+
+    // 容量
+    size_type capacity() const { return capacity_; }
+
+    // 要素数
+    size_type size() const { return size_; }
+
+    // 空かどうか
+    bool empty() const { return size_ == 0; }
+
+    // イテレータ
+    iterator begin() { return iterator(this, 0); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    iterator end() { return iterator(this, size_); }
+    const_iterator end() const { return const_iterator(this, size_); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+private:
+
+    // 容量を拡張する
+    void expand_capacity(size_type first_size = 8)
+    {
+        if (capacity_ == 0) {
+            reserve(first_size);
+        }
+        else if (size_ == capacity_) {
+            reserve(capacity_ * 2);
+        }
+    }
+
+    template<class Arg>
+    void ResizeImpl(size_type n, const Arg& value)
+    {
+        while (n < size_) {
+            pop_back();
+        }
+        if (n > size_) {
+            reserve(n);
+            while (size_ < n) {
+                ConstructRow<0>(size_, value);
+                ++size_;
+            }
+        }
+    }
+
+    template<size_t... I>
+    void InitColumns(impl::IndexSeq<I...>)
+    {
+        impl::Swallow({ (std::get<I>(columns_) = nullptr, raw_[I] = nullptr, 0)... });
+    }
+
+    // 1列分の領域確保
+    // アラインメント分だけ余分に確保して先頭を揃える
+    template<class T>
+    static T* AllocateColumn(size_type n, void*& raw)
+    {
+        tork::allocator<char> a;
+        raw = a.allocate(n * sizeof(T) + alignment - 1);
+        if (raw == nullptr) throw std::bad_alloc();
+
+        uintptr_t p = reinterpret_cast<uintptr_t>(raw);
+        p = (p + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+        return reinterpret_cast<T*>(p);
+    }
+
+    static void DeallocateColumn(void* raw)
+    {
+        if (raw == nullptr) return;
+        tork::allocator<char> a;
+        a.deallocate(static_cast<char*>(raw), 0);
+    }
+
+    template<size_t... I>
+    void ReleaseColumns(impl::IndexSeq<I...>)
+    {
+        impl::Swallow({ (DeallocateColumn(raw_[I]), 0)... });
+    }
+
+    // 要素のムーブ
+    template<class T>
+    void MoveColumn(T* dst, T* src)
+    {
+        for (size_type i = 0; i < size_; ++i) {
+            ::new(static_cast<void*>(dst + i)) T(std::move(src[i]));
+            Destroy(src + i);
+        }
+    }
+
+    // 全列を n 要素分の領域に移し替える
+    template<size_t... I>
+    void Reallocate(size_type n, impl::IndexSeq<I...>)
+    {
+        std::tuple<Fields*...> cols;
+        void* raw[field_count] = {};
+        try {
+            impl::Swallow({ (std::get<I>(cols) = AllocateColumn<Fields>(n, raw[I]), 0)... });
+        }
+        catch (...) {
+            impl::Swallow({ (DeallocateColumn(raw[I]), 0)... });
+            throw;
+        }
+
+        impl::Swallow({ (MoveColumn(std::get<I>(cols), std::get<I>(columns_)), 0)... });
+        impl::Swallow({ (DeallocateColumn(raw_[I]), raw_[I] = raw[I], 0)... });
+
+        columns_ = cols;
+        capacity_ = n;
+    }
+
+    // 行の構築
+    // 途中のフィールドで例外が出たら、構築済みのフィールドを破棄する
+    template<size_t I, class Row>
+    typename std::enable_if<(I < sizeof...(Fields)), void>::type
+        ConstructRow(size_type pos, Row& row)
+    {
+        typedef typename field<I>::type T;
+        typedef typename std::tuple_element<I,
+                typename std::remove_const<Row>::type>::type Arg;
+        typedef typename std::conditional<std::is_const<Row>::value,
+                const Arg, Arg>::type QualifiedArg;
+
+        T* p = std::get<I>(columns_) + pos;
+        ::new(static_cast<void*>(p)) T(std::forward<QualifiedArg>(std::get<I>(row)));
+        try {
+            ConstructRow<I + 1>(pos, row);
+        }
+        catch (...) {
+            Destroy(p);
+            throw;
+        }
+    }
+
+    template<size_t I, class Row>
+    typename std::enable_if<(I == sizeof...(Fields)), void>::type
+        ConstructRow(size_type, Row&)
+    {
+
+    }
+
+    template<class T>
+    static void Destroy(T* p)
+    {
+        p->~T();
+    }
+
+    template<size_t... I>
+    void DestroyRow(size_type pos, impl::IndexSeq<I...>)
+    {
+        impl::Swallow({ (Destroy(std::get<I>(columns_) + pos), 0)... });
+    }
+
+    template<size_t... I>
+    reference MakeRef(size_type i, impl::IndexSeq<I...>)
+    {
+        return reference(std::get<I>(columns_)[i]...);
+    }
+
+    template<size_t... I>
+    const_reference MakeConstRef(size_type i, impl::IndexSeq<I...>) const
+    {
+        return const_reference(std::get<I>(columns_)[i]...);
+    }
+
+};  // class SoAArray
+
+// スワップ
+template<class... Fields>
+void swap(SoAArray<Fields...>& x, SoAArray<Fields...>& y)
+{
+    x.swap(y);
+}
+
+}   // namespace tork
+
+#endif  // TORK_CONTAINER_SOA_ARRAY_H_INCLUDED
@@ -0,0 +1,136 @@
+﻿//******************************************************************************
+//
+// 文字列のインターン（重複しない文字列に連番の 32 ビット ID を振る）
+//
+// 文字列はブロック単位で確保した領域にコピーし、プールを破棄するまで動かさない
+// 登録済みの文字列の検索と ID からの参照はロックを取らない
+// 登録はハッシュ値で振り分けたシャードごとのスピンロックで守る
+//
+//******************************************************************************
+
+#ifndef TORK_CONTAINER_STRING_POOL_H_INCLUDED
+#define TORK_CONTAINER_STRING_POOL_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include "../string_view.h"
+
+namespace tork {
+
+//==============================================================================
+// 文字列プール
+//==============================================================================
+class StringPool {
+public:
+    typedef uint32_t id_type;
+
+    // 見つからなかったときの ID
+    static const id_type npos = 0xFFFFFFFF;
+
+private:
+    // ID から文字列を引く表
+    // 文字列の直前には 32 ビットの長さを置いている
+    // k 番目のセグメントは FirstSegmentSize << k 個で、確保したら動かさない
+    static const size_t FirstSegmentSize = 1024;
+    static const unsigned SegmentCount = 23;    // 合計が 2^32 を超える数
+
+    struct Shard;
+    struct Table;
+
+    std::unique_ptr<Shard[]> shards_;
+    size_t shard_count_;    // 2 の冪
+    unsigned shard_shift_;
+    std::atomic<const char**> segments_[SegmentCount];
+    std::atomic<id_type> next_id_;      // 次に振る ID
+    std::atomic<id_type> committed_;    // 表に書き終えた ID の数（これより小さい ID は読める）
+
+public:
+
+    // シャード数を指定して構築
+    // 0 ならハードウェアスレッド数の 4 倍を 2 の冪に切り上げた数
+    explicit StringPool(size_t shard_count = 0);
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator =(const StringPool&) = delete;
+
+    // デストラクタ
+    ~StringPool();
+
+    // 登録して ID を返す（登録済みならその ID）
+    // ID は 0 から振る連番
+    id_type intern(string_view s);
+
+    // 登録済みの文字列の ID（なければ npos）
+    id_type find(string_view s) const;
+
+    // ID の文字列
+    // id は intern() / find() が返したものか、size() より小さいものに限る
+    // 返したビューはプールを破棄するまで有効で、末尾には NUL がある
+    string_view view(id_type id) const
+    {
+        const char* data = entry(id);
+        return string_view(data, StoredSize(data));
+    }
+
+    // 範囲チェック付きの view()
+    string_view at(id_type id) const;
+
+    // 登録した文字列の数
+    // 別のスレッドが登録している途中の ID は、表に書き終えるまで数えない
+    size_t size() const { return committed_.load(std::memory_order_acquire); }
+
+    // 空かどうか
+    bool empty() const { return size() == 0; }
+
+    // 使っているメモリのバイト数（文字列の領域、ハッシュ表、ID の表）
+    size_t memory_usage() const;
+
+private:
+
+    // ID の位置（セグメントと、その中の添え字）
+    static void locate(id_type id, unsigned& segment, size_t& index)
+    {
+        uint64_t v = static_cast<uint64_t>(id) + FirstSegmentSize;
+        unsigned k = 0;
+        while ((v >> k) >= 2 * FirstSegmentSize) ++k;
+        segment = k;
+        index = static_cast<size_t>(v - (static_cast<uint64_t>(FirstSegmentSize) << k));
+    }
+
+    // 文字列の長さ
+    static size_t StoredSize(const char* data)
+    {
+        uint32_t n;
+        std::memcpy(&n, data - sizeof(n), sizeof(n));
+        return n;
+    }
+
+    // ID の文字列の先頭
+    const char* entry(id_type id) const
+    {
+        unsigned k;
+        size_t i;
+        locate(id, k, i);
+        return segments_[k].load(std::memory_order_acquire)[i];
+    }
+
+    // 登録済みかどうかを調べる
+    id_type find(const Shard& shard, string_view s, uint64_t hash) const;
+
+    // 新しい ID を振る
+    id_type add_entry(const char* data);
+
+    // ハッシュ値からシャード
+    size_t shard_index(uint64_t hash) const
+    {
+        return shard_count_ == 1 ? 0 : static_cast<size_t>(hash >> shard_shift_);
+    }
+
+};  // class StringPool
+
+}   // namespace tork
+
+#endif  // TORK_CONTAINER_STRING_POOL_H_INCLUDED
@@ -2,6 +2,12 @@
 // operator[] で例外を投げる単純なvector
 //
 // by ストラウストラップのプログラミング入門 19.4.2
+//
+// 第3テンプレート引数で範囲チェックの方法を選べる
+//  VectorCheck::Always     operator[] で毎回チェック（デフォルト）
+//  VectorCheck::DebugOnly  _DEBUG 定義時のみ operator[] でチェック
+//  VectorCheck::PerRange   operator[] ではチェックしない
+//                          checked_range() で範囲ごとにまとめてチェックする
 //******************************************************************************
 #ifndef TORK_CONTAINER_VECTOR_H_INCLUDED
 #define TORK_CONTAINER_VECTOR_H_INCLUDED
@@ -9,6 +15,7 @@
 #include <stdexcept>
 #include <vector>
 #include "../memory/allocator.h"
+#include "../span.h"
 
 namespace tork {
 
@@ -18,11 +25,45 @@ namespace tork {
         OutOfRangeError(int i): std::out_of_range("Range Error"), index(i) { }
     };
 
-    template<class T, class Allocator = std::allocator<T>>
+    // 範囲チェックのポリシー
+    namespace VectorCheck {
+
+        // 毎回チェック
+        struct Always {
+            static void check(size_t i, size_t size)
+            {
+                if (size <= i) {
+                    throw OutOfRangeError(static_cast<int>(i));
+                }
+            }
+        };
+
+        // デバッグ時のみチェック
+        struct DebugOnly {
+#ifdef _DEBUG
+            static void check(size_t i, size_t size)
+            {
+                Always::check(i, size);
+            }
+#else
+            static void check(size_t, size_t) { }
+#endif
+        };
+
+        // 要素ごとにはチェックしない
+        struct PerRange {
+            static void check(size_t, size_t) { }
+        };
+
+    }   // namespace VectorCheck
+
+    template<class T, class Allocator = std::allocator<T>,
+        class Check = VectorCheck::Always>
     class Vector : public std::vector<T, Allocator> {
     public:
         typedef std::vector<T, Allocator> base_type;
         typedef typename base_type::size_type size_type;
+        typedef Check check_policy;
 
         Vector() { }
         explicit Vector(size_type n) : base_type(n) { }
@@ -30,22 +71,54 @@ namespace tork {
 
         T& operator[] (size_type i)
         {
-            if (i < 0 || this->size() <= i) {
-                throw OutOfRangeError(i);
-            }
+            Check::check(i, this->size());
             return base_type::operator[](i);
         }
 
         const T& operator[] (size_type i) const
         {
-            if (i < 0 || this->size() <= i) {
-                throw OutOfRangeError(i);
-            }
+            Check::check(i, this->size());
             return base_type::operator[](i);
         }
+
+        // [i, i + n) が範囲内かまとめてチェックする
+        // 範囲外なら、最初に範囲外になる添え字で OutOfRangeError を投げる
+        void check_range(size_type i, size_type n) const
+        {
+            if (i > this->size()) {
+                throw OutOfRangeError(static_cast<int>(i));
+            }
+            if (n > this->size() - i) {
+                throw OutOfRangeError(static_cast<int>(this->size()));
+            }
+        }
+
+        // [i, i + n) を1回だけチェックして、チェックなしのスパンを返す
+        // ループの中では返したスパンを使えば、要素ごとの分岐がなくなる
+        span<T> checked_range(size_type i, size_type n)
+        {
+            check_range(i, n);
+            return span<T>(this->data() + i, n);
+        }
+
+        span<const T> checked_range(size_type i, size_type n) const
+        {
+            check_range(i, n);
+            return span<const T>(this->data() + i, n);
+        }
+
+        // 全体をチェックなしのスパンとして返す（範囲は自明なのでチェック不要）
+        span<T> checked_span()
+        {
+            return span<T>(this->data(), this->size());
+        }
+
+        span<const T> checked_span() const
+        {
+            return span<const T>(this->data(), this->size());
+        }
     };
 
 }   // namespace tork
 
 #endif  // TORK_CONTAINER_VECTOR_H_INCLUDED
-
@@ -0,0 +1,332 @@
+﻿//******************************************************************************
+//
+// 呼び出し側のバッファへの書式化
+//
+// format_to() / append_to() は値を文字列にしてバッファの末尾に追記する
+// バッファを使い回せば、1 行ごとのヒープ確保はなくなる
+//
+//   tork::StackBuffer<256> buf;        // 固定容量（あふれた分は切り捨て）
+//   tork::MemoryBuffer<> buf;          // 足りなくなったらヒープに広げる
+//   tork::format_to(buf, "id={} value={}\n", id, value);
+//   tork::append_to(buf, "id=", id);
+//
+// 値は、数値（to_chars と同じ書式）、bool（true / false）、char、文字列、
+// string_view を直接書き、それ以外の型は to_string() を使う
+//
+//******************************************************************************
+
+#ifndef TORK_FORMAT_H_INCLUDED
+#define TORK_FORMAT_H_INCLUDED
+
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "charconv.h"
+#include "string_view.h"
+#include "text.h"
+#include "memory/allocator.h"
+
+namespace tork {
+
+//==============================================================================
+// 出力バッファ
+// 追記先の領域を持ち、足りなくなったら派生クラスの grow() で広げる
+//==============================================================================
+class OutputBuffer {
+    char* data_;
+    size_t size_;
+    size_t capacity_;
+    bool truncated_;
+
+protected:
+
+    // コンストラクタ
+    OutputBuffer(char* data, size_t capacity)
+        :data_(data), size_(0), capacity_(capacity), truncated_(false) { }
+
+    // 領域を差し替える（中身のコピーは派生クラスで行う）
+    void set_buffer(char* data, size_t capacity)
+    {
+        data_ = data;
+        capacity_ = capacity;
+    }
+
+    // 容量を min_capacity 以上に広げる
+    // 広げられない場合は何もしない（入りきらない分は切り捨てられる）
+    virtual void grow(size_t min_capacity) = 0;
+
+public:
+
+    virtual ~OutputBuffer() { }
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator =(const OutputBuffer&) = delete;
+
+    // 先頭を指すポインタ（NUL 終端ではない）
+    const char* data() const { return data_; }
+    char* data() { return data_; }
+
+    // 文字数
+    size_t size() const { return size_; }
+
+    // 容量
+    size_t capacity() const { return capacity_; }
+
+    // 空かどうか
+    bool empty() const { return size_ == 0; }
+
+    // 容量が足りずに切り捨てたかどうか
+    bool truncated() const { return truncated_; }
+
+    // 空にする（領域はそのまま）
+    void clear()
+    {
+        size_ = 0;
+        truncated_ = false;
+    }
+
+    // 中身のビュー
+    string_view view() const { return string_view(data_, size_); }
+
+    // 中身のコピー
+    std::string str() const { return std::string(data_, size_); }
+
+    // 1 文字追記
+    void push_back(char c)
+    {
+        if (size_ < capacity_) {
+            data_[size_++] = c;
+        }
+        else {
+            append_slow(&c, 1);
+        }
+    }
+
+    // n 文字追記
+    void append(const char* s, size_t n)
+    {
+        if (n <= capacity_ - size_) {
+            std::memcpy(data_ + size_, s, n);
+            size_ += n;
+        }
+        else {
+            append_slow(s, n);
+        }
+    }
+
+    // 文字列を追記
+    void append(string_view s)
+    {
+        append(s.data(), s.size());
+    }
+
+private:
+
+    // 容量が足りない場合の追記
+    void append_slow(const char* s, size_t n);
+
+};  // class OutputBuffer
+
+//==============================================================================
+// 固定容量のバッファ
+// スタックに置いて使う。容量を超えた分は切り捨て、truncated() が true になる
+//==============================================================================
+template<size_t N>
+class StackBuffer : public OutputBuffer {
+    char storage_[N];
+
+public:
+    StackBuffer() :OutputBuffer(storage_, N) { }
+
+    StackBuffer(const StackBuffer&) = delete;
+    StackBuffer& operator =(const StackBuffer&) = delete;
+
+protected:
+    void grow(size_t) override { }
+
+};  // class StackBuffer
+
+//==============================================================================
+// 伸長するバッファ
+// InlineSize までは内部の領域を使い、超えたらヒープに広げる
+// clear() しても領域は解放しないので、使い回せば確保は最初だけになる
+//==============================================================================
+template<size_t InlineSize = 256, class Allocator = tork::allocator<char>>
+class MemoryBuffer : public OutputBuffer {
+    typedef std::allocator_traits<Allocator> AllocTraits;
+
+    Allocator alloc_;
+    char storage_[InlineSize];
+
+public:
+
+    // コンストラクタ
+    explicit MemoryBuffer(const Allocator& a = Allocator())
+        :OutputBuffer(storage_, InlineSize), alloc_(a) { }
+
+    MemoryBuffer(const MemoryBuffer&) = delete;
+    MemoryBuffer& operator =(const MemoryBuffer&) = delete;
+
+    // デストラクタ
+    ~MemoryBuffer()
+    {
+        if (data() != storage_) {
+            AllocTraits::deallocate(alloc_, data(), capacity());
+        }
+    }
+
+    // 容量を確保する
+    void reserve(size_t n)
+    {
+        if (n > capacity()) grow(n);
+    }
+
+protected:
+
+    // 倍々に広げる
+    void grow(size_t min_capacity) override
+    {
+        size_t cap = capacity() * 2;
+        if (cap < min_capacity) cap = min_capacity;
+        char* p = AllocTraits::allocate(alloc_, cap);
+        if (p == nullptr) throw std::bad_alloc();
+        std::memcpy(p, data(), size());
+        if (data() != storage_) {
+            AllocTraits::deallocate(alloc_, data(), capacity());
+        }
+        set_buffer(p, cap);
+    }
+
+};  // class MemoryBuffer
+
+    namespace impl {
+
+// 書式文字列の "{}" の手前までを書き、"{}" の直後を返す（"{{" と "}}" は 1 文字に）
+// "{}" がなければ末尾まで書いて nullptr を返す
+const char* FormatLiteral(OutputBuffer& out, const char* first, const char* last);
+
+// 直接書ける型（それ以外は to_string() を使う）
+template<class T>
+struct IsFormatDirect : std::integral_constant<bool,
+    IsFastText<T>::value || std::is_same<T, char>::value
+    || std::is_convertible<const T&, string_view>::value> { };
+
+// 数値
+template<class Sink, class T>
+typename std::enable_if<IsCharconvInteger<T>::value || IsCharconvFloat<T>::value>::type
+WriteValue(Sink& out, T value)
+{
+    char buf[MaxFloatChars > MaxIntegerChars ? MaxFloatChars : MaxIntegerChars];
+    to_chars_result r = tork::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, r.ptr - buf);
+}
+
+// bool
+template<class Sink>
+void WriteValue(Sink& out, bool value)
+{
+    if (value) {
+        out.append("true", 4);
+    }
+    else {
+        out.append("false", 5);
+    }
+}
+
+// 文字
+template<class Sink>
+void WriteValue(Sink& out, char c)
+{
+    out.push_back(c);
+}
+
+// 文字列
+template<class Sink>
+void WriteValue(Sink& out, string_view s)
+{
+    out.append(s.data(), s.size());
+}
+template<class Sink>
+void WriteValue(Sink& out, const char* s)
+{
+    out.append(s, std::strlen(s));
+}
+template<class Sink>
+void WriteValue(Sink& out, const std::string& s)
+{
+    out.append(s.data(), s.size());
+}
+
+// その他の型
+template<class Sink, class T>
+typename std::enable_if<!IsFormatDirect<T>::value>::type
+WriteValue(Sink& out, const T& value)
+{
+    std::string s = tork::to_string(value);
+    out.append(s.data(), s.size());
+}
+
+// 値を順に追記
+template<class Sink>
+inline void AppendValues(Sink&) { }
+
+template<class Sink, class T, class... Args>
+void AppendValues(Sink& out, const T& value, const Args&... args)
+{
+    WriteValue(out, value);
+    AppendValues(out, args...);
+}
+
+// 書式文字列の残りを書く（"{}" が残っていれば引数が足りない）
+inline void FormatValues(OutputBuffer& out, const char* first, const char* last)
+{
+    if (FormatLiteral(out, first, last)) {
+        throw std::invalid_argument("too few arguments at tork::format_to");
+    }
+}
+
+template<class T, class... Args>
+void FormatValues(OutputBuffer& out, const char* first, const char* last, const T& value, const Args&... args)
+{
+    const char* next = FormatLiteral(out, first, last);
+    if (!next) {
+        throw std::invalid_argument("too many arguments at tork::format_to");
+    }
+    WriteValue(out, value);
+    FormatValues(out, next, last, args...);
+}
+
+    }   // namespace tork::impl
+
+// 書式文字列の "{}" を順に引数で置き換えて追記する
+// "{{" と "}}" はそれぞれ "{" と "}" になる
+// "{}" と引数の数が合わなければ std::invalid_argument
+template<class... Args>
+OutputBuffer& format_to(OutputBuffer& out, string_view fmt, const Args&... args)
+{
+    impl::FormatValues(out, fmt.data(), fmt.data() + fmt.size(), args...);
+    return out;
+}
+
+// 値を順に追記する
+template<class... Args>
+OutputBuffer& append_to(OutputBuffer& out, const Args&... args)
+{
+    impl::AppendValues(out, args...);
+    return out;
+}
+
+// std::string に値を順に追記する
+template<class... Args>
+std::string& append_to(std::string& out, const Args&... args)
+{
+    impl::AppendValues(out, args...);
+    return out;
+}
+
+}   // namespace tork
+
+#endif  // TORK_FORMAT_H_INCLUDED
@@ -8,6 +8,7 @@
 #define TORK_MEMORY_PTR_HOLDER_H_INCLUDED
 
 #include <memory>
+#include <atomic>
 #include <typeinfo>
 #include <type_traits>
 #include <utility>
@@ -36,14 +37,15 @@ namespace tork {
     // ポインタホルダ基底クラス
     //==========================================================================
     class ptr_holder_base {
-        int ref_counter_ = 0;   // 参照カウンタ
-        int weak_counter_ = 0;  // ウィークカウンタ
+        // 複数スレッドからコピー、破棄されてもよいようにアトミックにする
+        std::atomic<int> ref_counter_;  // 参照カウンタ
+        std::atomic<int> weak_counter_; // ウィークカウンタ
 
     protected:
         void* ptr_ = nullptr;   // 保持するポインタ
 
     public:
-        ptr_holder_base(void* ptr) : ptr_(ptr) { }
+        ptr_holder_base(void* ptr) : ref_counter_(0), weak_counter_(0), ptr_(ptr) { }
         virtual ~ptr_holder_base() { }
 
         // 削除子取得
@@ -63,17 +65,29 @@ namespace tork {
         // 参照カウンタ増
         void add_ref()
         {
-            ++ref_counter_;
+            ref_counter_.fetch_add(1, std::memory_order_relaxed);
             add_weak_ref();
         }
 
+        // リソースが削除されていなければ参照カウンタ増
+        // weak_ptr から shared_ptr を作るときに使う
+        bool add_ref_if_alive()
+        {
+            int n = ref_counter_.load(std::memory_order_relaxed);
+            do {
+                if (n == 0) return false;
+            } while (!ref_counter_.compare_exchange_weak(n, n + 1, std::memory_order_relaxed));
+            add_weak_ref();
+            return true;
+        }
+
         // 参照カウンタ減
         // 0になったらリソース削除
         void release()
         {
-            --ref_counter_;
-            assert(ref_counter_ >= 0);
-            if (ref_counter_ == 0) {
+            int n = ref_counter_.fetch_sub(1, std::memory_order_acq_rel);
+            assert(n >= 1);
+            if (n == 1) {
                 destroy();
             }
             release_weak_ref();
@@ -82,16 +96,16 @@ namespace tork {
         // ウィークカウンタ増
         void add_weak_ref()
         {
-            ++weak_counter_;
+            weak_counter_.fetch_add(1, std::memory_order_relaxed);
         }
 
         // ウィークカウンタ減
         // 0になったらホルダ削除
         void release_weak_ref()
         {
-            --weak_counter_;
-            assert(weak_counter_ >= 0);
-            if (weak_counter_ == 0) {
+            int n = weak_counter_.fetch_sub(1, std::memory_order_acq_rel);
+            assert(n >= 1);
+            if (n == 1) {
                 destroy_holder();
             }
         }
@@ -121,8 +121,9 @@ public:
     explicit shared_ptr(const weak_ptr<U>& other)
         :p_holder_(other.p_holder_)
     {
-        if (p_holder_) {
-            p_holder_->add_ref();
+        // 他のスレッドで最後の shared_ptr が破棄された後なら空にする
+        if (p_holder_ && !p_holder_->add_ref_if_alive()) {
+            p_holder_ = nullptr;
         }
     }
 
@@ -328,8 +329,9 @@ public:
     shared_ptr(const weak_ptr<T[]>& other)
         :p_holder_(other.p_holder_)
     {
-        if (p_holder_) {
-            p_holder_->add_ref();
+        // 他のスレッドで最後の shared_ptr が破棄された後なら空にする
+        if (p_holder_ && !p_holder_->add_ref_if_alive()) {
+            p_holder_ = nullptr;
         }
     }
 
@@ -0,0 +1,243 @@
+﻿//******************************************************************************
+//
+// 並列アルゴリズム
+//
+// ThreadPool の上で、ランダムアクセス範囲をチャンクに分けて処理する
+// プールは最初に使われたときに作る。pool() で取り出して他の仕事も同じプールに投入するか、
+// set_pool() で既存のプールを渡せば、スレッドを二重に持たずに済む
+// チャンクの分け方は要素数と grain だけで決まり、スレッド数には依存しない
+// そのため reduce() や inclusive_scan() の結果（浮動小数点の丸めも含めて）は
+// スレッド数を変えても同じになる
+//
+// grain はチャンクあたりの要素数。0 なら要素数を最大 256 チャンクに分ける
+// 並列処理の中から呼ばれた場合は、入れ子にせず呼び出したスレッドで順に処理する
+//
+//******************************************************************************
+
+#ifndef TORK_PARALLEL_H_INCLUDED
+#define TORK_PARALLEL_H_INCLUDED
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace tork {
+
+class ThreadPool;
+
+    namespace parallel {
+
+        namespace impl {
+
+// チャンク番号 0 ～ chunks - 1 を並列に body に渡し、全部終わるまで待つ
+// body が例外を投げた場合は、最初の例外を呼び出し元で投げ直す
+void RunChunks(size_t chunks, const std::function<void(size_t)>& body);
+
+// 要素数 n をチャンクに分けたときのチャンク数
+inline size_t ChunkCount(size_t n, size_t grain)
+{
+    if (n == 0) return 0;
+    if (grain == 0) grain = (n + 255) / 256;
+    return (n + grain - 1) / grain;
+}
+
+// チャンク c の範囲 [first, last)
+inline void ChunkRange(size_t n, size_t chunks, size_t c, size_t& first, size_t& last)
+{
+    // 端数はなるべく均等に配る
+    size_t per = n / chunks;
+    size_t rest = n % chunks;
+    first = c * per + (c < rest ? c : rest);
+    last = first + per + (c < rest ? 1 : 0);
+}
+
+// 範囲をチャンクに分けて body(first, last) を並列に呼ぶ
+template<class Body>
+void ForChunks(size_t n, size_t grain, Body body)
+{
+    size_t chunks = ChunkCount(n, grain);
+    RunChunks(chunks, [&](size_t c) {
+        size_t first, last;
+        ChunkRange(n, chunks, c, first, last);
+        body(c, first, last);
+    });
+}
+
+        }   // namespace tork::parallel::impl
+
+// 並列処理に使うスレッド数（呼び出したスレッドを含む）
+unsigned thread_count();
+
+// 並列処理に使うスレッド数を設定する（0 ならハードウェアスレッド数）
+// 使っているプールは、その数から呼び出したスレッドの分を除いたワーカー数の新しいプールに置き換える
+void set_thread_count(unsigned n);
+
+// 並列処理に使うスレッドプール（まだなければハードウェアスレッド数 - 1 個のワーカーで作る）
+std::shared_ptr<ThreadPool> pool();
+
+// 並列処理に使うスレッドプールを差し替える（nullptr なら次に使うときに内蔵のプールを作る）
+// 実行中の並列処理は前のプールで最後まで動く
+// 前のプールのワーカーから呼んではいけない（最後の参照なら、そのワーカーの終了を待つことになる）
+void set_pool(std::shared_ptr<ThreadPool> p);
+
+// 添え字付きの for_each
+// f(*it, i) の i は範囲全体での位置
+template<class RandomIter, class Function>
+void each_with_index(RandomIter first, RandomIter last, Function f, size_t grain = 0)
+{
+    size_t n = static_cast<size_t>(last - first);
+    impl::ForChunks(n, grain, [&](size_t, size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+            f(first[i], i);
+        }
+    });
+}
+
+// for_each
+template<class RandomIter, class Function>
+void for_each(RandomIter first, RandomIter last, Function f, size_t grain = 0)
+{
+    size_t n = static_cast<size_t>(last - first);
+    impl::ForChunks(n, grain, [&](size_t, size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+            f(first[i]);
+        }
+    });
+}
+
+// transform
+// 出力の末尾を返す
+template<class RandomIter, class OutputIter, class Function>
+OutputIter transform(RandomIter first, RandomIter last, OutputIter out, Function op, size_t grain = 0)
+{
+    size_t n = static_cast<size_t>(last - first);
+    impl::ForChunks(n, grain, [&](size_t, size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+            out[i] = op(first[i]);
+        }
+    });
+    return out + n;
+}
+
+// reduce
+// op は結合的であること。チャンクごとの部分和を、チャンク順に init へ畳み込む
+template<class RandomIter, class T, class BinaryOp>
+T reduce(RandomIter first, RandomIter last, T init, BinaryOp op, size_t grain = 0)
+{
+    size_t n = static_cast<size_t>(last - first);
+    size_t chunks = impl::ChunkCount(n, grain);
+    std::vector<T> partial(chunks, init);
+    impl::ForChunks(n, grain, [&](size_t c, size_t b, size_t e) {
+        T acc = first[b];
+        for (size_t i = b + 1; i < e; ++i) {
+            acc = op(acc, first[i]);
+        }
+        partial[c] = acc;
+    });
+    for (size_t c = 0; c < chunks; ++c) {
+        init = op(init, partial[c]);
+    }
+    return init;
+}
+
+template<class RandomIter, class T>
+T reduce(RandomIter first, RandomIter last, T init)
+{
+    return parallel::reduce(first, last, init, std::plus<T>());
+}
+
+// inclusive_scan
+// チャンクごとの合計 → チャンク順の累積 → チャンクごとの走査、の 3 段階
+// out は first と同じでもよい（その場で累積する）
+template<class RandomIter, class OutputIter, class BinaryOp>
+OutputIter inclusive_scan(RandomIter first, RandomIter last, OutputIter out, BinaryOp op, size_t grain = 0)
+{
+    typedef typename std::iterator_traits<RandomIter>::value_type T;
+    size_t n = static_cast<size_t>(last - first);
+    size_t chunks = impl::ChunkCount(n, grain);
+    if (chunks == 0) return out;
+
+    std::vector<T> sums(chunks);
+    impl::ForChunks(n, grain, [&](size_t c, size_t b, size_t e) {
+        T acc = first[b];
+        for (size_t i = b + 1; i < e; ++i) {
+            acc = op(acc, first[i]);
+        }
+        sums[c] = acc;
+    });
+
+    // 各チャンクの前までの累積（先頭チャンクは使わない）
+    for (size_t c = 1; c < chunks; ++c) {
+        sums[c] = op(sums[c - 1], sums[c]);
+    }
+
+    impl::ForChunks(n, grain, [&](size_t c, size_t b, size_t e) {
+        T acc = (c == 0) ? first[b] : op(sums[c - 1], first[b]);
+        out[b] = acc;
+        for (size_t i = b + 1; i < e; ++i) {
+            acc = op(acc, first[i]);
+            out[i] = acc;
+        }
+    });
+    return out + n;
+}
+
+template<class RandomIter, class OutputIter>
+OutputIter inclusive_scan(RandomIter first, RandomIter last, OutputIter out)
+{
+    typedef typename std::iterator_traits<RandomIter>::value_type T;
+    return parallel::inclusive_scan(first, last, out, std::plus<T>());
+}
+
+// sort
+// チャンクごとに並列にソートし、隣り合う組を並列にマージしていく
+template<class RandomIter, class Compare>
+void sort(RandomIter first, RandomIter last, Compare comp, size_t grain = 0)
+{
+    size_t n = static_cast<size_t>(last - first);
+    size_t chunks = impl::ChunkCount(n, grain);
+    if (chunks <= 1) {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    std::vector<size_t> bounds(chunks + 1);
+    for (size_t c = 0; c < chunks; ++c) {
+        size_t b, e;
+        impl::ChunkRange(n, chunks, c, b, e);
+        bounds[c] = b;
+    }
+    bounds[chunks] = n;
+
+    impl::RunChunks(chunks, [&](size_t c) {
+        std::sort(first + bounds[c], first + bounds[c + 1], comp);
+    });
+
+    // 幅 width のランを2つずつマージする
+    for (size_t width = 1; width < chunks; width *= 2) {
+        size_t pairs = (chunks + 2 * width - 1) / (2 * width);
+        impl::RunChunks(pairs, [&](size_t p) {
+            size_t lo = p * 2 * width;
+            size_t mid = std::min(lo + width, chunks);
+            size_t hi = std::min(lo + 2 * width, chunks);
+            if (mid < hi) {
+                std::inplace_merge(first + bounds[lo], first + bounds[mid], first + bounds[hi], comp);
+            }
+        });
+    }
+}
+
+template<class RandomIter>
+void sort(RandomIter first, RandomIter last)
+{
+    typedef typename std::iterator_traits<RandomIter>::value_type T;
+    parallel::sort(first, last, std::less<T>());
+}
+
+    }   // namespace tork::parallel
+
+}   // namespace tork
+
+#endif  // TORK_PARALLEL_H_INCLUDED
@@ -0,0 +1,175 @@
+﻿//******************************************************************************
+//
+// 連続した要素列への参照（所有しない）
+//
+//******************************************************************************
+
+#ifndef TORK_SPAN_H_INCLUDED
+#define TORK_SPAN_H_INCLUDED
+
+#include <cstddef>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <cassert>
+
+namespace tork {
+
+//==============================================================================
+// スパン
+// 配列やコンテナの一部をコピーせずに参照する
+// 参照先の寿命は管理しないので、参照先より長く持たないこと
+//==============================================================================
+template<class T>
+class span {
+public:
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef typename std::remove_const<T>::type value_type;
+    typedef T element_type;
+    typedef T* pointer;
+    typedef T& reference;
+
+    typedef T* iterator;
+    typedef T* const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+private:
+    T* data_ = nullptr;
+    size_type size_ = 0;
+
+public:
+
+    // デフォルトコンストラクタ
+    span() { }
+
+    // ポインタと要素数
+    span(T* p, size_type n) :data_(p), size_(n) { }
+
+    // ポインタの範囲
+    // span(p, 0) が曖昧にならないように、終端はテンプレートで受ける
+    template<class U,
+        class = typename std::enable_if<std::is_same<U, T>::value, void>::type>
+    span(T* first, U* last) :data_(first), size_(last - first)
+    {
+        assert(first <= last);
+    }
+
+    // 配列
+    template<size_t N>
+    span(T (&ary)[N]) :data_(ary), size_(N) { }
+
+    // data() と size() を持つコンテナ
+    template<class Container,
+        class = typename std::enable_if<
+            !std::is_same<typename std::remove_const<Container>::type, span>::value
+            && std::is_convertible<
+                decltype(std::declval<Container&>().data()), T*>::value,
+        void>::type>
+    span(Container& c) :data_(c.data()), size_(c.size()) { }
+
+    // span<U> からの変換（span<T> -> span<const T> など）
+    template<class U,
+        class = typename std::enable_if<
+            std::is_convertible<U(*)[], T(*)[]>::value, void>::type>
+    span(const span<U>& s) :data_(s.data()), size_(s.size()) { }
+
+    // 要素数
+    size_type size() const { return size_; }
+
+    // バイト数
+    size_type size_bytes() const { return size_ * sizeof(T); }
+
+    // 空かどうか
+    bool empty() const { return size_ == 0; }
+
+    // データの先頭を指すポインタ
+    T* data() const { return data_; }
+
+    // 要素への添え字アクセス
+    T& operator [](size_type i) const
+    {
+        assert(i < size_);
+        return data_[i];
+    }
+
+    // 範囲チェック付きアクセス
+    T& at(size_type i) const
+    {
+        if (i >= size_) throw std::out_of_range("out of range at tork::span");
+        return data_[i];
+    }
+
+    // 先頭要素への参照
+    T& front() const { assert(!empty()); return data_[0]; }
+
+    // 末尾要素への参照
+    T& back() const { assert(!empty()); return data_[size_ - 1]; }
+
+    // 先頭から n 個
+    span first(size_type n) const
+    {
+        assert(n <= size_);
+        return span(data_, n);
+    }
+
+    // 末尾から n 個
+    span last(size_type n) const
+    {
+        assert(n <= size_);
+        return span(data_ + size_ - n, n);
+    }
+
+    // 部分スパン
+    // n を省略した場合は末尾まで
+    span subspan(size_type off, size_type n = size_type(-1)) const
+    {
+        if (off > size_) throw std::out_of_range("out of range at tork::span");
+        if (n > size_ - off) n = size_ - off;
+        return span(data_ + off, n);
+    }
+
+    // イテレータ
+    iterator begin() const { return data_; }
+    iterator end() const { return data_ + size_; }
+    const_iterator cbegin() const { return data_; }
+    const_iterator cend() const { return data_ + size_; }
+
+    // 逆イテレータ
+    reverse_iterator rbegin() const { return reverse_iterator(end()); }
+    reverse_iterator rend() const { return reverse_iterator(begin()); }
+
+};  // class span
+
+// スパン作成
+template<class T>
+inline span<T> make_span(T* p, size_t n)
+{
+    return span<T>(p, n);
+}
+template<class Container>
+inline auto make_span(Container& c) -> span<typename std::remove_pointer<decltype(c.data())>::type>
+{
+    return span<typename std::remove_pointer<decltype(c.data())>::type>(c);
+}
+
+// 要素の比較
+template<class T, class U>
+bool operator ==(const span<T>& x, const span<U>& y)
+{
+    if (x.size() != y.size()) return false;
+    return std::equal(x.begin(), x.end(), y.begin());
+}
+
+template<class T, class U>
+bool operator !=(const span<T>& x, const span<U>& y)
+{
+    return !(x == y);
+}
+
+}   // namespace tork
+
+#endif  // TORK_SPAN_H_INCLUDED
@@ -0,0 +1,364 @@
+﻿//******************************************************************************
+//
+// 文字列への参照（所有しない）
+//
+// std::basic_string_view と同じ使い方ができる
+// 参照先の寿命は管理しないので、参照先より長く持たないこと
+//
+//******************************************************************************
+
+#ifndef TORK_STRING_VIEW_H_INCLUDED
+#define TORK_STRING_VIEW_H_INCLUDED
+
+#include <cstddef>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <cassert>
+
+namespace tork {
+
+//==============================================================================
+// 文字列ビュー
+//==============================================================================
+template<class CharT, class Traits = std::char_traits<CharT>>
+class basic_string_view {
+public:
+    typedef Traits traits_type;
+    typedef CharT value_type;
+    typedef const CharT* pointer;
+    typedef const CharT* const_pointer;
+    typedef const CharT& reference;
+    typedef const CharT& const_reference;
+    typedef const CharT* iterator;
+    typedef const CharT* const_iterator;
+    typedef std::reverse_iterator<const_iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    static const size_type npos = size_type(-1);
+
+private:
+    const CharT* data_ = nullptr;
+    size_type size_ = 0;
+
+public:
+
+    // デフォルトコンストラクタ
+    basic_string_view() { }
+
+    // ポインタと文字数
+    basic_string_view(const CharT* s, size_type n) :data_(s), size_(n) { }
+
+    // NUL 終端文字列
+    basic_string_view(const CharT* s) :data_(s), size_(Traits::length(s)) { }
+
+    // std::basic_string
+    template<class Allocator>
+    basic_string_view(const std::basic_string<CharT, Traits, Allocator>& s)
+        :data_(s.data()), size_(s.size()) { }
+
+    // std::basic_string に変換（コピーする）
+    template<class Allocator>
+    explicit operator std::basic_string<CharT, Traits, Allocator>() const
+    {
+        return std::basic_string<CharT, Traits, Allocator>(data_, size_);
+    }
+
+    // std::basic_string にコピー
+    std::basic_string<CharT, Traits> to_string() const
+    {
+        return std::basic_string<CharT, Traits>(data_, size_);
+    }
+
+    // 文字数
+    size_type size() const { return size_; }
+    size_type length() const { return size_; }
+
+    // 空かどうか
+    bool empty() const { return size_ == 0; }
+
+    // 先頭を指すポインタ（NUL 終端とは限らない）
+    const CharT* data() const { return data_; }
+
+    // 添え字アクセス
+    const CharT& operator [](size_type i) const
+    {
+        assert(i < size_);
+        return data_[i];
+    }
+
+    // 範囲チェック付きアクセス
+    const CharT& at(size_type i) const
+    {
+        if (i >= size_) throw std::out_of_range("out of range at tork::basic_string_view");
+        return data_[i];
+    }
+
+    // 先頭の文字
+    const CharT& front() const { assert(!empty()); return data_[0]; }
+
+    // 末尾の文字
+    const CharT& back() const { assert(!empty()); return data_[size_ - 1]; }
+
+    // イテレータ
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+    const_iterator cbegin() const { return data_; }
+    const_iterator cend() const { return data_ + size_; }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    // 先頭から n 文字除く
+    void remove_prefix(size_type n)
+    {
+        assert(n <= size_);
+        data_ += n;
+        size_ -= n;
+    }
+
+    // 末尾から n 文字除く
+    void remove_suffix(size_type n)
+    {
+        assert(n <= size_);
+        size_ -= n;
+    }
+
+    // 交換
+    void swap(basic_string_view& other)
+    {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+    }
+
+    // 部分文字列（コピーしない）
+    basic_string_view substr(size_type pos = 0, size_type n = npos) const
+    {
+        if (pos > size_) throw std::out_of_range("out of range at tork::basic_string_view");
+        if (n > size_ - pos) n = size_ - pos;
+        return basic_string_view(data_ + pos, n);
+    }
+
+    // 比較
+    int compare(basic_string_view s) const
+    {
+        size_type n = (size_ < s.size_) ? size_ : s.size_;
+        int r = (n == 0) ? 0 : Traits::compare(data_, s.data_, n);
+        if (r != 0) return r;
+        return (size_ < s.size_) ? -1 : (size_ > s.size_) ? 1 : 0;
+    }
+
+    // 先頭が一致するか
+    bool starts_with(basic_string_view s) const
+    {
+        return size_ >= s.size_ && (s.size_ == 0 || Traits::compare(data_, s.data_, s.size_) == 0);
+    }
+    bool starts_with(CharT c) const
+    {
+        return size_ > 0 && Traits::eq(data_[0], c);
+    }
+
+    // 末尾が一致するか
+    bool ends_with(basic_string_view s) const
+    {
+        return size_ >= s.size_ && (s.size_ == 0 || Traits::compare(data_ + size_ - s.size_, s.data_, s.size_) == 0);
+    }
+    bool ends_with(CharT c) const
+    {
+        return size_ > 0 && Traits::eq(data_[size_ - 1], c);
+    }
+
+    // 文字を探す
+    size_type find(CharT c, size_type pos = 0) const
+    {
+        if (pos >= size_) return npos;
+        const CharT* p = Traits::find(data_ + pos, size_ - pos, c);
+        return p ? static_cast<size_type>(p - data_) : npos;
+    }
+
+    // 文字列を探す
+    size_type find(basic_string_view s, size_type pos = 0) const
+    {
+        if (pos > size_ || s.size_ > size_ - pos) return npos;
+        if (s.size_ == 0) return pos;
+        const CharT* last = data_ + size_ - s.size_ + 1;
+        for (const CharT* p = data_ + pos; ; ++p) {
+            p = Traits::find(p, last - p, s.data_[0]);
+            if (!p) return npos;
+            if (Traits::compare(p, s.data_, s.size_) == 0) return static_cast<size_type>(p - data_);
+        }
+    }
+
+    // 後ろから文字を探す
+    size_type rfind(CharT c, size_type pos = npos) const
+    {
+        if (size_ == 0) return npos;
+        size_type i = (pos < size_) ? pos : size_ - 1;
+        for (;;) {
+            if (Traits::eq(data_[i], c)) return i;
+            if (i == 0) return npos;
+            --i;
+        }
+    }
+
+    // 後ろから文字列を探す
+    size_type rfind(basic_string_view s, size_type pos = npos) const
+    {
+        if (s.size_ > size_) return npos;
+        size_type i = size_ - s.size_;
+        if (pos < i) i = pos;
+        for (;;) {
+            if (Traits::compare(data_ + i, s.data_, s.size_) == 0) return i;
+            if (i == 0) return npos;
+            --i;
+        }
+    }
+
+    // s に含まれる文字を探す
+    size_type find_first_of(basic_string_view s, size_type pos = 0) const
+    {
+        for (size_type i = pos; i < size_; ++i) {
+            if (Traits::find(s.data_, s.size_, data_[i])) return i;
+        }
+        return npos;
+    }
+
+    // s に含まれない文字を探す
+    size_type find_first_not_of(basic_string_view s, size_type pos = 0) const
+    {
+        for (size_type i = pos; i < size_; ++i) {
+            if (!Traits::find(s.data_, s.size_, data_[i])) return i;
+        }
+        return npos;
+    }
+
+    // 後ろから s に含まれる文字を探す
+    size_type find_last_of(basic_string_view s, size_type pos = npos) const
+    {
+        for (size_type i = (pos < size_) ? pos + 1 : size_; i > 0; --i) {
+            if (Traits::find(s.data_, s.size_, data_[i - 1])) return i - 1;
+        }
+        return npos;
+    }
+
+    // 後ろから s に含まれない文字を探す
+    size_type find_last_not_of(basic_string_view s, size_type pos = npos) const
+    {
+        for (size_type i = (pos < size_) ? pos + 1 : size_; i > 0; --i) {
+            if (!Traits::find(s.data_, s.size_, data_[i - 1])) return i - 1;
+        }
+        return npos;
+    }
+
+};  // class basic_string_view
+
+template<class CharT, class Traits>
+const typename basic_string_view<CharT, Traits>::size_type basic_string_view<CharT, Traits>::npos;
+
+typedef basic_string_view<char> string_view;
+typedef basic_string_view<wchar_t> wstring_view;
+
+// 比較演算子
+// 片方が std::string や文字列リテラルでも比較できるように、もう片方の型から変換する
+template<class CharT, class Traits>
+bool operator ==(basic_string_view<CharT, Traits> x, basic_string_view<CharT, Traits> y)
+{
+    return x.size() == y.size() && x.compare(y) == 0;
+}
+template<class CharT, class Traits, class U>
+bool operator ==(basic_string_view<CharT, Traits> x, const U& y)
+{
+    return x == basic_string_view<CharT, Traits>(y);
+}
+template<class CharT, class Traits, class U>
+bool operator ==(const U& x, basic_string_view<CharT, Traits> y)
+{
+    return basic_string_view<CharT, Traits>(x) == y;
+}
+
+template<class CharT, class Traits>
+bool operator !=(basic_string_view<CharT, Traits> x, basic_string_view<CharT, Traits> y)
+{
+    return !(x == y);
+}
+template<class CharT, class Traits, class U>
+bool operator !=(basic_string_view<CharT, Traits> x, const U& y)
+{
+    return !(x == basic_string_view<CharT, Traits>(y));
+}
+template<class CharT, class Traits, class U>
+bool operator !=(const U& x, basic_string_view<CharT, Traits> y)
+{
+    return !(basic_string_view<CharT, Traits>(x) == y);
+}
+
+template<class CharT, class Traits>
+bool operator <(basic_string_view<CharT, Traits> x, basic_string_view<CharT, Traits> y)
+{
+    return x.compare(y) < 0;
+}
+template<class CharT, class Traits>
+bool operator >(basic_string_view<CharT, Traits> x, basic_string_view<CharT, Traits> y)
+{
+    return x.compare(y) > 0;
+}
+template<class CharT, class Traits>
+bool operator <=(basic_string_view<CharT, Traits> x, basic_string_view<CharT, Traits> y)
+{
+    return x.compare(y) <= 0;
+}
+template<class CharT, class Traits>
+bool operator >=(basic_string_view<CharT, Traits> x, basic_string_view<CharT, Traits> y)
+{
+    return x.compare(y) >= 0;
+}
+
+// ストリーム出力
+template<class CharT, class Traits>
+std::basic_ostream<CharT, Traits>& operator <<(std::basic_ostream<CharT, Traits>& ost, basic_string_view<CharT, Traits> s)
+{
+    return ost.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+    namespace impl {
+
+// FNV-1a
+inline size_t HashBytes(const void* data, size_t n)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+#if defined(_WIN64) || defined(__x86_64__) || defined(__aarch64__)
+    size_t h = static_cast<size_t>(14695981039346656037ULL);
+    const size_t prime = static_cast<size_t>(1099511628211ULL);
+#else
+    size_t h = 2166136261U;
+    const size_t prime = 16777619U;
+#endif
+    for (size_t i = 0; i < n; ++i) {
+        h ^= p[i];
+        h *= prime;
+    }
+    return h;
+}
+
+    }   // namespace tork::impl
+
+}   // namespace tork
+
+namespace std {
+
+// ハッシュ
+template<class CharT, class Traits>
+struct hash<tork::basic_string_view<CharT, Traits>> {
+    size_t operator ()(tork::basic_string_view<CharT, Traits> s) const
+    {
+        return tork::impl::HashBytes(s.data(), s.size() * sizeof(CharT));
+    }
+};
+
+}   // namespace std
+
+#endif  // TORK_STRING_VIEW_H_INCLUDED
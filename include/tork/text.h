@@ -8,35 +8,115 @@
 
 #include <string>
 #include <sstream>
+#include <type_traits>
+#include <cmath>
+#include <limits>
+#include "charconv.h"
+#include "string_view.h"
 
 namespace tork {
 
 struct bad_from_string : std::bad_cast {
-    const char* what() const
+    const char* what() const throw()
     {
         return "bad cast from string";
     }
 };
 
 struct bad_lexical_cast : std::bad_cast {
-    const char* what() const
+    const char* what() const throw()
     {
         return "bad cast";
     }
 };
 
+    namespace impl {
+
+// ストリームを使わずに変換できる型（文字型を除く整数、float、double、bool）
+template<class T>
+struct IsFastText : std::integral_constant<bool,
+    IsCharconvInteger<T>::value || IsCharconvFloat<T>::value || std::is_same<T, bool>::value> { };
+
+// 数値を書き、末尾を返す
+template<class T>
+inline char* ToChars(char* first, char* last, T value)
+{
+    return tork::to_chars(first, last, value).ptr;
+}
+inline char* ToChars(char* first, char*, bool value)
+{
+    *first = value ? '1' : '0';
+    return first + 1;
+}
+
+// 数値を読む（bool は 0 か 1 だけ）
+template<class T>
+inline from_chars_result ParseNumber(const char* first, const char* last, T& value)
+{
+    return tork::from_chars(first, last, value);
+}
+inline from_chars_result ParseNumber(const char* first, const char* last, bool& value)
+{
+    unsigned v = 0;
+    from_chars_result r = tork::from_chars(first, last, v);
+    if (r.ec == std::errc()) {
+        if (v > 1) {
+            r.ec = std::errc::invalid_argument;
+        }
+        else {
+            value = (v != 0);
+        }
+    }
+    return r;
+}
+
+// 空白文字かどうか（C ロケール）
+inline bool IsSpace(char c)
+{
+    return c == ' ' || ('\t' <= c && c <= '\r');
+}
+
+// 先頭の空白と、符号の '+' を飛ばす
+inline const char* SkipLeadingSpace(const char* first, const char* last)
+{
+    while (first != last && IsSpace(*first)) ++first;
+    if (first != last && *first == '+' && last - first > 1 && first[1] != '-') ++first;
+    return first;
+}
+
+// 数値を読む（istream と同じく、先頭の空白と '+' を許し、後ろの余りは無視する）
+template<class T>
+inline bool FromChars(const char* first, const char* last, T& value)
+{
+    return ParseNumber(SkipLeadingSpace(first, last), last, value).ec == std::errc();
+}
+
+    }   // namespace tork::impl
+
 // 文字列に変換
 template<class T>
-std::string to_string(const T& t)
+typename std::enable_if<!impl::IsFastText<T>::value, std::string>::type
+to_string(const T& t)
 {
     std::ostringstream os;
     os << t;
     return os.str();
 }
 
+// 数値を文字列に変換（ストリームを使わない）
+// 浮動小数点数は読み戻すと元の値に戻る最短の桁数になる
+template<class T>
+typename std::enable_if<impl::IsFastText<T>::value, std::string>::type
+to_string(const T& t)
+{
+    char buf[impl::MaxFloatChars];
+    return std::string(buf, impl::ToChars(buf, buf + sizeof(buf), t));
+}
+
 // 文字列から変換
 template<class T>
-T from_string(const std::string& s)
+typename std::enable_if<!impl::IsFastText<T>::value, T>::type
+from_string(const std::string& s)
 {
     std::istringstream is(s);
     T t;
@@ -46,9 +126,151 @@ T from_string(const std::string& s)
     return t;
 }
 
-// 相互変換
+// 文字列から数値に変換（ストリームを使わない）
+// 数字がない場合、範囲外の場合、符号なし型に負数を与えた場合は bad_from_string
+template<class T>
+typename std::enable_if<impl::IsFastText<T>::value, T>::type
+from_string(const std::string& s)
+{
+    T t;
+    if (!impl::FromChars(s.data(), s.data() + s.size(), t)) {
+        throw bad_from_string();
+    }
+    return t;
+}
+
+    namespace impl {
+
+// lexical_cast の変換方法
+const int CastStream = 0;       // stringstream を通す
+const int CastIdentity = 1;     // 同じ型
+const int CastNumber = 2;       // 数値 → 数値
+const int CastFromString = 3;   // 文字列 → 数値
+const int CastToString = 4;     // 数値 → std::string
+const int CastStringCopy = 5;   // 文字列 → std::string
+
+// コピーせずに読める文字列型
+template<class T> struct IsStringSource : std::false_type { };
+template<> struct IsStringSource<const char*> : std::true_type { };
+template<> struct IsStringSource<std::string> : std::true_type { };
+template<> struct IsStringSource<string_view> : std::true_type { };
+
+// 変換方法を選ぶ
+template<class Target, class Source>
+struct LexicalCastKind : std::integral_constant<int,
+    std::is_same<Target, Source>::value ? CastIdentity
+    : (IsFastText<Target>::value && IsFastText<Source>::value) ? CastNumber
+    : (IsFastText<Target>::value && IsStringSource<Source>::value) ? CastFromString
+    : (std::is_same<Target, std::string>::value && IsFastText<Source>::value) ? CastToString
+    : (std::is_same<Target, std::string>::value && IsStringSource<Source>::value) ? CastStringCopy
+    : CastStream> { };
+
+// 整数 → 整数 の範囲チェック
+template<class Target, class Source>
+inline bool NumberFits(Source v, std::true_type, std::true_type)
+{
+    if (IsNegative(v, std::is_signed<Source>())) {
+        return std::is_signed<Target>::value
+            && static_cast<long long>(v) >= static_cast<long long>(std::numeric_limits<Target>::min());
+    }
+    return static_cast<unsigned long long>(v)
+        <= static_cast<unsigned long long>(std::numeric_limits<Target>::max());
+}
+
+// 浮動小数点数 → 整数 の範囲チェック（小数部があれば失敗）
+template<class Target, class Source>
+inline bool NumberFits(Source v, std::true_type, std::false_type)
+{
+    double limit = std::ldexp(1.0, std::numeric_limits<Target>::digits);
+    double lower = std::is_signed<Target>::value ? -limit : 0.0;
+    return v >= lower && v < limit && std::floor(v) == v;
+}
+
+// 整数 → 浮動小数点数 は常に収まる（丸めは許す）
 template<class Target, class Source>
-Target lexical_cast(Source arg)
+inline bool NumberFits(Source, std::false_type, std::true_type)
+{
+    return true;
+}
+
+// 浮動小数点数 → 浮動小数点数（有限の値が無限大にならないこと）
+template<class Target, class Source>
+inline bool NumberFits(Source v, std::false_type, std::false_type)
+{
+    return !(std::fabs(v) > std::numeric_limits<Target>::max()
+        && std::fabs(v) != std::numeric_limits<Source>::infinity());
+}
+
+// 数値 → 数値
+template<class Target, class Source>
+inline Target NumberCast(Source v, std::false_type)
+{
+    if (!NumberFits<Target>(v, std::is_integral<Target>(), std::is_integral<Source>())) {
+        throw bad_lexical_cast();
+    }
+    return static_cast<Target>(v);
+}
+
+// 数値 → bool（0 か 1 だけ）
+template<class Target, class Source>
+inline Target NumberCast(Source v, std::true_type)
+{
+    if (v != 0 && v != 1) throw bad_lexical_cast();
+    return v == 1;
+}
+
+// 文字列型をビューにする
+inline string_view ToView(const char* s) { return string_view(s); }
+inline string_view ToView(const std::string& s) { return string_view(s); }
+inline string_view ToView(string_view s) { return s; }
+
+// 同じ型
+template<class Target, class Source>
+inline Target LexicalCast(const Source& arg, std::integral_constant<int, CastIdentity>)
+{
+    return arg;
+}
+
+// 数値 → 数値（範囲チェック付き）
+template<class Target, class Source>
+inline Target LexicalCast(const Source& arg, std::integral_constant<int, CastNumber>)
+{
+    return NumberCast<Target>(arg, std::integral_constant<bool, std::is_same<Target, bool>::value>());
+}
+
+// 文字列 → 数値（前後の空白は許し、それ以外の余りがあれば失敗）
+template<class Target, class Source>
+inline Target LexicalCast(const Source& arg, std::integral_constant<int, CastFromString>)
+{
+    string_view s = ToView(arg);
+    const char* last = s.data() + s.size();
+    const char* first = SkipLeadingSpace(s.data(), last);
+    while (last != first && IsSpace(last[-1])) --last;
+
+    Target result;
+    from_chars_result r = ParseNumber(first, last, result);
+    if (r.ec != std::errc() || r.ptr != last) throw bad_lexical_cast();
+    return result;
+}
+
+// 数値 → std::string
+template<class Target, class Source>
+inline Target LexicalCast(const Source& arg, std::integral_constant<int, CastToString>)
+{
+    return tork::to_string(arg);
+}
+
+// 文字列 → std::string
+template<class Target, class Source>
+inline Target LexicalCast(const Source& arg, std::integral_constant<int, CastStringCopy>)
+{
+    string_view s = ToView(arg);
+    return std::string(s.data(), s.size());
+}
+
+// その他は stringstream を通す
+template<class Target, class Source>
+inline Target LexicalCast(const Source& arg, std::integral_constant<int, CastStream>)
 {
     std::stringstream interpreter;
     Target result;
@@ -62,12 +284,56 @@ Target lexical_cast(Source arg)
     return result;
 }
 
+    }   // namespace tork::impl
+
+// 相互変換
+// 型の組み合わせによってコンパイル時に変換方法を選ぶ
+//   同じ型                      そのまま返す
+//   数値 → 数値                範囲チェックして変換（収まらなければ bad_lexical_cast）
+//   文字列 → 数値              from_chars で変換（コピーもヒープ確保もしない）
+//   数値・文字列 → std::string  to_chars で変換、または全体をコピー
+//   それ以外                    stringstream を通す
+// 文字列は const char*、std::string、string_view、数値は文字型を除く整数、float、double、bool
+template<class Target, class Source>
+Target lexical_cast(const Source& arg)
+{
+    typedef typename std::decay<Source>::type S;
+    typedef typename std::conditional<std::is_same<S, char*>::value, const char*, S>::type Decayed;
+    return impl::LexicalCast<Target, Decayed>(arg,
+        std::integral_constant<int, impl::LexicalCastKind<Target, Decayed>::value>());
+}
+
 // ワイド文字変換
+// 狭い側はシステムのロケールのマルチバイト文字（Windows ではシステムのコードページ）
+// 変換できない文字があれば std::range_error
 std::wstring ToWide(const std::string& str);
 std::wstring ToWide(const char* str);
 std::string FromWide(const std::wstring& wstr);
 std::string FromWide(const wchar_t* wstr);
 
+// 不正なシーケンスの扱い
+enum class InvalidSequence {
+    Throw,      // std::range_error を投げる
+    Replace,    // U+FFFD に置き換える
+};
+
+// UTF-8 とワイド文字（Windows では UTF-16、それ以外では UTF-32）の変換
+// ロケールによらず、狭い側は常に UTF-8
+std::wstring Utf8ToWide(string_view str, InvalidSequence invalid = InvalidSequence::Throw);
+std::string WideToUtf8(wstring_view wstr, InvalidSequence invalid = InvalidSequence::Throw);
+
+// 変換後の長さ（wchar_t の数、バイト数）
+// 不正なシーケンスは置き換えたものとして数える
+size_t Utf8ToWideLength(const char* first, const char* last);
+size_t WideToUtf8Length(const wchar_t* first, const wchar_t* last);
+
+// 呼び出し側のバッファへ変換し、書き込んだ末尾を返す
+// out には Utf8ToWideLength() / WideToUtf8Length() の分の領域が必要
+wchar_t* Utf8ToWide(const char* first, const char* last, wchar_t* out,
+    InvalidSequence invalid = InvalidSequence::Throw);
+char* WideToUtf8(const wchar_t* first, const wchar_t* last, char* out,
+    InvalidSequence invalid = InvalidSequence::Throw);
+
 }   // namespace tork
 
 #endif  // TORK_TEXT_H_INCLUDED
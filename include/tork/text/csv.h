@@ -0,0 +1,225 @@
+﻿//******************************************************************************
+//
+// 区切り文字で並んだ数値と CSV の一括読み込み
+//
+// 値は列ごとの tork::Array に直接読み込む
+// 読めない値は T() を入れて先に進み、行と列を ParseResult に記録する（例外は投げない）
+//
+//   tork::Array<int> ids;
+//   tork::Array<double> prices;
+//   tork::Array<tork::string_view> names;
+//   tork::text::CsvOptions opt;
+//   opt.header = true;
+//   tork::text::ParseResult r = tork::text::parse_csv(text, opt, ids, prices, names);
+//
+//******************************************************************************
+
+#ifndef TORK_TEXT_CSV_H_INCLUDED
+#define TORK_TEXT_CSV_H_INCLUDED
+
+#include <cstddef>
+#include <system_error>
+#include <vector>
+#include "split.h"
+#include "../charconv.h"
+#include "../string_view.h"
+#include "../text.h"
+#include "../container/Array.h"
+
+namespace tork {
+
+    namespace text {
+
+// 誤りの種類
+enum class ParseErrorKind {
+    InvalidValue,   // 値として読めない
+    OutOfRange,     // 型の範囲を超える
+    MissingField,   // 列が足りない
+    ExtraField,     // 列が多すぎる
+};
+
+// 誤りの位置
+struct ParseError {
+    size_t row;             // 行（ヘッダーと空行を除いた 0 始まりの番号で、Array の添え字と同じ）
+    size_t column;          // 列（0 始まり）
+    size_t offset;          // 先頭からのバイト位置
+    ParseErrorKind kind;    // 種類
+};
+
+// 読み込みの結果
+struct ParseResult {
+    size_t rows = 0;                    // 読んだ行数
+    size_t values = 0;                  // 正しく読めた値の数
+    size_t error_count = 0;             // 誤りの総数
+    std::vector<ParseError> errors;     // 誤り（先頭から max_errors 個まで）
+
+    // 誤りがなかったかどうか
+    bool ok() const { return error_count == 0; }
+};
+
+// CSV の設定
+struct CsvOptions {
+    char delimiter = ',';       // 区切り文字
+    char quote = '"';           // 引用符（'\0' なら扱わない）
+    bool header = false;        // 先頭行を飛ばす
+    size_t max_errors = 100;    // 記録する誤りの数
+};
+
+        namespace impl {
+
+//==============================================================================
+// 行とフィールドの読み取り位置
+// 区切り文字と改行を find_any_of でまとめて探す
+//==============================================================================
+class CsvCursor {
+    const char* first_;
+    const char* p_;
+    const char* last_;
+    CharSet stops_;
+    char delimiter_;
+    char quote_;
+    bool row_end_;
+
+public:
+
+    // コンストラクタ
+    CsvCursor(string_view text, char delimiter, char quote);
+
+    // 次の行へ進む（空行は飛ばす）
+    // 残りがなければ false
+    bool next_row();
+
+    // 次のフィールド（行が終わっていれば false）
+    // 引用符で囲まれたフィールドは中身を返す（"" は 1 文字に戻さない）
+    bool next_field(string_view& field);
+
+    // 行の残りを読み飛ばし、残っていたフィールドの数を返す
+    size_t skip_row();
+
+    // 先頭からのバイト位置
+    size_t offset(const char* p) const { return p - first_; }
+    size_t offset() const { return p_ - first_; }
+
+};  // class CsvCursor
+
+// 誤りを記録する
+inline void AddError(ParseResult& result, size_t max_errors,
+    size_t row, size_t column, size_t offset, ParseErrorKind kind)
+{
+    ++result.error_count;
+    if (result.errors.size() < max_errors) {
+        ParseError e = { row, column, offset, kind };
+        result.errors.push_back(e);
+    }
+}
+
+// フィールドを数値として読む（前後の空白は除く）
+// 読めなければ false を返し、kind に種類を入れる
+template<class T>
+bool ParseField(string_view field, T& value, ParseErrorKind& kind)
+{
+    const char* last = field.data() + field.size();
+    const char* first = tork::impl::SkipLeadingSpace(field.data(), last);
+    while (last != first && tork::impl::IsSpace(last[-1])) --last;
+    from_chars_result r = tork::impl::ParseNumber(first, last, value);
+    if (r.ec == std::errc::result_out_of_range) {
+        kind = ParseErrorKind::OutOfRange;
+        return false;
+    }
+    if (first == last || r.ec != std::errc() || r.ptr != last) {
+        kind = ParseErrorKind::InvalidValue;
+        return false;
+    }
+    return true;
+}
+
+// 文字列の列はビューをそのまま入れる
+inline bool ParseField(string_view field, string_view& value, ParseErrorKind&)
+{
+    value = field;
+    return true;
+}
+
+// 1 行の各列を読む
+inline void ParseColumns(CsvCursor&, ParseResult&, const CsvOptions&, size_t) { }
+
+template<class T, class A, class... Rest>
+void ParseColumns(CsvCursor& cursor, ParseResult& result, const CsvOptions& options, size_t column,
+    Array<T, A>& values, Rest&... rest)
+{
+    T value = T();
+    string_view field;
+    ParseErrorKind kind;
+    if (!cursor.next_field(field)) {
+        AddError(result, options.max_errors, result.rows, column, cursor.offset(), ParseErrorKind::MissingField);
+    }
+    else if (!ParseField(field, value, kind)) {
+        value = T();
+        AddError(result, options.max_errors, result.rows, column, cursor.offset(field.data()), kind);
+    }
+    else {
+        ++result.values;
+    }
+    values.push_back(value);
+    ParseColumns(cursor, result, options, column + 1, rest...);
+}
+
+        }   // namespace tork::text::impl
+
+// 区切り文字と改行で並んだ数値を values の末尾に読み込む
+// 区切り文字が空白かタブなら、続いた区切り文字は 1 つとみなす
+// 誤りの行は空行を除いた行の番号、列はその行の中の位置
+template<class T, class A>
+ParseResult parse_numbers(string_view text, char delimiter, Array<T, A>& values, size_t max_errors = 100)
+{
+    const bool skip_empty = delimiter == ' ' || delimiter == '\t';
+    impl::CsvCursor cursor(text, delimiter, '\0');
+    ParseResult result;
+    while (cursor.next_row()) {
+        string_view field;
+        size_t column = 0;
+        while (cursor.next_field(field)) {
+            if (skip_empty && field.empty()) continue;
+            T value = T();
+            ParseErrorKind kind;
+            if (!impl::ParseField(field, value, kind)) {
+                value = T();
+                impl::AddError(result, max_errors, result.rows, column, cursor.offset(field.data()), kind);
+            }
+            else {
+                ++result.values;
+            }
+            values.push_back(value);
+            ++column;
+        }
+        ++result.rows;
+    }
+    return result;
+}
+
+// CSV を列ごとの Array の末尾に読み込む
+// 列の型は数値（文字型を除く整数、float、double、bool）か string_view
+// string_view の列は text を指すので、text より長く使わないこと
+template<class... Columns>
+ParseResult parse_csv(string_view text, const CsvOptions& options, Columns&... columns)
+{
+    impl::CsvCursor cursor(text, options.delimiter, options.quote);
+    ParseResult result;
+    if (options.header && cursor.next_row()) cursor.skip_row();
+    while (cursor.next_row()) {
+        impl::ParseColumns(cursor, result, options, 0, columns...);
+        size_t extra = cursor.offset();
+        if (cursor.skip_row() != 0) {
+            impl::AddError(result, options.max_errors, result.rows, sizeof...(Columns), extra,
+                ParseErrorKind::ExtraField);
+        }
+        ++result.rows;
+    }
+    return result;
+}
+
+    }   // namespace tork::text
+
+}   // namespace tork
+
+#endif  // TORK_TEXT_CSV_H_INCLUDED
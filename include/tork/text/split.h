@@ -0,0 +1,235 @@
+﻿//******************************************************************************
+//
+// 文字列の検索と分割
+//
+// 結果はすべて元の文字列へのビューで、コピーもヒープ確保もしない
+//
+//   for (tork::string_view field : tork::text::split(line, ',')) { ... }
+//   for (tork::string_view word : tork::text::tokenize(line, " \t")) { ... }
+//
+//******************************************************************************
+
+#ifndef TORK_TEXT_SPLIT_H_INCLUDED
+#define TORK_TEXT_SPLIT_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include "../string_view.h"
+#include "../text.h"
+
+namespace tork {
+
+    namespace text {
+
+//==============================================================================
+// 文字の集合
+// 8 文字以下なら SIMD で 16 バイトずつ探し、それより多ければ表を引いて探す
+//==============================================================================
+class CharSet {
+public:
+    static const size_t MaxSimdChars = 8;
+
+private:
+    uint32_t table_[8];
+    char chars_[MaxSimdChars];
+    size_t count_;  // 異なる文字の数
+
+public:
+
+    // 空の集合
+    CharSet() :table_(), chars_(), count_(0) { }
+
+    // 1 文字
+    CharSet(char c) :table_(), chars_(), count_(0) { add(c); }
+
+    // 文字列に含まれる文字
+    explicit CharSet(string_view chars) :table_(), chars_(), count_(0)
+    {
+        for (char c : chars) add(c);
+    }
+
+    // 文字を加える
+    void add(char c)
+    {
+        if (contains(c)) return;
+        unsigned char u = static_cast<unsigned char>(c);
+        table_[u >> 5] |= uint32_t(1) << (u & 31);
+        if (count_ < MaxSimdChars) chars_[count_] = c;
+        ++count_;
+    }
+
+    // 含むかどうか
+    bool contains(char c) const
+    {
+        unsigned char u = static_cast<unsigned char>(c);
+        return (table_[u >> 5] >> (u & 31)) & 1;
+    }
+
+    // 文字の数
+    size_t size() const { return count_; }
+
+    // 文字（size() が MaxSimdChars 以下の場合だけ全部入っている）
+    const char* chars() const { return chars_; }
+
+};  // class CharSet
+
+// set のどれかの文字を探し、その位置を返す（なければ string_view::npos）
+size_t find_any_of(string_view s, const CharSet& set, size_t pos = 0);
+
+inline size_t find_any_of(string_view s, string_view chars, size_t pos = 0)
+{
+    return find_any_of(s, CharSet(chars), pos);
+}
+
+//==============================================================================
+// 分割した文字列の範囲
+// 進めるたびに次の区切り文字を探す
+// イテレータは範囲を指すので、範囲より長く持たないこと
+//==============================================================================
+class SplitRange {
+    const char* first_;
+    const char* last_;
+    CharSet delims_;
+    bool skip_empty_;
+
+public:
+
+    //--------------------------------------------------------------------------
+    // イテレータ
+    //--------------------------------------------------------------------------
+    class iterator {
+        const SplitRange* range_ = nullptr;    // nullptr なら終端
+        const char* next_ = nullptr;           // 次を探し始める位置
+        bool done_ = false;                    // 最後のフィールドまで返したか
+        string_view token_;
+
+        friend class SplitRange;
+
+        // 次のフィールドへ
+        void advance()
+        {
+            for (;;) {
+                // 空の string_view() では next_ も nullptr なので、終わりは done_ で判断する
+                if (done_) {
+                    *this = iterator();     // 終端と同じ状態にする
+                    return;
+                }
+                const char* last = range_->last_;
+                size_t n = find_any_of(string_view(next_, last - next_), range_->delims_);
+                if (n == string_view::npos) {
+                    token_ = string_view(next_, last - next_);
+                    next_ = last;
+                    done_ = true;
+                }
+                else {
+                    token_ = string_view(next_, n);
+                    next_ += n + 1;
+                }
+                if (!range_->skip_empty_ || !token_.empty()) return;
+            }
+        }
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef string_view value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const string_view* pointer;
+        typedef const string_view& reference;
+
+        iterator() { }
+
+        reference operator *() const { return token_; }
+        pointer operator ->() const { return &token_; }
+
+        iterator& operator ++()
+        {
+            advance();
+            return *this;
+        }
+        iterator operator ++(int) { iterator t = *this; ++*this; return t; }
+
+        bool operator ==(const iterator& x) const
+        {
+            return range_ == x.range_ && token_.data() == x.token_.data() && next_ == x.next_
+                && done_ == x.done_;
+        }
+        bool operator !=(const iterator& x) const { return !(*this == x); }
+    };
+
+    typedef iterator const_iterator;
+
+    // コンストラクタ
+    // skip_empty なら空のフィールドを飛ばす
+    SplitRange(string_view s, const CharSet& delims, bool skip_empty)
+        :first_(s.data()), last_(s.data() + s.size()), delims_(delims), skip_empty_(skip_empty) { }
+
+    // 先頭
+    iterator begin() const
+    {
+        iterator it;
+        it.range_ = this;
+        it.next_ = first_;
+        it.advance();
+        return it;
+    }
+
+    // 終端
+    iterator end() const { return iterator(); }
+
+};  // class SplitRange
+
+// delim で分割する（空のフィールドも返す）
+// "a,,b" は "a", "", "b"、空文字列は "" を 1 つ
+inline SplitRange split(string_view s, char delim)
+{
+    return SplitRange(s, CharSet(delim), false);
+}
+inline SplitRange split(string_view s, const CharSet& delims)
+{
+    return SplitRange(s, delims, false);
+}
+
+// delims のどれかの文字で区切った語を返す（空の語は飛ばす）
+inline SplitRange tokenize(string_view s, string_view delims)
+{
+    return SplitRange(s, CharSet(delims), true);
+}
+inline SplitRange tokenize(string_view s, const CharSet& delims)
+{
+    return SplitRange(s, delims, true);
+}
+
+// 前後の空白を除く
+inline string_view trim_left(string_view s)
+{
+    size_t i = 0;
+    while (i < s.size() && tork::impl::IsSpace(s[i])) ++i;
+    return s.substr(i);
+}
+inline string_view trim_right(string_view s)
+{
+    size_t n = s.size();
+    while (n > 0 && tork::impl::IsSpace(s[n - 1])) --n;
+    return s.substr(0, n);
+}
+inline string_view trim(string_view s)
+{
+    return trim_right(trim_left(s));
+}
+
+// 前方一致、後方一致
+inline bool starts_with(string_view s, string_view prefix)
+{
+    return s.starts_with(prefix);
+}
+inline bool ends_with(string_view s, string_view suffix)
+{
+    return s.ends_with(suffix);
+}
+
+    }   // namespace tork::text
+
+}   // namespace tork
+
+#endif  // TORK_TEXT_SPLIT_H_INCLUDED
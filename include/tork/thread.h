@@ -0,0 +1,10 @@
+#ifndef TORK_THREAD_H_INCLUDED
+#define TORK_THREAD_H_INCLUDED
+
+#include "thread/SpinLock.h"
+#include "thread/Futex.h"
+#include "thread/SpscRing.h"
+#include "thread/MpmcQueue.h"
+#include "thread/ThreadPool.h"
+
+#endif  // TORK_THREAD_H_INCLUDED
@@ -0,0 +1,101 @@
+﻿//******************************************************************************
+//
+// アドレス待ち（futex）とイベントカウント
+//
+// Windows 8 以降は WaitOnAddress、Linux は futex システムコールを使う
+// どちらも使えない環境では短いスリープを挟んだポーリングになる
+//
+//******************************************************************************
+
+#ifndef TORK_THREAD_FUTEX_H_INCLUDED
+#define TORK_THREAD_FUTEX_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+
+namespace tork {
+
+// キャッシュラインのサイズ（偽共有を避けるための詰め物に使う）
+const size_t CacheLineSize = 64;
+
+// *addr が expected の間スレッドを眠らせる
+// 値が変わっていれば即座に戻る。理由なく起きることもあるので、呼び出し側で条件を確かめ直すこと
+void FutexWait(const std::atomic<unsigned>* addr, unsigned expected);
+
+// addr で待っているスレッドを1つ起こす
+void FutexWakeOne(const std::atomic<unsigned>* addr);
+
+// addr で待っているスレッドを全部起こす
+void FutexWakeAll(const std::atomic<unsigned>* addr);
+
+//==============================================================================
+// イベントカウント
+// ロックフリーなデータ構造に「条件が成り立つまで眠る」機能を後付けする
+//
+//  for (;;) {
+//      if (try_pop(x)) break;
+//      unsigned key = ec.prepare_wait();
+//      if (try_pop(x)) { ec.cancel_wait(); break; }
+//      ec.wait(key);
+//  }
+//
+// 条件を変えた側は notify_one() / notify_all() を呼ぶ
+// 待っているスレッドがいなければ、フェンスと読み込み1回で済む
+//==============================================================================
+class EventCount {
+    std::atomic<unsigned> epoch_;   // 通知のたびに増える
+    std::atomic<unsigned> waiters_; // 待っているスレッド数
+
+public:
+    EventCount() :epoch_(0), waiters_(0) { }
+
+    EventCount(const EventCount&) = delete;
+    EventCount& operator =(const EventCount&) = delete;
+
+    // 待つ準備
+    // この後で条件を確かめ直し、成り立っていなければ wait() する
+    unsigned prepare_wait()
+    {
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return epoch_.load(std::memory_order_acquire);
+    }
+
+    // 待つのをやめる
+    void cancel_wait()
+    {
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // prepare_wait() 以降に通知がなければ眠る
+    void wait(unsigned key)
+    {
+        while (epoch_.load(std::memory_order_acquire) == key) {
+            FutexWait(&epoch_, key);
+        }
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // 1つ起こす
+    void notify_one()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) == 0) return;
+        epoch_.fetch_add(1, std::memory_order_release);
+        FutexWakeOne(&epoch_);
+    }
+
+    // 全部起こす
+    void notify_all()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) == 0) return;
+        epoch_.fetch_add(1, std::memory_order_release);
+        FutexWakeAll(&epoch_);
+    }
+
+};  // class EventCount
+
+}   // namespace tork
+
+#endif  // TORK_THREAD_FUTEX_H_INCLUDED
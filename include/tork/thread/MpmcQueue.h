@@ -0,0 +1,243 @@
+﻿//******************************************************************************
+//
+// 複数生産者・複数消費者の有界キュー
+//
+// スロットごとに通し番号を持たせ、番号を見てそのスロットに書けるか読めるかを判断する
+// 書き込み位置と読み出し位置は CAS で進めるだけなので、ロックを取らない
+//
+//******************************************************************************
+
+#ifndef TORK_THREAD_MPMC_QUEUE_H_INCLUDED
+#define TORK_THREAD_MPMC_QUEUE_H_INCLUDED
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include "Futex.h"
+#include "../memory/allocator.h"
+
+namespace tork {
+
+    namespace impl {
+
+// MpmcQueue のスロット
+// seq == 位置 なら書き込み可、seq == 位置 + 1 なら読み込み可
+template<class T>
+struct MpmcCell {
+    std::atomic<size_t> seq;
+    typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type storage;
+
+    T* get() { return reinterpret_cast<T*>(&storage); }
+};
+
+    }   // namespace tork::impl
+
+//==============================================================================
+// MPMC キュークラス
+// Blocking が true なら、空きや要素を待って眠る push() / pop() が使える
+//==============================================================================
+template<class T, class Allocator = tork::allocator<T>, bool Blocking = false>
+class MpmcQueue {
+public:
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef Allocator allocator_type;
+
+private:
+    typedef impl::MpmcCell<T> Cell;
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Cell> CellAlloc;
+    typedef std::allocator_traits<CellAlloc> CellTraits;
+
+    CellAlloc alloc_;
+    Cell* cells_;
+    size_type mask_;
+    char padding0_[CacheLineSize];
+
+    std::atomic<size_type> enqueue_pos_;
+    char padding1_[CacheLineSize];
+
+    std::atomic<size_type> dequeue_pos_;
+    char padding2_[CacheLineSize];
+
+    EventCount not_empty_;
+    EventCount not_full_;
+
+public:
+
+    // 容量を指定して構築（2 の冪に切り上げる）
+    explicit MpmcQueue(size_type capacity, const Allocator& a = Allocator())
+        :alloc_(a), enqueue_pos_(0), dequeue_pos_(0)
+    {
+        size_type cap = 2;
+        while (cap < capacity) {
+            cap *= 2;
+        }
+        cells_ = CellTraits::allocate(alloc_, cap);
+        if (cells_ == nullptr) throw std::bad_alloc();
+        for (size_type i = 0; i < cap; ++i) {
+            ::new (static_cast<void*>(&cells_[i].seq)) std::atomic<size_type>(i);
+        }
+        mask_ = cap - 1;
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator =(const MpmcQueue&) = delete;
+
+    // デストラクタ
+    // 残っている要素も破棄する
+    ~MpmcQueue()
+    {
+        size_type t = enqueue_pos_.load(std::memory_order_relaxed);
+        for (size_type h = dequeue_pos_.load(std::memory_order_relaxed); h != t; ++h) {
+            cells_[h & mask_].get()->~T();
+        }
+        CellTraits::deallocate(alloc_, cells_, mask_ + 1);
+    }
+
+    // 構築して追加する。満杯なら false
+    // 位置を確保する前に作るので、T のコンストラクタが例外を投げてもキューは壊れない
+    template<class... Args>
+    bool try_emplace(Args&&... args)
+    {
+        T value(std::forward<Args>(args)...);
+        return try_insert(value);
+    }
+
+    // 追加する。満杯なら false
+    // 満杯で追加できなければ value はそのまま残る
+    bool try_push(const T& value)
+    {
+        T copy(value);
+        return try_insert(copy);
+    }
+    bool try_push(T&& value) { return try_insert(value); }
+
+    // 先頭を取り出す。空なら false
+    bool try_pop(T& out)
+    {
+        size_type pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_type seq = cell->seq.load(std::memory_order_acquire);
+            ptrdiff_t diff = static_cast<ptrdiff_t>(seq - (pos + 1));
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                // まだ書き込まれていない
+                return false;
+            }
+            else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        T* p = cell->get();
+        out = std::move(*p);
+        p->~T();
+        // 次の周の書き込み位置として開放する
+        cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+        notify(not_full_);
+        return true;
+    }
+
+    // 空きができるまで待って追加する（Blocking のときだけ）
+    void push(const T& value) { push_wait(value); }
+    void push(T&& value) { push_wait(std::move(value)); }
+
+    // 要素が来るまで待って取り出す（Blocking のときだけ）
+    void pop(T& out)
+    {
+        static_assert(Blocking, "tork::MpmcQueue::pop() requires Blocking = true");
+        while (!try_pop(out)) {
+            unsigned key = not_empty_.prepare_wait();
+            if (try_pop(out)) {
+                not_empty_.cancel_wait();
+                return;
+            }
+            not_empty_.wait(key);
+        }
+    }
+
+    // 要素数（他のスレッドが操作中なら概算）
+    size_type size() const
+    {
+        size_type t = enqueue_pos_.load(std::memory_order_acquire);
+        size_type h = dequeue_pos_.load(std::memory_order_acquire);
+        return t > h ? t - h : 0;
+    }
+
+    // 空かどうか
+    bool empty() const { return size() == 0; }
+
+    // 容量
+    size_type capacity() const { return mask_ + 1; }
+
+private:
+
+    // 位置を確保して value をムーブする。満杯なら false で、value は変えない
+    // 確保したあとに例外が出るとスロットが公開されずにキューが止まるので、ムーブは例外を投げてはいけない
+    bool try_insert(T& value)
+    {
+        static_assert(std::is_nothrow_move_constructible<T>::value,
+            "tork::MpmcQueue requires a nothrow move constructor");
+        size_type pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_type seq = cell->seq.load(std::memory_order_acquire);
+            ptrdiff_t diff = static_cast<ptrdiff_t>(seq - pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                // 1周前の要素がまだ読まれていない
+                return false;
+            }
+            else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        ::new (static_cast<void*>(cell->get())) T(std::move(value));
+        cell->seq.store(pos + 1, std::memory_order_release);
+        notify(not_empty_);
+        return true;
+    }
+
+    // 通知（Blocking でなければ何もしない）
+    void notify(EventCount& ec)
+    {
+        if (Blocking) ec.notify_one();
+    }
+
+    // 空きができるまで待って追加する
+    // const T& で受けたときも、コピーは一度だけ作る
+    void push_wait(const T& value)
+    {
+        T copy(value);
+        push_wait(std::move(copy));
+    }
+    void push_wait(T&& value)
+    {
+        static_assert(Blocking, "tork::MpmcQueue::push() requires Blocking = true");
+        while (!try_insert(value)) {
+            unsigned key = not_full_.prepare_wait();
+            if (try_insert(value)) {
+                not_full_.cancel_wait();
+                return;
+            }
+            not_full_.wait(key);
+        }
+    }
+
+};  // class MpmcQueue
+
+}   // namespace tork
+
+#endif  // TORK_THREAD_MPMC_QUEUE_H_INCLUDED
@@ -0,0 +1,191 @@
+﻿//******************************************************************************
+//
+// スピンロック
+//
+// 保持時間がごく短い排他に使う
+// 長く待つ場合はスレッドを譲るので、ビジーループで CPU を占有し続けることはない
+//
+//******************************************************************************
+
+#ifndef TORK_THREAD_SPIN_LOCK_H_INCLUDED
+#define TORK_THREAD_SPIN_LOCK_H_INCLUDED
+
+#include <atomic>
+#include <thread>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#include <emmintrin.h>
+#define TORK_CPU_RELAX() _mm_pause()
+#else
+#define TORK_CPU_RELAX() ((void)0)
+#endif
+
+namespace tork {
+
+    namespace impl {
+
+// スピン待ちのバックオフ
+// 待つたびに pause の回数を倍にし、上限を超えたらスレッドを譲る
+class SpinWait {
+    unsigned count_ = 0;
+
+public:
+    void wait()
+    {
+        if (count_ < 10) {
+            for (unsigned i = 0; i < (1u << count_); ++i) {
+                TORK_CPU_RELAX();
+            }
+            ++count_;
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+
+    void reset() { count_ = 0; }
+
+    // スピンし尽くしたかどうか（この後の wait() は yield になる）
+    bool exhausted() const { return count_ >= 10; }
+
+};  // class SpinWait
+
+    }   // namespace tork::impl
+
+//==============================================================================
+// スピンロック
+//==============================================================================
+class SpinLock {
+    std::atomic<bool> locked_;
+
+public:
+    SpinLock() :locked_(false) { }
+
+    SpinLock(const SpinLock&) = delete;
+    SpinLock& operator =(const SpinLock&) = delete;
+
+    // ロック
+    void lock()
+    {
+        impl::SpinWait w;
+        for (;;) {
+            if (!locked_.exchange(true, std::memory_order_acquire)) return;
+            // 解放されるまでは読むだけにしてキャッシュラインを奪い合わない
+            while (locked_.load(std::memory_order_relaxed)) {
+                w.wait();
+            }
+        }
+    }
+
+    // ロックを試みる
+    bool try_lock()
+    {
+        return !locked_.load(std::memory_order_relaxed)
+            && !locked_.exchange(true, std::memory_order_acquire);
+    }
+
+    // アンロック
+    void unlock()
+    {
+        locked_.store(false, std::memory_order_release);
+    }
+
+};  // class SpinLock
+
+//==============================================================================
+// 読み書きスピンロック
+// 読み込みは何スレッドでも同時に入れる
+// 書き込み待ちがいる間は新しい読み込みを入れないので、書き込みが飢餓状態にならない
+//==============================================================================
+class RWSpinLock {
+    // ビット0：書き込み中、ビット1：書き込み待ち、ビット2以上：読み込み数
+    static const unsigned Writer = 1;
+    static const unsigned Pending = 2;
+    static const unsigned Reader = 4;
+
+    std::atomic<unsigned> state_;
+
+public:
+    RWSpinLock() :state_(0) { }
+
+    RWSpinLock(const RWSpinLock&) = delete;
+    RWSpinLock& operator =(const RWSpinLock&) = delete;
+
+    // 書き込みロック
+    void lock()
+    {
+        impl::SpinWait w;
+        for (;;) {
+            unsigned s = state_.load(std::memory_order_relaxed);
+            if ((s & ~Pending) == 0) {
+                // 書き込み待ちのビットもここで落とす（他の待ちスレッドは立て直す）
+                if (state_.compare_exchange_weak(s, Writer, std::memory_order_acquire)) {
+                    return;
+                }
+            }
+            else if ((s & Pending) == 0) {
+                state_.fetch_or(Pending, std::memory_order_relaxed);
+            }
+            w.wait();
+        }
+    }
+
+    // 書き込みロックを試みる
+    bool try_lock()
+    {
+        unsigned s = state_.load(std::memory_order_relaxed);
+        return (s & ~Pending) == 0
+            && state_.compare_exchange_strong(s, Writer, std::memory_order_acquire);
+    }
+
+    // 書き込みアンロック
+    void unlock()
+    {
+        state_.fetch_sub(Writer, std::memory_order_release);
+    }
+
+    // 読み込みロック
+    void lock_shared()
+    {
+        impl::SpinWait w;
+        while (!try_lock_shared()) {
+            w.wait();
+        }
+    }
+
+    // 読み込みロックを試みる
+    bool try_lock_shared()
+    {
+        unsigned s = state_.load(std::memory_order_relaxed);
+        return (s & (Writer | Pending)) == 0
+            && state_.compare_exchange_weak(s, s + Reader, std::memory_order_acquire);
+    }
+
+    // 読み込みアンロック
+    void unlock_shared()
+    {
+        state_.fetch_sub(Reader, std::memory_order_release);
+    }
+
+};  // class RWSpinLock
+
+//==============================================================================
+// 読み込みロックのスコープガード
+// lock_shared() / unlock_shared() を持つロックに使う
+//==============================================================================
+template<class Lock>
+class SharedLockGuard {
+    Lock& lock_;
+
+public:
+    explicit SharedLockGuard(Lock& l) :lock_(l) { lock_.lock_shared(); }
+    ~SharedLockGuard() { lock_.unlock_shared(); }
+
+    SharedLockGuard(const SharedLockGuard&) = delete;
+    SharedLockGuard& operator =(const SharedLockGuard&) = delete;
+
+};  // class SharedLockGuard
+
+}   // namespace tork
+
+#endif  // TORK_THREAD_SPIN_LOCK_H_INCLUDED
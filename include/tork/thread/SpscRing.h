@@ -0,0 +1,242 @@
+﻿//******************************************************************************
+//
+// 単一生産者・単一消費者のリングバッファ
+//
+// 書き込むスレッドと読み出すスレッドがそれぞれ1つだけの場合に使う
+// 書き込み位置と読み出し位置は別々のキャッシュラインに置き、
+// 相手の位置はキャッシュしておいて、必要なときだけ読み直す
+//
+//******************************************************************************
+
+#ifndef TORK_THREAD_SPSC_RING_H_INCLUDED
+#define TORK_THREAD_SPSC_RING_H_INCLUDED
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include "Futex.h"
+#include "../memory/allocator.h"
+
+namespace tork {
+
+//==============================================================================
+// SPSC リングバッファクラス
+// Blocking が true なら、空きや要素を待って眠る push() / pop() が使える
+//==============================================================================
+template<class T, class Allocator = tork::allocator<T>, bool Blocking = false>
+class SpscRing {
+public:
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef Allocator allocator_type;
+
+private:
+    typedef std::allocator_traits<Allocator> AllocTraits;
+
+    // 生産者側（書き込み位置と、キャッシュした読み出し位置）
+    std::atomic<size_type> tail_;
+    size_type cached_head_;
+    char padding1_[CacheLineSize];
+
+    // 消費者側（読み出し位置と、キャッシュした書き込み位置）
+    std::atomic<size_type> head_;
+    size_type cached_tail_;
+    char padding2_[CacheLineSize];
+
+    Allocator alloc_;
+    T* buffer_;
+    size_type mask_;
+
+    EventCount not_empty_;
+    EventCount not_full_;
+
+public:
+
+    // 容量を指定して構築（2 の冪に切り上げる）
+    explicit SpscRing(size_type capacity, const Allocator& a = Allocator())
+        :tail_(0), cached_head_(0), head_(0), cached_tail_(0), alloc_(a)
+    {
+        size_type cap = 2;
+        while (cap < capacity) {
+            cap *= 2;
+        }
+        buffer_ = AllocTraits::allocate(alloc_, cap);
+        if (buffer_ == nullptr) throw std::bad_alloc();
+        mask_ = cap - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator =(const SpscRing&) = delete;
+
+    // デストラクタ
+    // 残っている要素も破棄する
+    ~SpscRing()
+    {
+        size_type t = tail_.load(std::memory_order_relaxed);
+        for (size_type h = head_.load(std::memory_order_relaxed); h != t; ++h) {
+            AllocTraits::destroy(alloc_, &buffer_[h & mask_]);
+        }
+        AllocTraits::deallocate(alloc_, buffer_, mask_ + 1);
+    }
+
+    //--------------------------------------------------------------------------
+    // 生産者スレッドから呼ぶもの
+    //--------------------------------------------------------------------------
+
+    // 構築して追加する。満杯なら false
+    template<class... Args>
+    bool try_emplace(Args&&... args)
+    {
+        size_type t = tail_.load(std::memory_order_relaxed);
+        if (free_space(t, 1) == 0) return false;
+        AllocTraits::construct(alloc_, &buffer_[t & mask_], std::forward<Args>(args)...);
+        tail_.store(t + 1, std::memory_order_release);
+        notify(not_empty_);
+        return true;
+    }
+
+    // 追加する。満杯なら false
+    bool try_push(const T& value) { return try_emplace(value); }
+    bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+    // [first, first + n) をまとめて追加する
+    // 追加できた数を返す
+    size_type push_batch(const T* first, size_type n)
+    {
+        size_type t = tail_.load(std::memory_order_relaxed);
+        size_type room = free_space(t, n);
+        if (n > room) n = room;
+        for (size_type i = 0; i < n; ++i) {
+            AllocTraits::construct(alloc_, &buffer_[(t + i) & mask_], first[i]);
+        }
+        if (n) {
+            tail_.store(t + n, std::memory_order_release);
+            notify(not_empty_);
+        }
+        return n;
+    }
+
+    // 空きができるまで待って追加する（Blocking のときだけ）
+    void push(const T& value) { push_wait(value); }
+    void push(T&& value) { push_wait(std::move(value)); }
+
+    //--------------------------------------------------------------------------
+    // 消費者スレッドから呼ぶもの
+    //--------------------------------------------------------------------------
+
+    // 先頭を取り出す。空なら false
+    bool try_pop(T& out)
+    {
+        size_type h = head_.load(std::memory_order_relaxed);
+        if (available(h, 1) == 0) return false;
+        T& slot = buffer_[h & mask_];
+        out = std::move(slot);
+        AllocTraits::destroy(alloc_, &slot);
+        head_.store(h + 1, std::memory_order_release);
+        notify(not_full_);
+        return true;
+    }
+
+    // 最大 n 個をまとめて out に取り出す
+    // 取り出した数を返す
+    size_type pop_batch(T* out, size_type n)
+    {
+        size_type h = head_.load(std::memory_order_relaxed);
+        size_type avail = available(h, n);
+        if (n > avail) n = avail;
+        for (size_type i = 0; i < n; ++i) {
+            T& slot = buffer_[(h + i) & mask_];
+            out[i] = std::move(slot);
+            AllocTraits::destroy(alloc_, &slot);
+        }
+        if (n) {
+            head_.store(h + n, std::memory_order_release);
+            notify(not_full_);
+        }
+        return n;
+    }
+
+    // 要素が来るまで待って取り出す（Blocking のときだけ）
+    void pop(T& out)
+    {
+        static_assert(Blocking, "tork::SpscRing::pop() requires Blocking = true");
+        while (!try_pop(out)) {
+            unsigned key = not_empty_.prepare_wait();
+            if (try_pop(out)) {
+                not_empty_.cancel_wait();
+                return;
+            }
+            not_empty_.wait(key);
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    // どのスレッドから呼んでもよいもの（他のスレッドが操作中なら概算）
+    //--------------------------------------------------------------------------
+
+    // 要素数
+    size_type size() const
+    {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    // 空かどうか
+    bool empty() const { return size() == 0; }
+
+    // 容量
+    size_type capacity() const { return mask_ + 1; }
+
+private:
+
+    // 通知（Blocking でなければ何もしない）
+    void notify(EventCount& ec)
+    {
+        if (Blocking) ec.notify_one();
+    }
+
+    // 生産者から見た空き
+    // want 個に足りないときだけ読み出し位置を読み直す
+    size_type free_space(size_type t, size_type want)
+    {
+        size_type room = capacity() - (t - cached_head_);
+        if (room < want) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            room = capacity() - (t - cached_head_);
+        }
+        return room;
+    }
+
+    // 消費者から見た要素数
+    // want 個に足りないときだけ書き込み位置を読み直す
+    size_type available(size_type h, size_type want)
+    {
+        size_type avail = cached_tail_ - h;
+        if (avail < want) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            avail = cached_tail_ - h;
+        }
+        return avail;
+    }
+
+    // 空きができるまで待って追加する
+    template<class U>
+    void push_wait(U&& value)
+    {
+        static_assert(Blocking, "tork::SpscRing::push() requires Blocking = true");
+        while (!try_push(std::forward<U>(value))) {
+            unsigned key = not_full_.prepare_wait();
+            if (try_push(std::forward<U>(value))) {
+                not_full_.cancel_wait();
+                return;
+            }
+            not_full_.wait(key);
+        }
+    }
+
+};  // class SpscRing
+
+}   // namespace tork
+
+#endif  // TORK_THREAD_SPSC_RING_H_INCLUDED
@@ -0,0 +1,617 @@
+﻿//******************************************************************************
+//
+// ワークスティーリング型のスレッドプール
+//
+// ワーカーごとに Chase-Lev 両端キューを持ち、自分のキューは後入れ先出しで、
+// 仕事がなくなったら他のワーカーからランダムに先入れ側を盗む
+// ワーカー以外のスレッドから投入された仕事は共有キューに入る
+// 仕事のないワーカーは EventCount で眠り、仕事が投入されたときだけ起こされる
+//
+// 待つ側（TaskGroup::wait()、Future::get()）は、ただ眠らずに他の仕事を手伝う
+// そのため、タスクの中で入れ子に fork / join してもデッドロックしない
+//
+//******************************************************************************
+
+#ifndef TORK_THREAD_THREAD_POOL_H_INCLUDED
+#define TORK_THREAD_THREAD_POOL_H_INCLUDED
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <cassert>
+#include "Futex.h"
+#include "SpinLock.h"
+
+namespace tork {
+
+class ThreadPool;
+
+// 呼び出したスレッドを指定したコアに固定する
+// 固定できなかった場合は false を返す
+bool PinThisThread(unsigned core);
+
+    namespace impl {
+
+//==============================================================================
+// スレッドプールで実行するタスク
+// execute() は実行後に自分自身を解放する
+//==============================================================================
+class PoolTask {
+public:
+    virtual ~PoolTask() { }
+    virtual void execute() = 0;
+};
+
+//==============================================================================
+// Chase-Lev 両端キュー
+// push() / pop() は持ち主のスレッドだけが、steal() はどのスレッドからでも呼べる
+// 満杯になったら倍の大きさの配列に移る。古い配列は盗む側がまだ読んでいる
+// かもしれないので、キューを破棄するまで残しておく
+//==============================================================================
+template<class T>
+class WorkStealingDeque {
+    struct Buffer {
+        long long mask;
+        std::atomic<T*>* slots;
+        Buffer* prev;
+
+        explicit Buffer(long long capacity, Buffer* p = nullptr)
+            :mask(capacity - 1), slots(new std::atomic<T*>[static_cast<size_t>(capacity)]), prev(p) { }
+        ~Buffer() { delete[] slots; }
+
+        T* get(long long i) const { return slots[i & mask].load(std::memory_order_relaxed); }
+        void put(long long i, T* x) { slots[i & mask].store(x, std::memory_order_relaxed); }
+    };
+
+    std::atomic<long long> top_;        // 盗む側
+    char padding1_[CacheLineSize];
+    std::atomic<long long> bottom_;     // 持ち主側
+    std::atomic<Buffer*> buffer_;
+    char padding2_[CacheLineSize];
+
+public:
+
+    // コンストラクタ（容量は 2 の冪）
+    explicit WorkStealingDeque(long long capacity = 256)
+        :top_(0), bottom_(0), buffer_(new Buffer(capacity)) { }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator =(const WorkStealingDeque&) = delete;
+
+    // デストラクタ
+    // 残っている要素は解放しない
+    ~WorkStealingDeque()
+    {
+        Buffer* b = buffer_.load(std::memory_order_relaxed);
+        while (b) {
+            Buffer* prev = b->prev;
+            delete b;
+            b = prev;
+        }
+    }
+
+    // おおよその要素数
+    size_t size() const
+    {
+        long long b = bottom_.load(std::memory_order_relaxed);
+        long long t = top_.load(std::memory_order_relaxed);
+        return (b > t) ? static_cast<size_t>(b - t) : 0;
+    }
+
+    // 空かどうか（おおよそ）
+    bool empty() const { return size() == 0; }
+
+    // 持ち主側に積む
+    void push(T* x)
+    {
+        long long b = bottom_.load(std::memory_order_relaxed);
+        long long t = top_.load(std::memory_order_acquire);
+        Buffer* a = buffer_.load(std::memory_order_relaxed);
+        if (b - t > a->mask) {
+            a = grow(a, b, t);
+        }
+        a->put(b, x);
+        bottom_.store(b + 1, std::memory_order_release);
+    }
+
+    // 持ち主側から取り出す（なければ nullptr）
+    T* pop()
+    {
+        long long b = bottom_.load(std::memory_order_relaxed) - 1;
+        Buffer* a = buffer_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long long t = top_.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // 空だった
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        T* x = a->get(b);
+        if (t == b) {
+            // 最後の1つは盗む側と取り合う
+            if (!top_.compare_exchange_strong(t, t + 1,
+                    std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                x = nullptr;
+            }
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return x;
+    }
+
+    // 反対側から盗む（なければ、または取り合いに負けたら nullptr）
+    T* steal()
+    {
+        long long t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long long b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) return nullptr;
+
+        Buffer* a = buffer_.load(std::memory_order_acquire);
+        T* x = a->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1,
+                std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return x;
+    }
+
+private:
+
+    // 配列を倍にする
+    Buffer* grow(Buffer* a, long long b, long long t)
+    {
+        Buffer* n = new Buffer((a->mask + 1) * 2, a);
+        for (long long i = t; i < b; ++i) {
+            n->put(i, a->get(i));
+        }
+        buffer_.store(n, std::memory_order_release);
+        return n;
+    }
+
+};  // class WorkStealingDeque
+
+//==============================================================================
+// Future の共有状態
+// 状態語は 完了ビット | 待機ビット で、待つ側はこの語の上で眠る
+//==============================================================================
+template<class T>
+struct FutureValue {
+    typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type storage;
+
+    template<class F>
+    void set(F& f) { new (&storage) T(f()); }
+    T take()
+    {
+        T* p = reinterpret_cast<T*>(&storage);
+        T v(std::move(*p));
+        p->~T();
+        return v;
+    }
+    void destroy() { reinterpret_cast<T*>(&storage)->~T(); }
+};
+
+template<>
+struct FutureValue<void> {
+    template<class F>
+    void set(F& f) { f(); }
+    void take() { }
+    void destroy() { }
+};
+
+template<class T>
+class FutureState {
+public:
+    static const unsigned Ready = 1;
+    static const unsigned Waiting = 2;
+
+    std::atomic<unsigned> state_;
+    std::atomic<int> refs_;
+    bool has_value_ = false;
+    FutureValue<T> value_;
+    std::exception_ptr error_;
+
+    FutureState() :state_(0), refs_(2) { }
+
+    virtual ~FutureState()
+    {
+        if (has_value_) value_.destroy();
+    }
+
+    // 参照を手放す
+    void release()
+    {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    // 完了したかどうか
+    bool ready() const { return (state_.load(std::memory_order_acquire) & Ready) != 0; }
+
+    // 完了を通知する
+    void complete()
+    {
+        unsigned prev = state_.fetch_or(Ready, std::memory_order_acq_rel);
+        if (prev & Waiting) {
+            FutexWakeAll(&state_);
+        }
+    }
+
+    // 完了するまで眠る
+    void sleep()
+    {
+        unsigned s = state_.fetch_or(Waiting, std::memory_order_acq_rel) | Waiting;
+        while ((s & Ready) == 0) {
+            FutexWait(&state_, s);
+            s = state_.load(std::memory_order_acquire);
+        }
+    }
+};
+
+// submit() で作られるタスク（共有状態と一体）
+template<class T, class F>
+class SubmitTask : public PoolTask, public FutureState<T> {
+    F func_;
+
+public:
+    explicit SubmitTask(F&& f) :func_(std::move(f)) { }
+
+    void execute() override
+    {
+        try {
+            this->value_.set(func_);
+            this->has_value_ = !std::is_void<T>::value;
+        }
+        catch (...) {
+            this->error_ = std::current_exception();
+        }
+        this->complete();
+        this->release();
+    }
+};
+
+    }   // namespace tork::impl
+
+//==============================================================================
+// スレッドプールの結果を受け取る Future
+// コピーはできない。get() は1回だけ呼べる
+//==============================================================================
+template<class T>
+class Future {
+    ThreadPool* pool_ = nullptr;
+    impl::FutureState<T>* state_ = nullptr;
+
+public:
+
+    // デフォルトコンストラクタ
+    Future() { }
+
+    // 共有状態から構築（ThreadPool から使う）
+    Future(ThreadPool* pool, impl::FutureState<T>* state) :pool_(pool), state_(state) { }
+
+    // ムーブコンストラクタ
+    Future(Future&& other) :pool_(other.pool_), state_(other.state_)
+    {
+        other.state_ = nullptr;
+    }
+
+    // ムーブ代入
+    Future& operator =(Future&& other)
+    {
+        if (this != &other) {
+            if (state_) state_->release();
+            pool_ = other.pool_;
+            state_ = other.state_;
+            other.state_ = nullptr;
+        }
+        return *this;
+    }
+
+    Future(const Future&) = delete;
+    Future& operator =(const Future&) = delete;
+
+    // デストラクタ
+    // 完了を待たずに手放す
+    ~Future()
+    {
+        if (state_) state_->release();
+    }
+
+    // 結果を持っているかどうか
+    bool valid() const { return state_ != nullptr; }
+
+    // 完了したかどうか
+    bool is_ready() const
+    {
+        assert(valid());
+        return state_->ready();
+    }
+
+    // 完了を待つ（他のタスクを手伝いながら）
+    void wait() const;
+
+    // 結果を取り出す
+    // タスクが例外を投げていたら、ここで投げ直す
+    T get()
+    {
+        wait();
+        impl::FutureState<T>* s = state_;
+        state_ = nullptr;
+        struct Releaser {
+            impl::FutureState<T>* s;
+            ~Releaser() { s->release(); }
+        } releaser = { s };
+        if (s->error_) std::rethrow_exception(s->error_);
+        s->has_value_ = false;
+        return s->value_.take();
+    }
+
+};  // class Future
+
+//==============================================================================
+// タスクグループ
+// run() で投入したタスクがすべて終わるまで wait() で待つ
+// タスクが投げた例外は、最初の1つを wait() で投げ直す
+//==============================================================================
+class TaskGroup {
+    static const unsigned Waiting = 0x80000000u;
+
+    ThreadPool& pool_;
+    std::atomic<unsigned> pending_;     // 未完了の数 | 待機ビット
+    SpinLock error_lock_;
+    std::exception_ptr error_;
+
+    template<class F>
+    class GroupTask : public impl::PoolTask {
+        TaskGroup* group_;
+        F func_;
+
+    public:
+        GroupTask(TaskGroup* g, F&& f) :group_(g), func_(std::move(f)) { }
+
+        void execute() override
+        {
+            TaskGroup* g = group_;
+            try {
+                func_();
+            }
+            catch (...) {
+                g->set_error(std::current_exception());
+            }
+            delete this;
+            g->finish();
+        }
+    };
+
+public:
+
+    // コンストラクタ
+    explicit TaskGroup(ThreadPool& pool) :pool_(pool), pending_(0) { }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator =(const TaskGroup&) = delete;
+
+    // デストラクタ
+    // 残っているタスクの完了を待つ（例外は捨てる）
+    ~TaskGroup()
+    {
+        wait_all();
+    }
+
+    // プール
+    ThreadPool& pool() const { return pool_; }
+
+    // タスクを投入
+    template<class F>
+    void run(F f);
+
+    // すべてのタスクの完了を待つ
+    void wait()
+    {
+        wait_all();
+        std::exception_ptr e;
+        {
+            std::lock_guard<SpinLock> lock(error_lock_);
+            e = error_;
+            error_ = nullptr;
+        }
+        if (e) std::rethrow_exception(e);
+    }
+
+    // 未完了のタスクがないかどうか
+    bool done() const { return (pending_.load(std::memory_order_acquire) & ~Waiting) == 0; }
+
+private:
+
+    // 例外を記録
+    void set_error(std::exception_ptr e)
+    {
+        std::lock_guard<SpinLock> lock(error_lock_);
+        if (!error_) error_ = e;
+    }
+
+    // タスクが1つ終わった
+    // 0 になった後は this に触れず、アドレスで起こすだけにする
+    void finish()
+    {
+        unsigned prev = pending_.fetch_sub(1, std::memory_order_acq_rel);
+        if (prev == (Waiting | 1)) {
+            FutexWakeAll(&pending_);
+        }
+    }
+
+    // 完了するまで眠る
+    void sleep()
+    {
+        unsigned s = pending_.fetch_or(Waiting, std::memory_order_acq_rel) | Waiting;
+        while (s != Waiting) {
+            FutexWait(&pending_, s);
+            s = pending_.load(std::memory_order_acquire);
+        }
+        pending_.store(0, std::memory_order_relaxed);
+    }
+
+    void wait_all();
+
+};  // class TaskGroup
+
+//==============================================================================
+// スレッドプール
+//==============================================================================
+class ThreadPool {
+    struct Worker;
+
+    std::unique_ptr<Worker[]> workers_;
+    unsigned thread_count_;
+    bool pin_threads_;
+
+    // ワーカー以外から投入された仕事
+    SpinLock inject_lock_;
+    std::vector<impl::PoolTask*> inject_;
+    size_t inject_head_ = 0;
+    std::atomic<size_t> inject_count_;
+
+    EventCount idle_;
+    std::atomic<bool> stop_;
+
+public:
+
+    // コンストラクタ
+    // thread_count が 0 ならハードウェアスレッド数
+    // pin_threads が true ならワーカー i をコア i に固定する
+    explicit ThreadPool(unsigned thread_count = 0, bool pin_threads = false);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator =(const ThreadPool&) = delete;
+
+    // デストラクタ
+    // 投入済みの仕事をすべて処理してからワーカーを止める
+    ~ThreadPool();
+
+    // ワーカー数
+    unsigned thread_count() const { return thread_count_; }
+
+    // 呼び出したスレッドがこのプールのワーカーなら、その番号（違えば -1）
+    int current_index() const;
+
+    // 関数を投入して Future を受け取る
+    template<class F>
+    Future<typename std::result_of<F()>::type> submit(F f)
+    {
+        typedef typename std::result_of<F()>::type R;
+        auto task = new impl::SubmitTask<R, F>(std::move(f));
+        schedule(task);
+        return Future<R>(this, task);
+    }
+
+    // [first, last) の各 i について f(i) を並列に呼ぶ
+    // 自分のキューが空のときだけ範囲を半分に割って残りを盗める形で積む（遅延二分割）
+    // grain は割らずに処理する最小の個数。0 なら範囲とワーカー数から決める
+    template<class Index, class F>
+    void parallel_for(Index first, Index last, F f, size_t grain = 0)
+    {
+        if (!(first < last)) return;
+        size_t n = static_cast<size_t>(last - first);
+        if (grain == 0) {
+            grain = n / (8 * static_cast<size_t>(thread_count_));
+            if (grain == 0) grain = 1;
+        }
+        TaskGroup group(*this);
+        for_range(group, first, last, f, grain);
+        group.wait();
+    }
+
+    // 仕事を1つ実行する（なければ false）
+    // 待っているスレッドが他のタスクを手伝うのに使う
+    bool run_one();
+
+    // タスクを積む（TaskGroup などから使う）
+    void schedule(impl::PoolTask* task);
+
+    // 範囲を割るべきかどうか
+    bool should_split() const;
+
+private:
+
+    template<class Index, class F>
+    void for_range(TaskGroup& group, Index first, Index last, const F& f, size_t grain)
+    {
+        while (first < last) {
+            size_t n = static_cast<size_t>(last - first);
+            if (n > grain && should_split()) {
+                Index mid = first + static_cast<Index>(n / 2);
+                Index end = last;
+                group.run([this, &group, &f, mid, end, grain]() {
+                    for_range(group, mid, end, f, grain);
+                });
+                last = mid;
+                continue;
+            }
+            Index stop = (n > grain) ? first + static_cast<Index>(grain) : last;
+            for (; first < stop; ++first) {
+                f(first);
+            }
+        }
+    }
+
+    impl::PoolTask* find_task(unsigned index);
+    impl::PoolTask* take_injected();
+    impl::PoolTask* steal_any(unsigned& seed, unsigned self);
+    bool has_work() const;
+    void worker_main(unsigned index);
+
+};  // class ThreadPool
+
+// タスクを投入
+template<class F>
+void TaskGroup::run(F f)
+{
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    pool_.schedule(new GroupTask<F>(this, std::move(f)));
+}
+
+// 完了を待つ（手伝いながら、仕事がなければ眠る）
+inline void TaskGroup::wait_all()
+{
+    while (!done()) {
+        if (pool_.run_one()) continue;
+        impl::SpinWait spin;
+        while (!done() && !spin.exhausted()) {
+            spin.wait();
+        }
+        if (!done() && !pool_.run_one()) {
+            sleep();
+            break;
+        }
+    }
+}
+
+// 完了を待つ（手伝いながら、仕事がなければ眠る）
+template<class T>
+void Future<T>::wait() const
+{
+    assert(valid());
+    while (!state_->ready()) {
+        if (pool_->run_one()) continue;
+        impl::SpinWait spin;
+        while (!state_->ready() && !spin.exhausted()) {
+            spin.wait();
+        }
+        if (!state_->ready() && !pool_->run_one()) {
+            state_->sleep();
+            break;
+        }
+    }
+}
+
+}   // namespace tork
+
+#endif  // TORK_THREAD_THREAD_POOL_H_INCLUDED
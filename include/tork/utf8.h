@@ -0,0 +1,53 @@
+﻿//******************************************************************************
+//
+// UTF-8 の検証と文字数の計算
+//
+// 実行時に CPU を調べ、AVX2、SSE2、バイト単位の順に使える実装を選ぶ
+//
+//******************************************************************************
+
+#ifndef TORK_UTF8_H_INCLUDED
+#define TORK_UTF8_H_INCLUDED
+
+#include <cstddef>
+#include "span.h"
+
+namespace tork {
+
+    namespace utf8 {
+
+        namespace impl {
+
+// 命令セット
+enum class SimdLevel {
+    Scalar,     // バイト単位
+    Sse2,       // ASCII の並びを 16 バイトずつ読み飛ばす
+    Avx2,       // 32 バイトずつ検証する
+};
+
+// この CPU で使える最上位の命令セット
+SimdLevel DetectSimdLevel();
+
+// 命令セットを指定した実装（テストとベンチマーク用）
+// 使えない命令セットを指定した場合は、使える中で最上位のものになる
+size_t FindInvalid(const char* s, size_t n, SimdLevel level);
+size_t CountCodePoints(const char* s, size_t n, SimdLevel level);
+
+        }   // namespace tork::utf8::impl
+
+// 最初の不正なシーケンスの位置（すべて正しければ s.size()）
+// 途中で切れたシーケンスは、その先頭の位置を返す
+size_t find_invalid(span<const char> s);
+
+// 正しい UTF-8 かどうか
+bool validate(span<const char> s);
+
+// コードポイントの数
+// 継続バイト（10xxxxxx）以外のバイトを数えるので、正しい UTF-8 であること
+size_t count_code_points(span<const char> s);
+
+    }   // namespace tork::utf8
+
+}   // namespace tork
+
+#endif  // TORK_UTF8_H_INCLUDED
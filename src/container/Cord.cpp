@@ -0,0 +1,434 @@
+﻿//******************************************************************************
+//
+// コード（大きな文字列を組み立てるためのロープ）
+//
+//******************************************************************************
+
+#include <tork/container/Cord.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace tork {
+
+    namespace impl {
+
+// 作成（参照カウントは 1）
+CordFlat* CordFlat::create(size_t capacity)
+{
+    void* p = ::operator new(sizeof(CordFlat) + capacity);
+    return new (p) CordFlat(capacity);
+}
+
+// 範囲の節を手放す
+CordList::~CordList()
+{
+    for (auto& piece : pieces) piece.node->release();
+}
+
+// 破棄
+void CordNode::destroy(CordNode* node)
+{
+    if (node->is_flat) {
+        CordFlat* flat = static_cast<CordFlat*>(node);
+        flat->~CordFlat();
+        ::operator delete(flat);
+    }
+    else {
+        delete static_cast<CordList*>(node);
+    }
+}
+
+    }   // namespace tork::impl
+
+namespace {
+
+    using tork::impl::CordNode;
+    using tork::impl::CordFlat;
+    using tork::impl::CordList;
+    using tork::impl::CordPiece;
+
+    // List の [offset, offset + length) にある Flat の範囲ごとに f(piece) を呼ぶ
+    template<class F>
+    void ForEachLeaf(const CordList* list, size_t offset, size_t length, F& f)
+    {
+        for (auto& p : list->pieces) {
+            if (length == 0) break;
+            if (offset >= p.length) {
+                offset -= p.length;
+                continue;
+            }
+            size_t off = p.offset + offset;
+            size_t len = min(p.length - offset, length);
+            offset = 0;
+            length -= len;
+            if (p.node->is_flat) {
+                CordPiece leaf = { p.node, off, len };
+                f(leaf);
+            }
+            else {
+                ForEachLeaf(static_cast<const CordList*>(p.node), off, len, f);
+            }
+        }
+    }
+
+    // 範囲を追加（参照は呼び出し側が増やしておく）
+    void AddPiece(CordList* list, const CordPiece& p)
+    {
+        list->pieces.push_back(p);
+        list->length += p.length;
+        if (!p.node->is_flat && p.node->depth + 1 > list->depth) {
+            list->depth = static_cast<unsigned char>(p.node->depth + 1);
+        }
+    }
+
+    // 根ごと共有せずに範囲を写す List の大きさ
+    const size_t SpliceLimit = 8;
+
+}   // anonymous namespace
+
+
+//------------------------------------------------------------------------------
+// Cord
+
+// 変更してよい根を返す（共有していれば作り直す）
+Cord::List* Cord::mutable_root()
+{
+    if (root_ == nullptr) {
+        root_ = new List();
+        return root_;
+    }
+    if (root_->is_unique()) return root_;
+
+    // 範囲が少なければ写す
+    // 多ければ末尾の範囲を除いた古い根をひとつの範囲としてつなぎ、末尾の範囲だけ写す
+    // 末尾の Flat はそのまま伸ばせて、次にまた共有されても範囲が少ないので写すだけで済む
+    List* r = new List();
+    if (root_->pieces.size() <= SpliceLimit) {
+        r->pieces.reserve(root_->pieces.size() + 1);
+        for (auto& p : root_->pieces) {
+            p.node->add_ref();
+            AddPiece(r, p);
+        }
+        root_->release();
+    }
+    else {
+        const Piece& last = root_->pieces.back();
+        Piece head = { root_, 0, root_->length - last.length };
+        AddPiece(r, head);  // 古い根の参照はそのまま head に移す
+        last.node->add_ref();
+        AddPiece(r, last);
+    }
+    root_ = r;
+    if (root_->depth > MaxDepth) rebuild();
+    return root_;
+}
+
+// 入れ子をなくして並べ直す
+void Cord::rebuild()
+{
+    List* r = new List();
+    auto f = [r](const Piece& p) {
+        // 同じ Flat の続いた範囲はまとめる
+        if (!r->pieces.empty()) {
+            Piece& last = r->pieces.back();
+            if (last.node == p.node && last.offset + last.length == p.offset) {
+                last.length += p.length;
+                r->length += p.length;
+                return;
+            }
+        }
+        p.node->add_ref();
+        AddPiece(r, p);
+    };
+    ForEachLeaf(root_, 0, root_->length, f);
+    root_->release();
+    root_ = r;
+}
+
+// 末尾に追加
+void Cord::append(const char* s, size_type n)
+{
+    if (n == 0) return;
+    bool shared = root_ && !root_->is_unique();
+    List* r = mutable_root();
+
+    // 最後の Flat の空きを確保できれば、そこに書く
+    size_t tail_capacity = 0;
+    if (!r->pieces.empty()) {
+        Piece& last = r->pieces.back();
+        if (last.node->is_flat) {
+            Flat* flat = static_cast<Flat*>(last.node);
+            tail_capacity = flat->capacity;
+            size_t end = last.offset + last.length;
+            size_t k = flat->claim(end, n);
+            memcpy(flat->data + end, s, k);
+            last.length += k;
+            r->length += k;
+            s += k;
+            n -= k;
+            if (n == 0) return;
+        }
+    }
+
+    // 新しい Flat を作る（コードが長くなるほど大きくする）
+    // 共有を外したばかりなら、コピーを取りながら少しずつ追加しているかもしれないので、
+    // 使われないまま残る空きが大きくならないように、前の Flat の倍までにとどめる
+    size_t capacity = r->length < MinFlatSize ? MinFlatSize
+        : (r->length < MaxFlatSize ? r->length : MaxFlatSize);
+    if (shared) {
+        size_t grown = tail_capacity * 2 < MinFlatSize ? MinFlatSize : tail_capacity * 2;
+        if (grown < capacity) capacity = grown;
+    }
+    if (capacity < n) capacity = n;
+    Flat* flat = Flat::create(capacity);
+    memcpy(flat->data, s, n);
+    flat->used.store(n, memory_order_relaxed);
+    Piece p = { flat, 0, n };
+    AddPiece(r, p);
+}
+
+// 末尾にコードを追加
+void Cord::append(const Cord& other)
+{
+    if (other.empty()) return;
+
+    // 短ければコピー
+    if (other.size() <= CopyThreshold) {
+        Cord keep(other);   // other が自分自身でも読めるようにしておく
+        for (string_view s : keep.chunks()) append(s.data(), s.size());
+        return;
+    }
+
+    List* o = other.root_;
+    o->add_ref();
+    List* r = mutable_root();
+    if (o->pieces.size() <= SpliceLimit) {
+        for (auto& p : o->pieces) {
+            p.node->add_ref();
+            AddPiece(r, p);
+        }
+        o->release();
+    }
+    else {
+        Piece p = { o, 0, o->length };
+        AddPiece(r, p);
+    }
+    if (r->depth > MaxDepth) rebuild();
+}
+
+// 部分コード
+Cord Cord::substr(size_type pos, size_type n) const
+{
+    size_type sz = size();
+    if (pos > sz) throw std::out_of_range("out of range at tork::Cord");
+    if (n > sz - pos) n = sz - pos;
+
+    Cord r;
+    if (n == 0) return r;
+    if (pos == 0 && n == sz) return *this;
+
+    // 短ければコピー、そうでなければ元の根の範囲として参照する
+    if (n <= CopyThreshold) {
+        string buf(n, '\0');
+        size_t off = pos;
+        size_t len = n;
+        char* out = &buf[0];
+        auto f = [&out](const Piece& p) {
+            memcpy(out, static_cast<const Flat*>(p.node)->data + p.offset, p.length);
+            out += p.length;
+        };
+        ForEachLeaf(root_, off, len, f);
+        r.append(buf.data(), buf.size());
+        return r;
+    }
+    r.root_ = new List();
+    root_->add_ref();
+    Piece p = { root_, pos, n };
+    AddPiece(r.root_, p);
+    if (r.root_->depth > MaxDepth) r.rebuild();
+    return r;
+}
+
+// チャンクの数
+Cord::size_type Cord::chunk_count() const
+{
+    size_type n = 0;
+    for_each_chunk([&n](string_view) { ++n; });
+    return n;
+}
+
+// ひとつのチャンクにまとめる
+string_view Cord::flatten()
+{
+    if (root_ == nullptr) return string_view();
+    if (!is_flat()) {
+        Flat* flat = Flat::create(root_->length);
+        copy_to(flat->data);
+        flat->used.store(root_->length, memory_order_relaxed);
+        List* r = new List();
+        Piece p = { flat, 0, root_->length };
+        AddPiece(r, p);
+        root_->release();
+        root_ = r;
+    }
+    const Piece& p = root_->pieces[0];
+    return string_view(static_cast<const Flat*>(p.node)->data + p.offset, p.length);
+}
+
+// out に全体をコピー
+char* Cord::copy_to(char* out) const
+{
+    for (string_view s : chunks()) {
+        memcpy(out, s.data(), s.size());
+        out += s.size();
+    }
+    return out;
+}
+
+// std::string にコピー
+string Cord::str() const
+{
+    string s(size(), '\0');
+    if (!s.empty()) copy_to(&s[0]);
+    return s;
+}
+
+// ファイルディスクリプタに書き出す
+void Cord::write_to(int fd) const
+{
+#ifdef _WIN32
+    // writev がないので、チャンクごとに _write する
+    for (string_view s : chunks()) {
+        const char* p = s.data();
+        size_t n = s.size();
+        while (n > 0) {
+            unsigned int k = static_cast<unsigned int>(min<size_t>(n, INT_MAX));
+            int w = ::_write(fd, p, k);
+            if (w < 0) throw system_error(errno, generic_category(), "tork::Cord::write_to");
+            p += w;
+            n -= static_cast<size_t>(w);
+        }
+    }
+#else
+    // BatchSize 個ずつ writev し、途中までしか書けなければ残りから続ける
+    const int BatchSize = 64;
+    iovec iov[BatchSize];
+    int count = 0;
+
+    auto flush = [&iov, &count, fd]() {
+        iovec* v = iov;
+        int n = count;
+        while (n > 0) {
+            ssize_t w = ::writev(fd, v, n);
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                throw system_error(errno, generic_category(), "tork::Cord::write_to");
+            }
+            size_t done = static_cast<size_t>(w);
+            while (n > 0 && done >= v->iov_len) {
+                done -= v->iov_len;
+                ++v;
+                --n;
+            }
+            if (n > 0) {
+                v->iov_base = static_cast<char*>(v->iov_base) + done;
+                v->iov_len -= done;
+            }
+        }
+        count = 0;
+    };
+
+    for (string_view s : chunks()) {
+        iov[count].iov_base = const_cast<char*>(s.data());
+        iov[count].iov_len = s.size();
+        if (++count == BatchSize) flush();
+    }
+    flush();
+#endif
+}
+
+// 比較
+int Cord::compare(const Cord& other) const
+{
+    chunk_iterator i(root_), j(other.root_), e;
+    string_view a, b;
+    for (;;) {
+        if (a.empty()) {
+            if (i == e) break;
+            a = *i++;
+        }
+        if (b.empty()) {
+            if (j == e) break;
+            b = *j++;
+        }
+        size_t n = min(a.size(), b.size());
+        int c = memcmp(a.data(), b.data(), n);
+        if (c != 0) return c;
+        a.remove_prefix(n);
+        b.remove_prefix(n);
+    }
+    size_type x = size();
+    size_type y = other.size();
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+int Cord::compare(string_view s) const
+{
+    size_t pos = 0;
+    for (string_view a : chunks()) {
+        size_t n = min(a.size(), s.size() - pos);
+        int c = memcmp(a.data(), s.data() + pos, n);
+        if (c != 0) return c;
+        pos += n;
+        if (n < a.size()) return 1;
+    }
+    return pos < s.size() ? -1 : 0;
+}
+
+
+//------------------------------------------------------------------------------
+// Cord::chunk_iterator
+
+// 次のチャンクへ
+void Cord::chunk_iterator::advance()
+{
+    while (top_ >= 0) {
+        Frame& fr = stack_[top_];
+        if (fr.remain == 0 || fr.index == fr.list->pieces.size()) {
+            --top_;
+            continue;
+        }
+        const Piece& p = fr.list->pieces[fr.index++];
+        if (fr.skip >= p.length) {
+            fr.skip -= p.length;
+            continue;
+        }
+        size_t off = p.offset + fr.skip;
+        size_t len = min(p.length - fr.skip, fr.remain);
+        fr.skip = 0;
+        fr.remain -= len;
+        if (p.node->is_flat) {
+            current_ = string_view(static_cast<const Flat*>(p.node)->data + off, len);
+            return;
+        }
+        // 根の深さは MaxDepth 以下なので、stack_ はあふれない
+        Frame child = { static_cast<const List*>(p.node), 0, off, len };
+        stack_[++top_] = child;
+    }
+    current_ = string_view();
+}
+
+}   // namespace tork
@@ -0,0 +1,350 @@
+﻿//******************************************************************************
+//
+// 可変長ビット集合
+//
+//******************************************************************************
+
+#include <tork/container/DynamicBitset.h>
+#include <tork/bits.h>
+#include <algorithm>
+
+using namespace std;
+
+namespace tork {
+
+namespace {
+
+    typedef DynamicBitset::word_type Word;
+
+    size_t WordsFor(size_t bits)
+    {
+        return (bits + DynamicBitset::bits_per_word - 1) / DynamicBitset::bits_per_word;
+    }
+
+    // ワード列どうしの演算
+    // SSE2 が使えれば 2 ワードずつ処理する
+    enum class BitOp { And, Or, Xor, AndNot };
+
+    template<BitOp Op>
+    Word Apply(Word a, Word b)
+    {
+        switch (Op) {
+        case BitOp::And: return a & b;
+        case BitOp::Or: return a | b;
+        case BitOp::Xor: return a ^ b;
+        default: return a & ~b;
+        }
+    }
+
+#ifdef TORK_HAS_SSE2
+    template<BitOp Op>
+    __m128i Apply(__m128i a, __m128i b)
+    {
+        switch (Op) {
+        case BitOp::And: return _mm_and_si128(a, b);
+        case BitOp::Or: return _mm_or_si128(a, b);
+        case BitOp::Xor: return _mm_xor_si128(a, b);
+        default: return _mm_andnot_si128(b, a);
+        }
+    }
+#endif
+
+    template<BitOp Op>
+    void ApplyWords(Word* dst, const Word* src, size_t n)
+    {
+        size_t i = 0;
+#ifdef TORK_HAS_SSE2
+        for (; i + 2 <= n; i += 2) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), Apply<Op>(a, b));
+        }
+#endif
+        for (; i < n; ++i) {
+            dst[i] = Apply<Op>(dst[i], src[i]);
+        }
+    }
+
+    // ワード内で k 番目（0 から）の立っているビットの位置
+    unsigned SelectInWord(Word x, unsigned k)
+    {
+        for (unsigned j = 0; j < k; ++j) {
+            x &= x - 1;
+        }
+        return impl::CountTrailingZeros64(x);
+    }
+
+}   // anonymous namespace
+
+const DynamicBitset::size_type DynamicBitset::npos;
+const DynamicBitset::size_type DynamicBitset::bits_per_word;
+
+// ビット数と初期値
+DynamicBitset::DynamicBitset(size_type n, bool value)
+    :words_(WordsFor(n), value ? ~Word(0) : Word(0)), size_(n)
+{
+    trim();
+}
+
+// '0' と '1' の文字列（先頭がビット 0）
+DynamicBitset::DynamicBitset(const string& s)
+    :words_(WordsFor(s.size()), Word(0)), size_(s.size())
+{
+    for (size_type i = 0; i < s.size(); ++i) {
+        if (s[i] == '1') set(i);
+        else if (s[i] != '0') throw invalid_argument("invalid character at tork::DynamicBitset");
+    }
+}
+
+// ビット数の変更（増えた分は value）
+void DynamicBitset::resize(size_type n, bool value)
+{
+    size_type old = size_;
+    words_.resize(WordsFor(n), value ? ~Word(0) : Word(0));
+    size_ = n;
+    if (value && n > old && old % bits_per_word != 0) {
+        // 元の最後のワードの空きを埋める
+        words_[old / bits_per_word] |= ~Word(0) << (old % bits_per_word);
+    }
+    trim();
+}
+
+// 全ビットの削除
+void DynamicBitset::clear()
+{
+    words_.clear();
+    size_ = 0;
+}
+
+// 末尾にビットを追加
+void DynamicBitset::push_back(bool value)
+{
+    if (size_ % bits_per_word == 0) {
+        words_.push_back(0);
+    }
+    ++size_;
+    if (value) set(size_ - 1);
+}
+
+// 全ビットを立てる
+DynamicBitset& DynamicBitset::set()
+{
+    fill(words_.begin(), words_.end(), ~Word(0));
+    trim();
+    return *this;
+}
+
+// 全ビットを落とす
+DynamicBitset& DynamicBitset::reset()
+{
+    fill(words_.begin(), words_.end(), Word(0));
+    return *this;
+}
+
+// 全ビットを反転する
+DynamicBitset& DynamicBitset::flip()
+{
+    for (auto& w : words_) {
+        w = ~w;
+    }
+    trim();
+    return *this;
+}
+
+// 立っているビットの数
+DynamicBitset::size_type DynamicBitset::count() const
+{
+    size_type n = 0;
+    for (Word w : words_) {
+        n += impl::PopCount64(w);
+    }
+    return n;
+}
+
+// どれか立っているか
+bool DynamicBitset::any() const
+{
+    for (Word w : words_) {
+        if (w) return true;
+    }
+    return false;
+}
+
+// 全部立っているか
+bool DynamicBitset::all() const
+{
+    size_type full = size_ / bits_per_word;
+    for (size_type i = 0; i < full; ++i) {
+        if (words_[i] != ~Word(0)) return false;
+    }
+    size_type rest = size_ % bits_per_word;
+    return rest == 0 || words_[full] == (Word(1) << rest) - 1;
+}
+
+// 最初に立っているビットの位置
+DynamicBitset::size_type DynamicBitset::find_first() const
+{
+    for (size_type w = 0; w < words_.size(); ++w) {
+        if (words_[w]) return w * bits_per_word + impl::CountTrailingZeros64(words_[w]);
+    }
+    return npos;
+}
+
+// i より後で最初に立っているビットの位置
+DynamicBitset::size_type DynamicBitset::find_next(size_type i) const
+{
+    ++i;
+    if (i == 0 || i >= size_) return npos;
+
+    size_type w = i / bits_per_word;
+    Word x = words_[w] & (~Word(0) << (i % bits_per_word));
+    while (x == 0) {
+        if (++w == words_.size()) return npos;
+        x = words_[w];
+    }
+    return w * bits_per_word + impl::CountTrailingZeros64(x);
+}
+
+// 集合演算
+DynamicBitset& DynamicBitset::operator &=(const DynamicBitset& other)
+{
+    check_size(other);
+    ApplyWords<BitOp::And>(words_.data(), other.words_.data(), words_.size());
+    return *this;
+}
+
+DynamicBitset& DynamicBitset::operator |=(const DynamicBitset& other)
+{
+    check_size(other);
+    ApplyWords<BitOp::Or>(words_.data(), other.words_.data(), words_.size());
+    return *this;
+}
+
+DynamicBitset& DynamicBitset::operator ^=(const DynamicBitset& other)
+{
+    check_size(other);
+    ApplyWords<BitOp::Xor>(words_.data(), other.words_.data(), words_.size());
+    return *this;
+}
+
+DynamicBitset& DynamicBitset::and_not(const DynamicBitset& other)
+{
+    check_size(other);
+    ApplyWords<BitOp::AndNot>(words_.data(), other.words_.data(), words_.size());
+    return *this;
+}
+
+// other の立っているビットが全部立っているか
+bool DynamicBitset::is_superset_of(const DynamicBitset& other) const
+{
+    check_size(other);
+    for (size_type i = 0; i < words_.size(); ++i) {
+        if (other.words_[i] & ~words_[i]) return false;
+    }
+    return true;
+}
+
+// 等しいかどうか
+bool DynamicBitset::operator ==(const DynamicBitset& other) const
+{
+    return size_ == other.size_ && equal(words_.begin(), words_.end(), other.words_.begin());
+}
+
+// '0' と '1' の文字列
+string DynamicBitset::to_string() const
+{
+    string s(size_, '0');
+    for_each_set([&s](size_type i) { s[i] = '1'; });
+    return s;
+}
+
+// 最後のワードの余分なビットを落とす
+void DynamicBitset::trim()
+{
+    size_type rest = size_ % bits_per_word;
+    if (rest) {
+        words_[size_ / bits_per_word] &= (Word(1) << rest) - 1;
+    }
+}
+
+//------------------------------------------------------------------------------
+// RankSelectIndex
+//------------------------------------------------------------------------------
+
+// ビット集合から作る
+RankSelectIndex::RankSelectIndex(const DynamicBitset& bits)
+{
+    build(bits);
+}
+
+// 作り直す
+void RankSelectIndex::build(const DynamicBitset& bits)
+{
+    p_bits_ = &bits;
+    const Word* words = bits.data();
+    size_type n = bits.num_words();
+    size_type blocks = n / 8 + 1;   // 末尾の位置でも引けるように 1 つ余分に持つ
+
+    counts_.assign(blocks * 2, 0);
+    size_type total = 0;
+    for (size_type b = 0; b < blocks; ++b) {
+        counts_[b * 2] = total;
+        uint64_t rel = 0;
+        size_type in_block = 0;
+        for (size_type j = 0; j < 8; ++j) {
+            size_type w = b * 8 + j;
+            if (j > 0) {
+                // j 番目のワードの前までの数を 9 ビットずつ詰める
+                rel |= static_cast<uint64_t>(in_block) << (9 * (j - 1));
+            }
+            if (w < n) in_block += impl::PopCount64(words[w]);
+        }
+        counts_[b * 2 + 1] = rel;
+        total += in_block;
+    }
+    ones_ = total;
+}
+
+// [0, i) の中の 1 の数
+RankSelectIndex::size_type RankSelectIndex::rank1(size_type i) const
+{
+    assert(p_bits_ && i <= p_bits_->size());
+    size_type w = i / DynamicBitset::bits_per_word;
+    size_type b = w / 8;
+    size_type j = w % 8;
+    size_type r = static_cast<size_type>(counts_[b * 2]);
+    if (j > 0) {
+        r += static_cast<size_type>((counts_[b * 2 + 1] >> (9 * (j - 1))) & 0x1FF);
+    }
+    size_type bit = i % DynamicBitset::bits_per_word;
+    if (bit) {
+        r += impl::PopCount64(p_bits_->data()[w] & ((Word(1) << bit) - 1));
+    }
+    return r;
+}
+
+// k 番目の 1 の位置
+RankSelectIndex::size_type RankSelectIndex::select1(size_type k) const
+{
+    if (k >= ones_) return DynamicBitset::npos;
+
+    // 累積数が k 以下の最後のブロック
+    size_type lo = 0, hi = counts_.size() / 2;
+    while (hi - lo > 1) {
+        size_type mid = (lo + hi) / 2;
+        if (counts_[mid * 2] <= k) lo = mid;
+        else hi = mid;
+    }
+
+    size_type rest = k - static_cast<size_type>(counts_[lo * 2]);
+    const Word* words = p_bits_->data();
+    for (size_type w = lo * 8; ; ++w) {
+        size_type c = impl::PopCount64(words[w]);
+        if (rest < c) {
+            return w * DynamicBitset::bits_per_word + SelectInWord(words[w], static_cast<unsigned>(rest));
+        }
+        rest -= c;
+    }
+}
+
+}   // namespace tork
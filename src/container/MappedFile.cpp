@@ -0,0 +1,334 @@
+﻿//******************************************************************************
+//
+// メモリマップトファイル
+//
+//******************************************************************************
+
+#include <tork/container/MappedFile.h>
+#include <string>
+#include <utility>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+using namespace std;
+
+namespace {
+
+#ifdef _WIN32
+
+    int LastError() { return static_cast<int>(::GetLastError()); }
+
+#else
+
+    int LastError() { return errno; }
+
+    // ハンドルを格納する void* とファイルディスクリプタの変換
+    int ToFd(void* p) { return static_cast<int>(reinterpret_cast<intptr_t>(p)); }
+    void* FromFd(int fd) { return reinterpret_cast<void*>(static_cast<intptr_t>(fd)); }
+
+#endif
+
+    // 直前の OS エラーで例外を投げる
+    void ThrowLastError(const string& what)
+    {
+        throw tork::MappedFileError(what, LastError());
+    }
+
+}   // anonymous namespace
+
+
+namespace tork {
+
+//------------------------------------------------------------------------------
+// MappedFileError
+
+MappedFileError::MappedFileError(const string& what, int code)
+    :std::runtime_error(what + " (error " + to_string(code) + ")"),
+    code_(code)
+{
+
+}
+
+
+//------------------------------------------------------------------------------
+// MappedFile
+
+// コンストラクタ
+MappedFile::MappedFile()
+{
+
+}
+
+// ムーブコンストラクタ
+MappedFile::MappedFile(MappedFile&& other)
+{
+    swap(other);
+}
+
+// デストラクタ
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+// ムーブ代入演算子
+MappedFile& MappedFile::operator =(MappedFile&& other)
+{
+    if (this == &other) return *this;
+    close();
+    swap(other);
+    return *this;
+}
+
+// スワップ
+void MappedFile::swap(MappedFile& other)
+{
+    std::swap(p_data_, other.p_data_);
+    std::swap(size_, other.size_);
+    std::swap(mode_, other.mode_);
+    std::swap(is_open_, other.is_open_);
+    std::swap(file_, other.file_);
+    std::swap(mapping_, other.mapping_);
+}
+
+// 既存のファイルを開く
+void MappedFile::open(const string& path, MapMode mode)
+{
+    close();
+    open_file(path, mode, false);
+
+    // ファイルサイズを取得してマップ
+    size_t bytes = 0;
+#ifdef _WIN32
+    LARGE_INTEGER li;
+    if (!::GetFileSizeEx(file_, &li)) {
+        int code = LastError();
+        close();
+        throw MappedFileError("tork::MappedFile: cannot get size of " + path, code);
+    }
+    bytes = static_cast<size_t>(li.QuadPart);
+#else
+    struct stat st;
+    if (::fstat(ToFd(file_), &st) != 0) {
+        int code = LastError();
+        close();
+        throw MappedFileError("tork::MappedFile: cannot get size of " + path, code);
+    }
+    bytes = static_cast<size_t>(st.st_size);
+#endif
+
+    try {
+        map(bytes);
+    }
+    catch (...) {
+        close();
+        throw;
+    }
+}
+
+// ファイルを作成して開く
+void MappedFile::create(const string& path, size_t bytes)
+{
+    close();
+    open_file(path, MapMode::ReadWrite, true);
+    try {
+        resize(bytes);
+    }
+    catch (...) {
+        close();
+        throw;
+    }
+}
+
+// 閉じる
+void MappedFile::close()
+{
+    if (!is_open_) return;
+
+    unmap();
+#ifdef _WIN32
+    ::CloseHandle(file_);
+#else
+    ::close(ToFd(file_));
+#endif
+    file_ = nullptr;
+    is_open_ = false;
+}
+
+// ファイルサイズを変更してマップし直す
+void MappedFile::resize(size_t bytes)
+{
+    if (!is_open_ || mode_ != MapMode::ReadWrite) {
+        throw std::logic_error("tork::MappedFile::resize needs a file opened with MapMode::ReadWrite");
+    }
+
+    unmap();
+#ifdef _WIN32
+    LARGE_INTEGER li;
+    li.QuadPart = static_cast<LONGLONG>(bytes);
+    if (!::SetFilePointerEx(file_, li, nullptr, FILE_BEGIN) || !::SetEndOfFile(file_)) {
+        ThrowLastError("tork::MappedFile: cannot resize file");
+    }
+#else
+    if (::ftruncate(ToFd(file_), static_cast<off_t>(bytes)) != 0) {
+        ThrowLastError("tork::MappedFile: cannot resize file");
+    }
+#endif
+    map(bytes);
+}
+
+// 変更をファイルに書き出す
+void MappedFile::flush()
+{
+    if (p_data_ == nullptr || mode_ != MapMode::ReadWrite) return;
+
+#ifdef _WIN32
+    if (!::FlushViewOfFile(p_data_, size_) || !::FlushFileBuffers(file_)) {
+        ThrowLastError("tork::MappedFile: flush failed");
+    }
+#else
+    if (::msync(p_data_, size_, MS_SYNC) != 0) {
+        ThrowLastError("tork::MappedFile: flush failed");
+    }
+#endif
+}
+
+// アクセスパターンのヒントを与える
+void MappedFile::advise(MapAdvice advice)
+{
+    advise(advice, 0, size_);
+}
+
+void MappedFile::advise(MapAdvice advice, size_t offset, size_t bytes)
+{
+    if (p_data_ == nullptr || offset >= size_) return;
+    if (bytes > size_ - offset) bytes = size_ - offset;
+
+#ifdef _WIN32
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+    // Windows には先読み以外のヒントがない
+    if (advice == MapAdvice::WillNeed) {
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = static_cast<char*>(p_data_) + offset;
+        range.NumberOfBytes = bytes;
+        ::PrefetchVirtualMemory(::GetCurrentProcess(), 1, &range, 0);
+    }
+#else
+    (void)advice;
+#endif
+#else
+    // アドレスはページ境界に揃える必要がある
+    size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t head = offset % page;
+    char* addr = static_cast<char*>(p_data_) + offset - head;
+
+    int flag = POSIX_MADV_NORMAL;
+    switch (advice) {
+    case MapAdvice::Normal:     flag = POSIX_MADV_NORMAL; break;
+    case MapAdvice::Sequential: flag = POSIX_MADV_SEQUENTIAL; break;
+    case MapAdvice::Random:     flag = POSIX_MADV_RANDOM; break;
+    case MapAdvice::WillNeed:   flag = POSIX_MADV_WILLNEED; break;
+    }
+    // ヒントなので失敗しても無視する
+    ::posix_madvise(addr, bytes + head, flag);
+#endif
+}
+
+// ファイルを開く
+void MappedFile::open_file(const string& path, MapMode mode, bool create)
+{
+#ifdef _WIN32
+    DWORD access = (mode == MapMode::ReadWrite) ?
+        GENERIC_READ | GENERIC_WRITE : GENERIC_READ;
+    DWORD disposition = create ? CREATE_ALWAYS : OPEN_EXISTING;
+    HANDLE h = ::CreateFileA(path.c_str(), access, FILE_SHARE_READ,
+            nullptr, disposition, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) {
+        ThrowLastError("tork::MappedFile: cannot open " + path);
+    }
+    file_ = h;
+#else
+    // プライベートマップは書き込み権限なしで開いたファイルでも書き込める
+    int flags = (mode == MapMode::ReadWrite) ? O_RDWR : O_RDONLY;
+    if (create) flags |= O_CREAT | O_TRUNC;
+    int fd = ::open(path.c_str(), flags, 0644);
+    if (fd < 0) {
+        ThrowLastError("tork::MappedFile: cannot open " + path);
+    }
+    file_ = FromFd(fd);
+#endif
+    mode_ = mode;
+    is_open_ = true;
+}
+
+// ファイル全体をマップ
+void MappedFile::map(size_t bytes)
+{
+    size_ = bytes;
+    p_data_ = nullptr;
+
+    // サイズ 0 はマップできない
+    if (bytes == 0) return;
+
+#ifdef _WIN32
+    DWORD protect = PAGE_READONLY;
+    DWORD access = FILE_MAP_READ;
+    if (mode_ == MapMode::ReadWrite) {
+        protect = PAGE_READWRITE;
+        access = FILE_MAP_WRITE;
+    }
+    else if (mode_ == MapMode::CopyOnWrite) {
+        protect = PAGE_WRITECOPY;
+        access = FILE_MAP_COPY;
+    }
+
+    HANDLE h = ::CreateFileMappingA(file_, nullptr, protect, 0, 0, nullptr);
+    if (h == nullptr) {
+        size_ = 0;
+        ThrowLastError("tork::MappedFile: CreateFileMapping failed");
+    }
+    void* p = ::MapViewOfFile(h, access, 0, 0, bytes);
+    if (p == nullptr) {
+        int code = LastError();
+        ::CloseHandle(h);
+        size_ = 0;
+        throw MappedFileError("tork::MappedFile: MapViewOfFile failed", code);
+    }
+    mapping_ = h;
+    p_data_ = p;
+#else
+    int prot = (mode_ == MapMode::ReadOnly) ? PROT_READ : PROT_READ | PROT_WRITE;
+    int flags = (mode_ == MapMode::CopyOnWrite) ? MAP_PRIVATE : MAP_SHARED;
+    void* p = ::mmap(nullptr, bytes, prot, flags, ToFd(file_), 0);
+    if (p == MAP_FAILED) {
+        size_ = 0;
+        ThrowLastError("tork::MappedFile: mmap failed");
+    }
+    p_data_ = p;
+#endif
+}
+
+// マップ解除
+void MappedFile::unmap()
+{
+#ifdef _WIN32
+    if (p_data_) ::UnmapViewOfFile(p_data_);
+    if (mapping_) ::CloseHandle(mapping_);
+    mapping_ = nullptr;
+#else
+    if (p_data_) ::munmap(p_data_, size_);
+#endif
+    p_data_ = nullptr;
+    size_ = 0;
+}
+
+}   // namespace tork
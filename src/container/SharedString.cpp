@@ -0,0 +1,27 @@
+﻿//******************************************************************************
+//
+// 共有文字列クラス
+//
+//******************************************************************************
+
+#include <tork/container/SharedString.h>
+#include <new>
+
+namespace tork {
+
+    namespace impl {
+
+// 作成（参照カウントは 1）
+SharedStringBuffer* SharedStringBuffer::create(const char* s, size_t n)
+{
+    void* p = ::operator new(sizeof(SharedStringBuffer) + n);
+    SharedStringBuffer* b = static_cast<SharedStringBuffer*>(p);
+    new (&b->ref_counter) std::atomic<int>(1);
+    std::memcpy(b->data, s, n);
+    b->data[n] = '\0';
+    return b;
+}
+
+    }   // namespace tork::impl
+
+}   // namespace tork
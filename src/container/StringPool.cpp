@@ -0,0 +1,305 @@
+﻿//******************************************************************************
+//
+// 文字列のインターン
+//
+//******************************************************************************
+
+#include <tork/container/StringPool.h>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <tork/thread/SpinLock.h>
+
+using namespace std;
+
+namespace tork {
+
+namespace {
+
+// 文字列の領域のブロックの大きさ（最初は小さく、倍々に大きくする）
+const size_t FirstBlockSize = 1024;
+const size_t MaxBlockSize = 64 * 1024;
+
+// 文字列のハッシュ値（8 バイトずつ混ぜる）
+uint64_t HashString(const char* p, size_t n)
+{
+    const uint64_t m = 0xFF51AFD7ED558CCDULL;
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ (n * m);
+    while (n >= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        h = (h ^ v) * m;
+        h ^= h >> 32;
+        p += 8;
+        n -= 8;
+    }
+    uint64_t v = 0;
+    memcpy(&v, p, n);
+    h = (h ^ v) * 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 29;
+    h *= m;
+    h ^= h >> 32;
+    return h;
+}
+
+}   // anonymous namespace
+
+//------------------------------------------------------------------------------
+// ハッシュ表
+// 開番地法（線形探査）で、スロットには ID + 1、ハッシュ値の下位 32 ビット、文字列を入れる
+// ID + 1 が 0 なら空きで、ほかは ID + 1 を release で書く前に書いておく
+// 削除はしないので、一度埋まったスロットは変わらない
+//------------------------------------------------------------------------------
+struct StringPool::Table {
+    struct Slot {
+        std::atomic<uint32_t> id_plus1;
+        uint32_t hash;
+        const char* data;
+    };
+
+    size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    Table* older;   // 広げる前の表（読み込み中のスレッドがいるかもしれないので残す）
+
+    explicit Table(size_t capacity, Table* old = nullptr)
+        :mask(capacity - 1), slots(new Slot[capacity]), older(old)
+    {
+        for (size_t i = 0; i < capacity; ++i) {
+            slots[i].id_plus1.store(0, std::memory_order_relaxed);
+            slots[i].hash = 0;
+            slots[i].data = nullptr;
+        }
+    }
+
+    ~Table() { delete older; }
+
+    // 空きスロットに入れる（書き込みはロック中の 1 スレッドだけ）
+    void insert(uint32_t hash, const char* data, uint32_t id_plus1)
+    {
+        size_t i = hash & mask;
+        while (slots[i].id_plus1.load(std::memory_order_relaxed) != 0) {
+            i = (i + 1) & mask;
+        }
+        slots[i].hash = hash;
+        slots[i].data = data;
+        slots[i].id_plus1.store(id_plus1, std::memory_order_release);
+    }
+};
+
+//------------------------------------------------------------------------------
+// シャード
+// 登録はロックを取り、ハッシュ表の差し替えはアトミックに行う
+//------------------------------------------------------------------------------
+struct StringPool::Shard {
+    SpinLock lock;
+    std::atomic<Table*> table;
+    size_t count;               // 登録数
+    char* block;                // 文字列を書き込んでいるブロック
+    size_t block_left;          // ブロックの残り
+    std::vector<char*> blocks;  // 確保したブロック
+    size_t block_bytes;         // 確保したバイト数
+    size_t table_bytes;         // ハッシュ表（古いものも含む）のバイト数
+    char padding[64];
+
+    Shard() :table(nullptr), count(0), block(nullptr), block_left(0), block_bytes(0), table_bytes(0) { }
+
+    ~Shard()
+    {
+        delete table.load(std::memory_order_relaxed);
+        for (char* p : blocks) delete[] p;
+    }
+
+    // 文字列を長さ、本体、NUL の順にコピーし、本体の先頭を返す
+    const char* store(const char* s, size_t n)
+    {
+        uint32_t size = static_cast<uint32_t>(n);
+        size_t need = sizeof(size) + n + 1;
+        char* p;
+        if (need <= block_left) {
+            p = block;
+            block += need;
+            block_left -= need;
+        }
+        else {
+            // 先に blocks を広げておき、確保したブロックを push_back で漏らさないようにする
+            blocks.reserve(blocks.size() + 1);
+            size_t next = block_bytes < FirstBlockSize ? FirstBlockSize
+                        : block_bytes < MaxBlockSize ? block_bytes : MaxBlockSize;
+            if (need > next / 4) {
+                // 大きな文字列は専用のブロックにして、今のブロックの残りを捨てない
+                p = new char[need];
+                blocks.push_back(p);
+                block_bytes += need;
+            }
+            else {
+                p = new char[next];
+                blocks.push_back(p);
+                block_bytes += next;
+                block = p + need;
+                block_left = next - need;
+            }
+        }
+        memcpy(p, &size, sizeof(size));
+        memcpy(p + sizeof(size), s, n);
+        p[sizeof(size) + n] = '\0';
+        return p + sizeof(size);
+    }
+};
+
+// コンストラクタ
+StringPool::StringPool(size_t shard_count)
+    :next_id_(0), committed_(0)
+{
+    if (shard_count == 0) {
+        shard_count = std::thread::hardware_concurrency() * 4;
+    }
+    if (shard_count > 256) shard_count = 256;
+
+    unsigned bits = 0;
+    while ((size_t(1) << bits) < shard_count) {
+        ++bits;
+    }
+    shard_count_ = size_t(1) << bits;
+    shard_shift_ = 64 - bits;
+    shards_.reset(new Shard[shard_count_]);
+    for (size_t i = 0; i < shard_count_; ++i) {
+        shards_[i].table.store(new Table(16), std::memory_order_relaxed);
+        shards_[i].table_bytes = sizeof(Table) + 16 * sizeof(Table::Slot);
+    }
+    for (unsigned k = 0; k < SegmentCount; ++k) {
+        segments_[k].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+// デストラクタ
+StringPool::~StringPool()
+{
+    for (unsigned k = 0; k < SegmentCount; ++k) {
+        delete[] segments_[k].load(std::memory_order_relaxed);
+    }
+}
+
+// 登録済みかどうかを調べる（ロックを取らない）
+StringPool::id_type StringPool::find(const Shard& shard, string_view s, uint64_t hash) const
+{
+    const Table* t = shard.table.load(std::memory_order_acquire);
+    uint32_t h = static_cast<uint32_t>(hash);
+    size_t i = h & t->mask;
+    for (;;) {
+        uint32_t v = t->slots[i].id_plus1.load(std::memory_order_acquire);
+        if (v == 0) return npos;
+        const Table::Slot& slot = t->slots[i];
+        if (slot.hash == h && StoredSize(slot.data) == s.size()
+            && memcmp(slot.data, s.data(), s.size()) == 0) {
+            return v - 1;
+        }
+        i = (i + 1) & t->mask;
+    }
+}
+
+// 登録済みの文字列の ID
+StringPool::id_type StringPool::find(string_view s) const
+{
+    uint64_t hash = HashString(s.data(), s.size());
+    return find(shards_[shard_index(hash)], s, hash);
+}
+
+// 登録
+StringPool::id_type StringPool::intern(string_view s)
+{
+    if (s.size() > 0xFFFFFFFF) throw std::length_error("too long string at tork::StringPool");
+
+    uint64_t hash = HashString(s.data(), s.size());
+    Shard& shard = shards_[shard_index(hash)];
+    id_type id = find(shard, s, hash);
+    if (id != npos) return id;
+
+    std::lock_guard<SpinLock> guard(shard.lock);
+    // ロックを待つ間に登録されたかもしれない
+    id = find(shard, s, hash);
+    if (id != npos) return id;
+
+    // 埋まりが 3/4 を超えるなら広げる
+    Table* t = shard.table.load(std::memory_order_relaxed);
+    if ((shard.count + 1) * 4 > (t->mask + 1) * 3) {
+        size_t capacity = (t->mask + 1) * 2;
+        Table* bigger = new Table(capacity, t);
+        for (size_t i = 0; i <= t->mask; ++i) {
+            const Table::Slot& slot = t->slots[i];
+            uint32_t v = slot.id_plus1.load(std::memory_order_relaxed);
+            if (v != 0) bigger->insert(slot.hash, slot.data, v);
+        }
+        shard.table.store(bigger, std::memory_order_release);
+        shard.table_bytes += sizeof(Table) + capacity * sizeof(Table::Slot);
+    }
+
+    const char* data = shard.store(s.data(), s.size());
+    id = add_entry(data);
+    shard.table.load(std::memory_order_relaxed)->insert(static_cast<uint32_t>(hash), data, id + 1);
+    ++shard.count;
+    return id;
+}
+
+// 新しい ID を振る
+// ID を確保したあとに例外を投げると、その ID が公開されずに後の登録がすべて止まる
+// そのため、入れるセグメントを先に用意してから ID を確保する
+StringPool::id_type StringPool::add_entry(const char* data)
+{
+    id_type id = next_id_.load(std::memory_order_relaxed);
+    const char** segment;
+    size_t i;
+    do {
+        if (id == npos) throw std::length_error("too many strings at tork::StringPool");
+        unsigned k;
+        locate(id, k, i);
+        segment = segments_[k].load(std::memory_order_acquire);
+        if (segment == nullptr) {
+            // 別のシャードと同時に確保したら、先に置いた方を使う
+            const char** fresh = new const char*[FirstSegmentSize << k];
+            if (segments_[k].compare_exchange_strong(segment, fresh, std::memory_order_acq_rel)) {
+                segment = fresh;
+            }
+            else {
+                delete[] fresh;
+            }
+        }
+    } while (!next_id_.compare_exchange_weak(id, id + 1, std::memory_order_relaxed));
+    segment[i] = data;
+
+    // 小さい ID から順に公開する。size() より小さい ID は表に書き終えている
+    // 前の ID は別のシャードで書いている途中なので、それを待つ（すぐに終わる）
+    impl::SpinWait spin;
+    while (committed_.load(std::memory_order_acquire) != id) {
+        spin.wait();
+    }
+    committed_.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+// 範囲チェック付きの view()
+string_view StringPool::at(id_type id) const
+{
+    if (id >= size()) throw std::out_of_range("out of range at tork::StringPool");
+    return view(id);
+}
+
+// 使っているメモリのバイト数
+size_t StringPool::memory_usage() const
+{
+    size_t bytes = sizeof(*this) + shard_count_ * sizeof(Shard);
+    for (size_t i = 0; i < shard_count_; ++i) {
+        Shard& shard = shards_[i];
+        std::lock_guard<SpinLock> guard(shard.lock);
+        bytes += shard.block_bytes + shard.table_bytes + shard.blocks.capacity() * sizeof(char*);
+    }
+    for (unsigned k = 0; k < SegmentCount; ++k) {
+        if (segments_[k].load(std::memory_order_acquire)) {
+            bytes += (FirstSegmentSize << k) * sizeof(const char*);
+        }
+    }
+    return bytes;
+}
+
+}   // namespace tork
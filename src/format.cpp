@@ -0,0 +1,53 @@
+﻿//******************************************************************************
+//
+// 呼び出し側のバッファへの書式化
+//
+//******************************************************************************
+
+#include <tork/format.h>
+
+namespace tork {
+
+// 容量が足りない場合の追記
+void OutputBuffer::append_slow(const char* s, size_t n)
+{
+    grow(size_ + n);
+    size_t room = capacity_ - size_;
+    if (n > room) {
+        n = room;
+        truncated_ = true;
+    }
+    std::memcpy(data_ + size_, s, n);
+    size_ += n;
+}
+
+    namespace impl {
+
+// 書式文字列の "{}" の手前までを書く
+const char* FormatLiteral(OutputBuffer& out, const char* first, const char* last)
+{
+    const char* p = first;
+    while (p != last) {
+        if (*p == '{' || *p == '}') {
+            out.append(first, p - first);
+            if (p + 1 != last && p[1] == *p) {
+                // "{{" または "}}"
+                out.push_back(*p);
+                p += 2;
+                first = p;
+                continue;
+            }
+            if (*p == '{' && p + 1 != last && p[1] == '}') {
+                return p + 2;
+            }
+            throw std::invalid_argument("unmatched brace at tork::format_to");
+        }
+        ++p;
+    }
+    out.append(first, p - first);
+    return nullptr;
+}
+
+    }   // namespace tork::impl
+
+}   // namespace tork
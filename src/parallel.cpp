@@ -0,0 +1,131 @@
+﻿//******************************************************************************
+//
+// 並列アルゴリズムを動かすスレッドプール
+//
+//******************************************************************************
+
+#include <tork/parallel.h>
+#include <tork/thread/ThreadPool.h>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#if defined(_MSC_VER)
+#define TORK_PARALLEL_THREAD_LOCAL __declspec(thread)
+#else
+#define TORK_PARALLEL_THREAD_LOCAL __thread
+#endif
+
+namespace tork {
+
+    namespace parallel {
+
+        namespace {
+
+// チャンクを処理している最中かどうか（入れ子の並列処理を防ぐ）
+TORK_PARALLEL_THREAD_LOCAL bool InChunk = false;
+
+// 並列処理に使うプール（PoolMutex で保護）
+// 実行中の並列処理は shared_ptr を持っているので、差し替えても途中でプールは消えない
+std::mutex PoolMutex;
+std::shared_ptr<ThreadPool> Pool;   // まだ作っていなければ nullptr
+bool Serial = false;                // set_thread_count(1) なら呼び出したスレッドだけで処理する
+
+// 内蔵のプールを作る（呼び出したスレッドも処理するので、ワーカーは 1 つ少なくする）
+std::shared_ptr<ThreadPool> MakePool(unsigned threads)
+{
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    return std::make_shared<ThreadPool>(threads > 1 ? threads - 1 : 1);
+}
+
+// 並列処理に使うプール（PoolMutex を取ってから呼ぶ）
+std::shared_ptr<ThreadPool> LockedPool()
+{
+    if (!Pool) Pool = MakePool(0);
+    return Pool;
+}
+
+        }   // anonymous namespace
+
+        namespace impl {
+
+// チャンク番号を並列に body に渡す
+void RunChunks(size_t chunks, const std::function<void(size_t)>& body)
+{
+    if (chunks == 0) return;
+
+    // 入れ子の呼び出しはその場で処理する
+    std::shared_ptr<ThreadPool> pool;
+    if (chunks > 1 && !InChunk) {
+        std::lock_guard<std::mutex> lock(PoolMutex);
+        if (!Serial) pool = LockedPool();
+    }
+    if (!pool) {
+        for (size_t c = 0; c < chunks; ++c) {
+            body(c);
+        }
+        return;
+    }
+
+    // 例外が出たら残りのチャンクは処理しない（最初の例外は TaskGroup が投げ直す）
+    std::atomic<bool> failed(false);
+    pool->parallel_for(size_t(0), chunks, [&body, &failed](size_t c) {
+        if (failed.load(std::memory_order_relaxed)) return;
+        bool outer = InChunk;
+        InChunk = true;
+        try {
+            body(c);
+        }
+        catch (...) {
+            InChunk = outer;
+            failed.store(true, std::memory_order_relaxed);
+            throw;
+        }
+        InChunk = outer;
+    }, 1);
+}
+
+        }   // namespace tork::parallel::impl
+
+// 並列処理に使うスレッド数
+unsigned thread_count()
+{
+    std::lock_guard<std::mutex> lock(PoolMutex);
+    return Serial ? 1 : LockedPool()->thread_count() + 1;
+}
+
+// 並列処理に使うスレッド数を設定する
+void set_thread_count(unsigned n)
+{
+    std::shared_ptr<ThreadPool> old;
+    {
+        std::lock_guard<std::mutex> lock(PoolMutex);
+        old.swap(Pool);
+        Serial = (n == 1);
+        if (!Serial) Pool = MakePool(n);
+    }
+    // 古いプールのワーカーはロックの外で止める
+}
+
+// 並列処理に使うスレッドプール
+std::shared_ptr<ThreadPool> pool()
+{
+    std::lock_guard<std::mutex> lock(PoolMutex);
+    return LockedPool();
+}
+
+// 並列処理に使うスレッドプールを差し替える
+void set_pool(std::shared_ptr<ThreadPool> p)
+{
+    {
+        std::lock_guard<std::mutex> lock(PoolMutex);
+        p.swap(Pool);
+        Serial = false;
+    }
+    // 古いプールのワーカーはロックの外で止める
+}
+
+    }   // namespace tork::parallel
+
+}   // namespace tork
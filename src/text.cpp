@@ -1,36 +1,476 @@
 ﻿
 #include <tork/text.h>
-#include <string>
+#include <tork/bits.h>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
 #include <locale>
+#include <mutex>
+#include <stdexcept>
+#include <string>
 
 using namespace std;
-using Converter = wstring_convert<codecvt<wchar_t, char, mbstate_t>>;
-using ConvByName = codecvt_byname<wchar_t, char, mbstate_t>;
 
 namespace tork {
 
+namespace {
+
+// 置換文字
+const uint32_t Replacement = 0xFFFD;
+
+// wchar_t が UTF-16 かどうか
+const bool WideIsUtf16 = sizeof(wchar_t) == 2;
+
+// ASCII が続く範囲の末尾
+const char* SkipAscii(const char* p, const char* last)
+{
+#ifdef TORK_HAS_SSE2
+    while (last - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        if (_mm_movemask_epi8(v) != 0) break;
+        p += 16;
+    }
+#endif
+    while (p != last && static_cast<unsigned char>(*p) < 0x80) ++p;
+    return p;
+}
+const wchar_t* SkipAscii(const wchar_t* p, const wchar_t* last)
+{
+#ifdef TORK_HAS_SSE2
+    const size_t lanes = 16 / sizeof(wchar_t);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i high = WideIsUtf16 ? _mm_set1_epi16(static_cast<short>(0xFF80))
+                                     : _mm_set1_epi32(static_cast<int>(0xFFFFFF80));
+    while (static_cast<size_t>(last - p) >= lanes) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(v, high), zero)) != 0xFFFF) break;
+        p += lanes;
+    }
+#endif
+    while (p != last && static_cast<uint32_t>(*p) < 0x80) ++p;
+    return p;
+}
+
+// ASCII だけの範囲を広げてコピー
+wchar_t* WidenAscii(const char* p, const char* last, wchar_t* out)
+{
+#ifdef TORK_HAS_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    while (last - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        __m128i* dst = reinterpret_cast<__m128i*>(out);
+        if (WideIsUtf16) {
+            _mm_storeu_si128(dst, lo);
+            _mm_storeu_si128(dst + 1, hi);
+        }
+        else {
+            _mm_storeu_si128(dst, _mm_unpacklo_epi16(lo, zero));
+            _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(lo, zero));
+            _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(hi, zero));
+            _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(hi, zero));
+        }
+        p += 16;
+        out += 16;
+    }
+#endif
+    while (p != last) *out++ = static_cast<wchar_t>(*p++);
+    return out;
+}
+
+// ASCII だけの範囲を狭めてコピー
+char* NarrowAscii(const wchar_t* p, const wchar_t* last, char* out)
+{
+#ifdef TORK_HAS_SSE2
+    while (last - p >= 16) {
+        const __m128i* src = reinterpret_cast<const __m128i*>(p);
+        __m128i v;
+        if (WideIsUtf16) {
+            v = _mm_packus_epi16(_mm_loadu_si128(src), _mm_loadu_si128(src + 1));
+        }
+        else {
+            __m128i lo = _mm_packs_epi32(_mm_loadu_si128(src), _mm_loadu_si128(src + 1));
+            __m128i hi = _mm_packs_epi32(_mm_loadu_si128(src + 2), _mm_loadu_si128(src + 3));
+            v = _mm_packus_epi16(lo, hi);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), v);
+        p += 16;
+        out += 16;
+    }
+#endif
+    while (p != last) *out++ = static_cast<char>(*p++);
+    return out;
+}
+
+// UTF-8 を 1 文字デコードし、使ったバイト数を返す
+// 不正な場合は、1 つの置換文字にする範囲のバイト数を負にして返す
+int DecodeUtf8(const unsigned char* p, const unsigned char* last, uint32_t& cp)
+{
+    unsigned c = p[0];
+    unsigned lo = 0x80, hi = 0xBF;  // 2 バイト目の範囲
+    int n;
+    if (c < 0x80) {
+        cp = c;
+        return 1;
+    }
+    // よく出る 2 バイト文字と、E0 と ED 以外で始まる 3 バイト文字
+    if (last - p >= 3) {
+        unsigned d1 = p[1] ^ 0x80, d2 = p[2] ^ 0x80;
+        if (c >= 0xC2 && c < 0xE0 && d1 < 0x40) {
+            cp = ((c & 0x1F) << 6) | d1;
+            return 2;
+        }
+        if (c > 0xE0 && c < 0xF0 && c != 0xED && (d1 | d2) < 0x40) {
+            cp = ((c & 0x0F) << 12) | (d1 << 6) | d2;
+            return 3;
+        }
+    }
+    if (c < 0xC2) {
+        return -1;
+    }
+    else if (c < 0xE0) {
+        n = 2;
+        cp = c & 0x1F;
+    }
+    else if (c < 0xF0) {
+        n = 3;
+        cp = c & 0x0F;
+        if (c == 0xE0) lo = 0xA0;       // 冗長な表現
+        else if (c == 0xED) hi = 0x9F;  // サロゲート
+    }
+    else if (c < 0xF5) {
+        n = 4;
+        cp = c & 0x07;
+        if (c == 0xF0) lo = 0x90;       // 冗長な表現
+        else if (c == 0xF4) hi = 0x8F;  // U+10FFFF 超
+    }
+    else {
+        return -1;
+    }
+    for (int i = 1; i < n; ++i) {
+        if (p + i == last) return -i;
+        unsigned d = p[i];
+        if (d < lo || d > hi) return -i;
+        cp = (cp << 6) | (d & 0x3F);
+        lo = 0x80;
+        hi = 0xBF;
+    }
+    return n;
+}
+
+// wchar_t を 1 文字デコードし、使った数を返す
+// 不正な場合は -1
+int DecodeWide(const wchar_t* p, const wchar_t* last, uint32_t& cp)
+{
+    uint32_t c = static_cast<uint32_t>(p[0]);
+    if (WideIsUtf16) {
+        c &= 0xFFFF;
+        if (c >= 0xD800 && c < 0xDC00) {
+            if (p + 1 != last) {
+                uint32_t d = static_cast<uint32_t>(p[1]) & 0xFFFF;
+                if (d >= 0xDC00 && d < 0xE000) {
+                    cp = 0x10000 + ((c - 0xD800) << 10) + (d - 0xDC00);
+                    return 2;
+                }
+            }
+            return -1;
+        }
+        if (c >= 0xDC00 && c < 0xE000) return -1;
+    }
+    else if (c > 0x10FFFF || (c >= 0xD800 && c < 0xE000)) {
+        return -1;
+    }
+    cp = c;
+    return 1;
+}
+
+// 符号化したときの長さ
+size_t WideUnits(uint32_t cp)
+{
+    return WideIsUtf16 && cp >= 0x10000 ? 2 : 1;
+}
+size_t Utf8Bytes(uint32_t cp)
+{
+    return cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+}
+
+// 1 文字書き込む
+wchar_t* PutWide(wchar_t* out, uint32_t cp)
+{
+    if (WideIsUtf16 && cp >= 0x10000) {
+        cp -= 0x10000;
+        *out++ = static_cast<wchar_t>(0xD800 + (cp >> 10));
+        *out++ = static_cast<wchar_t>(0xDC00 + (cp & 0x3FF));
+    }
+    else {
+        *out++ = static_cast<wchar_t>(cp);
+    }
+    return out;
+}
+char* PutUtf8(char* out, uint32_t cp)
+{
+    if (cp < 0x80) {
+        *out++ = static_cast<char>(cp);
+    }
+    else if (cp < 0x800) {
+        *out++ = static_cast<char>(0xC0 | (cp >> 6));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000) {
+        *out++ = static_cast<char>(0xE0 | (cp >> 12));
+        *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else {
+        *out++ = static_cast<char>(0xF0 | (cp >> 18));
+        *out++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    return out;
+}
+
+}   // anonymous namespace
+
+// 変換後の wchar_t の数
+size_t Utf8ToWideLength(const char* first, const char* last)
+{
+    size_t n = 0;
+    const char* p = first;
+    while (p != last) {
+        if (static_cast<unsigned char>(*p) < 0x80) {
+            const char* q = SkipAscii(p, last);
+            n += q - p;
+            p = q;
+            continue;
+        }
+        uint32_t cp;
+        int len = DecodeUtf8(reinterpret_cast<const unsigned char*>(p),
+            reinterpret_cast<const unsigned char*>(last), cp);
+        if (len < 0) {
+            n += 1;
+            p -= len;
+        }
+        else {
+            n += WideUnits(cp);
+            p += len;
+        }
+    }
+    return n;
+}
+
+// 変換後のバイト数
+size_t WideToUtf8Length(const wchar_t* first, const wchar_t* last)
+{
+    size_t n = 0;
+    const wchar_t* p = first;
+    while (p != last) {
+        if (static_cast<uint32_t>(*p) < 0x80) {
+            const wchar_t* q = SkipAscii(p, last);
+            n += q - p;
+            p = q;
+            continue;
+        }
+        uint32_t cp;
+        int len = DecodeWide(p, last, cp);
+        if (len < 0) {
+            n += Utf8Bytes(Replacement);
+            p += 1;
+        }
+        else {
+            n += Utf8Bytes(cp);
+            p += len;
+        }
+    }
+    return n;
+}
+
+// ワイド文字へ変換（呼び出し側のバッファ）
+wchar_t* Utf8ToWide(const char* first, const char* last, wchar_t* out, InvalidSequence invalid)
+{
+    const char* p = first;
+    while (p != last) {
+        if (static_cast<unsigned char>(*p) < 0x80) {
+            const char* q = SkipAscii(p, last);
+            out = WidenAscii(p, q, out);
+            p = q;
+            continue;
+        }
+        uint32_t cp;
+        int len = DecodeUtf8(reinterpret_cast<const unsigned char*>(p),
+            reinterpret_cast<const unsigned char*>(last), cp);
+        if (len < 0) {
+            if (invalid == InvalidSequence::Throw) {
+                throw range_error("invalid UTF-8 sequence at tork::Utf8ToWide");
+            }
+            cp = Replacement;
+            len = -len;
+        }
+        out = PutWide(out, cp);
+        p += len;
+    }
+    return out;
+}
+
+// ワイド文字から変換（呼び出し側のバッファ）
+char* WideToUtf8(const wchar_t* first, const wchar_t* last, char* out, InvalidSequence invalid)
+{
+    const wchar_t* p = first;
+    while (p != last) {
+        if (static_cast<uint32_t>(*p) < 0x80) {
+            const wchar_t* q = SkipAscii(p, last);
+            out = NarrowAscii(p, q, out);
+            p = q;
+            continue;
+        }
+        uint32_t cp;
+        int len = DecodeWide(p, last, cp);
+        if (len < 0) {
+            if (invalid == InvalidSequence::Throw) {
+                throw range_error("invalid wide character at tork::WideToUtf8");
+            }
+            cp = Replacement;
+            len = 1;
+        }
+        out = PutUtf8(out, cp);
+        p += len;
+    }
+    return out;
+}
+
+// UTF-8 からワイド文字列へ変換
+// wchar_t の数はバイト数を超えないので、その長さで変換してから詰める
+wstring Utf8ToWide(string_view str, InvalidSequence invalid)
+{
+    wstring result(str.size(), L'\0');
+    if (!result.empty()) {
+        const char* first = str.data();
+        result.resize(Utf8ToWide(first, first + str.size(), &result[0], invalid) - &result[0]);
+        if (result.size() < result.capacity() / 2) result.shrink_to_fit();
+    }
+    return result;
+}
+
+// ワイド文字列から UTF-8 へ変換
+string WideToUtf8(wstring_view wstr, InvalidSequence invalid)
+{
+    const wchar_t* first = wstr.data();
+    const wchar_t* last = first + wstr.size();
+    string result(WideToUtf8Length(first, last), '\0');
+    if (!result.empty()) WideToUtf8(first, last, &result[0], invalid);
+    return result;
+}
+
+namespace {
+
+typedef codecvt<wchar_t, char, mbstate_t> Codecvt;
+
+// システムのロケールの変換器
+// 作るのは重いので、最初に使うときに1回だけ作る
+once_flag SystemCodecvtOnce;
+const locale* SystemLocale = nullptr;
+const Codecvt* SystemCodecvtFacet = nullptr;
+
+const Codecvt& SystemCodecvt()
+{
+    call_once(SystemCodecvtOnce, [] {
+        // プログラムの終わりまで使うので解放しない
+        SystemLocale = new locale(locale::classic(), new codecvt_byname<wchar_t, char, mbstate_t>(""));
+        SystemCodecvtFacet = &use_facet<Codecvt>(*SystemLocale);
+    });
+    return *SystemCodecvtFacet;
+}
+
+// システムのロケールでワイド文字列へ変換
+// 先頭の ASCII はそのまま広げ、残りを変換器に任せる
+wstring LocaleToWide(const char* first, const char* last)
+{
+    const char* p = SkipAscii(first, last);
+    wstring result(last - first, L'\0');
+    if (result.empty()) return result;
+    wchar_t* out = WidenAscii(first, p, &result[0]);
+    if (p != last) {
+        const Codecvt& cvt = SystemCodecvt();
+        mbstate_t state = mbstate_t();
+        for (;;) {
+            const char* from_next = p;
+            wchar_t* to_next = out;
+            wchar_t* to_end = &result[0] + result.size();
+            codecvt_base::result r = cvt.in(state, p, last, from_next, out, to_end, to_next);
+            if (r == codecvt_base::noconv) {
+                out = WidenAscii(p, last, out);
+                break;
+            }
+            if (r == codecvt_base::error) throw range_error("bad conversion at tork::ToWide");
+            bool progressed = from_next != p || to_next != out;
+            p = from_next;
+            out = to_next;
+            if (r == codecvt_base::ok && p == last) break;
+            // 出力が足りなければ広げて続ける。進まなければ末尾の文字が途中で切れている
+            if (!progressed && to_next != to_end) throw range_error("bad conversion at tork::ToWide");
+            size_t used = out - &result[0];
+            result.resize(result.size() * 2 + 8);
+            out = &result[0] + used;
+        }
+    }
+    result.resize(out - &result[0]);
+    return result;
+}
+
+// システムのロケールでワイド文字列から変換
+string LocaleFromWide(const wchar_t* first, const wchar_t* last)
+{
+    const wchar_t* p = SkipAscii(first, last);
+    string result((p - first) + (last - p) * 2, '\0');
+    if (result.empty()) return result;
+    char* out = NarrowAscii(first, p, &result[0]);
+    if (p != last) {
+        const Codecvt& cvt = SystemCodecvt();
+        mbstate_t state = mbstate_t();
+        for (;;) {
+            const wchar_t* from_next = p;
+            char* to_next = out;
+            char* to_end = &result[0] + result.size();
+            codecvt_base::result r = cvt.out(state, p, last, from_next, out, to_end, to_next);
+            if (r == codecvt_base::error) throw range_error("bad conversion at tork::FromWide");
+            if (r == codecvt_base::noconv) throw range_error("bad conversion at tork::FromWide");
+            bool progressed = from_next != p || to_next != out;
+            p = from_next;
+            out = to_next;
+            if (r == codecvt_base::ok && p == last) break;
+            if (!progressed && static_cast<size_t>(to_end - out) >= static_cast<size_t>(cvt.max_length())) {
+                throw range_error("bad conversion at tork::FromWide");
+            }
+            size_t used = out - &result[0];
+            result.resize(result.size() * 2 + 16);
+            out = &result[0] + used;
+        }
+    }
+    result.resize(out - &result[0]);
+    return result;
+}
+
+}   // anonymous namespace
+
 // ワイド文字へ変換
 wstring ToWide(const string& str)
 {
-    Converter conv(new ConvByName(""));
-    return conv.from_bytes(str);
+    return LocaleToWide(str.data(), str.data() + str.size());
 }
 wstring ToWide(const char* str)
 {
-    Converter conv(new ConvByName(""));
-    return conv.from_bytes(str);
+    return LocaleToWide(str, str + strlen(str));
 }
 
 // ワイド文字から変換
 string FromWide(const wstring& wstr)
 {
-    Converter conv(new ConvByName(""));
-    return conv.to_bytes(wstr);
+    return LocaleFromWide(wstr.data(), wstr.data() + wstr.size());
 }
 string FromWide(const wchar_t* wstr)
 {
-    Converter conv(new ConvByName(""));
-    return conv.to_bytes(wstr);
+    return LocaleFromWide(wstr, wstr + wcslen(wstr));
 }
 
 
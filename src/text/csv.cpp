@@ -0,0 +1,102 @@
+﻿//******************************************************************************
+//
+// 区切り文字で並んだ数値と CSV の一括読み込み
+//
+//******************************************************************************
+
+#include <tork/text/csv.h>
+#include <cstring>
+
+namespace tork {
+
+    namespace text {
+
+        namespace impl {
+
+// コンストラクタ
+CsvCursor::CsvCursor(string_view text, char delimiter, char quote)
+    :first_(text.data()), p_(text.data()), last_(text.data() + text.size()),
+     delimiter_(delimiter), quote_(quote), row_end_(true)
+{
+    stops_.add(delimiter);
+    stops_.add('\n');
+}
+
+// 次の行へ進む
+bool CsvCursor::next_row()
+{
+    // 空行（"\n" と "\r\n"）を飛ばす
+    while (p_ != last_) {
+        if (*p_ == '\n') {
+            ++p_;
+        }
+        else if (*p_ == '\r' && (p_ + 1 == last_ || p_[1] == '\n')) {
+            p_ += p_ + 1 == last_ ? 1 : 2;
+        }
+        else {
+            row_end_ = false;
+            return true;
+        }
+    }
+    row_end_ = true;
+    return false;
+}
+
+// 次のフィールド
+bool CsvCursor::next_field(string_view& field)
+{
+    if (row_end_) return false;
+
+    const char* begin = p_;
+    const char* content_first = p_;
+    const char* content_last = nullptr;
+
+    // 引用符で囲まれたフィールド
+    if (quote_ != '\0' && p_ != last_ && *p_ == quote_) {
+        const char* q = p_ + 1;
+        for (;;) {
+            q = static_cast<const char*>(std::memchr(q, quote_, last_ - q));
+            if (q == nullptr || q + 1 == last_ || q[1] != quote_) break;
+            q += 2;     // "" は中身の引用符
+        }
+        if (q != nullptr) {
+            content_first = p_ + 1;
+            content_last = q;
+            p_ = q + 1;
+        }
+    }
+
+    // 次の区切り文字か改行まで
+    size_t n = find_any_of(string_view(p_, last_ - p_), stops_);
+    const char* end = n == string_view::npos ? last_ : p_ + n;
+    if (end == last_ || *end == '\n') {
+        row_end_ = true;
+    }
+    p_ = end == last_ ? last_ : end + 1;
+
+    const char* field_last = end;
+    if (row_end_ && field_last != begin && field_last[-1] == '\r') --field_last;
+    if (content_last != nullptr && content_last + 1 == field_last) {
+        field = string_view(content_first, content_last - content_first);
+    }
+    else {
+        // 引用符の後ろに余計な文字があれば、引用符ごと返す
+        field = string_view(begin, field_last - begin);
+    }
+    return true;
+}
+
+// 行の残りを読み飛ばす
+size_t CsvCursor::skip_row()
+{
+    size_t n = 0;
+    string_view field;
+    while (next_field(field)) ++n;
+    return n;
+}
+
+        }   // namespace tork::text::impl
+
+    }   // namespace tork::text
+
+}   // namespace tork
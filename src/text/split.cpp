@@ -0,0 +1,75 @@
+﻿//******************************************************************************
+//
+// 文字列の検索と分割
+//
+//******************************************************************************
+
+#include <tork/text/split.h>
+#include <tork/bits.h>
+#include <cstring>
+
+namespace tork {
+
+    namespace text {
+
+        namespace {
+
+// 表を引いて 1 バイトずつ探す
+const char* FindScalar(const char* p, const char* last, const CharSet& set)
+{
+    while (p != last && !set.contains(*p)) ++p;
+    return p;
+}
+
+#ifdef TORK_HAS_SSE2
+
+// 文字ごとに比較して 16 バイトずつ探す
+// N は比較の回数（集合の文字数が N より少なければ先頭の文字で埋める）
+template<size_t N>
+const char* FindSse2(const char* p, const char* last, const CharSet& set)
+{
+    __m128i needles[N];
+    for (size_t i = 0; i < N; ++i) {
+        needles[i] = _mm_set1_epi8(set.chars()[i < set.size() ? i : 0]);
+    }
+    while (last - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hit = _mm_cmpeq_epi8(v, needles[0]);
+        for (size_t i = 1; i < N; ++i) hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, needles[i]));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hit));
+        if (mask != 0) return p + tork::impl::CountTrailingZeros(mask);
+        p += 16;
+    }
+    return FindScalar(p, last, set);
+}
+
+#endif  // TORK_HAS_SSE2
+
+        }   // anonymous namespace
+
+// 集合のどれかの文字を探す
+size_t find_any_of(string_view s, const CharSet& set, size_t pos)
+{
+    if (pos >= s.size() || set.size() == 0) return string_view::npos;
+    const char* first = s.data() + pos;
+    const char* last = s.data() + s.size();
+    const char* p;
+    switch (set.size()) {
+    case 1:
+        // 1 文字なら、ライブラリの（ベクトル化された）memchr を使う
+        p = static_cast<const char*>(std::memchr(first, set.chars()[0], last - first));
+        return p ? p - s.data() : string_view::npos;
+#ifdef TORK_HAS_SSE2
+    case 2: p = FindSse2<2>(first, last, set); break;
+    case 3: p = FindSse2<3>(first, last, set); break;
+    case 4: p = FindSse2<4>(first, last, set); break;
+    case 5: case 6: case 7: case 8: p = FindSse2<CharSet::MaxSimdChars>(first, last, set); break;
+#endif
+    default: p = FindScalar(first, last, set); break;
+    }
+    return p == last ? string_view::npos : p - s.data();
+}
+
+    }   // namespace tork::text
+
+}   // namespace tork
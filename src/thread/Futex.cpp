@@ -0,0 +1,83 @@
+﻿//******************************************************************************
+//
+// アドレス待ち（futex）
+//
+//******************************************************************************
+
+#include <tork/thread/Futex.h>
+#include <thread>
+#include <chrono>
+
+#if defined(_WIN32)
+#include <windows.h>
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+#define TORK_HAS_WAIT_ON_ADDRESS
+#pragma comment(lib, "Synchronization.lib")
+#endif
+#elif defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+#define TORK_HAS_FUTEX
+#endif
+
+namespace tork {
+
+#if defined(TORK_HAS_WAIT_ON_ADDRESS)
+
+// *addr が expected の間スレッドを眠らせる
+void FutexWait(const std::atomic<unsigned>* addr, unsigned expected)
+{
+    ::WaitOnAddress(const_cast<std::atomic<unsigned>*>(addr), &expected, sizeof(unsigned), INFINITE);
+}
+
+// 1つ起こす
+void FutexWakeOne(const std::atomic<unsigned>* addr)
+{
+    ::WakeByAddressSingle(const_cast<std::atomic<unsigned>*>(addr));
+}
+
+// 全部起こす
+void FutexWakeAll(const std::atomic<unsigned>* addr)
+{
+    ::WakeByAddressAll(const_cast<std::atomic<unsigned>*>(addr));
+}
+
+#elif defined(TORK_HAS_FUTEX)
+
+// *addr が expected の間スレッドを眠らせる
+void FutexWait(const std::atomic<unsigned>* addr, unsigned expected)
+{
+    ::syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+// 1つ起こす
+void FutexWakeOne(const std::atomic<unsigned>* addr)
+{
+    ::syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
+
+// 全部起こす
+void FutexWakeAll(const std::atomic<unsigned>* addr)
+{
+    ::syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+#else
+
+// アドレス待ちがない環境では少し眠ってから戻る（呼び出し側が確かめ直す）
+void FutexWait(const std::atomic<unsigned>* addr, unsigned expected)
+{
+    if (addr->load(std::memory_order_acquire) == expected) {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+void FutexWakeOne(const std::atomic<unsigned>*) { }
+
+void FutexWakeAll(const std::atomic<unsigned>*) { }
+
+#endif
+
+}   // namespace tork
@@ -0,0 +1,253 @@
+﻿//******************************************************************************
+//
+// ワークスティーリング型のスレッドプール
+//
+//******************************************************************************
+
+#include <tork/thread/ThreadPool.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(_MSC_VER)
+#define TORK_POOL_THREAD_LOCAL __declspec(thread)
+#else
+#define TORK_POOL_THREAD_LOCAL __thread
+#endif
+
+namespace tork {
+
+    namespace {
+
+// 呼び出したスレッドが属するプールと、その中での番号
+TORK_POOL_THREAD_LOCAL ThreadPool* CurrentPool = nullptr;
+TORK_POOL_THREAD_LOCAL unsigned CurrentIndex = 0;
+
+// ワーカー以外のスレッドが盗むときの乱数
+TORK_POOL_THREAD_LOCAL unsigned ExternalSeed = 0;
+
+// xorshift
+inline unsigned NextRandom(unsigned& x)
+{
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+    }   // anonymous namespace
+
+// 呼び出したスレッドを指定したコアに固定する
+bool PinThisThread(unsigned core)
+{
+#if defined(_WIN32)
+    const unsigned bits = sizeof(DWORD_PTR) * 8;
+    if (core >= bits) return false;
+    return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << core) != 0;
+#elif defined(__linux__)
+    if (core >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)core;
+    return false;
+#endif
+}
+
+//==============================================================================
+// ワーカー
+//==============================================================================
+struct ThreadPool::Worker {
+    impl::WorkStealingDeque<impl::PoolTask> deque;
+    std::thread thread;
+    unsigned seed = 1;
+    char padding[CacheLineSize];
+};
+
+// コンストラクタ
+ThreadPool::ThreadPool(unsigned thread_count, bool pin_threads)
+    :pin_threads_(pin_threads), inject_count_(0), stop_(false)
+{
+    if (thread_count == 0) {
+        thread_count = std::thread::hardware_concurrency();
+        if (thread_count == 0) thread_count = 1;
+    }
+    thread_count_ = thread_count;
+    workers_.reset(new Worker[thread_count_]);
+    for (unsigned i = 0; i < thread_count_; ++i) {
+        workers_[i].seed = i * 2654435761u + 1;
+    }
+
+    // スレッドを作れなければ、作ったスレッドを止めてから投げ直す
+    // （joinable なまま workers_ を破棄すると std::terminate になる）
+    unsigned started = 0;
+    try {
+        for (; started < thread_count_; ++started) {
+            workers_[started].thread = std::thread([this, started]() { worker_main(started); });
+        }
+    }
+    catch (...) {
+        stop_.store(true, std::memory_order_seq_cst);
+        idle_.notify_all();
+        for (unsigned i = 0; i < started; ++i) {
+            workers_[i].thread.join();
+        }
+        throw;
+    }
+}
+
+// デストラクタ
+ThreadPool::~ThreadPool()
+{
+    stop_.store(true, std::memory_order_seq_cst);
+    idle_.notify_all();
+    for (unsigned i = 0; i < thread_count_; ++i) {
+        workers_[i].thread.join();
+    }
+}
+
+// 呼び出したスレッドのワーカー番号
+int ThreadPool::current_index() const
+{
+    return (CurrentPool == this) ? static_cast<int>(CurrentIndex) : -1;
+}
+
+// タスクを積む
+void ThreadPool::schedule(impl::PoolTask* task)
+{
+    if (CurrentPool == this) {
+        workers_[CurrentIndex].deque.push(task);
+    }
+    else {
+        std::lock_guard<SpinLock> lock(inject_lock_);
+        inject_.push_back(task);
+        inject_count_.fetch_add(1, std::memory_order_release);
+    }
+    idle_.notify_one();
+}
+
+// 範囲を割るべきかどうか
+// ワーカーなら自分のキューが空のとき（盗まれた後か、まだ何も積んでいない）
+bool ThreadPool::should_split() const
+{
+    if (CurrentPool != this) return true;
+    return workers_[CurrentIndex].deque.empty();
+}
+
+// 仕事を1つ実行する
+bool ThreadPool::run_one()
+{
+    impl::PoolTask* task;
+    if (CurrentPool == this) {
+        task = find_task(CurrentIndex);
+    }
+    else {
+        task = take_injected();
+        if (!task) {
+            if (ExternalSeed == 0) {
+                ExternalSeed = static_cast<unsigned>(reinterpret_cast<size_t>(&ExternalSeed)) | 1;
+            }
+            task = steal_any(ExternalSeed, thread_count_);
+        }
+    }
+    if (!task) return false;
+    task->execute();
+    return true;
+}
+
+// 自分のキュー → 共有キュー → 他のワーカー の順に仕事を探す
+impl::PoolTask* ThreadPool::find_task(unsigned index)
+{
+    Worker& w = workers_[index];
+    impl::PoolTask* task = w.deque.pop();
+    if (task) return task;
+    task = take_injected();
+    if (task) return task;
+    return steal_any(w.seed, index);
+}
+
+// 共有キューから取り出す
+impl::PoolTask* ThreadPool::take_injected()
+{
+    if (inject_count_.load(std::memory_order_acquire) == 0) return nullptr;
+    std::lock_guard<SpinLock> lock(inject_lock_);
+    if (inject_head_ == inject_.size()) return nullptr;
+    impl::PoolTask* task = inject_[inject_head_++];
+    if (inject_head_ == inject_.size()) {
+        inject_.clear();
+        inject_head_ = 0;
+    }
+    inject_count_.fetch_sub(1, std::memory_order_relaxed);
+    return task;
+}
+
+// ランダムに選んだワーカーから順に盗む
+impl::PoolTask* ThreadPool::steal_any(unsigned& seed, unsigned self)
+{
+    unsigned n = thread_count_;
+    unsigned start = NextRandom(seed) % n;
+    for (unsigned k = 0; k < n; ++k) {
+        unsigned victim = start + k;
+        if (victim >= n) victim -= n;
+        if (victim == self) continue;
+        impl::PoolTask* task = workers_[victim].deque.steal();
+        if (task) return task;
+    }
+    return nullptr;
+}
+
+// どこかに仕事があるかどうか
+bool ThreadPool::has_work() const
+{
+    if (inject_count_.load(std::memory_order_acquire) != 0) return true;
+    for (unsigned i = 0; i < thread_count_; ++i) {
+        if (!workers_[i].deque.empty()) return true;
+    }
+    return false;
+}
+
+// ワーカースレッドの本体
+void ThreadPool::worker_main(unsigned index)
+{
+    CurrentPool = this;
+    CurrentIndex = index;
+    if (pin_threads_) {
+        unsigned hw = std::thread::hardware_concurrency();
+        PinThisThread(hw ? index % hw : index);
+    }
+
+    for (;;) {
+        impl::PoolTask* task = find_task(index);
+        if (!task) {
+            // 少しだけ回ってから眠る
+            impl::SpinWait spin;
+            while (!spin.exhausted() && (task = find_task(index)) == nullptr) {
+                spin.wait();
+            }
+        }
+        if (task) {
+            task->execute();
+            continue;
+        }
+
+        unsigned key = idle_.prepare_wait();
+        if (has_work()) {
+            idle_.cancel_wait();
+            continue;
+        }
+        if (stop_.load(std::memory_order_seq_cst)) {
+            idle_.cancel_wait();
+            break;
+        }
+        idle_.wait(key);
+    }
+    CurrentPool = nullptr;
+}
+
+}   // namespace tork
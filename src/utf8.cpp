@@ -0,0 +1,379 @@
+﻿//******************************************************************************
+//
+// UTF-8 の検証と文字数の計算
+//
+// AVX2 の検証は、前後 3 バイトの組み合わせを表引きで調べる方法
+// （Keiser, Lemire "Validating UTF-8 in less than one instruction per byte"）
+//
+//******************************************************************************
+
+#include <tork/utf8.h>
+#include <tork/bits.h>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TORK_UTF8_X86
+#endif
+
+#if defined(TORK_UTF8_X86) && (defined(_MSC_VER) || defined(__GNUC__))
+#define TORK_UTF8_AVX2
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TORK_TARGET_AVX2
+#else
+#define TORK_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace tork {
+
+    namespace utf8 {
+
+        namespace {
+
+using impl::SimdLevel;
+
+// 継続バイトかどうか
+inline bool IsContinuation(unsigned char c)
+{
+    return (c & 0xC0) == 0x80;
+}
+
+// 正しい 1 文字の長さ（不正なら 0）
+size_t ValidLength(const unsigned char* p, const unsigned char* last)
+{
+    unsigned c = p[0];
+    unsigned lo = 0x80, hi = 0xBF;  // 2 バイト目の範囲
+    size_t n;
+    if (c < 0x80) return 1;
+    else if (c < 0xC2) return 0;
+    else if (c < 0xE0) n = 2;
+    else if (c < 0xF0) {
+        n = 3;
+        if (c == 0xE0) lo = 0xA0;       // 冗長な表現
+        else if (c == 0xED) hi = 0x9F;  // サロゲート
+    }
+    else if (c < 0xF5) {
+        n = 4;
+        if (c == 0xF0) lo = 0x90;       // 冗長な表現
+        else if (c == 0xF4) hi = 0x8F;  // U+10FFFF 超
+    }
+    else return 0;
+    if (static_cast<size_t>(last - p) < n) return 0;
+    if (p[1] < lo || p[1] > hi) return 0;
+    for (size_t i = 2; i < n; ++i) {
+        if (!IsContinuation(p[i])) return 0;
+    }
+    return n;
+}
+
+// バイト単位の検証（from は文字の先頭）
+size_t FindInvalidScalar(const unsigned char* s, size_t n, size_t from)
+{
+    const unsigned char* p = s + from;
+    const unsigned char* last = s + n;
+    while (p != last) {
+        size_t len = ValidLength(p, last);
+        if (len == 0) return p - s;
+        p += len;
+    }
+    return n;
+}
+
+// バイト単位の文字数
+size_t CountScalar(const unsigned char* p, size_t n)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        count += !IsContinuation(p[i]);
+    }
+    return count;
+}
+
+// 不正なブロックの近くから、バイト単位で検証し直す
+// ブロックより前は正しいので、3 バイト前から継続バイトを飛ばした位置が文字の先頭になる
+size_t RestartScalar(const unsigned char* s, size_t n, size_t block)
+{
+    size_t from = block < 3 ? 0 : block - 3;
+    while (from < block && IsContinuation(s[from])) ++from;
+    return FindInvalidScalar(s, n, from);
+}
+
+#ifdef TORK_HAS_SSE2
+
+// ASCII の並びを 16 バイトずつ読み飛ばす検証
+size_t FindInvalidSse2(const unsigned char* s, size_t n)
+{
+    const unsigned char* p = s;
+    const unsigned char* last = s + n;
+    while (p != last) {
+        if (*p < 0x80) {
+            while (last - p >= 16
+                && _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) == 0) {
+                p += 16;
+            }
+            while (p != last && *p < 0x80) ++p;
+            continue;
+        }
+        size_t len = ValidLength(p, last);
+        if (len == 0) return p - s;
+        p += len;
+    }
+    return n;
+}
+
+// 継続バイト以外を 16 バイトずつ数える
+size_t CountSse2(const unsigned char* p, size_t n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i threshold = _mm_set1_epi8(-65);   // 0xBF より大きいか 0x80 未満
+    size_t count = 0;
+    size_t i = 0;
+    while (n - i >= 16) {
+        // 8 ビットの計数があふれないよう 255 回ごとに足し込む
+        size_t blocks = (n - i) / 16;
+        if (blocks > 255) blocks = 255;
+        __m128i acc = zero;
+        for (size_t k = 0; k < blocks; ++k, i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            acc = _mm_sub_epi8(acc, _mm_cmpgt_epi8(v, threshold));
+        }
+        __m128i sums = _mm_sad_epu8(acc, zero);
+        count += _mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+    }
+    return count + CountScalar(p + i, n - i);
+}
+
+#endif  // TORK_HAS_SSE2
+
+#ifdef TORK_UTF8_AVX2
+
+// 2 バイトの組み合わせの誤りを表すビット
+const char TooShort = 1 << 0;       // 11______ 0_______ / 11______ 11______
+const char TooLong = 1 << 1;        // 0_______ 10______
+const char Overlong3 = 1 << 2;      // 11100000 100_____
+const char TooLarge = 1 << 3;       // 11110100 1001____ など
+const char Surrogate = 1 << 4;      // 11101101 101_____
+const char Overlong2 = 1 << 5;      // 1100000_ 10______
+const char TooLarge1000 = 1 << 6;   // 11110101 1000____ など
+const char Overlong4 = 1 << 6;      // 11110000 1000____
+const char TwoConts = -128;         // 10______ 10______（3, 4 バイト文字なら正しい）
+const char Carry = TooShort | TooLong | TwoConts;
+
+// 16 バイトの表を両方のレーンに置く
+#define TORK_UTF8_TABLE(a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15) \
+    _mm256_setr_epi8(a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15, \
+                     a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15)
+
+// 32 バイトのブロックを検証し、誤りがあれば 0 以外を返す
+// prev は直前のブロック
+TORK_TARGET_AVX2
+__m256i CheckBlockAvx2(__m256i in, __m256i prev)
+{
+    const __m256i low4 = _mm256_set1_epi8(0x0F);
+
+    // 1～3 バイト前
+    __m256i shifted = _mm256_permute2x128_si256(prev, in, 0x21);
+    __m256i prev1 = _mm256_alignr_epi8(in, shifted, 15);
+    __m256i prev2 = _mm256_alignr_epi8(in, shifted, 14);
+    __m256i prev3 = _mm256_alignr_epi8(in, shifted, 13);
+
+    // 直前のバイトの上位 4 ビット、下位 4 ビットと、このバイトの上位 4 ビットで表を引く
+    const __m256i byte1_high_table = TORK_UTF8_TABLE(
+        TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong,
+        TwoConts, TwoConts, TwoConts, TwoConts,
+        TooShort | Overlong2,
+        TooShort,
+        TooShort | Overlong3 | Surrogate,
+        TooShort | TooLarge | TooLarge1000 | Overlong4);
+    const __m256i byte1_low_table = TORK_UTF8_TABLE(
+        Carry | Overlong3 | Overlong2 | Overlong4,
+        Carry | Overlong2,
+        Carry,
+        Carry,
+        Carry | TooLarge,
+        Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000 | Surrogate,
+        Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000);
+    const __m256i byte2_high_table = TORK_UTF8_TABLE(
+        TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort,
+        TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge1000 | Overlong4,
+        TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge,
+        TooLong | Overlong2 | TwoConts | Surrogate | TooLarge,
+        TooLong | Overlong2 | TwoConts | Surrogate | TooLarge,
+        TooShort, TooShort, TooShort, TooShort);
+
+    __m256i byte1_high = _mm256_shuffle_epi8(byte1_high_table,
+        _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low4));
+    __m256i byte1_low = _mm256_shuffle_epi8(byte1_low_table, _mm256_and_si256(prev1, low4));
+    __m256i byte2_high = _mm256_shuffle_epi8(byte2_high_table,
+        _mm256_and_si256(_mm256_srli_epi16(in, 4), low4));
+    __m256i special = _mm256_and_si256(_mm256_and_si256(byte1_high, byte1_low), byte2_high);
+
+    // 2 バイト前が 3, 4 バイト文字の先頭か、3 バイト前が 4 バイト文字の先頭なら継続バイトでなければならない
+    __m256i third = _mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xE0 - 1)));
+    __m256i fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 1)));
+    __m256i must23 = _mm256_cmpgt_epi8(_mm256_or_si256(third, fourth), _mm256_setzero_si256());
+    __m256i must23_80 = _mm256_and_si256(must23, _mm256_set1_epi8(-128));
+    return _mm256_xor_si256(must23_80, special);
+}
+
+// 32 バイトずつの検証
+TORK_TARGET_AVX2
+size_t FindInvalidAvx2(const unsigned char* s, size_t n)
+{
+    // 末尾 3 バイトがこれを超えたら、次のブロックに続く
+    const __m256i max_value = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+    __m256i prev = _mm256_setzero_si256();
+    __m256i prev_incomplete = _mm256_setzero_si256();
+    unsigned char tail[32];
+    size_t i = 0;
+    while (i < n) {
+        const unsigned char* block = s + i;
+        if (n - i < 32) {
+            // 端数は 0（ASCII）で埋める
+            std::memset(tail, 0, sizeof(tail));
+            std::memcpy(tail, s + i, n - i);
+            block = tail;
+        }
+        __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+        __m256i error = _mm256_movemask_epi8(in) == 0 ? prev_incomplete : CheckBlockAvx2(in, prev);
+        if (!_mm256_testz_si256(error, error)) return RestartScalar(s, n, i);
+        prev_incomplete = _mm256_subs_epu8(in, max_value);
+        prev = in;
+        i += 32;
+    }
+    if (!_mm256_testz_si256(prev_incomplete, prev_incomplete)) return RestartScalar(s, n, n);
+    return n;
+}
+
+// 継続バイト以外を 32 バイトずつ数える
+TORK_TARGET_AVX2
+size_t CountAvx2(const unsigned char* p, size_t n)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i threshold = _mm256_set1_epi8(-65);
+    size_t count = 0;
+    size_t i = 0;
+    while (n - i >= 32) {
+        size_t blocks = (n - i) / 32;
+        if (blocks > 255) blocks = 255;
+        __m256i acc = zero;
+        for (size_t k = 0; k < blocks; ++k, i += 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+            acc = _mm256_sub_epi8(acc, _mm256_cmpgt_epi8(v, threshold));
+        }
+        __m256i sums = _mm256_sad_epu8(acc, zero);
+        __m128i half = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+        count += _mm_cvtsi128_si32(half) + _mm_cvtsi128_si32(_mm_srli_si128(half, 8));
+    }
+    return count + CountScalar(p + i, n - i);
+}
+
+#undef TORK_UTF8_TABLE
+
+#endif  // TORK_UTF8_AVX2
+
+// AVX2 が使えるかどうか（OS が YMM レジスタを保存するかも調べる）
+bool HasAvx2()
+{
+#if defined(TORK_UTF8_AVX2) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    const int osxsave = 1 << 27, avx = 1 << 28;
+    if ((info[2] & (osxsave | avx)) != (osxsave | avx)) return false;
+    if ((_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(TORK_UTF8_AVX2)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#else
+    return false;
+#endif
+}
+
+// 起動時に一度だけ調べる
+// 初期化より前に呼ばれた場合は 0（Scalar）のままなので、バイト単位の実装になる
+const SimdLevel DetectedLevel = impl::DetectSimdLevel();
+
+        }   // anonymous namespace
+
+        namespace impl {
+
+// この CPU で使える最上位の命令セット
+SimdLevel DetectSimdLevel()
+{
+    if (HasAvx2()) return SimdLevel::Avx2;
+#ifdef TORK_HAS_SSE2
+    return SimdLevel::Sse2;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+// 命令セットを指定した検証
+size_t FindInvalid(const char* s, size_t n, SimdLevel level)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(s);
+    if (level > DetectedLevel) level = DetectedLevel;
+#ifdef TORK_UTF8_AVX2
+    if (level == SimdLevel::Avx2) return FindInvalidAvx2(p, n);
+#endif
+#ifdef TORK_HAS_SSE2
+    if (level >= SimdLevel::Sse2) return FindInvalidSse2(p, n);
+#endif
+    return FindInvalidScalar(p, n, 0);
+}
+
+// 命令セットを指定した文字数の計算
+size_t CountCodePoints(const char* s, size_t n, SimdLevel level)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(s);
+    if (level > DetectedLevel) level = DetectedLevel;
+#ifdef TORK_UTF8_AVX2
+    if (level == SimdLevel::Avx2) return CountAvx2(p, n);
+#endif
+#ifdef TORK_HAS_SSE2
+    if (level >= SimdLevel::Sse2) return CountSse2(p, n);
+#endif
+    return CountScalar(p, n);
+}
+
+        }   // namespace tork::utf8::impl
+
+// 最初の不正なシーケンスの位置
+size_t find_invalid(span<const char> s)
+{
+    return impl::FindInvalid(s.data(), s.size(), DetectedLevel);
+}
+
+// 正しい UTF-8 かどうか
+bool validate(span<const char> s)
+{
+    return find_invalid(s) == s.size();
+}
+
+// コードポイントの数
+size_t count_code_points(span<const char> s)
+{
+    return impl::CountCodePoints(s.data(), s.size(), DetectedLevel);
+}
+
+    }   // namespace tork::utf8
+
+}   // namespace tork